@@ -0,0 +1,95 @@
+/**
+ * \file            daemon.c
+ * \brief           Multi-process stack daemon over socket emulator
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+#include "system/esp_daemon.h"
+#include "esp_emu.h"
+
+#define DAEMON_HEAP_SIZE            0x40000
+
+static uint8_t heap[DAEMON_HEAP_SIZE];
+static esp_mem_region_t heap_regions[] = {
+    { heap, sizeof(heap), ESP_MEM_CLASS_DEFAULT },
+};
+
+/**
+ * \brief           Global event callback
+ * \param[in]       evt: Event information
+ * \return          \ref espOK on success, member of \ref espr_t otherwise
+ */
+static espr_t
+daemon_evt(esp_evt_t* evt) {
+    ESP_UNUSED(evt);
+    return espOK;
+}
+
+/**
+ * \brief           Program entry point
+ *
+ * Usage: `esp_daemon <socket> [seconds]`, runs until killed when time is not set
+ *
+ * \param[in]       argc: Number of arguments
+ * \param[in]       argv: Arguments
+ * \return          `0` on success, `1` otherwise
+ */
+int
+main(int argc, char** argv) {
+    esp_daemon_stats_t stats;
+    uint32_t seconds;
+
+    if (argc < 2) {
+        printf("Usage: %s <socket> [seconds]\r\n", argv[0]);
+        return 1;
+    }
+    seconds = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 0;
+    if (!esp_mem_assignmemory(heap_regions, ESP_ARRAYSIZE(heap_regions))
+        || esp_init(daemon_evt, 1) != espOK
+        || esp_sta_join("emu", "daemon", NULL, NULL, NULL, 1) != espOK
+        || esp_daemon_start(argv[1]) != espOK) {
+        printf("Could not start daemon\r\n");
+        return 1;
+    }
+    printf("Daemon listening on %s\r\n", argv[1]);
+    fflush(stdout);
+
+    for (uint32_t i = 0; seconds == 0 || i < seconds; ++i) {
+        esp_delay(1000);
+    }
+    esp_daemon_get_stats(&stats);
+    printf("Daemon: %u clients, %u connections, %u bytes to module, %u bytes to clients\r\n",
+        (unsigned)stats.clients, (unsigned)stats.conns, (unsigned)stats.bytes_tx, (unsigned)stats.bytes_rx);
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * \file            daemon_client.c
+ * \brief           Echo test client for multi-process stack daemon
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <time.h>
+#include "system/esp_daemon_client.h"
+
+/**
+ * \brief           Get monotonic time
+ * \return          Time in units of milliseconds
+ */
+static uint32_t
+client_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/**
+ * \brief           Program entry point
+ *
+ * Usage: `esp_daemon_client <socket> <host> <port> <bytes>`.
+ * Sends data to echo server through daemon and checks echoed data
+ *
+ * \param[in]       argc: Number of arguments
+ * \param[in]       argv: Arguments
+ * \return          `0` on success, `1` otherwise
+ */
+int
+main(int argc, char** argv) {
+    esp_daemon_client_p client;
+    esp_daemon_conn_p conn;
+    struct pollfd pfd = { .events = POLLIN };
+    uint32_t t, total, sent = 0, received = 0, errors = 0;
+    const uint8_t* rx;
+    uint8_t* tx;
+    size_t len;
+    espr_t res;
+
+    if (argc < 5) {
+        printf("Usage: %s <socket> <host> <port> <bytes>\r\n", argv[0]);
+        return 1;
+    }
+    total = (uint32_t)strtoul(argv[4], NULL, 0);
+    if ((client = esp_daemon_client_new(argv[1])) == NULL) {
+        printf("Could not connect to daemon on %s\r\n", argv[1]);
+        return 1;
+    }
+    t = client_now();
+    if ((res = esp_daemon_conn_start(client, &conn, ESP_CONN_TYPE_TCP, argv[2], (esp_port_t)strtoul(argv[3], NULL, 0))) != espOK) {
+        printf("Could not start connection: %d\r\n", (int)res);
+        esp_daemon_client_delete(client);
+        return 1;
+    }
+
+    /* Single thread loop, waits on doorbell descriptor when nothing can be done */
+    pfd.fd = esp_daemon_client_get_fd(client);
+    while (received < total) {
+        uint8_t progress = 0;
+
+        esp_daemon_client_clear_fd(client);
+
+        while (sent < total && (tx = esp_daemon_conn_send_alloc(conn, &len, 0)) != NULL) {
+            len = len < total - sent ? len : total - sent;
+            for (size_t i = 0; i < len; ++i) {
+                tx[i] = (uint8_t)((sent + i) % 251);/* Data written in place to shared memory */
+            }
+            esp_daemon_conn_send_commit(conn, len);
+            sent += (uint32_t)len;
+            progress = 1;
+        }
+        while ((res = esp_daemon_conn_receive(conn, (const void**)&rx, &len, 0)) == espOK) {
+            for (size_t i = 0; i < len; ++i) {
+                errors += rx[i] != (uint8_t)((received + i) % 251);
+            }
+            received += (uint32_t)len;
+            esp_daemon_conn_recved(conn);
+            progress = 1;
+        }
+        if (res == espCLOSED) {
+            break;
+        }
+        if (!progress && poll(&pfd, 1, 5000) == 0) {
+            break;                              /* No data for too long */
+        }
+    }
+    t = client_now() - t;
+
+    printf("Client: %u bytes sent, %u bytes received, %u errors in %u ms\r\n",
+        (unsigned)sent, (unsigned)received, (unsigned)errors, (unsigned)t);
+    esp_daemon_conn_close(conn);
+    esp_daemon_client_delete(client);
+    return received == total && errors == 0 ? 0 : 1;
+}
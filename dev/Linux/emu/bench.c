@@ -0,0 +1,503 @@
+/**
+ * \file            bench.c
+ * \brief           End-to-end benchmark over socket emulator
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+#include "esp/esp_netconn.h"
+#include "esp/apps/esp_http_server.h"
+#include "esp/apps/esp_mqtt_client_api.h"
+#include "system/esp_sys.h"
+#include "esp_emu.h"
+#if ESP_EMU_FRAME
+#include "system/esp_ll_frame.h"
+#endif /* ESP_EMU_FRAME */
+
+#define BENCH_HEAP_SIZE             0x40000
+#define BENCH_CHUNK_LEN             1024
+
+static uint8_t heap[BENCH_HEAP_SIZE];
+static esp_mem_region_t heap_regions[] = {
+    { heap, sizeof(heap), ESP_MEM_CLASS_DEFAULT },
+};
+
+static uint8_t chunk[BENCH_CHUNK_LEN];
+
+/**
+ * \brief           Global event callback
+ * \param[in]       evt: Event information
+ * \return          \ref espOK on success, member of \ref espr_t otherwise
+ */
+static espr_t
+bench_evt(esp_evt_t* evt) {
+    ESP_UNUSED(evt);
+    return espOK;
+}
+
+/**
+ * \brief           Print rate of transfer
+ * \param[in]       name: Transfer name
+ * \param[in]       cnt: Number of units
+ * \param[in]       unit: Unit name
+ * \param[in]       ms: Time in units of milliseconds
+ */
+static void
+bench_print_rate(const char* name, uint32_t cnt, const char* unit, uint32_t ms) {
+    ms = ms > 0 ? ms : 1;
+    printf("%s: %u %s in %u ms, %.1f %s/s\r\n", name, (unsigned)cnt, unit, (unsigned)ms,
+        (double)cnt * 1000.0 / (double)ms, unit);
+}
+
+/**
+ * \brief           Send data to TCP server, then receive until remote closes connection
+ * \param[in]       host: Server host
+ * \param[in]       port: Server port
+ * \param[in]       total: Number of bytes to send
+ * \param[in]       rate: Rate limit for both directions in units of bytes per second, `0` for no limit
+ * \return          `0` on success, `1` otherwise
+ */
+static int
+bench_tcp(const char* host, esp_port_t port, uint32_t total, uint32_t rate) {
+    esp_netconn_p nc;
+    esp_pbuf_p pbuf;
+    uint32_t t, sent = 0, received = 0;
+    espr_t res;
+
+    if ((nc = esp_netconn_new(ESP_NETCONN_TYPE_TCP)) == NULL) {
+        return 1;
+    }
+    if (esp_netconn_connect(nc, host, port) != espOK) {
+        printf("Could not connect to %s:%u\r\n", host, (unsigned)port);
+        esp_netconn_delete(nc);
+        return 1;
+    }
+#if ESP_CFG_CONN_RATE_LIMIT
+    if (rate > 0) {
+        esp_conn_rate_limit_t limit = { .rate = rate, .burst = BENCH_CHUNK_LEN };
+        esp_conn_set_rate_limit(esp_netconn_get_conn(nc), &limit, &limit);
+    }
+#else /* ESP_CFG_CONN_RATE_LIMIT */
+    ESP_UNUSED(rate);
+#endif /* !ESP_CFG_CONN_RATE_LIMIT */
+    t = esp_sys_now();
+    while (sent < total) {
+        size_t len = ESP_MIN(sizeof(chunk), (size_t)(total - sent));
+        if (esp_netconn_write(nc, chunk, len) != espOK) {
+            break;
+        }
+        sent += (uint32_t)len;
+    }
+    esp_netconn_flush(nc);
+    bench_print_rate("TCP send", sent, "bytes", esp_sys_now() - t);
+#if ESP_CFG_CONN_ADAPTIVE_CHUNK
+    {
+        esp_conn_chunk_stats_t cs;
+
+        if (esp_conn_get_chunk_stats(esp_netconn_get_conn(nc), &cs) == espOK) {
+            printf("TCP chunk size: %u bytes, %u ms per kB, grows: %u, shrinks: %u, fails: %u\r\n",
+                (unsigned)cs.size, (unsigned)cs.time_per_kb, (unsigned)cs.grows, (unsigned)cs.shrinks, (unsigned)cs.fails);
+        }
+    }
+#endif /* ESP_CFG_CONN_ADAPTIVE_CHUNK */
+
+    t = esp_sys_now();
+    esp_netconn_set_receive_timeout(nc, 5000);
+    while ((res = esp_netconn_receive(nc, &pbuf)) == espOK) {
+        received += (uint32_t)esp_pbuf_length(pbuf, 1);
+        esp_pbuf_free(pbuf);
+    }
+    if (received > 0) {
+        bench_print_rate("TCP receive", received, "bytes", esp_sys_now() - t);
+    }
+    if (res != espCLOSED) {
+        esp_netconn_close(nc);
+    }
+    esp_netconn_delete(nc);
+    return sent == total ? 0 : 1;
+}
+
+#if ESP_CFG_EVT_POLL
+
+/**
+ * \brief           Send next chunk without blocking
+ * \param[in]       conn: Connection handle
+ * \param[in,out]   sent: Number of bytes sent so far
+ * \param[in]       total: Number of bytes to send
+ */
+static void
+bench_poll_send(esp_conn_p conn, uint32_t* sent, uint32_t total) {
+    size_t len = ESP_MIN(sizeof(chunk), (size_t)(total - *sent));
+
+    if (len > 0 && esp_conn_send(conn, chunk, len, NULL, 0) == espOK) {
+        *sent += (uint32_t)len;
+    }
+}
+
+/**
+ * \brief           Send and receive data on TCP connection from single epoll loop
+ *
+ * All connection events are processed on this thread,
+ * read from pollable event queue
+ *
+ * \param[in]       host: Server host
+ * \param[in]       port: Server port
+ * \param[in]       total: Number of bytes to send
+ * \param[in]       rate: Transmit rate limit in units of bytes per second, `0` for no limit
+ * \return          `0` on success, `1` otherwise
+ */
+static int
+bench_poll(const char* host, esp_port_t port, uint32_t total, uint32_t rate) {
+    struct epoll_event ev = { .events = EPOLLIN };
+    esp_evt_poll_stats_t stats;
+    esp_conn_p conn = NULL;
+    esp_evt_t evt;
+    esp_pbuf_p pbuf;
+    uint32_t t, last, sent = 0, acked = 0, received = 0;
+    uint8_t done = 0;
+    int ep;
+#if ESP_CFG_EVT_TIMESTAMP
+    uint64_t wait_sum = 0;
+    uint32_t wait, wait_max = 0, events = 0;
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+
+    if (esp_evt_poll_init() != espOK || (ep = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        return 1;
+    }
+    epoll_ctl(ep, EPOLL_CTL_ADD, esp_evt_poll_get_fd(), &ev);
+
+    t = last = esp_sys_now();
+    if (esp_conn_start(NULL, ESP_CONN_TYPE_TCP, host, port, NULL, esp_evt_poll_evt_fn, 0) != espOK) {
+        done = 1;
+    }
+
+    /* Echo server returns all data, other servers close connection or stay idle */
+    while (!done && esp_sys_now() - last < 5000) {
+        if (epoll_wait(ep, &ev, 1, 1000) <= 0) {
+            continue;
+        }
+        while (esp_evt_poll(&evt) == espOK) {
+#if ESP_CFG_EVT_TIMESTAMP
+            wait = ESP_CFG_EVT_TIMESTAMP_NOW() - esp_evt_get_time_dispatch(&evt);
+            wait_sum += wait;
+            wait_max = ESP_MAX(wait_max, wait);
+            ++events;
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+            switch (esp_evt_get_type(&evt)) {
+                case ESP_EVT_CONN_ACTIVE:
+                    conn = esp_evt_conn_active_get_conn(&evt);
+#if ESP_CFG_CONN_RATE_LIMIT
+                    if (rate > 0) {
+                        esp_conn_rate_limit_t limit = { .rate = rate, .burst = BENCH_CHUNK_LEN };
+                        esp_conn_set_rate_limit(conn, &limit, NULL);
+                    }
+#else /* ESP_CFG_CONN_RATE_LIMIT */
+                    ESP_UNUSED(rate);
+#endif /* !ESP_CFG_CONN_RATE_LIMIT */
+                    bench_poll_send(conn, &sent, total);
+                    break;
+                case ESP_EVT_CONN_SEND:
+                    if (esp_evt_conn_send_get_result(&evt) == espOK) {
+                        acked += (uint32_t)esp_evt_conn_send_get_length(&evt);
+                        last = esp_sys_now();
+                        bench_poll_send(conn, &sent, total);
+                    }
+                    break;
+                case ESP_EVT_CONN_RECV:
+                    pbuf = esp_evt_conn_recv_get_buff(&evt);
+                    received += (uint32_t)esp_pbuf_length(pbuf, 1);
+                    esp_conn_recved(esp_evt_conn_recv_get_conn(&evt), pbuf);
+                    esp_pbuf_free(pbuf);        /* Application owns queued buffer */
+                    last = esp_sys_now();
+                    done = received >= total;
+                    break;
+                case ESP_EVT_CONN_ERROR:
+                case ESP_EVT_CONN_CLOSE:
+                    conn = NULL;
+                    done = 1;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    if (conn != NULL) {
+        esp_conn_close(conn, 1);
+    }
+    bench_print_rate("Poll send", acked, "bytes", last - t);
+    printf("Poll receive: %u bytes\r\n", (unsigned)received);
+    if (esp_evt_poll_get_stats(&stats) == espOK) {
+        printf("Poll queue: %u events, dropped: %u, held: %u, merged: %u, max pending: %u\r\n",
+            (unsigned)stats.queued, (unsigned)stats.dropped, (unsigned)stats.held,
+            (unsigned)stats.merged, (unsigned)stats.pending_max);
+    }
+#if ESP_CFG_EVT_TIMESTAMP
+    printf("Poll hand-off: avg %u us, max %u us\r\n",
+        (unsigned)(events > 0 ? wait_sum / events : 0), (unsigned)wait_max);
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+    close(ep);
+    esp_evt_poll_deinit();
+    return acked == total ? 0 : 1;
+}
+
+/**
+ * \brief           Overflow pollable event queue and check that no connection event is lost
+ *
+ * Connections are opened, written and closed before application reads any event,
+ * so echoed data and close events arrive while queue is full
+ *
+ * \param[in]       host: Echo server host
+ * \param[in]       port: Echo server port
+ * \param[in]       count: Number of connections
+ * \param[in]       total: Number of bytes to send on each connection
+ * \return          `0` on success, `1` otherwise
+ */
+static int
+bench_poll_flood(const char* host, esp_port_t port, size_t count, uint32_t total) {
+    esp_conn_p conns[ESP_CFG_MAX_CONNS] = { NULL };
+    uint32_t received[ESP_CFG_MAX_CONNS] = { 0 }, sent, t;
+    uint8_t state[ESP_CFG_MAX_CONNS] = { 0 };   /* 0 = not active, 1 = active, 2 = closed */
+    esp_evt_poll_stats_t stats;
+    esp_evt_t evt;
+    esp_conn_p conn;
+    size_t i, pending;
+    int res = 0;
+
+    count = ESP_MIN(count, ESP_ARRAYSIZE(conns));
+    if (esp_evt_poll_init() != espOK) {
+        return 1;
+    }
+    for (i = 0; i < count; ++i) {
+        if (esp_conn_start(&conns[i], ESP_CONN_TYPE_TCP, host, port, NULL, esp_evt_poll_evt_fn, 1) != espOK) {
+            printf("Could not connect to %s:%u\r\n", host, (unsigned)port);
+            res = 1;
+            break;
+        }
+    }
+    for (i = 0; res == 0 && i < count; ++i) {
+        for (sent = 0; sent < total; sent += BENCH_CHUNK_LEN) {
+            esp_conn_send(conns[i], chunk, ESP_MIN((size_t)BENCH_CHUNK_LEN, (size_t)(total - sent)), NULL, 1);
+        }
+    }
+
+    /* Wait for echo to reach library, then close while queue is still full */
+    t = esp_sys_now();
+    do {
+        esp_delay(10);
+        for (i = 0, pending = 0; res == 0 && i < count; ++i) {
+            pending += esp_conn_get_total_recved_count(conns[i]) < total;
+        }
+    } while (pending > 0 && esp_sys_now() - t < 5000);
+    for (i = 0; i < count; ++i) {
+        if (conns[i] != NULL) {
+            esp_conn_close(conns[i], 1);
+        }
+    }
+
+    /* Drain queue, every connection must report open, all data and close in order */
+    while (esp_evt_poll(&evt) == espOK) {
+        if ((conn = esp_conn_get_from_evt(&evt)) == NULL) {
+            continue;
+        }
+        for (i = 0; i < count && conns[i] != conn; ++i) {}
+        if (i == count) {
+            continue;
+        }
+        switch (esp_evt_get_type(&evt)) {
+            case ESP_EVT_CONN_ACTIVE:
+                res |= state[i] != 0;
+                state[i] = 1;
+                break;
+            case ESP_EVT_CONN_RECV:
+                res |= state[i] != 1;
+                received[i] += (uint32_t)esp_pbuf_length(esp_evt_conn_recv_get_buff(&evt), 1);
+                esp_conn_recved(conn, esp_evt_conn_recv_get_buff(&evt));
+                esp_pbuf_free(esp_evt_conn_recv_get_buff(&evt));
+                break;
+            case ESP_EVT_CONN_CLOSE:
+                res |= state[i] != 1;
+                state[i] = 2;
+                break;
+            default:
+                break;
+        }
+    }
+    for (i = 0; i < count; ++i) {
+        printf("Flood connection %u: %u/%u bytes, %s\r\n", (unsigned)i, (unsigned)received[i], (unsigned)total,
+            state[i] == 2 ? "closed" : "not closed");
+        res |= received[i] != total || state[i] != 2;
+    }
+    if (esp_evt_poll_get_stats(&stats) == espOK) {
+        printf("Poll queue: %u events, dropped: %u, held: %u, merged: %u, max pending: %u\r\n",
+            (unsigned)stats.queued, (unsigned)stats.dropped, (unsigned)stats.held,
+            (unsigned)stats.merged, (unsigned)stats.pending_max);
+        if (stats.held == 0 && stats.merged == 0) {
+            printf("Queue did not overflow\r\n");
+            res = 1;
+        }
+    }
+    esp_evt_poll_deinit();
+    return res;
+}
+
+#endif /* ESP_CFG_EVT_POLL */
+
+/**
+ * \brief           Run HTTP server on emulated module
+ * \param[in]       port: Local port
+ * \param[in]       seconds: Time to run server
+ * \return          `0` on success, `1` otherwise
+ */
+static int
+bench_http(esp_port_t port, uint32_t seconds) {
+    http_metrics_t metrics;
+
+    if (esp_http_server_init(NULL, port) != espOK) {
+        printf("Could not start HTTP server\r\n");
+        return 1;
+    }
+    printf("HTTP server listening on port %u for %u s\r\n", (unsigned)port, (unsigned)seconds);
+    esp_delay(seconds * 1000);
+    esp_http_server_get_metrics(&metrics);
+    printf("HTTP requests: %u\r\n", (unsigned)metrics.requests);
+    return 0;
+}
+
+/**
+ * \brief           Publish messages to MQTT broker with quality of service 1
+ * \param[in]       host: Broker host
+ * \param[in]       port: Broker port
+ * \param[in]       count: Number of messages to publish
+ * \return          `0` on success, `1` otherwise
+ */
+static int
+bench_mqtt(const char* host, esp_port_t port, uint32_t count) {
+    esp_mqtt_client_info_t info = { .id = "esp_emu_bench", .keep_alive = 10 };
+    esp_mqtt_client_api_p client;
+    esp_mqtt_conn_status_t status;
+    uint32_t t, i;
+
+    if ((client = esp_mqtt_client_api_new(2048, 256)) == NULL) {
+        return 1;
+    }
+    if ((status = esp_mqtt_client_api_connect(client, host, port, &info)) != ESP_MQTT_CONN_STATUS_ACCEPTED) {
+        printf("Could not connect to broker %s:%u, status %d\r\n", host, (unsigned)port, (int)status);
+        esp_mqtt_client_api_delete(client);
+        return 1;
+    }
+    t = esp_sys_now();
+    for (i = 0; i < count; ++i) {
+        if (esp_mqtt_client_api_publish(client, "esp/bench", chunk, 64, ESP_MQTT_QOS_AT_LEAST_ONCE, 0) != espOK) {
+            break;
+        }
+    }
+    bench_print_rate("MQTT publish", i, "msgs", esp_sys_now() - t);
+    esp_mqtt_client_api_close(client);
+    esp_mqtt_client_api_delete(client);
+    return i == count ? 0 : 1;
+}
+
+/**
+ * \brief           Program entry point
+ *
+ * Usage:
+ *
+ *  - `esp_emu_bench tcp <host> <port> <bytes> [rate]`
+ *  - `esp_emu_bench poll <host> <port> <bytes> [rate]`
+ *  - `esp_emu_bench flood <host> <port> <conns> <bytes>`
+ *  - `esp_emu_bench http <port> <seconds>`
+ *  - `esp_emu_bench mqtt <host> <port> <count>`
+ *
+ * \return          `0` on success, `1` otherwise
+ */
+int
+main(int argc, char** argv) {
+    esp_emu_stats_t stats;
+    int res;
+
+    if (argc < 3) {
+        printf("Usage: %s tcp <host> <port> <bytes> [rate] | poll <host> <port> <bytes> [rate] | flood <host> <port> <conns> <bytes> | http <port> <seconds> | mqtt <host> <port> <count>\r\n", argv[0]);
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(chunk); ++i) {
+        chunk[i] = (uint8_t)('A' + i % 26);
+    }
+#if ESP_EMU_FRAME
+    esp_emu_frame_attach();
+#endif /* ESP_EMU_FRAME */
+    if (!esp_mem_assignmemory(heap_regions, ESP_ARRAYSIZE(heap_regions))
+        || esp_init(bench_evt, 1) != espOK
+        || esp_sta_join("emu", "bench", NULL, NULL, NULL, 1) != espOK) {
+        printf("Could not initialize library\r\n");
+        return 1;
+    }
+
+    if (!strcmp(argv[1], "tcp") && argc > 4) {
+        res = bench_tcp(argv[2], (esp_port_t)strtoul(argv[3], NULL, 0), (uint32_t)strtoul(argv[4], NULL, 0),
+                argc > 5 ? (uint32_t)strtoul(argv[5], NULL, 0) : 0);
+#if ESP_CFG_EVT_POLL
+    } else if (!strcmp(argv[1], "poll") && argc > 4) {
+        res = bench_poll(argv[2], (esp_port_t)strtoul(argv[3], NULL, 0), (uint32_t)strtoul(argv[4], NULL, 0),
+                argc > 5 ? (uint32_t)strtoul(argv[5], NULL, 0) : 0);
+    } else if (!strcmp(argv[1], "flood") && argc > 5) {
+        res = bench_poll_flood(argv[2], (esp_port_t)strtoul(argv[3], NULL, 0), (size_t)strtoul(argv[4], NULL, 0),
+                (uint32_t)strtoul(argv[5], NULL, 0));
+#endif /* ESP_CFG_EVT_POLL */
+    } else if (!strcmp(argv[1], "http")) {
+        res = bench_http((esp_port_t)strtoul(argv[2], NULL, 0), argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 0) : 30);
+    } else if (!strcmp(argv[1], "mqtt") && argc > 4) {
+        res = bench_mqtt(argv[2], (esp_port_t)strtoul(argv[3], NULL, 0), (uint32_t)strtoul(argv[4], NULL, 0));
+    } else {
+        printf("Unknown mode %s\r\n", argv[1]);
+        res = 1;
+    }
+
+    esp_emu_get_stats(&stats);
+    printf("Emulator: %u commands, %u/%u connections opened/closed, %u bytes sent, %u bytes received\r\n",
+        (unsigned)stats.cmds, (unsigned)stats.conns_opened, (unsigned)stats.conns_closed,
+        (unsigned)stats.bytes_tx, (unsigned)stats.bytes_rx);
+#if ESP_EMU_FRAME
+    {
+        esp_ll_frame_stats_t fs;
+
+        esp_ll_frame_get_stats(&fs);
+        printf("Frames: %u transactions, %u/%u transfers sent/received, %u/%u status/sequence errors, %u request retries\r\n",
+            (unsigned)fs.transactions, (unsigned)fs.frames_tx, (unsigned)fs.frames_rx, (unsigned)fs.status_errors,
+            (unsigned)fs.seq_errors, (unsigned)fs.request_retries);
+    }
+#endif /* ESP_EMU_FRAME */
+    return res;
+}
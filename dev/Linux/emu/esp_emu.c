@@ -0,0 +1,856 @@
+/**
+ * \file            esp_emu.c
+ * \brief           ESP AT module emulator backed by host sockets
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include "esp/esp.h"
+#include "esp/esp_input.h"
+#include "system/esp_ll.h"
+#include "system/esp_sys.h"
+#include "esp_emu.h"
+#if ESP_EMU_FRAME
+#include "system/esp_ll_frame_loop.h"
+#endif /* ESP_EMU_FRAME */
+
+#if !__DOXYGEN__
+
+#define EMU_MAX_LINKS               ESP_CFG_MAX_CONNS
+#define EMU_IN_SIZE                 0x4000
+#define EMU_OUT_SIZE                0x10000
+#define EMU_CMD_SIZE                256
+#define EMU_IPD_MAX_LEN             1460
+#define EMU_CONNECT_TIMEOUT         5000
+#define EMU_SERVER_ADDR             "127.0.0.1"
+
+/**
+ * \brief           Single link on emulated module
+ */
+typedef struct {
+    int fd;                                     /*!< Socket descriptor, `-1` when link is not active */
+    uint8_t is_server;                          /*!< Link was accepted by server */
+    uint8_t is_udp;                             /*!< Link is UDP socket */
+    struct sockaddr_in remote;                  /*!< Remote address */
+    esp_port_t local_port;                      /*!< Local port */
+    size_t notified;                            /*!< Available bytes last reported in manual receive mode */
+} emu_link_t;
+
+/**
+ * \brief           Emulator state
+ */
+typedef struct {
+    esp_emu_config_t cfg;                       /*!< Active configuration */
+    esp_emu_stats_t stats;                      /*!< Statistics */
+    esp_sys_mutex_t mutex;                      /*!< Protects input buffer and statistics */
+    uint8_t initialized;                        /*!< Set to `1` once thread is running */
+    int wake[2];                                /*!< Pipe to wake up emulator thread when library sends data */
+
+    uint8_t in[EMU_IN_SIZE];                    /*!< Data from library waiting to be processed */
+    size_t in_len;                              /*!< Number of bytes in input buffer */
+
+    char cmd[EMU_CMD_SIZE];                     /*!< Current AT command line */
+    size_t cmd_len;                             /*!< Length of command line */
+
+    int data_link;                              /*!< Link in data mode after `CIPSEND` or `-1` */
+    size_t data_len;                            /*!< Number of bytes to receive in data mode */
+    size_t data_recv;                           /*!< Number of already received bytes in data mode */
+    uint8_t data[ESP_CFG_CONN_MAX_DATA_LEN];    /*!< Data received in data mode */
+    struct sockaddr_in data_remote;             /*!< Remote address for UDP data */
+    uint8_t data_remote_set;                    /*!< Set to `1` when UDP data use address from `CIPSEND` */
+
+    uint8_t dinfo;                              /*!< Set to `1` when +IPD includes remote IP and port */
+    uint8_t recv_mode;                          /*!< Set to `1` for manual TCP receive with `AT+CIPRECVDATA` */
+    int server_fd;                              /*!< Listening socket or `-1` */
+    size_t server_max_conn;                     /*!< Maximal number of server connections */
+
+    uint8_t out[EMU_OUT_SIZE];                  /*!< Data waiting to be sent to library */
+    size_t out_len;                             /*!< Number of bytes waiting */
+
+    emu_link_t links[EMU_MAX_LINKS];            /*!< List of links */
+} esp_emu_t;
+
+static esp_emu_t emu = {
+    .data_link = -1,
+    .server_fd = -1,
+    .server_max_conn = EMU_MAX_LINKS,
+};
+
+/**
+ * \brief           Increase statistics counter
+ * \param[in]       cnt: Counter to increase
+ * \param[in]       val: Value to add
+ */
+static void
+emu_count(uint32_t* cnt, uint32_t val) {
+    esp_sys_mutex_lock(&emu.mutex);
+    *cnt += val;
+    esp_sys_mutex_unlock(&emu.mutex);
+}
+
+/**
+ * \brief           Write data to library output buffer
+ * \param[in]       data: Data to write
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+emu_out(const void* data, size_t len) {
+    if (emu.out_len + len <= sizeof(emu.out)) {
+        memcpy(&emu.out[emu.out_len], data, len);
+        emu.out_len += len;
+    }
+}
+
+/**
+ * \brief           Write formatted string to library output buffer
+ * \param[in]       fmt: Format string
+ */
+static void
+emu_outf(const char* fmt, ...) {
+    char str[256];
+    va_list va;
+    int len;
+
+    va_start(va, fmt);
+    len = vsnprintf(str, sizeof(str), fmt, va);
+    va_end(va);
+    if (len > 0) {
+        emu_out(str, ESP_MIN((size_t)len, sizeof(str) - 1));
+    }
+}
+
+/**
+ * \brief           Resolve host name to IPv4 address
+ * \param[in]       host: Host name or IP address
+ * \param[in]       port: Port number
+ * \param[out]      addr: Output address
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+emu_resolve(const char* host, esp_port_t port, struct sockaddr_in* addr) {
+    struct addrinfo hints, *res;
+
+    memset(&hints, 0x00, sizeof(hints));
+    hints.ai_family = AF_INET;
+    if (getaddrinfo(host, NULL, &hints, &res) != 0 || res == NULL) {
+        return 0;
+    }
+    memcpy(addr, res->ai_addr, sizeof(*addr));
+    addr->sin_port = htons(port);
+    freeaddrinfo(res);
+    return 1;
+}
+
+/**
+ * \brief           Get local port of socket
+ * \param[in]       fd: Socket descriptor
+ * \return          Local port
+ */
+static esp_port_t
+emu_local_port(int fd) {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+
+    if (getsockname(fd, (struct sockaddr *)&addr, &len) != 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+/**
+ * \brief           Connect TCP socket with timeout
+ * \param[in]       addr: Remote address
+ * \return          Socket descriptor on success, `-1` otherwise
+ */
+static int
+emu_tcp_connect(const struct sockaddr_in* addr) {
+    struct pollfd pfd;
+    int fd, flags, err = 0, one = 1;
+    socklen_t len = sizeof(err);
+
+    if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        return -1;
+    }
+    flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    if (connect(fd, (const struct sockaddr *)addr, sizeof(*addr)) != 0) {
+        if (errno != EINPROGRESS) {
+            close(fd);
+            return -1;
+        }
+        pfd.fd = fd;
+        pfd.events = POLLOUT;
+        if (poll(&pfd, 1, emu.cfg.connect_timeout > 0 ? (int)emu.cfg.connect_timeout : EMU_CONNECT_TIMEOUT) != 1
+            || getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    fcntl(fd, F_SETFL, flags);                  /* Writes are blocking, reads are done after poll */
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+/**
+ * \brief           Activate link and notify library with `+LINK_CONN`
+ * \param[in]       num: Link number
+ * \param[in]       fd: Socket descriptor
+ * \param[in]       is_server: Set to `1` when link was accepted by server
+ * \param[in]       is_udp: Set to `1` for UDP link
+ * \param[in]       remote: Remote address
+ */
+static void
+link_open(int num, int fd, uint8_t is_server, uint8_t is_udp, const struct sockaddr_in* remote) {
+    emu_link_t* l = &emu.links[num];
+
+    l->fd = fd;
+    l->is_server = is_server;
+    l->is_udp = is_udp;
+    l->remote = *remote;
+    l->local_port = emu_local_port(fd);
+    l->notified = 0;
+    emu_count(&emu.stats.conns_opened, 1);
+
+    emu_outf("+LINK_CONN:0,%d,\"%s\",%d,\"%s\",%d,%d\r\n", num, is_udp ? "UDP" : "TCP", (int)is_server,
+        inet_ntoa(l->remote.sin_addr), (int)ntohs(l->remote.sin_port), (int)l->local_port);
+}
+
+/**
+ * \brief           Close link
+ * \param[in]       num: Link number
+ * \param[in]       notify: Set to `1` to send `CLOSED` notification to library
+ */
+static void
+link_close(int num, uint8_t notify) {
+    emu_link_t* l = &emu.links[num];
+
+    if (l->fd < 0) {
+        return;
+    }
+    close(l->fd);
+    l->fd = -1;
+    emu_count(&emu.stats.conns_closed, 1);
+    if (notify) {
+        emu_outf("%d,CLOSED\r\n", num);
+    }
+}
+
+/**
+ * \brief           Close all links and listening socket
+ */
+static void
+emu_close_all(void) {
+    for (int i = 0; i < EMU_MAX_LINKS; ++i) {
+        link_close(i, 0);
+    }
+    if (emu.server_fd >= 0) {
+        close(emu.server_fd);
+        emu.server_fd = -1;
+    }
+}
+
+/**
+ * \brief           Start listening socket for `AT+CIPSERVER`
+ * \param[in]       port: Local port
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+emu_server_start(esp_port_t port) {
+    struct sockaddr_in addr;
+    int fd, one = 1;
+
+    if (emu.server_fd >= 0) {
+        close(emu.server_fd);
+        emu.server_fd = -1;
+    }
+    memset(&addr, 0x00, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, emu.cfg.server_addr != NULL ? emu.cfg.server_addr : EMU_SERVER_ADDR, &addr.sin_addr) != 1
+        || (fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        return 0;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+        close(fd);
+        return 0;
+    }
+    emu.server_fd = fd;
+    return 1;
+}
+
+/**
+ * \brief           Get number of bytes available to read on link
+ * \param[in]       num: Link number
+ * \return          Number of bytes in socket receive buffer
+ */
+static size_t
+emu_link_available(int num) {
+    int avail = 0;
+
+    if (emu.links[num].fd < 0 || ioctl(emu.links[num].fd, FIONREAD, &avail) != 0 || avail < 0) {
+        return 0;
+    }
+    return (size_t)avail;
+}
+
+/**
+ * \brief           Process `AT+CIPRECVDATA` command in manual TCP receive mode
+ * \param[in]       num: Link number
+ * \param[in]       len: Maximal number of bytes to read
+ */
+static void
+emu_ciprecvdata(int num, size_t len) {
+    static uint8_t buff[ESP_CFG_CONN_MAX_DATA_LEN];
+    emu_link_t* l;
+    ssize_t res;
+
+    if (num < 0 || num >= EMU_MAX_LINKS || emu.links[num].fd < 0 || len == 0) {
+        emu_outf("\r\nERROR\r\n");
+        return;
+    }
+    l = &emu.links[num];
+    res = recv(l->fd, buff, ESP_MIN(len, sizeof(buff)), MSG_DONTWAIT);
+    if (res <= 0) {
+        emu_outf("\r\nERROR\r\n");
+        return;
+    }
+    emu_outf("+CIPRECVDATA:%d,\"%s\",%d,", (int)res, inet_ntoa(l->remote.sin_addr), (int)ntohs(l->remote.sin_port));
+    emu_out(buff, (size_t)res);
+    emu_outf("\r\nOK\r\n");
+    emu_count(&emu.stats.bytes_rx, (uint32_t)res);
+    l->notified = 0;                            /* Data may arrive after AT+CIPRECVLEN, socket is polled to report them */
+}
+
+/**
+ * \brief           Process `AT+CIPSTART` command
+ * \param[in]       num: Link number
+ * \param[in]       type: Connection type string
+ * \param[in]       host: Remote host
+ * \param[in]       port: Remote port
+ * \param[in]       opts: Command part after remote port
+ */
+static void
+emu_cipstart(int num, const char* type, const char* host, esp_port_t port, const char* opts) {
+    struct sockaddr_in remote, local;
+    unsigned short local_port = 0;
+    int fd;
+
+    if (num < 0 || num >= EMU_MAX_LINKS) {
+        emu_outf("\r\nERROR\r\n");
+        return;
+    } else if (emu.links[num].fd >= 0) {
+        emu_outf("ALREADY CONNECTED\r\n\r\nERROR\r\n");
+        return;
+    } else if (!emu_resolve(host, port, &remote)) {
+        emu_outf("DNS Fail\r\n\r\nERROR\r\n");
+        return;
+    }
+    if (!strcmp(type, "TCP")) {
+        if ((fd = emu_tcp_connect(&remote)) < 0) {
+            emu_outf("\r\nERROR\r\n");
+            return;
+        }
+        link_open(num, fd, 0, 0, &remote);
+    } else if (!strcmp(type, "UDP")) {
+        /* Options are ",<local port>,<mode>", local port may be empty */
+        sscanf(opts, ",%hu", &local_port);
+        memset(&local, 0x00, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = htons(local_port);
+        if ((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+            emu_outf("\r\nERROR\r\n");
+            return;
+        }
+        if (bind(fd, (struct sockaddr *)&local, sizeof(local)) != 0) {
+            close(fd);
+            emu_outf("\r\nERROR\r\n");
+            return;
+        }
+        link_open(num, fd, 0, 1, &remote);
+    } else {                                    /* SSL is not supported by emulator */
+        emu_outf("\r\nERROR\r\n");
+        return;
+    }
+    emu_outf("\r\nOK\r\n");
+}
+
+/**
+ * \brief           Process single AT command line
+ * \param[in]       cmd: Command string without line ending
+ */
+static void
+emu_process_cmd(const char* cmd) {
+    int num, val, n = 0;
+    unsigned len;
+    char type[4], host[64], ip[16];
+    unsigned short port;
+    struct sockaddr_in addr;
+
+    emu_count(&emu.stats.cmds, 1);
+    if (!strcmp(cmd, "AT+RST") || !strcmp(cmd, "AT+RESTORE")) {
+        emu_close_all();
+        emu.dinfo = 0;
+        emu.recv_mode = 0;
+        emu_outf("\r\nOK\r\n\r\nready\r\n");
+    } else if (!strcmp(cmd, "AT+GMR")) {
+        emu_outf("AT version:2.1.0.0(emu)\r\nSDK version:v4.0.1\r\ncompile time:emu\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+BLEINIT?")) {
+        emu_outf("+BLEINIT:0\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CWDHCP?")) {
+        emu_outf("+CWDHCP:3\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CWMODE?")) {
+        emu_outf("+CWMODE:1\r\n\r\nOK\r\n");
+    } else if (!strncmp(cmd, "AT+CWJAP=", 9)) {
+        emu_outf("WIFI CONNECTED\r\nWIFI GOT IP\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CWJAP?")) {
+        emu_outf("+CWJAP:\"emu\",\"02:00:00:00:00:01\",6,-40\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CIPSTA?")) {
+        emu_outf("+CIPSTA:ip:\"127.0.0.1\"\r\n+CIPSTA:gateway:\"127.0.0.1\"\r\n+CIPSTA:netmask:\"255.0.0.0\"\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CIPSTAMAC?")) {
+        emu_outf("+CIPSTAMAC:\"02:00:00:00:00:10\"\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CIPAP?")) {
+        emu_outf("+CIPAP:ip:\"192.168.4.1\"\r\n+CIPAP:gateway:\"192.168.4.1\"\r\n+CIPAP:netmask:\"255.255.255.0\"\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CIPAPMAC?")) {
+        emu_outf("+CIPAPMAC:\"02:00:00:00:00:11\"\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CIPSTATUS")) {
+        emu_outf("STATUS:2\r\n");
+        for (int i = 0; i < EMU_MAX_LINKS; ++i) {
+            emu_link_t* l = &emu.links[i];
+            if (l->fd >= 0) {
+                emu_outf("+CIPSTATUS:%d,\"%s\",\"%s\",%d,%d,%d\r\n", i, l->is_udp ? "UDP" : "TCP",
+                    inet_ntoa(l->remote.sin_addr), (int)ntohs(l->remote.sin_port), (int)l->local_port, (int)l->is_server);
+            }
+        }
+        emu_outf("\r\nOK\r\n");
+    } else if (sscanf(cmd, "AT+CIPDINFO=%d", &val) == 1) {
+        emu.dinfo = !!val;
+        emu_outf("\r\nOK\r\n");
+    } else if (sscanf(cmd, "AT+CIPRECVMODE=%d", &val) == 1) {
+        emu.recv_mode = !!val;
+        emu_outf("\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CIPRECVLEN?")) {
+        emu_outf("+CIPRECVLEN:");
+        for (int i = 0; i < EMU_MAX_LINKS; ++i) {
+            size_t avail = emu.links[i].is_udp ? 0 : emu_link_available(i);
+            emu.links[i].notified = avail;
+            emu_outf(i > 0 ? ",%d" : "%d", (int)avail);
+        }
+        emu_outf("\r\n\r\nOK\r\n");
+    } else if (sscanf(cmd, "AT+CIPRECVDATA=%d,%u", &num, &len) == 2) {
+        emu_ciprecvdata(num, len);
+    } else if (sscanf(cmd, "AT+CIPDOMAIN=\"%63[^\"]\"", host) == 1) {
+        if (emu_resolve(host, 0, &addr)) {
+            emu_outf("+CIPDOMAIN:%s\r\n\r\nOK\r\n", inet_ntoa(addr.sin_addr));
+        } else {
+            emu_outf("DNS Fail\r\n\r\nERROR\r\n");
+        }
+    } else if (sscanf(cmd, "AT+CIPSERVERMAXCONN=%d", &val) == 1) {
+        emu.server_max_conn = val > 0 && val <= EMU_MAX_LINKS ? (size_t)val : EMU_MAX_LINKS;
+        emu_outf("\r\nOK\r\n");
+    } else if (sscanf(cmd, "AT+CIPSERVER=%d,%hu", &val, &port) >= 1) {
+        if (!val) {
+            if (emu.server_fd >= 0) {
+                close(emu.server_fd);
+                emu.server_fd = -1;
+            }
+            emu_outf("\r\nOK\r\n");
+        } else if (emu_server_start(port > 0 ? port : 333)) {
+            emu_outf("\r\nOK\r\n");
+        } else {
+            emu_outf("\r\nERROR\r\n");
+        }
+    } else if (sscanf(cmd, "AT+CIPSTART=%d,\"%3[A-Z]\",\"%63[^\"]\",%hu%n", &num, type, host, &port, &n) == 4) {
+        emu_cipstart(num, type, host, port, &cmd[n]);
+    } else if (sscanf(cmd, "AT+CIPSEND=%d,%u", &num, &len) == 2) {
+        if (num < 0 || num >= EMU_MAX_LINKS || emu.links[num].fd < 0) {
+            emu_outf("link is not valid\r\n\r\nERROR\r\n");
+        } else if (len == 0 || len > sizeof(emu.data)) {
+            emu_outf("\r\nERROR\r\n");
+        } else {
+            emu.data_remote_set = sscanf(cmd, "AT+CIPSEND=%d,%u,\"%15[^\"]\",%hu", &num, &len, ip, &port) == 4
+                                    && emu_resolve(ip, port, &emu.data_remote);
+            emu.data_link = num;
+            emu.data_len = len;
+            emu.data_recv = 0;
+            emu_outf("\r\nOK\r\n\r\n> ");
+        }
+    } else if (sscanf(cmd, "AT+CIPCLOSE=%d", &num) == 1) {
+        if (num >= EMU_MAX_LINKS) {
+            for (int i = 0; i < EMU_MAX_LINKS; ++i) {
+                link_close(i, 1);
+            }
+            emu_outf("\r\nOK\r\n");
+        } else if (num >= 0 && emu.links[num].fd >= 0) {
+            link_close(num, 1);
+            emu_outf("\r\nOK\r\n");
+        } else {
+            emu_outf("UNLINK\r\n\r\nERROR\r\n");
+        }
+    } else if (!strncmp(cmd, "AT+CIPSENDBUF", 13) || !strncmp(cmd, "AT+CIPSSL", 9) || !strncmp(cmd, "AT+PING", 7)) {
+        emu_outf("\r\nERROR\r\n");              /* Not available on host */
+    } else {
+        emu_outf("\r\nOK\r\n");                 /* Accept any other command */
+    }
+}
+
+/**
+ * \brief           Finish data mode after all bytes were received and write data to socket
+ */
+static void
+emu_data_done(void) {
+    emu_link_t* l = &emu.links[emu.data_link];
+    const uint8_t* d = emu.data;
+    size_t rem = emu.data_len;
+    ssize_t res = -1;
+
+    emu_outf("\r\nRecv %d bytes\r\n", (int)emu.data_len);
+    if (l->fd >= 0) {
+        if (l->is_udp) {
+            const struct sockaddr_in* to = emu.data_remote_set ? &emu.data_remote : &l->remote;
+            res = sendto(l->fd, d, rem, 0, (const struct sockaddr *)to, sizeof(*to));
+            rem = res == (ssize_t)emu.data_len ? 0 : rem;
+        } else {
+            while (rem > 0 && (res = send(l->fd, d, rem, MSG_NOSIGNAL)) > 0) {
+                d += res;
+                rem -= (size_t)res;
+            }
+        }
+    }
+    if (l->fd >= 0 && rem == 0) {
+        emu_count(&emu.stats.bytes_tx, (uint32_t)emu.data_len);
+        emu_outf("\r\nSEND OK\r\n");
+    } else {
+        emu_outf("\r\nSEND FAIL\r\n");
+    }
+    emu.data_link = -1;
+}
+
+/**
+ * \brief           Process data received from library
+ * \param[in]       d: Data
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+emu_process_input(const uint8_t* d, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (emu.data_link >= 0) {
+            emu.data[emu.data_recv++] = d[i];
+            if (emu.data_recv == emu.data_len) {
+                emu_data_done();
+            }
+        } else if (d[i] == '\n') {
+            if (emu.cmd_len > 0 && emu.cmd[emu.cmd_len - 1] == '\r') {
+                --emu.cmd_len;
+            }
+            emu.cmd[emu.cmd_len] = 0;
+            if (emu.cmd_len > 0) {
+                emu_process_cmd(emu.cmd);
+            }
+            emu.cmd_len = 0;
+        } else if (emu.cmd_len < sizeof(emu.cmd) - 1) {
+            emu.cmd[emu.cmd_len++] = (char)d[i];
+        }
+    }
+}
+
+/**
+ * \brief           Accept incoming connection on listening socket
+ */
+static void
+emu_accept(void) {
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    size_t cnt = 0;
+    int fd, num = -1, one = 1;
+
+    if ((fd = accept(emu.server_fd, (struct sockaddr *)&addr, &addr_len)) < 0) {
+        return;
+    }
+    for (int i = 0; i < EMU_MAX_LINKS; ++i) {
+        if (emu.links[i].fd < 0) {
+            num = num < 0 ? i : num;            /* Module uses lowest free link */
+        } else if (emu.links[i].is_server) {
+            ++cnt;
+        }
+    }
+    if (num < 0 || cnt >= emu.server_max_conn) {
+        close(fd);
+        return;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    link_open(num, fd, 1, 0, &addr);
+}
+
+/**
+ * \brief           Read data from link socket and report it with `+IPD`
+ * \param[in]       num: Link number
+ */
+static void
+emu_link_read(int num) {
+    emu_link_t* l = &emu.links[num];
+    uint8_t buff[EMU_IPD_MAX_LEN];
+    struct sockaddr_in from = l->remote;
+    socklen_t from_len = sizeof(from);
+    ssize_t len;
+
+    if (emu.recv_mode && !l->is_udp) {
+        /* Manual receive mode only notifies available length, library reads with AT+CIPRECVDATA */
+        if (recv(l->fd, buff, 1, MSG_PEEK | MSG_DONTWAIT) == 0) {
+            link_close(num, 1);
+        } else if ((l->notified = emu_link_available(num)) > 0) {
+            emu_outf("\r\n+IPD,%d,%d\r\n", num, (int)l->notified);
+        }
+        return;
+    } else if (l->is_udp) {
+        len = recvfrom(l->fd, buff, sizeof(buff), MSG_DONTWAIT, (struct sockaddr *)&from, &from_len);
+    } else {
+        len = recv(l->fd, buff, sizeof(buff), MSG_DONTWAIT);
+    }
+    if (len > 0) {
+        if (emu.dinfo) {
+            emu_outf("\r\n+IPD,%d,%d,\"%s\",%d:", num, (int)len, inet_ntoa(from.sin_addr), (int)ntohs(from.sin_port));
+        } else {
+            emu_outf("\r\n+IPD,%d,%d:", num, (int)len);
+        }
+        emu_out(buff, (size_t)len);
+        emu_count(&emu.stats.bytes_rx, (uint32_t)len);
+    } else if (!l->is_udp && (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))) {
+        link_close(num, 1);                     /* Closed by remote side or failed */
+    }
+}
+
+/**
+ * \brief           Emulator thread, executes commands and delivers socket data to library
+ * \param[in]       arg: Thread argument, not used
+ */
+static void
+emu_thread(void* arg) {
+    static uint8_t in[EMU_IN_SIZE];
+    struct pollfd fds[EMU_MAX_LINKS + 2];
+    int links[EMU_MAX_LINKS + 2];
+    size_t nfds, in_len;
+    char dummy[64];
+
+    ESP_UNUSED(arg);
+    while (1) {
+        /* Wait for library data or socket events */
+        nfds = 0;
+        fds[nfds].fd = emu.wake[0];
+        fds[nfds++].events = POLLIN;
+        if (emu.server_fd >= 0) {
+            fds[nfds].fd = emu.server_fd;
+            fds[nfds++].events = POLLIN;
+        }
+        for (int i = 0; i < EMU_MAX_LINKS; ++i) {
+            /*
+             * Sockets are read only when output has space, TCP window provides flow control.
+             * In manual receive mode, link with already reported data waits for AT+CIPRECVDATA
+             */
+            if (emu.links[i].fd >= 0 && emu.data_link < 0
+                && emu.out_len + EMU_IPD_MAX_LEN + 64 <= sizeof(emu.out)
+                && (!emu.recv_mode || emu.links[i].is_udp || emu.links[i].notified == 0)) {
+                links[nfds] = i;
+                fds[nfds].fd = emu.links[i].fd;
+                fds[nfds++].events = POLLIN;
+            }
+        }
+        poll(fds, nfds, 10);
+
+        /* Process commands and data from library */
+        if (fds[0].revents & POLLIN) {
+            while (read(emu.wake[0], dummy, sizeof(dummy)) == sizeof(dummy)) {}
+        }
+        esp_sys_mutex_lock(&emu.mutex);
+        in_len = emu.in_len;
+        memcpy(in, emu.in, in_len);
+        emu.in_len = 0;
+        esp_sys_mutex_unlock(&emu.mutex);
+        emu_process_input(in, in_len);
+
+        /* Process socket events */
+        for (size_t i = 1; i < nfds; ++i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            if (fds[i].fd == emu.server_fd) {
+                emu_accept();
+            } else if (emu.links[links[i]].fd == fds[i].fd) {   /* Link may be closed by command in between */
+                emu_link_read(links[i]);
+            }
+        }
+
+        /* Deliver output to library */
+        if (emu.out_len > 0) {
+#if ESP_EMU_FRAME
+            esp_ll_frame_loop_output(emu.out, emu.out_len);
+#elif ESP_CFG_INPUT_USE_PROCESS
+            esp_input_process(emu.out, emu.out_len);
+#else /* ESP_CFG_INPUT_USE_PROCESS */
+            esp_input(emu.out, emu.out_len);
+#endif /* !ESP_EMU_FRAME && !ESP_CFG_INPUT_USE_PROCESS */
+            emu.out_len = 0;
+        }
+    }
+}
+
+/**
+ * \brief           Receive data sent by library to module
+ * \param[in]       data: Data to send. `NULL` for flush
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Number of bytes accepted
+ */
+static size_t
+emu_send(const void* data, size_t len) {
+    const uint8_t* d = data;
+    size_t n, rem = len;
+
+    if (data == NULL) {
+        return 0;
+    }
+    while (rem > 0) {
+        esp_sys_mutex_lock(&emu.mutex);
+        n = ESP_MIN(rem, sizeof(emu.in) - emu.in_len);
+        memcpy(&emu.in[emu.in_len], d, n);
+        emu.in_len += n;
+        esp_sys_mutex_unlock(&emu.mutex);
+        if (write(emu.wake[1], "", 1) < 0) {}   /* Wake up emulator thread */
+        d += n;
+        rem -= n;
+        if (rem > 0) {
+            esp_delay(1);                       /* Input buffer is full, like UART without flow control space */
+        }
+    }
+    return len;
+}
+
+/**
+ * \brief           Start emulator thread
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+emu_start(void) {
+    if (!emu.initialized) {
+        for (int i = 0; i < EMU_MAX_LINKS; ++i) {
+            emu.links[i].fd = -1;
+        }
+        if (pipe(emu.wake) != 0) {
+            return 0;
+        }
+        fcntl(emu.wake[0], F_SETFL, fcntl(emu.wake[0], F_GETFL, 0) | O_NONBLOCK);
+        fcntl(emu.wake[1], F_SETFL, fcntl(emu.wake[1], F_GETFL, 0) | O_NONBLOCK);
+        esp_sys_mutex_create(&emu.mutex);
+        esp_sys_thread_create(NULL, "esp_emu", emu_thread, NULL, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO);
+        emu.initialized = 1;
+    }
+    return 1;
+}
+
+#endif /* !__DOXYGEN__ */
+
+/**
+ * \brief           Set emulator configuration
+ * \note            Must be called before \ref esp_init to take effect from first command
+ * \param[in]       config: New configuration
+ */
+void
+esp_emu_set_config(const esp_emu_config_t* config) {
+    emu.cfg = *config;
+}
+
+/**
+ * \brief           Get emulator statistics
+ * \param[out]      stats: Output statistics
+ */
+void
+esp_emu_get_stats(esp_emu_stats_t* stats) {
+    esp_sys_mutex_lock(&emu.mutex);
+    *stats = emu.stats;
+    esp_sys_mutex_unlock(&emu.mutex);
+}
+
+#if ESP_EMU_FRAME
+
+/**
+ * \brief           Attach emulator as module behind framed transport loopback link
+ * \note            Must be called before \ref esp_init
+ */
+void
+esp_emu_frame_attach(void) {
+    static const esp_ll_frame_loop_module_t module = {
+        .init_fn = emu_start,
+        .input_fn = emu_send,
+    };
+
+    esp_ll_frame_loop_set_module(&module);
+    esp_ll_frame_set_link(esp_ll_frame_loop_get_link());
+}
+
+#else /* ESP_EMU_FRAME */
+
+/**
+ * \brief           Callback function called from initialization process
+ * \note            This function may be called multiple times if AT baudrate is changed from application
+ * \param[in,out]   ll: Pointer to \ref esp_ll_t structure to fill data for communication functions
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_ll_init(esp_ll_t* ll) {
+    if (!emu_start()) {
+        return espERR;
+    }
+    ll->send_fn = emu_send;
+    return espOK;
+}
+
+/**
+ * \brief           Callback function to de-init low-level communication part
+ * \param[in,out]   ll: Pointer to \ref esp_ll_t structure to fill data for communication functions
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_ll_deinit(esp_ll_t* ll) {
+    ESP_UNUSED(ll);
+    return espOK;
+}
+
+#endif /* !ESP_EMU_FRAME */
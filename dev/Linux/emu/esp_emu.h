@@ -0,0 +1,106 @@
+/**
+ * \file            esp_emu.h
+ * \brief           ESP AT module emulator backed by host sockets
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_EMU_H
+#define ESP_HDR_EMU_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "esp/esp.h"
+
+/**
+ * \defgroup        ESP_EMU Socket emulator
+ * \brief           In-process ESP AT module emulator backed by real host sockets
+ * \{
+ *
+ * Emulator answers AT commands sent by the library and executes network commands on host:
+ *
+ *  - `AT+CIPSTART` opens real \e TCP or \e UDP socket, \e SSL is not supported
+ *  - `AT+CIPSEND` writes data to socket, received data are reported with `+IPD`
+ *  - `AT+CIPRECVMODE=1` keeps received data in host socket until `AT+CIPRECVDATA`
+ *  - `AT+CIPSERVER` listens on configured local address
+ *  - `AT+CIPDOMAIN` resolves host name with host resolver
+ *
+ * Station is always connected. Other commands are accepted with `OK`,
+ * commands not available on host answer with `ERROR`.
+ */
+
+/**
+ * \brief           Enables `1` or disables `0` running emulator as module behind
+ *                  \ref ESP_LL_FRAME_LOOP instead of as low-level driver
+ *
+ * \note            Framed transport driver then implements \ref esp_ll_init,
+ *                  application calls \ref esp_emu_frame_attach before \ref esp_init
+ */
+#ifndef ESP_EMU_FRAME
+#define ESP_EMU_FRAME                       0
+#endif
+
+/**
+ * \brief           Emulator configuration
+ */
+typedef struct {
+    const char* server_addr;                    /*!< Local address for `AT+CIPSERVER` listening socket.
+                                                    Set to `NULL` to use `127.0.0.1` */
+    uint32_t connect_timeout;                   /*!< Timeout for `AT+CIPSTART` in units of milliseconds.
+                                                    Set to `0` to use default value */
+} esp_emu_config_t;
+
+/**
+ * \brief           Emulator statistics
+ */
+typedef struct {
+    uint32_t cmds;                              /*!< Number of processed AT commands */
+    uint32_t conns_opened;                      /*!< Number of opened connections, both directions */
+    uint32_t conns_closed;                      /*!< Number of closed connections */
+    uint32_t bytes_tx;                          /*!< Number of bytes written to host sockets */
+    uint32_t bytes_rx;                          /*!< Number of bytes received from host sockets */
+} esp_emu_stats_t;
+
+void    esp_emu_set_config(const esp_emu_config_t* config);
+void    esp_emu_get_stats(esp_emu_stats_t* stats);
+#if ESP_EMU_FRAME || __DOXYGEN__
+void    esp_emu_frame_attach(void);
+#endif /* ESP_EMU_FRAME || __DOXYGEN__ */
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ESP_HDR_EMU_H */
@@ -0,0 +1,100 @@
+/**
+ * \file            esp_config.h
+ * \brief           Configuration for ESP soak test on Linux
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_CONFIG_H
+#define ESP_HDR_CONFIG_H
+
+/* User specific config which overwrites setup from esp_config_default.h file */
+
+#if !__DOXYGEN__
+#define ESP_CFG_NETCONN                     1
+#define ESP_CFG_NETCONN_RECEIVE_QUEUE_LEN   16
+
+#define ESP_CFG_DBG                         ESP_DBG_OFF
+
+/* Internal allocator is required for heap statistics */
+#define ESP_CFG_MEM_CUSTOM                  0
+#define ESP_CFG_MEM_AFFINITY                1
+
+#define ESP_CFG_ESP32                       1
+#define ESP_CFG_ESP8266                     1
+
+#define ESP_CFG_RCV_BUFF_SIZE               0x1000
+#define ESP_CFG_IPD_ADAPTIVE                1
+#define ESP_CFG_IPD_INFO_POLICY             1
+#define ESP_CFG_CONN_MAX_DATA_LEN           2048
+#define ESP_CFG_CONN_SENDBUF                1
+#define ESP_CFG_CONN_RATE_LIMIT             1
+#define ESP_CFG_CONN_ADAPTIVE_CHUNK         1
+/* Builds with framed transport disable it, their driver thread may not wait for core lock */
+#ifndef ESP_CFG_INPUT_USE_PROCESS
+#define ESP_CFG_INPUT_USE_PROCESS           1
+#endif
+#define ESP_CFG_AT_ECHO                     0
+
+#define ESP_CFG_USE_API_FUNC_EVT            1
+
+#define ESP_CFG_MAX_CONNS                   5
+
+#define ESP_CFG_DNS                         1
+#define ESP_CFG_PING                        1
+
+#define ESP_CFG_PM                          1
+
+#define ESP_CFG_LINKQ                       1
+
+#define ESP_CFG_RESET_ON_INIT               1
+
+#define ESP_CFG_THREAD_STACK_STATS          1
+
+#define ESP_CFG_CAPTURE                     1
+
+/* Microsecond monotonic time of POSIX ports, shared by capture records and event timestamps */
+#define ESP_CFG_CAPTURE_TIME_US()           esp_sys_posix_now_us()
+#define ESP_CFG_EVT_TIMESTAMP_NOW()         ((uint32_t)esp_sys_posix_now_us())
+
+#define ESP_CFG_EVT_TIMESTAMP               1
+#define ESP_CFG_EVT_POLL                    1
+
+#define ESP_CFG_MQTT_METRICS                1
+
+#define HTTP_USE_METRICS                    1
+#define HTTP_USE_METRICS_STATUS             1
+#define HTTP_FS_POSIX_ROOT                  "../../www"
+
+#endif /* !__DOXYGEN__ */
+
+/* Include default configuration setup */
+#include "esp/esp_config_default.h"
+
+#endif /* ESP_HDR_CONFIG_H */
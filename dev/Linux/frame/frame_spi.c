@@ -0,0 +1,124 @@
+/**
+ * \file            frame_spi.c
+ * \brief           Framed transport over SPI test tool
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "esp/esp.h"
+#include "system/esp_ll_frame_spi.h"
+
+/**
+ * \brief           Event callback function for ESP stack
+ * \param[in]       evt: Event information with data
+ * \return          \ref espOK on success, member of \ref espr_t otherwise
+ */
+static espr_t
+frame_spi_evt(esp_evt_t* evt) {
+    ESP_UNUSED(evt);
+    return espOK;
+}
+
+/**
+ * \brief           Get monotonic time, independent of library system time
+ * \return          Time in units of milliseconds
+ */
+static uint32_t
+frame_spi_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/**
+ * \brief           Program entry point
+ *
+ * Usage: `esp_frame_spi <spidev> <gpiochip> <handshake_line> [count] [reset_line]`
+ *
+ * Library is initialized over SPI link, then `count` blocking
+ * commands are executed and their round-trip time is reported
+ * together with transport statistics.
+ *
+ * \return          `0` on success, `1` otherwise
+ */
+int
+main(int argc, char** argv) {
+    esp_ll_frame_spi_config_t cfg = { 0 };
+    esp_ll_frame_stats_t fs;
+    esp_sw_version_t ver;
+    esp_mode_t mode;
+    uint32_t count, start, t, sum = 0, max = 0, failed = 0;
+
+    if (argc < 4) {
+        printf("Usage: %s <spidev> <gpiochip> <handshake_line> [count] [reset_line]\r\n", argv[0]);
+        return 1;
+    }
+    cfg.dev = argv[1];
+    cfg.gpio_chip = argv[2];
+    cfg.hs_line = (uint32_t)strtoul(argv[3], NULL, 0);
+    count = argc > 4 ? (uint32_t)strtoul(argv[4], NULL, 0) : 100;
+    if (argc > 5) {
+        cfg.reset = 1;
+        cfg.reset_line = (uint32_t)strtoul(argv[5], NULL, 0);
+    }
+    esp_ll_frame_spi_set_config(&cfg);
+    esp_ll_frame_set_link(esp_ll_frame_spi_get_link());
+
+    start = frame_spi_now();
+    if (esp_init(frame_spi_evt, 1) != espOK) {
+        printf("Could not initialize library\r\n");
+        return 1;
+    }
+    esp_get_current_at_fw_version(&ver);
+    printf("Initialized in %u ms, AT version %u.%u.%u\r\n", (unsigned)(frame_spi_now() - start),
+        (unsigned)ver.major, (unsigned)ver.minor, (unsigned)ver.patch);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        start = frame_spi_now();
+        if (esp_get_wifi_mode(&mode, NULL, NULL, 1) != espOK) {
+            ++failed;
+            continue;
+        }
+        t = frame_spi_now() - start;
+        sum += t;
+        max = ESP_MAX(max, t);
+    }
+    printf("Commands: %u, failed: %u, round trip avg: %u ms, max: %u ms\r\n", (unsigned)count, (unsigned)failed,
+        (unsigned)(count > failed ? sum / (count - failed) : 0), (unsigned)max);
+
+    esp_ll_frame_get_stats(&fs);
+    printf("Frames: %u transactions, %u/%u transfers sent/received, %u/%u status/sequence errors, %u request retries\r\n",
+        (unsigned)fs.transactions, (unsigned)fs.frames_tx, (unsigned)fs.frames_rx,
+        (unsigned)fs.status_errors, (unsigned)fs.seq_errors, (unsigned)fs.request_retries);
+    return failed > 0;
+}
@@ -0,0 +1,116 @@
+/**
+ * \file            ll_tcp.c
+ * \brief           AT command latency test over TCP serial bridge
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp/esp.h"
+#include "system/esp_ll_tcp.h"
+
+/**
+ * \brief           Event callback function for ESP stack
+ * \param[in]       evt: Event information with data
+ * \return          \ref espOK on success, member of \ref espr_t otherwise
+ */
+static espr_t
+ll_tcp_evt(esp_evt_t* evt) {
+    ESP_UNUSED(evt);
+    return espOK;
+}
+
+/**
+ * \brief           Get monotonic time, independent of library system time
+ * \return          Time in units of milliseconds
+ */
+static uint32_t
+ll_tcp_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/**
+ * \brief           Program entry point
+ *
+ * Usage: `esp_ll_tcp <host> <port> [raw|rfc2217] [count] [flow]`
+ *
+ * Library is initialized over the bridge, then `count` blocking
+ * commands are executed and their round-trip time is reported.
+ * Bridge may be any serial device server, for example
+ * `socat TCP-LISTEN:4000,reuseaddr,nodelay /dev/ttyUSB0,b115200,raw,echo=0`
+ *
+ * \return          `0` on success, `1` otherwise
+ */
+int
+main(int argc, char** argv) {
+    esp_ll_tcp_config_t cfg = { 0 };
+    esp_sw_version_t ver;
+    esp_mode_t mode;
+    uint32_t count, start, t, sum = 0, max = 0, failed = 0;
+
+    if (argc < 3) {
+        printf("Usage: %s <host> <port> [raw|rfc2217] [count] [flow]\r\n", argv[0]);
+        return 1;
+    }
+    cfg.host = argv[1];
+    cfg.port = (uint16_t)strtoul(argv[2], NULL, 0);
+    cfg.rfc2217 = argc > 3 && !strcmp(argv[3], "rfc2217");
+    count = argc > 4 ? (uint32_t)strtoul(argv[4], NULL, 0) : 100;
+    cfg.flow_control = argc > 5 && !strcmp(argv[5], "flow");
+    esp_ll_tcp_set_config(&cfg);
+
+    start = ll_tcp_now();
+    if (esp_init(ll_tcp_evt, 1) != espOK) {
+        printf("Could not initialize library, bridge %sconnected\r\n", esp_ll_tcp_is_connected() ? "" : "not ");
+        return 1;
+    }
+    esp_get_current_at_fw_version(&ver);
+    printf("Initialized in %u ms, AT version %u.%u.%u\r\n", (unsigned)(ll_tcp_now() - start),
+        (unsigned)ver.major, (unsigned)ver.minor, (unsigned)ver.patch);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        start = ll_tcp_now();
+        if (esp_get_wifi_mode(&mode, NULL, NULL, 1) != espOK) {
+            ++failed;
+            continue;
+        }
+        t = ll_tcp_now() - start;
+        sum += t;
+        max = ESP_MAX(max, t);
+    }
+    printf("Commands: %u, failed: %u, round trip avg: %u ms, max: %u ms\r\n", (unsigned)count, (unsigned)failed,
+        (unsigned)(count > failed ? sum / (count - failed) : 0), (unsigned)max);
+    return failed > 0;
+}
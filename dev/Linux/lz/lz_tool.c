@@ -0,0 +1,203 @@
+/**
+ * \file            lz_tool.c
+ * \brief           Host side LZ compression tool and benchmark
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp/esp.h"
+#include "esp/apps/esp_lz.h"
+
+#define LZ_TOOL_CHUNK_LEN           4096
+#define LZ_TOOL_UART_BAUD           115200
+
+static esp_lz_enc_t enc;
+static esp_lz_dec_t dec;
+
+/**
+ * \brief           Encoder output to file
+ */
+static size_t
+lz_tool_enc_out(esp_lz_enc_t* e, const void* data, size_t len) {
+    return fwrite(data, 1, len, e->arg);
+}
+
+/**
+ * \brief           Decoder output to file
+ */
+static espr_t
+lz_tool_dec_out(esp_lz_dec_t* d, const void* data, size_t len) {
+    return fwrite(data, 1, len, d->arg) == len ? espOK : espERR;
+}
+
+/**
+ * \brief           Compress or decompress standard input to standard output
+ * \param[in]       compress: Set to `1` to compress, `0` to decompress
+ * \return          Process exit code
+ */
+static int
+lz_tool_stream(uint8_t compress) {
+    static uint8_t chunk[LZ_TOOL_CHUNK_LEN];
+    espr_t res = espOK;
+    size_t len;
+
+    esp_lz_enc_init(&enc, lz_tool_enc_out, stdout);
+    esp_lz_dec_init(&dec, lz_tool_dec_out, stdout);
+    while (res == espOK && (len = fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+        res = compress ? esp_lz_enc_write(&enc, chunk, len) : esp_lz_dec_feed(&dec, chunk, len);
+    }
+    if (res == espOK && compress) {
+        res = esp_lz_enc_flush(&enc);
+    }
+    if (res != espOK) {
+        fprintf(stderr, "Failed with error %d\r\n", (int)res);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * \brief           Decoder output compared against original data
+ */
+static espr_t
+lz_tool_dec_verify(esp_lz_dec_t* d, const void* data, size_t len) {
+    const uint8_t** orig = d->arg;
+
+    if (memcmp(*orig, data, len)) {
+        return espERR;
+    }
+    *orig += len;
+    return espOK;
+}
+
+/**
+ * \brief           Get monotonic time in units of seconds
+ */
+static double
+lz_tool_time(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * \brief           Compress file in pieces of random size, verify round trip and print statistics
+ * \param[in]       path: Input file path
+ * \param[in]       baud: UART baudrate used to estimate transfer time
+ * \return          Process exit code
+ */
+static int
+lz_tool_bench(const char* path, uint32_t baud) {
+    uint8_t *in, *out;
+    const uint8_t* verify;
+    size_t in_len, out_size, off, len;
+    double t_enc, t_dec;
+    uint8_t ok;
+    FILE* f;
+
+    if ((f = fopen(path, "rb")) == NULL) {
+        fprintf(stderr, "Cannot open %s\r\n", path);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    in_len = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out_size = ESP_LZ_MAX_COMPRESSED_LEN(in_len) + 3 * (in_len / 1024 + 1);
+    in = malloc(in_len + 1);
+    out = malloc(out_size);
+    if (in == NULL || out == NULL || fread(in, 1, in_len, f) != in_len) {
+        fprintf(stderr, "Cannot read %s\r\n", path);
+        fclose(f);
+        free(in);
+        free(out);
+        return 1;
+    }
+    fclose(f);
+
+    /* Pieces of random size with occasional flush, as they come from application */
+    srand(1);
+    t_enc = lz_tool_time();
+    esp_lz_enc_init_buff(&enc, out, out_size);
+    for (off = 0; off < in_len; off += len) {
+        len = (size_t)(rand() % 1024 + 1);
+        len = ESP_MIN(in_len - off, len);
+        esp_lz_enc_write(&enc, &in[off], len);
+        if (rand() % 64 == 0) {
+            esp_lz_enc_flush(&enc);
+        }
+    }
+    esp_lz_enc_flush(&enc);
+    t_enc = lz_tool_time() - t_enc;
+
+    verify = in;
+    t_dec = lz_tool_time();
+    esp_lz_dec_init(&dec, lz_tool_dec_verify, &verify);
+    for (off = 0; off < enc.len && dec.res == espOK; off += len) {
+        len = (size_t)(rand() % 512 + 1);
+        len = ESP_MIN(enc.len - off, len);
+        esp_lz_dec_feed(&dec, &out[off], len);
+    }
+    t_dec = lz_tool_time() - t_dec;
+
+    printf("Window: %u bytes, max match: %u, encoder: %u bytes, decoder: %u bytes\r\n",
+        (unsigned)ESP_LZ_WINDOW_SIZE, (unsigned)ESP_LZ_MAX_MATCH, (unsigned)sizeof(enc), (unsigned)sizeof(dec));
+    printf("Input: %u bytes, compressed: %u bytes, ratio: %.2f\r\n",
+        (unsigned)in_len, (unsigned)enc.len, enc.len > 0 ? (double)in_len / enc.len : 0);
+    printf("Encode: %.1f MB/s, decode: %.1f MB/s\r\n",
+        in_len / 1e6 / (t_enc > 0 ? t_enc : 1e-9), in_len / 1e6 / (t_dec > 0 ? t_dec : 1e-9));
+    printf("UART %u baud: plain %.2f s, compressed %.2f s\r\n",
+        (unsigned)baud, in_len * 10.0 / baud, enc.len * 10.0 / baud);
+    ok = !enc.err && dec.res == espOK && verify == in + in_len;
+    printf("Round trip: %s\r\n", ok ? "OK" : "FAIL");
+
+    free(in);
+    free(out);
+    return ok ? 0 : 1;
+}
+
+/**
+ * \brief           Program entry point
+ */
+int
+main(int argc, char** argv) {
+    if (argc > 1 && !strcmp(argv[1], "c")) {
+        return lz_tool_stream(1);
+    } else if (argc > 1 && !strcmp(argv[1], "d")) {
+        return lz_tool_stream(0);
+    } else if (argc > 2 && !strcmp(argv[1], "bench")) {
+        return lz_tool_bench(argv[2], argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 0) : LZ_TOOL_UART_BAUD);
+    }
+    printf("Usage: %s c | d | bench <file> [baud]\r\n", argv[0]);
+    return 1;
+}
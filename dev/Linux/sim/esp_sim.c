@@ -0,0 +1,882 @@
+/**
+ * \file            esp_sim.c
+ * \brief           Simulated ESP AT module
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "esp/esp.h"
+#include "esp/esp_input.h"
+#include "system/esp_ll.h"
+#include "system/esp_sys.h"
+#include "esp_sim.h"
+
+#if !__DOXYGEN__
+
+#define SIM_MAX_LINKS               ESP_CFG_MAX_CONNS
+#define SIM_OUT_SIZE                0x10000
+#define SIM_PEER_IN_SIZE            0x800
+#define SIM_PEER_PEND_SIZE          0x2000
+#define SIM_CMD_SIZE                256
+#define SIM_IPD_MAX_LEN             1460
+#define SIM_IPD_SMALL_LEN           128
+#define SIM_REMOTE_IP               "10.0.0.2"
+#define SIM_SENDBUF_SEGMENTS        3
+
+/**
+ * \brief           Type of remote peer emulated on link
+ */
+typedef enum {
+    SIM_PEER_ECHO,                              /*!< Echo server */
+    SIM_PEER_MQTT,                              /*!< MQTT broker */
+    SIM_PEER_HTTP_SERVER,                       /*!< HTTP server for outgoing connections */
+    SIM_PEER_HTTP_CLIENT,                       /*!< HTTP client on incoming connections */
+} sim_peer_t;
+
+/**
+ * \brief           Single link on simulated module
+ */
+typedef struct {
+    uint8_t active;                             /*!< Link is active */
+    uint8_t is_server;                          /*!< Link was opened by remote side */
+    uint8_t close_after_send;                   /*!< Remote closes link once pending data are delivered */
+    char type[4];                               /*!< Link type string */
+    sim_peer_t peer;                            /*!< Remote peer type */
+    esp_port_t remote_port;                     /*!< Remote port */
+    esp_port_t local_port;                      /*!< Local port */
+    uint32_t close_time;                        /*!< Time when remote side closes link, `0` if never */
+    uint8_t in[SIM_PEER_IN_SIZE];               /*!< Data from host waiting for peer to process */
+    size_t in_len;                              /*!< Number of bytes in input buffer */
+    uint8_t pend[SIM_PEER_PEND_SIZE];           /*!< Data from peer waiting to be sent to host with +IPD */
+    size_t pend_len;                            /*!< Number of bytes in pending buffer */
+    uint32_t seg_id;                            /*!< Last segment ID queued with `AT+CIPSENDBUF` */
+    uint32_t seg_done;                          /*!< Last segment ID reported with `SEND OK` or `SEND FAIL` */
+    uint32_t seg_fail;                          /*!< First failed segment ID, `0` if none. Link closes once it is reported */
+} sim_link_t;
+
+/**
+ * \brief           Simulator state
+ */
+typedef struct {
+    esp_sim_config_t cfg;                       /*!< Active configuration */
+    esp_sim_stats_t stats;                      /*!< Statistics */
+    esp_sys_mutex_t mutex;                      /*!< Protects simulator state */
+    esp_sys_sem_t sem;                          /*!< Wakes up simulator thread */
+    uint8_t initialized;                        /*!< Set to `1` once thread is running */
+    uint32_t rnd;                               /*!< Random generator state */
+
+    char cmd[SIM_CMD_SIZE];                     /*!< Current AT command line */
+    size_t cmd_len;                             /*!< Length of command line */
+
+    int data_link;                              /*!< Link in data mode after `CIPSEND` or `-1` */
+    size_t data_len;                            /*!< Number of bytes to receive in data mode */
+    size_t data_recv;                           /*!< Number of already received bytes in data mode */
+    uint8_t data_buffered;                      /*!< Set to `1` when data mode was started with `AT+CIPSENDBUF` */
+    uint8_t data[ESP_CFG_CONN_MAX_DATA_LEN];    /*!< Data received in data mode */
+
+    uint8_t wifi;                               /*!< Set to `1` when station is connected */
+    uint8_t dinfo;                              /*!< Set to `1` when +IPD includes remote IP and port */
+    uint8_t server;                             /*!< Set to `1` when server is enabled */
+    esp_port_t server_port;                     /*!< Server port */
+    uint32_t next_incoming;                     /*!< Time of next incoming connection */
+    esp_port_t next_port;                       /*!< Next local port for client connections */
+
+    esp_sleep_mode_t sleep;                     /*!< Sleep mode set with `AT+SLEEP` */
+    uint8_t wakeup_pin;                         /*!< Set to `1` when wakeup pin is active */
+    uint32_t wakeup_time;                       /*!< Time when wakeup pin has been activated */
+    uint8_t deep_sleep;                         /*!< Set to `1` during deep sleep started with `AT+GSLP` */
+    uint32_t deep_sleep_end;                    /*!< Time when deep sleep ends with `ready` */
+
+    uint8_t out[SIM_OUT_SIZE];                  /*!< Data waiting to be sent to host */
+    size_t out_len;                             /*!< Number of bytes waiting */
+
+    sim_link_t links[SIM_MAX_LINKS];            /*!< List of links */
+} esp_sim_t;
+
+static esp_sim_t sim = {
+    .cfg = {
+        .seed = 1,
+        .send_fail_ratio = 0,
+        .remote_close_ratio = 0,
+        .server_conn_interval = 1000,
+        .http_body_max = 4096,
+    },
+    .data_link = -1,
+};
+
+/**
+ * \brief           Get next pseudo random number
+ * \return          Random number
+ */
+static uint32_t
+sim_rand(void) {
+    sim.rnd ^= sim.rnd << 13;
+    sim.rnd ^= sim.rnd >> 17;
+    sim.rnd ^= sim.rnd << 5;
+    return sim.rnd;
+}
+
+/**
+ * \brief           Check random event with percent probability
+ * \param[in]       ratio: Probability in units of percent
+ * \return          `1` when event happens, `0` otherwise
+ */
+static uint8_t
+sim_chance(uint8_t ratio) {
+    return ratio > 0 && (sim_rand() % 100) < ratio;
+}
+
+/**
+ * \brief           Write data to host output buffer
+ * \param[in]       data: Data to write
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+sim_out(const void* data, size_t len) {
+    if (sim.out_len + len <= sizeof(sim.out)) {
+        memcpy(&sim.out[sim.out_len], data, len);
+        sim.out_len += len;
+    }
+}
+
+/**
+ * \brief           Write formatted string to host output buffer
+ * \param[in]       fmt: Format string
+ */
+static void
+sim_outf(const char* fmt, ...) {
+    char str[256];
+    va_list va;
+    int len;
+
+    va_start(va, fmt);
+    len = vsnprintf(str, sizeof(str), fmt, va);
+    va_end(va);
+    if (len > 0) {
+        sim_out(str, ESP_MIN((size_t)len, sizeof(str) - 1));
+    }
+}
+
+/**
+ * \brief           Add data to link pending buffer, to be sent to host
+ * \param[in]       l: Link
+ * \param[in]       data: Data to add
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+link_pend(sim_link_t* l, const void* data, size_t len) {
+    len = ESP_MIN(len, sizeof(l->pend) - l->pend_len);
+    memcpy(&l->pend[l->pend_len], data, len);
+    l->pend_len += len;
+}
+
+/**
+ * \brief           Open new link
+ * \param[in]       num: Link number
+ * \param[in]       is_server: Set to `1` when link is opened by remote side
+ * \param[in]       type: Link type string
+ * \param[in]       peer: Peer type
+ * \param[in]       remote_port: Remote port
+ * \param[in]       local_port: Local port
+ */
+static void
+link_open(int num, uint8_t is_server, const char* type, sim_peer_t peer, esp_port_t remote_port, esp_port_t local_port) {
+    sim_link_t* l = &sim.links[num];
+
+    memset(l, 0x00, sizeof(*l));
+    l->active = 1;
+    l->is_server = is_server;
+    l->peer = peer;
+    l->remote_port = remote_port;
+    l->local_port = local_port;
+    strncpy(l->type, type, sizeof(l->type) - 1);
+    ++sim.stats.conns_opened;
+
+    sim_outf("+LINK_CONN:0,%d,\"%s\",%d,\"" SIM_REMOTE_IP "\",%d,%d\r\n",
+        num, l->type, (int)is_server, (int)remote_port, (int)local_port);
+}
+
+/**
+ * \brief           Close link
+ * \param[in]       num: Link number
+ * \param[in]       notify: Set to `1` to send `CLOSED` notification to host
+ */
+static void
+link_close(int num, uint8_t notify) {
+    sim_link_t* l = &sim.links[num];
+
+    if (!l->active) {
+        return;
+    }
+    l->active = 0;
+    ++sim.stats.conns_closed;
+    if (notify) {
+        sim_outf("%d,CLOSED\r\n", num);
+    }
+}
+
+/**
+ * \brief           Process MQTT packets received by broker
+ * \param[in]       l: Link
+ */
+static void
+mqtt_process(sim_link_t* l) {
+    uint8_t resp[4];
+    size_t rem, hdr, mult, i, tot;
+
+    while (l->in_len >= 2) {
+        /* Decode remaining length */
+        rem = 0;
+        mult = 1;
+        for (i = 1; i < l->in_len && i < 5; ++i) {
+            rem += (l->in[i] & 0x7F) * mult;
+            mult *= 128;
+            if (!(l->in[i] & 0x80)) {
+                break;
+            }
+        }
+        if (i >= l->in_len || i == 5) {
+            return;                             /* Header not complete */
+        }
+        hdr = i + 1;
+        tot = hdr + rem;
+        if (tot > l->in_len) {
+            if (tot > sizeof(l->in)) {          /* Packet can never fit, drop everything */
+                l->in_len = 0;
+            }
+            return;
+        }
+
+        switch (l->in[0] >> 4) {
+            case 1: {                           /* CONNECT */
+                resp[0] = 0x20; resp[1] = 0x02; resp[2] = 0x00; resp[3] = 0x00;
+                link_pend(l, resp, 4);
+                break;
+            }
+            case 3: {                           /* PUBLISH */
+                uint8_t qos = (l->in[0] >> 1) & 0x03;
+                size_t topic_len = ((size_t)l->in[hdr] << 8) | l->in[hdr + 1];
+                size_t off = hdr + 2 + topic_len, payload_len;
+                uint8_t h[5];
+                size_t h_len = 1, echo_rem;
+
+                if (qos > 0) {
+                    resp[0] = qos == 1 ? 0x40 : 0x50;
+                    resp[1] = 0x02;
+                    resp[2] = l->in[off];
+                    resp[3] = l->in[off + 1];
+                    link_pend(l, resp, 4);
+                    off += 2;
+                }
+
+                /* Echo message back with QoS 0 */
+                payload_len = tot - off;
+                echo_rem = 2 + topic_len + payload_len;
+                h[0] = 0x30;
+                do {
+                    h[h_len] = echo_rem & 0x7F;
+                    echo_rem >>= 7;
+                    if (echo_rem > 0) {
+                        h[h_len] |= 0x80;
+                    }
+                    ++h_len;
+                } while (echo_rem > 0);
+                if (l->pend_len + h_len + 2 + topic_len + payload_len <= sizeof(l->pend)) {
+                    link_pend(l, h, h_len);
+                    link_pend(l, &l->in[hdr], 2 + topic_len);
+                    link_pend(l, &l->in[off], payload_len);
+                }
+                break;
+            }
+            case 6: {                           /* PUBREL */
+                resp[0] = 0x70; resp[1] = 0x02; resp[2] = l->in[hdr]; resp[3] = l->in[hdr + 1];
+                link_pend(l, resp, 4);
+                break;
+            }
+            case 8: {                           /* SUBSCRIBE */
+                uint8_t suback[5] = {0x90, 0x03, l->in[hdr], l->in[hdr + 1], l->in[tot - 1] & 0x03};
+                link_pend(l, suback, sizeof(suback));
+                break;
+            }
+            case 10: {                          /* UNSUBSCRIBE */
+                resp[0] = 0xB0; resp[1] = 0x02; resp[2] = l->in[hdr]; resp[3] = l->in[hdr + 1];
+                link_pend(l, resp, 4);
+                break;
+            }
+            case 12: {                          /* PINGREQ */
+                resp[0] = 0xD0; resp[1] = 0x00;
+                link_pend(l, resp, 2);
+                break;
+            }
+            case 14: {                          /* DISCONNECT */
+                l->close_after_send = 1;
+                break;
+            }
+            default:
+                break;
+        }
+        memmove(l->in, &l->in[tot], l->in_len - tot);
+        l->in_len -= tot;
+    }
+}
+
+/**
+ * \brief           Process data host sent to remote peer
+ * \param[in]       l: Link
+ * \param[in]       data: Data sent by host
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+peer_input(sim_link_t* l, const uint8_t* data, size_t len) {
+    size_t n;
+
+    switch (l->peer) {
+        case SIM_PEER_ECHO: {
+            link_pend(l, data, len);
+            break;
+        }
+        case SIM_PEER_MQTT:
+        case SIM_PEER_HTTP_SERVER: {
+            n = ESP_MIN(len, sizeof(l->in) - l->in_len);
+            memcpy(&l->in[l->in_len], data, n);
+            l->in_len += n;
+            if (l->peer == SIM_PEER_MQTT) {
+                mqtt_process(l);
+            } else {
+                /* Respond once full request header is received */
+                for (size_t i = 3; i < l->in_len; ++i) {
+                    if (!memcmp(&l->in[i - 3], "\r\n\r\n", 4)) {
+                        char hdr[128];
+                        size_t body_len = sim.cfg.http_body_max > 0 ? sim_rand() % (sim.cfg.http_body_max + 1) : 0;
+                        int hdr_len;
+
+                        body_len = ESP_MIN(body_len, sizeof(l->pend) - sizeof(hdr));
+                        hdr_len = snprintf(hdr, sizeof(hdr), "HTTP/1.1 200 OK\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", (int)body_len);
+                        link_pend(l, hdr, hdr_len);
+                        for (size_t k = 0; k < body_len; ++k) {
+                            uint8_t ch = (uint8_t)('a' + (k % 26));
+                            link_pend(l, &ch, 1);
+                        }
+                        l->close_after_send = 1;
+                        l->in_len = 0;
+                        break;
+                    }
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    if (l->peer != SIM_PEER_HTTP_CLIENT && sim_chance(sim.cfg.remote_close_ratio)) {
+        l->close_after_send = 1;
+        ++sim.stats.remote_closes;
+    }
+}
+
+/**
+ * \brief           Process single AT command line
+ * \param[in]       cmd: Command string without line ending
+ */
+static void
+sim_process_cmd(const char* cmd) {
+    int num, val;
+    unsigned len;
+    char type[4], host[64];
+    unsigned short port;
+
+    ++sim.stats.cmds;
+    if (sim.sleep != ESP_SLEEP_NONE && strncmp(cmd, "AT+SLEEP", 8)) {
+        ++sim.stats.sleep_cmds;                 /* Host must wake module up first */
+    }
+    if (!strcmp(cmd, "AT+RST") || !strcmp(cmd, "AT+RESTORE")) {
+        for (int i = 0; i < SIM_MAX_LINKS; ++i) {
+            sim.links[i].active = 0;
+        }
+        sim.wifi = 0;
+        sim.server = 0;
+        sim.sleep = ESP_SLEEP_NONE;
+        sim_outf("\r\nOK\r\n\r\nready\r\n");
+    } else if (sscanf(cmd, "AT+SLEEP=%d", &val) == 1) {
+        if (val < 0 || val > 2) {
+            sim_outf("\r\nERROR\r\n");
+        } else {
+            if (val == 0) {
+                if (sim.sleep != ESP_SLEEP_NONE) {
+                    ++sim.stats.wakeups;
+                }
+                sim.sleep = ESP_SLEEP_NONE;
+            } else {
+                /* ESP8266 uses 1 for light sleep, ESP32 uses 1 for modem sleep */
+                sim.sleep = (val == 1) == !!sim.cfg.esp8266 ? ESP_SLEEP_LIGHT : ESP_SLEEP_MODEM;
+                ++sim.stats.sleeps;
+            }
+            sim_outf("\r\nOK\r\n");
+        }
+    } else if (!strcmp(cmd, "AT+SLEEP?")) {
+        val = sim.sleep == ESP_SLEEP_NONE ? 0 : (sim.sleep == ESP_SLEEP_LIGHT) == !!sim.cfg.esp8266 ? 1 : 2;
+        sim_outf("+SLEEP:%d\r\n\r\nOK\r\n", val);
+    } else if (sscanf(cmd, "AT+GSLP=%u", &len) == 1) {
+        /* Deep sleep loses all state, module reports ready once it wakes up */
+        for (int i = 0; i < SIM_MAX_LINKS; ++i) {
+            link_close(i, 0);
+        }
+        sim.wifi = 0;
+        sim.server = 0;
+        sim.sleep = ESP_SLEEP_NONE;
+        sim.deep_sleep = 1;
+        sim.deep_sleep_end = esp_sys_now() + ESP_MAX(len, 1U);
+        ++sim.stats.deep_sleeps;
+        sim_outf("\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+GMR")) {
+        sim_outf("AT version:2.1.0.0(sim)\r\nSDK version:v4.0.1\r\ncompile time:sim\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+BLEINIT?")) {
+        if (sim.cfg.esp8266) {
+            sim_outf("\r\nERROR\r\n");
+        } else {
+            sim_outf("+BLEINIT:0\r\n\r\nOK\r\n");
+        }
+    } else if (!strcmp(cmd, "AT+CWDHCP?")) {
+        sim_outf("+CWDHCP:3\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CWMODE?")) {
+        sim_outf("+CWMODE:1\r\n\r\nOK\r\n");
+    } else if (!strncmp(cmd, "AT+CWJAP=", 9)) {
+        sim.wifi = 1;
+        sim_outf("WIFI CONNECTED\r\nWIFI GOT IP\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CWJAP?")) {
+        if (sim.wifi) {
+            sim_outf("+CWJAP:\"sim\",\"02:00:00:00:00:01\",6,%d\r\n\r\nOK\r\n",
+                sim.cfg.rssi != 0 ? (int)sim.cfg.rssi : -50 - (int)(sim_rand() % 30));
+        } else {
+            sim_outf("No AP\r\n\r\nOK\r\n");
+        }
+    } else if (!strcmp(cmd, "AT+CWQAP")) {
+        sim.wifi = 0;
+        sim_outf("\r\nOK\r\nWIFI DISCONNECT\r\n");
+    } else if (!strcmp(cmd, "AT+CIPSTA?")) {
+        sim_outf("+CIPSTA:ip:\"192.168.1.10\"\r\n+CIPSTA:gateway:\"192.168.1.1\"\r\n+CIPSTA:netmask:\"255.255.255.0\"\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CIPSTAMAC?")) {
+        sim_outf("+CIPSTAMAC:\"02:00:00:00:00:10\"\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CIPAP?")) {
+        sim_outf("+CIPAP:ip:\"192.168.4.1\"\r\n+CIPAP:gateway:\"192.168.4.1\"\r\n+CIPAP:netmask:\"255.255.255.0\"\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CIPAPMAC?")) {
+        sim_outf("+CIPAPMAC:\"02:00:00:00:00:11\"\r\n\r\nOK\r\n");
+    } else if (!strcmp(cmd, "AT+CIPSTATUS")) {
+        sim_outf("STATUS:%d\r\n", sim.wifi ? 2 : 5);
+        for (int i = 0; i < SIM_MAX_LINKS; ++i) {
+            sim_link_t* l = &sim.links[i];
+            if (l->active) {
+                sim_outf("+CIPSTATUS:%d,\"%s\",\"" SIM_REMOTE_IP "\",%d,%d,%d\r\n",
+                    i, l->type, (int)l->remote_port, (int)l->local_port, (int)l->is_server);
+            }
+        }
+        sim_outf("\r\nOK\r\n");
+    } else if (sscanf(cmd, "AT+CIPDINFO=%d", &val) == 1) {
+        sim.dinfo = !!val;
+        sim_outf("\r\nOK\r\n");
+    } else if (!strncmp(cmd, "AT+CIPDOMAIN=", 13)) {
+        sim_outf("+CIPDOMAIN:" SIM_REMOTE_IP "\r\n\r\nOK\r\n");
+    } else if (!strncmp(cmd, "AT+PING=", 8)) {
+        sim_outf("+PING:%d\r\n\r\nOK\r\n", (int)(1 + sim_rand() % 20));
+    } else if (sscanf(cmd, "AT+CIPSERVER=%d,%hu", &val, &port) >= 1) {
+        sim.server = !!val;
+        if (sim.server) {
+            sim.server_port = port > 0 ? port : 333;
+            sim.next_incoming = esp_sys_now() + sim.cfg.server_conn_interval;
+        }
+        sim_outf("\r\nOK\r\n");
+    } else if (sscanf(cmd, "AT+CIPSTART=%d,\"%3[A-Z]\",\"%63[^\"]\",%hu", &num, type, host, &port) == 4) {
+        if (num < 0 || num >= SIM_MAX_LINKS || !sim.wifi) {
+            sim_outf("\r\nERROR\r\n");
+        } else if (sim.links[num].active) {
+            sim_outf("ALREADY CONNECTED\r\n\r\nERROR\r\n");
+        } else {
+            sim_peer_t peer = SIM_PEER_ECHO;
+            if (!strcmp(type, "TCP") || !strcmp(type, "SSL")) {
+                if (port == ESP_SIM_PORT_MQTT) {
+                    peer = SIM_PEER_MQTT;
+                } else if (port == ESP_SIM_PORT_HTTP) {
+                    peer = SIM_PEER_HTTP_SERVER;
+                }
+            }
+            if (++sim.next_port < 50000) {
+                sim.next_port = 50000;
+            }
+            link_open(num, 0, type, peer, port, sim.next_port);
+            sim_outf("\r\nOK\r\n");
+        }
+    } else if (sscanf(cmd, "AT+CIPSEND=%d,%u", &num, &len) == 2) {
+        if (num < 0 || num >= SIM_MAX_LINKS || !sim.links[num].active) {
+            sim_outf("link is not valid\r\n\r\nERROR\r\n");
+        } else if (len == 0 || len > sizeof(sim.data)) {
+            sim_outf("\r\nERROR\r\n");
+        } else {
+            sim.data_link = num;
+            sim.data_len = len;
+            sim.data_recv = 0;
+            sim.data_buffered = 0;
+            sim_outf("\r\nOK\r\n\r\n> ");
+        }
+    } else if (sscanf(cmd, "AT+CIPSENDBUF=%d,%u", &num, &len) == 2) {
+        if (!sim.cfg.sendbuf) {
+            sim_outf("\r\nERROR\r\n");
+        } else if (num < 0 || num >= SIM_MAX_LINKS || !sim.links[num].active) {
+            sim_outf("link is not valid\r\n\r\nERROR\r\n");
+        } else if (len == 0 || len > sizeof(sim.data)) {
+            sim_outf("\r\nERROR\r\n");
+        } else if (sim.links[num].seg_id - sim.links[num].seg_done >= SIM_SENDBUF_SEGMENTS) {
+            ++sim.stats.sendbuf_busy;
+            sim_outf("busy\r\n\r\nERROR\r\n");
+        } else {
+            sim_link_t* l = &sim.links[num];
+
+            sim.data_link = num;
+            sim.data_len = len;
+            sim.data_recv = 0;
+            sim.data_buffered = 1;
+            sim_outf("%u,%u\r\n\r\nOK\r\n\r\n> ", (unsigned)(l->seg_id + 1), (unsigned)l->seg_done);
+        }
+    } else if (sscanf(cmd, "AT+CIPCLOSE=%d", &num) == 1) {
+        if (num >= SIM_MAX_LINKS) {
+            for (int i = 0; i < SIM_MAX_LINKS; ++i) {
+                link_close(i, 1);
+            }
+            sim_outf("\r\nOK\r\n");
+        } else if (num >= 0 && sim.links[num].active) {
+            link_close(num, 1);
+            sim_outf("\r\nOK\r\n");
+        } else {
+            sim_outf("UNLINK\r\n\r\nERROR\r\n");
+        }
+    } else {
+        sim_outf("\r\nOK\r\n");                 /* Accept any other command */
+    }
+}
+
+/**
+ * \brief           Finish data mode after all bytes were received
+ */
+static void
+sim_data_done(void) {
+    sim_link_t* l = &sim.links[sim.data_link];
+
+    sim_outf("\r\nRecv %d bytes\r\n", (int)sim.data_len);
+    if (sim.data_buffered) {
+        /* Segment is queued, SEND OK or SEND FAIL is reported later */
+        ++l->seg_id;
+        ++sim.stats.sendbuf_segments;
+        if (l->seg_fail == 0 && l->active && !sim_chance(sim.cfg.send_fail_ratio)) {
+            ++sim.stats.send_ok;
+            sim.stats.bytes_tx += (uint32_t)sim.data_len;
+            peer_input(l, sim.data, sim.data_len);
+        } else {
+            ++sim.stats.send_fail;
+            if (l->seg_fail == 0) {
+                l->seg_fail = l->seg_id;        /* TCP stream is broken from this segment on */
+            }
+        }
+    } else if (!l->active || sim_chance(sim.cfg.send_fail_ratio)) {
+        ++sim.stats.send_fail;
+        sim_outf("\r\nSEND FAIL\r\n");
+    } else {
+        ++sim.stats.send_ok;
+        sim.stats.bytes_tx += (uint32_t)sim.data_len;
+        sim_outf("\r\nSEND OK\r\n");
+        peer_input(l, sim.data, sim.data_len);
+    }
+    sim.data_link = -1;
+}
+
+/**
+ * \brief           Process periodic events: pending data, remote closes and incoming connections
+ */
+static void
+sim_poll(void) {
+    uint32_t now = esp_sys_now();
+
+    if (sim.deep_sleep) {
+        if ((int32_t)(now - sim.deep_sleep_end) < 0) {
+            return;
+        }
+        sim.deep_sleep = 0;
+        sim_outf("\r\nready\r\n");
+    }
+    if (sim.data_link >= 0) {                   /* Never interrupt data mode */
+        return;
+    }
+    for (int i = 0; i < SIM_MAX_LINKS; ++i) {
+        sim_link_t* l = &sim.links[i];
+        size_t n;
+
+        if (!l->active) {
+            continue;
+        }
+        if (l->seg_done != l->seg_id) {         /* Report one buffered segment per poll */
+            ++l->seg_done;
+            if (l->seg_fail > 0 && l->seg_done >= l->seg_fail) {
+                sim_outf("%d,%u,SEND FAIL\r\n", i, (unsigned)l->seg_done);
+                if (l->seg_done == l->seg_id) {
+                    link_close(i, 1);
+                    continue;
+                }
+            } else {
+                sim_outf("%d,%u,SEND OK\r\n", i, (unsigned)l->seg_done);
+            }
+        }
+        while (l->pend_len > 0 && sim.out_len + SIM_IPD_MAX_LEN + 64 < sizeof(sim.out)) {
+            n = ESP_MIN(l->pend_len, SIM_IPD_MAX_LEN);
+            if (sim_chance(sim.cfg.ipd_small_ratio)) {
+                size_t small = 1 + sim_rand() % SIM_IPD_SMALL_LEN;
+                n = ESP_MIN(n, small);
+            }
+            if (sim.dinfo) {
+                sim_outf("\r\n+IPD,%d,%d,\"" SIM_REMOTE_IP "\",%d:", i, (int)n, (int)l->remote_port);
+            } else {
+                sim_outf("\r\n+IPD,%d,%d:", i, (int)n);
+            }
+            sim_out(l->pend, n);
+            sim.stats.bytes_rx += (uint32_t)n;
+            memmove(l->pend, &l->pend[n], l->pend_len - n);
+            l->pend_len -= n;
+        }
+        if ((l->pend_len == 0 && l->close_after_send)
+            || (l->close_time > 0 && (int32_t)(now - l->close_time) >= 0)) {
+            link_close(i, 1);
+        }
+    }
+
+    /* Open incoming connection with HTTP request */
+    if (sim.server && sim.wifi && sim.cfg.server_conn_interval > 0
+        && (int32_t)(now - sim.next_incoming) >= 0) {
+        static const char* paths[] = {"/", "/index.html", "/css/style.css", "/js/js.js", "/missing.html", "/status"};
+
+        sim.next_incoming = now + sim.cfg.server_conn_interval;
+        for (int i = SIM_MAX_LINKS - 1; i >= 0; --i) {
+            if (!sim.links[i].active) {
+                char req[128];
+                int req_len;
+
+                link_open(i, 1, "TCP", SIM_PEER_HTTP_CLIENT, (esp_port_t)(40000 + sim_rand() % 20000), sim.server_port);
+                req_len = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: sim\r\n\r\n", paths[sim_rand() % ESP_ARRAYSIZE(paths)]);
+                link_pend(&sim.links[i], req, req_len);
+                sim.links[i].close_time = now + 10000;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * \brief           Simulator thread delivering module output to library
+ * \param[in]       arg: Thread argument, not used
+ */
+static void
+sim_thread(void* arg) {
+    static uint8_t buff[SIM_OUT_SIZE];
+    size_t len;
+
+    ESP_UNUSED(arg);
+    while (1) {
+        esp_sys_sem_wait(&sim.sem, 5);
+
+        esp_sys_mutex_lock(&sim.mutex);
+        sim_poll();
+        len = sim.out_len;
+        memcpy(buff, sim.out, len);
+        sim.out_len = 0;
+        esp_sys_mutex_unlock(&sim.mutex);
+
+        if (len > 0) {
+#if ESP_CFG_INPUT_USE_PROCESS
+            esp_input_process(buff, len);
+#else /* ESP_CFG_INPUT_USE_PROCESS */
+            esp_input(buff, len);
+#endif /* !ESP_CFG_INPUT_USE_PROCESS */
+        }
+    }
+}
+
+/**
+ * \brief           Check if module UART is able to receive
+ *
+ * Input is lost during deep sleep and during light sleep,
+ * until wakeup pin has been active for configured wakeup latency
+ *
+ * \return          `1` when input is received, `0` when it is lost
+ */
+static uint8_t
+sim_input_ready(void) {
+    if (sim.deep_sleep) {
+        return 0;
+    }
+    if (sim.sleep == ESP_SLEEP_LIGHT) {
+        return sim.wakeup_pin && esp_sys_now() - sim.wakeup_time >= sim.cfg.wakeup_latency;
+    }
+    return 1;
+}
+
+/**
+ * \brief           Receive data sent by library to module
+ * \param[in]       data: Data to send. `NULL` for flush
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Number of bytes accepted
+ */
+static size_t
+sim_send(const void* data, size_t len) {
+    const uint8_t* d = data;
+
+    if (data == NULL) {
+        return 0;
+    }
+    esp_sys_mutex_lock(&sim.mutex);
+    for (size_t i = 0; i < len; ++i) {
+        if (!sim_input_ready()) {
+            ++sim.stats.sleep_lost;
+        } else if (sim.data_link >= 0) {
+            sim.data[sim.data_recv++] = d[i];
+            if (sim.data_recv == sim.data_len) {
+                sim_data_done();
+            }
+        } else if (d[i] == '\n') {
+            if (sim.cmd_len > 0 && sim.cmd[sim.cmd_len - 1] == '\r') {
+                --sim.cmd_len;
+            }
+            sim.cmd[sim.cmd_len] = 0;
+            if (sim.cmd_len > 0) {
+                sim_process_cmd(sim.cmd);
+            }
+            sim.cmd_len = 0;
+        } else if (sim.cmd_len < sizeof(sim.cmd) - 1) {
+            sim.cmd[sim.cmd_len++] = (char)d[i];
+        }
+    }
+    esp_sys_mutex_unlock(&sim.mutex);
+    esp_sys_sem_release(&sim.sem);
+    return len;
+}
+
+/**
+ * \brief           Drive wakeup pin of module
+ * \param[in]       state: Set to `1` to activate wakeup pin, `0` to release it
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+sim_wakeup(uint8_t state) {
+    esp_sys_mutex_lock(&sim.mutex);
+    if (state && !sim.wakeup_pin) {
+        sim.wakeup_time = esp_sys_now();
+    }
+    sim.wakeup_pin = !!state;
+    esp_sys_mutex_unlock(&sim.mutex);
+    return 1;
+}
+
+#endif /* !__DOXYGEN__ */
+
+/**
+ * \brief           Set simulator configuration
+ * \note            Must be called before \ref esp_init to take effect from first command
+ * \param[in]       config: New configuration
+ */
+void
+esp_sim_set_config(const esp_sim_config_t* config) {
+    if (sim.initialized) {
+        esp_sys_mutex_lock(&sim.mutex);
+    }
+    if (sim.rnd == 0 || config->seed != sim.cfg.seed) {
+        sim.rnd = config->seed != 0 ? config->seed : 1;
+    }
+    sim.cfg = *config;
+    if (sim.initialized) {
+        esp_sys_mutex_unlock(&sim.mutex);
+    }
+}
+
+/**
+ * \brief           Get simulator statistics
+ * \param[out]      stats: Output statistics
+ */
+void
+esp_sim_get_stats(esp_sim_stats_t* stats) {
+    esp_sys_mutex_lock(&sim.mutex);
+    *stats = sim.stats;
+    esp_sys_mutex_unlock(&sim.mutex);
+}
+
+/**
+ * \brief           Get number of active links on simulated module
+ * \return          Number of active links
+ */
+size_t
+esp_sim_get_active_links(void) {
+    size_t cnt = 0;
+
+    esp_sys_mutex_lock(&sim.mutex);
+    for (size_t i = 0; i < SIM_MAX_LINKS; ++i) {
+        cnt += sim.links[i].active;
+    }
+    esp_sys_mutex_unlock(&sim.mutex);
+    return cnt;
+}
+
+/**
+ * \brief           Callback function called from initialization process
+ * \note            This function may be called multiple times if AT baudrate is changed from application
+ * \param[in,out]   ll: Pointer to \ref esp_ll_t structure to fill data for communication functions
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_ll_init(esp_ll_t* ll) {
+    if (!sim.initialized) {
+        if (sim.rnd == 0) {
+            sim.rnd = sim.cfg.seed != 0 ? sim.cfg.seed : 1;
+        }
+        esp_sys_mutex_create(&sim.mutex);
+        esp_sys_sem_create(&sim.sem, 0);
+        esp_sys_thread_create(NULL, "esp_sim", sim_thread, NULL, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO);
+        sim.initialized = 1;
+    }
+    ll->send_fn = sim_send;
+    ll->wakeup_fn = sim_wakeup;
+    return espOK;
+}
+
+/**
+ * \brief           Callback function to de-init low-level communication part
+ * \param[in,out]   ll: Pointer to \ref esp_ll_t structure to fill data for communication functions
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_ll_deinit(esp_ll_t* ll) {
+    ESP_UNUSED(ll);
+    return espOK;
+}
@@ -0,0 +1,119 @@
+/**
+ * \file            esp_sim.h
+ * \brief           Simulated ESP AT module
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_SIM_H
+#define ESP_HDR_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "esp/esp.h"
+
+/**
+ * \defgroup        ESP_SIM Simulated module
+ * \brief           In-process simulated ESP AT module for host builds
+ * \{
+ *
+ * Simulator answers AT commands sent by the library and emulates remote peers,
+ * selected by remote port number of \ref esp_conn_start:
+ *
+ *  - \ref ESP_SIM_PORT_MQTT: Minimal MQTT broker, acknowledges packets and echoes publish messages back
+ *  - \ref ESP_SIM_PORT_HTTP: HTTP server, answers every request with random length body and closes connection
+ *  - Any other port: Echo server
+ *
+ * When server is enabled with \ref esp_set_server, simulator periodically opens
+ * incoming connections and sends HTTP `GET` request on them.
+ *
+ * `AT+SLEEP` puts module to modem or light sleep. In light sleep, input is lost
+ * until wakeup pin, driven with `wakeup_fn` of low-level interface, has been active for `wakeup_latency`.
+ * `AT+GSLP` drops all connections and Wi-Fi, ignores input for given time and reports `ready` afterwards.
+ */
+
+#define ESP_SIM_PORT_HTTP           80          /*!< Remote port emulating HTTP server */
+#define ESP_SIM_PORT_MQTT           1883        /*!< Remote port emulating MQTT broker */
+
+/**
+ * \brief           Simulator configuration
+ */
+typedef struct {
+    uint32_t seed;                              /*!< Random generator seed */
+    uint8_t send_fail_ratio;                    /*!< Percent of send operations answered with `SEND FAIL` */
+    uint8_t remote_close_ratio;                 /*!< Percent of received packets after which remote side closes connection */
+    uint32_t server_conn_interval;              /*!< Interval between incoming connections in units of milliseconds,
+                                                    used when server is enabled. Set to `0` to disable */
+    size_t http_body_max;                       /*!< Maximal length of HTTP response body */
+    uint8_t ipd_small_ratio;                    /*!< Percent of `+IPD` segments limited to small random size,
+                                                    to model streams of small TCP segments */
+    uint8_t esp8266;                            /*!< Set to `1` to answer `AT+BLEINIT?` with error, as ESP8266 does */
+    uint8_t sendbuf;                            /*!< Set to `1` to support `AT+CIPSENDBUF` buffered send */
+    uint32_t wakeup_latency;                    /*!< Time in units of milliseconds from wakeup pin activation
+                                                    until module leaves light sleep */
+    int16_t rssi;                               /*!< RSSI in units of dBm reported by `AT+CWJAP?`.
+                                                    Set to `0` to report random value between `-79` and `-50` */
+} esp_sim_config_t;
+
+/**
+ * \brief           Simulator statistics
+ */
+typedef struct {
+    uint32_t cmds;                              /*!< Number of processed AT commands */
+    uint32_t conns_opened;                      /*!< Number of opened connections, both directions */
+    uint32_t conns_closed;                      /*!< Number of closed connections */
+    uint32_t remote_closes;                     /*!< Number of connections closed by remote side */
+    uint32_t send_ok;                           /*!< Number of successful send operations */
+    uint32_t send_fail;                         /*!< Number of injected send failures */
+    uint32_t sendbuf_segments;                  /*!< Number of segments queued with `AT+CIPSENDBUF` */
+    uint32_t sendbuf_busy;                      /*!< Number of `AT+CIPSENDBUF` commands rejected with full buffer */
+    uint32_t bytes_tx;                          /*!< Number of bytes host sent to remote peers */
+    uint32_t bytes_rx;                          /*!< Number of bytes remote peers sent to host */
+    uint32_t sleeps;                            /*!< Number of times module entered modem or light sleep */
+    uint32_t wakeups;                           /*!< Number of times module left sleep with `AT+SLEEP=0` */
+    uint32_t sleep_cmds;                        /*!< Number of commands other than `AT+SLEEP` received in sleep mode */
+    uint32_t sleep_lost;                        /*!< Number of bytes lost in light sleep or deep sleep */
+    uint32_t deep_sleeps;                       /*!< Number of deep sleeps started with `AT+GSLP` */
+} esp_sim_stats_t;
+
+void    esp_sim_set_config(const esp_sim_config_t* config);
+void    esp_sim_get_stats(esp_sim_stats_t* stats);
+size_t  esp_sim_get_active_links(void);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ESP_HDR_SIM_H */
@@ -0,0 +1,723 @@
+/**
+ * \file            main.c
+ * \brief           Long-running soak test with heap and leak tracking
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+#include "esp/esp_netconn.h"
+#include "esp/apps/esp_http_server.h"
+#include "esp/apps/esp_http_server_fs.h"
+#include "esp/apps/esp_mqtt_client_api.h"
+#include "system/esp_sys.h"
+#include "esp_sim.h"
+
+#define SOAK_HEAP_SIZE              0x10000
+#define SOAK_HEAP_FAST_SIZE         0x4000
+#define SOAK_MAX_SAMPLES            4096
+#define SOAK_ECHO_PORT              7
+#define SOAK_QUIESCE_TIMEOUT        30000
+
+/**
+ * \brief           Single heap sample
+ */
+typedef struct {
+    uint32_t time;                              /*!< Time of sample in units of seconds since start */
+    size_t used;                                /*!< Used heap in units of bytes */
+    size_t largest_free;                        /*!< Largest free block in units of bytes */
+    size_t free_blocks;                         /*!< Number of free blocks */
+    size_t pbufs;                               /*!< Number of allocated pbufs */
+    size_t conns;                               /*!< Number of active connections */
+} soak_sample_t;
+
+/**
+ * \brief           Latency statistics
+ */
+typedef struct {
+    uint32_t count;                             /*!< Number of samples */
+    uint64_t sum;                               /*!< Sum of all samples */
+    uint32_t max;                               /*!< Maximal sample */
+} soak_latency_t;
+
+/**
+ * \brief           Worker statistics
+ */
+typedef struct {
+    uint32_t sessions;                          /*!< Number of finished sessions */
+    uint32_t errors;                            /*!< Number of failed operations */
+    uint32_t mismatches;                        /*!< Number of data verification errors */
+    uint32_t bytes;                             /*!< Number of received payload bytes */
+} soak_worker_stats_t;
+
+static uint8_t heap[SOAK_HEAP_SIZE];
+static esp_mem_region_t heap_regions[] = {
+    { heap, SOAK_HEAP_FAST_SIZE, ESP_MEM_CLASS_FAST },
+    { heap + SOAK_HEAP_FAST_SIZE, sizeof(heap) - SOAK_HEAP_FAST_SIZE, ESP_MEM_CLASS_BULK },
+};
+
+static soak_sample_t samples[SOAK_MAX_SAMPLES];
+static size_t samples_cnt, samples_step = 1, samples_skip;
+static uint32_t start_time;
+
+static esp_sim_config_t sim_cfg = {
+    .send_fail_ratio = 2,
+    .remote_close_ratio = 2,
+    .server_conn_interval = 500,
+    .http_body_max = 4096,
+    .ipd_small_ratio = 50,
+    .esp8266 = 1,
+    .sendbuf = 1,
+};
+
+/* Serve files from "www" directory with memory mapped file system */
+static const http_init_t http_init = {
+    .fs_open = http_fs_open,
+    .fs_read = http_fs_read,
+    .fs_close = http_fs_close,
+};
+
+static esp_sys_mutex_t soak_mutex;
+static volatile uint8_t running;
+static volatile size_t workers_alive;
+static soak_worker_stats_t echo_stats, http_stats, mqtt_stats;
+static esp_mqtt_client_metrics_t mqtt_metrics;
+#if ESP_CFG_EVT_TIMESTAMP
+static soak_latency_t rx_stack_latency, rx_app_latency;
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+
+/**
+ * \brief           Thread safe random number in range `[0, max)`
+ * \param[in]       max: Upper bound
+ * \return          Random number
+ */
+static uint32_t
+soak_rand(uint32_t max) {
+    uint32_t r;
+
+    esp_sys_mutex_lock(&soak_mutex);
+    r = (uint32_t)rand();
+    esp_sys_mutex_unlock(&soak_mutex);
+    return max > 0 ? r % max : 0;
+}
+
+/**
+ * \brief           Increase statistics counter
+ * \param[in]       cnt: Counter to increase
+ * \param[in]       val: Value to add
+ */
+static void
+soak_count(uint32_t* cnt, uint32_t val) {
+    esp_sys_mutex_lock(&soak_mutex);
+    *cnt += val;
+    esp_sys_mutex_unlock(&soak_mutex);
+}
+
+#if ESP_CFG_EVT_TIMESTAMP
+
+/**
+ * \brief           Add latency sample
+ * \param[in,out]   l: Latency statistics
+ * \param[in]       val: Latency value
+ */
+static void
+soak_latency_add(soak_latency_t* l, uint32_t val) {
+    ++l->count;
+    l->sum += val;
+    l->max = val > l->max ? val : l->max;
+}
+
+/**
+ * \brief           Record time received data spent inside the stack and until read by application
+ * \param[in]       pbuf: Received packet buffer
+ */
+static void
+soak_rx_latency(esp_pbuf_p pbuf) {
+    uint32_t now = ESP_CFG_EVT_TIMESTAMP_NOW(), input = esp_pbuf_get_time_input(pbuf);
+
+    esp_sys_mutex_lock(&soak_mutex);
+    soak_latency_add(&rx_stack_latency, esp_pbuf_get_time_dispatch(pbuf) - input);
+    soak_latency_add(&rx_app_latency, now - input);
+    esp_sys_mutex_unlock(&soak_mutex);
+}
+
+/**
+ * \brief           Print latency statistics
+ * \param[in]       name: Statistics name
+ * \param[in]       l: Latency statistics
+ */
+static void
+print_latency(const char* name, const soak_latency_t* l) {
+    printf("rx    %s latency samples: %u, avg: %u us, max: %u us\r\n", name, (unsigned)l->count,
+        (unsigned)(l->count > 0 ? l->sum / l->count : 0), (unsigned)l->max);
+}
+
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+
+/**
+ * \brief           Add latency histogram to total
+ * \param[in,out]   total: Histogram to add to
+ * \param[in]       h: Histogram to add
+ */
+static void
+soak_hist_add(esp_mqtt_hist_t* total, const esp_mqtt_hist_t* h) {
+    for (size_t i = 0; i < ESP_MQTT_METRICS_HIST_LEN; ++i) {
+        total->buckets[i] += h->buckets[i];
+    }
+    total->count += h->count;
+    total->sum += h->sum;
+    total->max = h->max > total->max ? h->max : total->max;
+}
+
+/**
+ * \brief           Add metrics of finished MQTT client session to total
+ * \param[in]       m: Metrics of MQTT client
+ */
+static void
+soak_mqtt_metrics_add(const esp_mqtt_client_metrics_t* m) {
+    esp_sys_mutex_lock(&soak_mutex);
+    for (size_t i = 0; i < ESP_MQTT_METRICS_PKT_TYPES; ++i) {
+        mqtt_metrics.tx[i].packets += m->tx[i].packets;
+        mqtt_metrics.tx[i].bytes += m->tx[i].bytes;
+        mqtt_metrics.rx[i].packets += m->rx[i].packets;
+        mqtt_metrics.rx[i].bytes += m->rx[i].bytes;
+    }
+    for (size_t i = 0; i < ESP_ARRAYSIZE(m->pub_ack); ++i) {
+        soak_hist_add(&mqtt_metrics.pub_ack[i], &m->pub_ack[i]);
+    }
+    soak_hist_add(&mqtt_metrics.keep_alive_rtt, &m->keep_alive_rtt);
+    for (size_t i = 0; i < ESP_MQTT_DISCONNECT_REASON_END; ++i) {
+        mqtt_metrics.disconnects[i] += m->disconnects[i];
+    }
+    mqtt_metrics.rx_dropped += m->rx_dropped;
+    mqtt_metrics.requests_full += m->requests_full;
+    mqtt_metrics.tx_buff_full += m->tx_buff_full;
+    mqtt_metrics.connects += m->connects;
+    mqtt_metrics.requests_max = m->requests_max > mqtt_metrics.requests_max ? m->requests_max : mqtt_metrics.requests_max;
+    mqtt_metrics.tx_buff_max = m->tx_buff_max > mqtt_metrics.tx_buff_max ? m->tx_buff_max : mqtt_metrics.tx_buff_max;
+    esp_sys_mutex_unlock(&soak_mutex);
+}
+
+/**
+ * \brief           Echo client worker, sends random data and verifies echoed bytes
+ * \param[in]       arg: Pointer to worker statistics
+ */
+static void
+echo_worker(void* arg) {
+    soak_worker_stats_t* st = arg;
+    uint8_t data[1500];
+    esp_netconn_p nc;
+    esp_pbuf_p pbuf;
+    size_t len, recv, n;
+    uint8_t seq = 0;
+
+    while (running) {
+        if ((nc = esp_netconn_new(ESP_NETCONN_TYPE_TCP)) == NULL) {
+            soak_count(&st->errors, 1);
+            esp_delay(100);
+            continue;
+        }
+        esp_netconn_set_receive_timeout(nc, 5000);
+        if (esp_netconn_connect(nc, "echo.sim", SOAK_ECHO_PORT) == espOK) {
+            for (n = 1 + soak_rand(20); n > 0 && running; --n) {
+                len = 1 + soak_rand(sizeof(data));
+                for (size_t i = 0; i < len; ++i) {
+                    data[i] = (uint8_t)(seq + i);
+                }
+                if (esp_netconn_write(nc, data, len) != espOK || esp_netconn_flush(nc) != espOK) {
+                    soak_count(&st->errors, 1);
+                    break;
+                }
+
+                /* Collect echoed data and verify content */
+                for (recv = 0; recv < len; ) {
+                    if (esp_netconn_receive(nc, &pbuf) != espOK) {
+                        break;
+                    }
+#if ESP_CFG_EVT_TIMESTAMP
+                    soak_rx_latency(pbuf);
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+                    for (size_t i = 0, tot = esp_pbuf_length(pbuf, 1); i < tot && recv < len; ++i, ++recv) {
+                        uint8_t ch;
+                        if (!esp_pbuf_get_at(pbuf, i, &ch) || ch != data[recv]) {
+                            soak_count(&st->mismatches, 1);
+                            break;
+                        }
+                    }
+                    esp_pbuf_free(pbuf);
+                }
+                soak_count(&st->bytes, (uint32_t)recv);
+                if (recv < len) {
+                    soak_count(&st->errors, 1);     /* Closed by remote side or timeout */
+                    break;
+                }
+                ++seq;
+            }
+            esp_netconn_close(nc);
+            soak_count(&st->sessions, 1);
+        } else {
+            soak_count(&st->errors, 1);
+        }
+        esp_netconn_delete(nc);
+        esp_delay(soak_rand(50));
+    }
+    esp_sys_mutex_lock(&soak_mutex);
+    --workers_alive;
+    esp_sys_mutex_unlock(&soak_mutex);
+    esp_sys_thread_terminate(NULL);
+}
+
+/**
+ * \brief           HTTP client worker, requests random pages from simulated server
+ * \param[in]       arg: Pointer to worker statistics
+ */
+static void
+http_worker(void* arg) {
+    soak_worker_stats_t* st = arg;
+    static const char req[] = "GET / HTTP/1.1\r\nHost: http.sim\r\nConnection: close\r\n\r\n";
+    esp_netconn_p nc;
+    esp_pbuf_p pbuf;
+    espr_t res;
+
+    while (running) {
+        if ((nc = esp_netconn_new(ESP_NETCONN_TYPE_TCP)) == NULL) {
+            soak_count(&st->errors, 1);
+            esp_delay(100);
+            continue;
+        }
+        esp_netconn_set_receive_timeout(nc, 5000);
+        if (esp_netconn_connect(nc, "http.sim", ESP_SIM_PORT_HTTP) == espOK) {
+            if (esp_netconn_write(nc, req, sizeof(req) - 1) == espOK && esp_netconn_flush(nc) == espOK) {
+                /* Server closes connection once response is sent */
+                while ((res = esp_netconn_receive(nc, &pbuf)) == espOK) {
+                    soak_count(&st->bytes, (uint32_t)esp_pbuf_length(pbuf, 1));
+                    esp_pbuf_free(pbuf);
+                }
+                if (res != espCLOSED) {
+                    soak_count(&st->errors, 1);
+                }
+            } else {
+                soak_count(&st->errors, 1);
+            }
+            esp_netconn_close(nc);
+            soak_count(&st->sessions, 1);
+        } else {
+            soak_count(&st->errors, 1);
+        }
+        esp_netconn_delete(nc);
+        esp_delay(soak_rand(100));
+    }
+    esp_sys_mutex_lock(&soak_mutex);
+    --workers_alive;
+    esp_sys_mutex_unlock(&soak_mutex);
+    esp_sys_thread_terminate(NULL);
+}
+
+/**
+ * \brief           MQTT client worker, subscribes and publishes messages echoed by simulated broker
+ * \param[in]       arg: Pointer to worker statistics
+ */
+static void
+mqtt_worker(void* arg) {
+    soak_worker_stats_t* st = arg;
+    static const esp_mqtt_client_info_t info = {
+        .id = "esp_soak",
+        .keep_alive = 10,
+    };
+    esp_mqtt_client_api_p client;
+    esp_mqtt_client_api_buf_p buf;
+    esp_mqtt_client_metrics_t metrics;
+    char payload[64];
+    size_t n, len;
+
+    while (running) {
+        if ((client = esp_mqtt_client_api_new(256, 256)) == NULL) {
+            soak_count(&st->errors, 1);
+            esp_delay(100);
+            continue;
+        }
+        if (esp_mqtt_client_api_connect(client, "mqtt.sim", ESP_SIM_PORT_MQTT, &info) == ESP_MQTT_CONN_STATUS_ACCEPTED) {
+            if (esp_mqtt_client_api_subscribe(client, "soak/#", ESP_MQTT_QOS_AT_LEAST_ONCE) == espOK) {
+                for (n = 1 + soak_rand(10); n > 0 && running; --n) {
+                    len = (size_t)snprintf(payload, sizeof(payload), "message %u", (unsigned)soak_rand(100000));
+                    if (esp_mqtt_client_api_publish(client, "soak/data", payload, len,
+                            soak_rand(2) ? ESP_MQTT_QOS_AT_LEAST_ONCE : ESP_MQTT_QOS_AT_MOST_ONCE, 0) != espOK) {
+                        soak_count(&st->errors, 1);
+                        break;
+                    }
+                    if (esp_mqtt_client_api_receive(client, &buf, 5000) == espOK && buf != NULL) {
+                        if (buf->payload_len != len || memcmp(buf->payload, payload, len)) {
+                            soak_count(&st->mismatches, 1);
+                        }
+                        soak_count(&st->bytes, (uint32_t)buf->payload_len);
+                        esp_mqtt_client_api_buf_free(buf);
+                    } else {
+                        soak_count(&st->errors, 1);
+                        break;
+                    }
+                }
+                esp_mqtt_client_api_unsubscribe(client, "soak/#");
+            } else {
+                soak_count(&st->errors, 1);
+            }
+            esp_mqtt_client_api_close(client);
+            soak_count(&st->sessions, 1);
+        } else {
+            soak_count(&st->errors, 1);
+        }
+        if (esp_mqtt_client_api_get_metrics(client, &metrics) == espOK) {
+            soak_mqtt_metrics_add(&metrics);
+        }
+        esp_mqtt_client_api_delete(client);
+        esp_delay(soak_rand(100));
+    }
+    esp_sys_mutex_lock(&soak_mutex);
+    --workers_alive;
+    esp_sys_mutex_unlock(&soak_mutex);
+    esp_sys_thread_terminate(NULL);
+}
+
+/**
+ * \brief           Start all worker threads
+ */
+static void
+workers_start(void) {
+    static const struct {
+        const char* name;
+        esp_sys_thread_fn fn;
+        soak_worker_stats_t* stats;
+    } workers[] = {
+        { "soak_echo_1", echo_worker, &echo_stats },
+        { "soak_echo_2", echo_worker, &echo_stats },
+        { "soak_http", http_worker, &http_stats },
+        { "soak_mqtt", mqtt_worker, &mqtt_stats },
+    };
+
+    esp_sim_set_config(&sim_cfg);
+    running = 1;
+    for (size_t i = 0; i < ESP_ARRAYSIZE(workers); ++i) {
+        esp_sys_mutex_lock(&soak_mutex);
+        ++workers_alive;
+        esp_sys_mutex_unlock(&soak_mutex);
+        esp_sys_thread_create(NULL, workers[i].name, workers[i].fn, workers[i].stats, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO);
+    }
+}
+
+/**
+ * \brief           Stop worker threads and wait until library has no open connections or pbufs
+ * \return          `1` when system became idle, `0` on timeout
+ */
+static uint8_t
+workers_stop(void) {
+    esp_sim_config_t cfg = sim_cfg;
+    uint32_t t = esp_sys_now();
+
+    cfg.server_conn_interval = 0;               /* No new incoming connections */
+    esp_sim_set_config(&cfg);
+    running = 0;
+    while (esp_sys_now() - t < SOAK_QUIESCE_TIMEOUT) {
+        if (workers_alive == 0 && esp_conn_get_active_count() == 0 && esp_pbuf_get_count() == 0) {
+            esp_delay(500);                     /* Let pending events and API messages finish */
+            return 1;
+        }
+        esp_delay(100);
+    }
+    return 0;
+}
+
+/**
+ * \brief           Get used heap in units of bytes
+ * \return          Used heap size
+ */
+static size_t
+heap_used(void) {
+    esp_mem_stats_t ms;
+
+    esp_mem_get_stats(&ms);
+    return ms.total - ms.available;
+}
+
+/**
+ * \brief           Take heap sample and store it to sample list
+ */
+static void
+sample_take(void) {
+    esp_mem_stats_t ms;
+    soak_sample_t s;
+
+    esp_mem_get_stats(&ms);
+    s.time = (esp_sys_now() - start_time) / 1000;
+    s.used = ms.total - ms.available;
+    s.largest_free = ms.largest_free;
+    s.free_blocks = ms.free_blocks;
+    s.pbufs = esp_pbuf_get_count();
+    s.conns = esp_conn_get_active_count();
+
+    printf("[%6u s] used: %6u, min free: %6u, largest free: %6u, free blocks: %3u, pbufs: %3u, conns: %u\r\n",
+        (unsigned)s.time, (unsigned)s.used, (unsigned)ms.min_available, (unsigned)s.largest_free,
+        (unsigned)s.free_blocks, (unsigned)s.pbufs, (unsigned)s.conns);
+    fflush(stdout);
+
+    /* Keep whole run in fixed memory by decimating older samples */
+    if (++samples_skip < samples_step) {
+        return;
+    }
+    samples_skip = 0;
+    if (samples_cnt == SOAK_MAX_SAMPLES) {
+        for (size_t i = 0; i < SOAK_MAX_SAMPLES / 2; ++i) {
+            samples[i] = samples[2 * i];
+        }
+        samples_cnt = SOAK_MAX_SAMPLES / 2;
+        samples_step *= 2;
+    }
+    samples[samples_cnt++] = s;
+}
+
+/**
+ * \brief           Calculate least squares slope of sample field over time
+ * \param[in]       off: Offset of `size_t` field in \ref soak_sample_t structure
+ * \return          Slope in units per hour
+ */
+static double
+sample_slope(size_t off) {
+    double sx = 0, sy = 0, sxx = 0, sxy = 0, x, y, n = (double)samples_cnt, d;
+
+    if (samples_cnt < 2) {
+        return 0;
+    }
+    for (size_t i = 0; i < samples_cnt; ++i) {
+        x = samples[i].time / 3600.0;
+        y = (double)*(const size_t*)((const uint8_t*)&samples[i] + off);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    d = n * sxx - sx * sx;
+    return d != 0 ? (n * sxy - sx * sy) / d : 0;
+}
+
+/**
+ * \brief           Library event callback
+ * \param[in]       evt: Event information
+ * \return          \ref espOK on success, member of \ref espr_t otherwise
+ */
+static espr_t
+esp_evt(esp_evt_t* evt) {
+    ESP_UNUSED(evt);
+    return espOK;
+}
+
+/**
+ * \brief           Print worker statistics
+ * \param[in]       name: Worker name
+ * \param[in]       st: Worker statistics
+ */
+static void
+print_worker_stats(const char* name, const soak_worker_stats_t* st) {
+    printf("%-5s sessions: %8u, errors: %6u, mismatches: %u, bytes: %u\r\n", name,
+        (unsigned)st->sessions, (unsigned)st->errors, (unsigned)st->mismatches, (unsigned)st->bytes);
+}
+
+/**
+ * \brief           Program entry point
+ *
+ * Usage: `esp_soak [duration_seconds [seed [sample_interval_seconds]]]`
+ *
+ * \return          `0` when no leak was detected, `1` otherwise
+ */
+int
+main(int argc, char** argv) {
+    esp_sim_stats_t sim_stats;
+    esp_mem_region_stats_t region_stats;
+    esp_conn_ipd_stats_t ipd_stats;
+    http_metrics_t http_metrics;
+    uint32_t duration, interval, warmup, t, next_sample;
+    size_t used_baseline, used_final, pbufs_final;
+    double slope_used, slope_blocks, slope_largest;
+    int leak = 0;
+
+    duration = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 3600;
+    sim_cfg.seed = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : (uint32_t)time(NULL);
+    interval = argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 0) : 10;
+    interval = interval > 0 ? interval : 1;
+    warmup = duration / 10 > 5 ? duration / 10 : 5;
+    srand(sim_cfg.seed);
+
+    printf("Soak test: duration %u s, seed %u, sample interval %u s\r\n",
+        (unsigned)duration, (unsigned)sim_cfg.seed, (unsigned)interval);
+
+    if (!esp_mem_assignmemory(heap_regions, ESP_ARRAYSIZE(heap_regions))) {
+        printf("Could not assign memory\r\n");
+        return 1;
+    }
+    esp_sys_mutex_create(&soak_mutex);
+    esp_sim_set_config(&sim_cfg);
+    if (esp_init(esp_evt, 1) != espOK
+        || esp_sta_join("sim", "soak", NULL, NULL, NULL, 1) != espOK
+        || esp_http_server_init(&http_init, 80) != espOK) {
+        printf("Could not initialize library\r\n");
+        return 1;
+    }
+
+    /* Warm-up run allocates one-time resources before baseline is measured */
+    start_time = esp_sys_now();
+    workers_start();
+    esp_delay(warmup * 1000);
+    if (!workers_stop()) {
+        printf("System did not become idle after warm-up\r\n");
+        return 1;
+    }
+    used_baseline = heap_used();
+    printf("Baseline after %u s warm-up: %u bytes used\r\n", (unsigned)warmup, (unsigned)used_baseline);
+
+    /* Main run */
+    workers_start();
+    next_sample = esp_sys_now();
+    while ((t = esp_sys_now()) - start_time < duration * 1000) {
+        if ((int32_t)(t - next_sample) >= 0) {
+            sample_take();
+            next_sample += interval * 1000;
+        }
+        esp_delay(100);
+    }
+    if (!workers_stop()) {
+        printf("System did not become idle at the end of test\r\n");
+        leak = 1;
+    }
+    sample_take();
+    used_final = heap_used();
+    pbufs_final = esp_pbuf_get_count();
+
+    /* Report */
+    slope_used = sample_slope(offsetof(soak_sample_t, used));
+    slope_blocks = sample_slope(offsetof(soak_sample_t, free_blocks));
+    slope_largest = sample_slope(offsetof(soak_sample_t, largest_free));
+    esp_sim_get_stats(&sim_stats);
+    esp_conn_get_ipd_stats(&ipd_stats);
+    esp_http_server_get_metrics(&http_metrics);
+
+    printf("\r\n---- Soak test report ----\r\n");
+    print_worker_stats("echo", &echo_stats);
+    print_worker_stats("http", &http_stats);
+    print_worker_stats("mqtt", &mqtt_stats);
+    printf("sim   cmds: %u, conns opened: %u, closed: %u, remote closes: %u, send ok: %u, send fail: %u\r\n",
+        (unsigned)sim_stats.cmds, (unsigned)sim_stats.conns_opened, (unsigned)sim_stats.conns_closed,
+        (unsigned)sim_stats.remote_closes, (unsigned)sim_stats.send_ok, (unsigned)sim_stats.send_fail);
+    printf("sim   buffered segments: %u, busy: %u\r\n",
+        (unsigned)sim_stats.sendbuf_segments, (unsigned)sim_stats.sendbuf_busy);
+    printf("ipd   packets: %u, buffers allocated: %u, coalesced: %u, failed: %u\r\n",
+        (unsigned)ipd_stats.packets, (unsigned)ipd_stats.allocs, (unsigned)ipd_stats.coalesced, (unsigned)ipd_stats.failed);
+#if ESP_CFG_EVT_TIMESTAMP
+    print_latency("stack", &rx_stack_latency);
+    print_latency("app  ", &rx_app_latency);
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+    for (size_t i = 0; esp_mem_get_region_stats(i, &region_stats); ++i) {
+        printf("heap  region %u class %u: total: %u, min free: %u, allocs: %u, fallback: %u\r\n",
+            (unsigned)i, (unsigned)region_stats.mem_class, (unsigned)region_stats.total,
+            (unsigned)region_stats.min_available, (unsigned)region_stats.alloc_cnt, (unsigned)region_stats.fallback_cnt);
+    }
+    {
+        uint32_t tx_pkts = 0, tx_bytes = 0, rx_pkts = 0, rx_bytes = 0;
+        const esp_mqtt_hist_t* h;
+
+        for (size_t i = 0; i < ESP_MQTT_METRICS_PKT_TYPES; ++i) {
+            tx_pkts += mqtt_metrics.tx[i].packets;
+            tx_bytes += mqtt_metrics.tx[i].bytes;
+            rx_pkts += mqtt_metrics.rx[i].packets;
+            rx_bytes += mqtt_metrics.rx[i].bytes;
+        }
+        printf("mqttc tx: %u packets, %u bytes, rx: %u packets, %u bytes, dropped: %u, requests max: %u, full: %u, tx_buff max: %u, full: %u\r\n",
+            (unsigned)tx_pkts, (unsigned)tx_bytes, (unsigned)rx_pkts, (unsigned)rx_bytes, (unsigned)mqtt_metrics.rx_dropped,
+            (unsigned)mqtt_metrics.requests_max, (unsigned)mqtt_metrics.requests_full,
+            (unsigned)mqtt_metrics.tx_buff_max, (unsigned)mqtt_metrics.tx_buff_full);
+        for (size_t i = 0; i < ESP_ARRAYSIZE(mqtt_metrics.pub_ack); ++i) {
+            h = &mqtt_metrics.pub_ack[i];
+            printf("mqttc publish QoS %u ack: %u, avg: %u ms, max: %u ms\r\n", (unsigned)i, (unsigned)h->count,
+                (unsigned)(h->count > 0 ? h->sum / h->count : 0), (unsigned)h->max);
+        }
+        h = &mqtt_metrics.keep_alive_rtt;
+        printf("mqttc keep-alive: %u, avg: %u ms, max: %u ms, connects: %u, disconnects user: %u, remote: %u, send failed: %u, refused: %u, tcp failed: %u\r\n",
+            (unsigned)h->count, (unsigned)(h->count > 0 ? h->sum / h->count : 0), (unsigned)h->max, (unsigned)mqtt_metrics.connects,
+            (unsigned)mqtt_metrics.disconnects[ESP_MQTT_DISCONNECT_REASON_USER], (unsigned)mqtt_metrics.disconnects[ESP_MQTT_DISCONNECT_REASON_REMOTE],
+            (unsigned)mqtt_metrics.disconnects[ESP_MQTT_DISCONNECT_REASON_SEND_FAILED], (unsigned)mqtt_metrics.disconnects[ESP_MQTT_DISCONNECT_REASON_REFUSED],
+            (unsigned)mqtt_metrics.disconnects[ESP_MQTT_DISCONNECT_REASON_TCP_FAILED]);
+    }
+    printf("httpd conns: %u, max active: %u, requests: %u, rejected: %u, aborted: %u\r\n",
+        (unsigned)http_metrics.conns_total, (unsigned)http_metrics.conns_max, (unsigned)http_metrics.requests,
+        (unsigned)http_metrics.rejected, (unsigned)http_metrics.aborted);
+    for (size_t i = 0; i < HTTP_METRICS_MAX_ROUTES; ++i) {
+        const http_route_metrics_t* r = &http_metrics.routes[i];
+        if (r->uri[0] != '\0') {
+            printf("httpd route %-16s requests: %u, 2xx: %u, 4xx: %u, bytes: %u, complete avg: %u ms, max: %u ms\r\n",
+                r->uri, (unsigned)r->requests, (unsigned)r->status[1], (unsigned)r->status[3], (unsigned)r->bytes_sent,
+                (unsigned)(r->complete.count > 0 ? r->complete.sum / r->complete.count : 0), (unsigned)r->complete.max);
+        }
+    }
+#if ESP_CFG_THREAD_STACK_STATS
+    {
+        esp_sys_thread_stack_t stacks[ESP_CFG_THREAD_STACK_STATS_MAX];
+        size_t cnt = esp_sys_thread_get_stack_stats(stacks, ESP_ARRAYSIZE(stacks));
+
+        for (size_t i = 0; i < cnt; ++i) {
+            printf("Thread %-16s stack: %u bytes, used max: %u bytes\r\n", stacks[i].name != NULL ? stacks[i].name : "?",
+                (unsigned)stacks[i].size, (unsigned)stacks[i].used_max);
+        }
+    }
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+    printf("Heap used trend: %+.1f bytes/hour\r\n", slope_used);
+    printf("Free blocks trend: %+.2f blocks/hour\r\n", slope_blocks);
+    printf("Largest free block trend: %+.1f bytes/hour\r\n", slope_largest);
+    printf("Idle heap: baseline %u bytes, final %u bytes\r\n", (unsigned)used_baseline, (unsigned)used_final);
+#ifdef ESP_SYS_VIRTUAL_TIME
+    printf("Virtual time: %u s simulated in %u ms of real time\r\n",
+        (unsigned)((esp_sys_now() - start_time) / 1000), (unsigned)esp_sys_vt_get_real_time());
+#endif /* ESP_SYS_VIRTUAL_TIME */
+
+    if (used_final > used_baseline) {
+        printf("LEAK: %u bytes not released\r\n", (unsigned)(used_final - used_baseline));
+        leak = 1;
+    }
+    if (pbufs_final > 0) {
+        printf("LEAK: %u pbufs not released\r\n", (unsigned)pbufs_final);
+        leak = 1;
+    }
+    if (echo_stats.mismatches > 0 || mqtt_stats.mismatches > 0) {
+        printf("DATA: received data did not match sent data\r\n");
+        leak = 1;
+    }
+    printf("Result: %s\r\n", leak ? "FAIL" : "PASS");
+    return leak;
+}
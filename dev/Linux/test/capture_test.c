@@ -0,0 +1,310 @@
+/**
+ * \file            capture_test.c
+ * \brief           AT link capture test, records are parsed back as pcapng blocks
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <string.h>
+#include "esp/esp.h"
+#include "esp/esp_private.h"
+#include "esp/esp_capture.h"
+#include "esp/esp_mem.h"
+#include "system/esp_sys.h"
+#include "test.h"
+
+#define TEST_BT_SHB                 0x0A0D0D0AUL
+#define TEST_BT_IDB                 0x00000001UL
+#define TEST_BT_EPB                 0x00000006UL
+#define TEST_LINKTYPE_USER0         147
+#define TEST_FLAG_INBOUND           0x01
+#define TEST_FLAG_OUTBOUND          0x02
+
+/* Size of SHB and IDB written on start, and EPB overhead */
+#define TEST_HEADER_LEN             (52 + 44)
+#define TEST_EPB_LEN(len)           (44 + (((len) + 3) & ~3))
+
+/**
+ * \brief           Single parsed packet record
+ */
+typedef struct {
+    uint32_t flags;                             /*!< Direction flags */
+    uint64_t time;                              /*!< Timestamp in units of microseconds */
+    const uint8_t* data;                        /*!< Packet data */
+    uint32_t len;                               /*!< Length of packet data */
+} test_pkt_t;
+
+static size_t sent_len;
+static uint8_t out_buff[0x1000];
+static size_t out_len;
+static esp_sys_sem_t recv_done;
+
+/**
+ * \brief           Low-level send stub, counts bytes
+ */
+static size_t
+test_send(const void* data, size_t len) {
+    sent_len += len;
+    return len;
+}
+
+/**
+ * \brief           Capture output to linear buffer
+ */
+static void
+test_out(const void* data, size_t len, void* arg) {
+    if (out_len + len <= sizeof(out_buff)) {
+        memcpy(&out_buff[out_len], data, len);
+        out_len += len;
+    }
+}
+
+/**
+ * \brief           Read 32-bit value in host byte order
+ */
+static uint32_t
+test_u32(const uint8_t* p) {
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * \brief           Parse capture file and check block structure
+ * \param[in]       d: Capture data
+ * \param[in]       len: Length of capture data
+ * \param[out]      pkts: Parsed packet records
+ * \param[in]       max_pkts: Size of records array
+ * \return          Number of packet records, `-1` on structure error
+ */
+static int
+test_parse(const uint8_t* d, size_t len, test_pkt_t* pkts, size_t max_pkts) {
+    size_t off = 0, blen, n = 0;
+    uint32_t type;
+
+    while (off < len) {
+        if (len - off < 12) {
+            printf("Truncated block at %u\r\n", (unsigned)off);
+            return -1;
+        }
+        type = test_u32(&d[off]);
+        blen = test_u32(&d[off + 4]);
+        if (blen < 12 || (blen & 3) != 0 || blen > len - off
+            || test_u32(&d[off + blen - 4]) != blen) {
+            printf("Bad block length %u at %u\r\n", (unsigned)blen, (unsigned)off);
+            return -1;
+        }
+        if (off == 0 && (type != TEST_BT_SHB || test_u32(&d[8]) != 0x1A2B3C4DUL)) {
+            printf("Capture does not start with section header\r\n");
+            return -1;
+        }
+        if (type == TEST_BT_IDB) {
+            if ((test_u32(&d[off + 8]) & 0xFFFF) != TEST_LINKTYPE_USER0) {
+                printf("Bad link type\r\n");
+                return -1;
+            }
+        } else if (type == TEST_BT_EPB) {
+            const uint8_t* b = &d[off];
+            uint32_t cap_len = test_u32(&b[20]), opt;
+
+            if (n == max_pkts || cap_len != test_u32(&b[24])
+                || TEST_EPB_LEN(cap_len) != blen) {
+                printf("Bad packet block at %u\r\n", (unsigned)off);
+                return -1;
+            }
+            opt = 28 + ((cap_len + 3) & ~3);
+            if (test_u32(&b[opt]) != (2 | (4UL << 16)) || test_u32(&b[opt + 8]) != 0) {
+                printf("Missing flags option at %u\r\n", (unsigned)off);
+                return -1;
+            }
+            pkts[n].flags = test_u32(&b[opt + 4]);
+            pkts[n].time = ((uint64_t)test_u32(&b[12]) << 32) | test_u32(&b[16]);
+            pkts[n].data = &b[28];
+            pkts[n].len = cap_len;
+            ++n;
+        } else if (type != TEST_BT_SHB) {
+            printf("Unknown block type 0x%08X\r\n", (unsigned)type);
+            return -1;
+        }
+        off += blen;
+    }
+    return (int)n;
+}
+
+/**
+ * \brief           Check packet direction and content
+ */
+static uint8_t
+test_pkt_is(const test_pkt_t* p, uint32_t flags, const char* data) {
+    return p->flags == flags && p->len == strlen(data) && !memcmp(p->data, data, p->len);
+}
+
+/**
+ * \brief           Record received data from other thread while core is locked
+ */
+static void
+test_recv_thread(void* arg) {
+    espi_capture_recv("+IPD,0,4:ping", 13);
+    esp_sys_sem_release(&recv_done);
+    esp_sys_thread_terminate(NULL);
+}
+
+/**
+ * \brief           Records are written in time order with direction flags
+ */
+static void
+test_records(void) {
+    static uint8_t data[0x1000];
+    esp_capture_stats_t stats;
+    test_pkt_t pkts[8];
+    size_t len;
+    int n;
+
+    TEST_CHECK(esp_capture_start_ring(sizeof(data)) == espOK);
+    espi_capture_send("AT+CIPSEND=0,", 13);     /* Combined to single record */
+    espi_capture_send("4\r\n", 3);
+    espi_capture_send(NULL, 0);
+    espi_capture_recv("OK\r\n>", 5);
+    espi_capture_send("ping", 4);               /* Flushed by next receive */
+    espi_capture_recv("SEND OK\r\n", 9);
+
+    /* Receive path must not wait for core lock */
+    esp_core_lock();
+    esp_sys_thread_create(NULL, "capture_recv", test_recv_thread, NULL, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO);
+    TEST_CHECK(esp_sys_sem_wait(&recv_done, 2000) != ESP_SYS_TIMEOUT);
+    esp_core_unlock();
+
+    len = esp_capture_read(data, sizeof(data));
+    TEST_CHECK(len == TEST_HEADER_LEN + TEST_EPB_LEN(16) + TEST_EPB_LEN(5)
+                        + TEST_EPB_LEN(4) + TEST_EPB_LEN(9) + TEST_EPB_LEN(13));
+    n = test_parse(data, len, pkts, ESP_ARRAYSIZE(pkts));
+    TEST_CHECK(n == 5);
+    if (n == 5) {
+        TEST_CHECK(test_pkt_is(&pkts[0], TEST_FLAG_OUTBOUND, "AT+CIPSEND=0,4\r\n"));
+        TEST_CHECK(test_pkt_is(&pkts[1], TEST_FLAG_INBOUND, "OK\r\n>"));
+        TEST_CHECK(test_pkt_is(&pkts[2], TEST_FLAG_OUTBOUND, "ping"));
+        TEST_CHECK(test_pkt_is(&pkts[3], TEST_FLAG_INBOUND, "SEND OK\r\n"));
+        TEST_CHECK(test_pkt_is(&pkts[4], TEST_FLAG_INBOUND, "+IPD,0,4:ping"));
+        for (int i = 1; i < n; ++i) {
+            TEST_CHECK(pkts[i].time >= pkts[i - 1].time);
+        }
+    }
+    TEST_CHECK(esp_capture_get_stats(&stats) == espOK);
+    TEST_CHECK(stats.tx_bytes == 20 && stats.rx_bytes == 27 && stats.records == 5 && stats.dropped == 0);
+    TEST_CHECK(sent_len == 20);
+    esp_capture_stop();
+}
+
+/**
+ * \brief           Full ring drops whole records, never writes partial ones
+ */
+static void
+test_ring_full(void) {
+    static uint8_t data[0x400];
+    esp_capture_stats_t stats;
+    test_pkt_t pkts[4];
+    size_t len;
+    int n;
+
+    /* Ring keeps one byte free, it must hold header and smallest record */
+    TEST_CHECK(esp_capture_start_ring(TEST_HEADER_LEN) == espPARERR);
+    TEST_CHECK(esp_capture_start_ring(TEST_HEADER_LEN + TEST_EPB_LEN(1)) == espPARERR);
+    TEST_CHECK(esp_capture_start_ring(TEST_HEADER_LEN + TEST_EPB_LEN(1) + 1) == espOK);
+    espi_capture_recv("1", 1);
+    TEST_CHECK(esp_capture_get_stats(&stats) == espOK && stats.records == 1 && stats.dropped == 0);
+    len = esp_capture_read(data, sizeof(data));
+    TEST_CHECK(len == TEST_HEADER_LEN + TEST_EPB_LEN(1));
+    TEST_CHECK(test_parse(data, len, pkts, ESP_ARRAYSIZE(pkts)) == 1);
+    esp_capture_stop();
+
+    /* Room for header and one 8-byte record only */
+    TEST_CHECK(esp_capture_start_ring(TEST_HEADER_LEN + TEST_EPB_LEN(8) + TEST_EPB_LEN(8) / 2) == espOK);
+    espi_capture_recv("12345678", 8);
+    espi_capture_recv("abcdefgh", 8);           /* Dropped */
+    espi_capture_recv("ABCDEFGH", 8);           /* Dropped */
+    TEST_CHECK(esp_capture_get_stats(&stats) == espOK);
+    TEST_CHECK(stats.records == 1 && stats.dropped == 2 && stats.rx_bytes == 24);
+
+    len = esp_capture_read(data, sizeof(data));
+    TEST_CHECK(len == TEST_HEADER_LEN + TEST_EPB_LEN(8));
+    n = test_parse(data, len, pkts, ESP_ARRAYSIZE(pkts));
+    TEST_CHECK(n == 1 && test_pkt_is(&pkts[0], TEST_FLAG_INBOUND, "12345678"));
+
+    /* Reading frees space for new records */
+    espi_capture_recv("ijklmnop", 8);
+    len = esp_capture_read(data, sizeof(data));
+    TEST_CHECK(len == TEST_EPB_LEN(8));
+    TEST_CHECK(test_u32(data) == TEST_BT_EPB && test_u32(&data[4]) == TEST_EPB_LEN(8));
+    TEST_CHECK(!memcmp(&data[28], "ijklmnop", 8));
+    esp_capture_stop();
+}
+
+/**
+ * \brief           Output function receives same file as ring buffer
+ */
+static void
+test_output_fn(void) {
+    test_pkt_t pkts[4];
+    int n;
+
+    out_len = 0;
+    TEST_CHECK(esp_capture_start(test_out, NULL) == espOK);
+    TEST_CHECK(out_len == TEST_HEADER_LEN);
+    espi_capture_send("AT\r\n", 4);
+    espi_capture_recv("OK\r\n", 4);
+    esp_capture_stop();
+    espi_capture_recv("late", 4);               /* Not recorded after stop */
+    n = test_parse(out_buff, out_len, pkts, ESP_ARRAYSIZE(pkts));
+    TEST_CHECK(n == 2);
+    if (n == 2) {
+        TEST_CHECK(test_pkt_is(&pkts[0], TEST_FLAG_OUTBOUND, "AT\r\n"));
+        TEST_CHECK(test_pkt_is(&pkts[1], TEST_FLAG_INBOUND, "OK\r\n"));
+    }
+}
+
+/**
+ * \brief           Program entry point
+ */
+int
+main(void) {
+    if (!esp_sys_init() || !test_init_heap()
+        || !esp_sys_sem_create(&recv_done, 0)) {
+        printf("Could not initialize test\r\n");
+        return 1;
+    }
+    esp.ll.send_fn = test_send;                 /* No device, library is not initialized */
+
+    test_records();
+    test_ring_full();
+    test_output_fn();
+
+    return test_result();
+}
@@ -0,0 +1,375 @@
+/**
+ * \file            cbor_test.c
+ * \brief           Streaming CBOR encoder and decoder test
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+#include "esp/apps/esp_cbor.h"
+#include "system/esp_sys.h"
+
+#define TEST_HEAP_SIZE              0x4000
+#include "test.h"
+
+#define TEST_TRACE_LEN              512
+
+/**
+ * \brief           Decoding vector
+ */
+typedef struct {
+    const char* hex;                            /*!< Encoded data in hex */
+    espr_t res;                                 /*!< Expected result of decoding */
+    const char* trace;                          /*!< Expected items, `NULL` when not checked */
+} test_vector_t;
+
+/**
+ * \brief           Trace of decoded items
+ */
+typedef struct {
+    char str[TEST_TRACE_LEN];                   /*!< Items in text form */
+    char val[64];                               /*!< Collected string value */
+    size_t val_len;                             /*!< Length of collected string value */
+    uint8_t stale;                              /*!< Set to `1` when non-string item carried string data */
+} test_trace_t;
+
+static const test_vector_t vectors[] = {
+    /* Integers */
+    { "00", espOK, "u0" },
+    { "17", espOK, "u23" },
+    { "1818", espOK, "u24" },
+    { "1903e8", espOK, "u1000" },
+    { "1b000000e8d4a51000", espOK, "u1000000000000" },
+    { "1bffffffffffffffff", espOK, "u18446744073709551615" },
+    { "20", espOK, "n-1" },
+    { "3903e7", espOK, "n-1000" },
+    { "3b7fffffffffffffff", espOK, "n-9223372036854775808" },
+
+    /* Half, single and double precision floats */
+    { "f90000", espOK, "f0" },
+    { "f98000", espOK, "f-0" },
+    { "f93c00", espOK, "f1" },
+    { "f93e00", espOK, "f1.5" },
+    { "f97bff", espOK, "f65504" },
+    { "f90001", espOK, "f5.96046e-08" },
+    { "f90400", espOK, "f6.10352e-05" },
+    { "f9c400", espOK, "f-4" },
+    { "f97c00", espOK, "finf" },
+    { "f9fc00", espOK, "f-inf" },
+    { "f97e00", espOK, "fnan" },
+    { "fa47c35000", espOK, "f100000" },
+    { "fb3ff199999999999a", espOK, "f1.1" },
+
+    /* Simple values and tags */
+    { "f4f5f6f7", espOK, "false true null undefined" },
+    { "f0f8ff", espOK, "s16 s255" },
+    { "c11a514b67b0", espOK, "tag1 u1363896240" },
+    { "d82076687474703a2f2f7777772e6578616d706c652e636f6d", espOK, "tag32 t'http://www.example.com'" },
+
+    /* Strings */
+    { "40", espOK, "h''" },
+    { "4401020304", espOK, "h'01020304'" },
+    { "60", espOK, "t''" },
+    { "6449455446", espOK, "t'IETF'" },
+    { "62c3bc", espOK, "t'\xc3\xbc'" },
+
+    /* Definite containers */
+    { "80", espOK, "[0 ]" },
+    { "a0", espOK, "{0 }" },
+    { "83010203", espOK, "[3 u1 u2 u3 ]" },
+    { "8301820203820405", espOK, "[3 u1 [2 u2 u3 ] [2 u4 u5 ] ]" },
+    { "a201020304", espOK, "{2 u1 u2 u3 u4 }" },
+    { "a26161016162820203", espOK, "{2 t'a' u1 t'b' [2 u2 u3 ] }" },
+
+    /* Nested indefinite containers */
+    { "9fff", espOK, "[_ ]" },
+    { "bfff", espOK, "{_ }" },
+    { "9f018202039f0405ffff", espOK, "[_ u1 [2 u2 u3 ] [_ u4 u5 ] ]" },
+    { "bf61610161629f0203ffff", espOK, "{_ t'a' u1 t'b' [_ u2 u3 ] }" },
+    { "9fbfff9f9fffffff", espOK, "[_ {_ } [_ [_ ] ] ]" },
+    { "bf01bf0203ffff", espOK, "{_ u1 {_ u2 u3 } }" },
+    { "826161bf61626163ff", espOK, "[2 t'a' {_ t'b' t'c' } ]" },
+
+    /* Malformed data */
+    { "bf01ff", espERR, NULL },                 /* Map key without value */
+    { "bf010203ff", espERR, NULL },
+    { "bf01bf02ffff", espERR, NULL },           /* Odd count in nested map */
+    { "9fc1ff", espERR, NULL },                 /* Tag followed by break */
+    { "bfc1ff", espERR, NULL },
+    { "c1", espERR, NULL },                     /* Tag without item at end */
+    { "ff", espERR, NULL },                     /* Break outside container */
+    { "8201ff", espERR, NULL },                 /* Break in definite container */
+    { "5f", espERR, NULL },                     /* Indefinite strings not supported */
+    { "1c", espERR, NULL },                     /* Reserved additional information */
+    { "1903", espERR, NULL },                   /* Truncated argument */
+    { "64494554", espERR, NULL },               /* Truncated string */
+    { "8301", espERR, NULL },                   /* Truncated array */
+    { "9f01", espERR, NULL },
+    { "818181818181818100", espOK, "[1 [1 [1 [1 [1 [1 [1 [1 u0 ] ] ] ] ] ] ] ]" },
+    { "81818181818181818100", espERRMEM, NULL },/* Nesting limit */
+};
+
+
+/**
+ * \brief           Convert hex string to binary
+ * \return          Length of data
+ */
+static size_t
+test_unhex(const char* hex, uint8_t* data, size_t size) {
+    size_t len = 0;
+    unsigned int b;
+
+    for (; hex[0] != '\0' && hex[1] != '\0' && len < size; hex += 2) {
+        sscanf(hex, "%2x", &b);
+        data[len++] = (uint8_t)b;
+    }
+    return len;
+}
+
+/**
+ * \brief           Append text to trace
+ */
+static void
+test_trace_add(test_trace_t* t, const char* str) {
+    size_t len = strlen(t->str);
+
+    snprintf(&t->str[len], sizeof(t->str) - len, "%s%s", len > 0 ? " " : "", str);
+}
+
+/**
+ * \brief           Decoder callback, writes items to trace
+ */
+static espr_t
+test_item(esp_cbor_decoder_t* d, const esp_cbor_item_t* item) {
+    test_trace_t* t = d->arg;
+    char str[96];
+
+    if (item->type != ESP_CBOR_TYPE_BYTES && item->type != ESP_CBOR_TYPE_TEXT
+        && (item->data != NULL || item->len != 0)) {
+        t->stale = 1;
+    }
+    switch (item->type) {
+        case ESP_CBOR_TYPE_UINT: snprintf(str, sizeof(str), "u%" PRIu64, item->val.u); break;
+        case ESP_CBOR_TYPE_NINT: snprintf(str, sizeof(str), "n%" PRId64, item->val.i); break;
+        case ESP_CBOR_TYPE_BYTES:
+        case ESP_CBOR_TYPE_TEXT:
+            if (item->off != t->val_len) {
+                return espERR;                  /* Chunks must follow each other */
+            }
+            if (t->val_len + item->len < sizeof(t->val)) {
+                memcpy(&t->val[t->val_len], item->data, item->len);
+            }
+            t->val_len += item->len;
+            if (item->off + item->len < item->val.u) {
+                return espOK;                   /* Wait for rest of string */
+            }
+            if (item->type == ESP_CBOR_TYPE_TEXT) {
+                snprintf(str, sizeof(str), "t'%.*s'", (int)t->val_len, t->val);
+            } else {
+                size_t n = snprintf(str, sizeof(str), "h'");
+
+                for (size_t i = 0; i < t->val_len && n + 4 < sizeof(str); ++i) {
+                    n += snprintf(&str[n], sizeof(str) - n, "%02x", (uint8_t)t->val[i]);
+                }
+                snprintf(&str[n], sizeof(str) - n, "'");
+            }
+            t->val_len = 0;
+            break;
+        case ESP_CBOR_TYPE_ARR_BEGIN:
+        case ESP_CBOR_TYPE_MAP_BEGIN:
+            if (item->val.u == ESP_CBOR_INDEFINITE) {
+                snprintf(str, sizeof(str), "%c_", item->type == ESP_CBOR_TYPE_ARR_BEGIN ? '[' : '{');
+            } else {
+                snprintf(str, sizeof(str), "%c%" PRIu64, item->type == ESP_CBOR_TYPE_ARR_BEGIN ? '[' : '{', item->val.u);
+            }
+            break;
+        case ESP_CBOR_TYPE_ARR_END: strcpy(str, "]"); break;
+        case ESP_CBOR_TYPE_MAP_END: strcpy(str, "}"); break;
+        case ESP_CBOR_TYPE_TAG: snprintf(str, sizeof(str), "tag%" PRIu64, item->val.u); break;
+        case ESP_CBOR_TYPE_FALSE: strcpy(str, "false"); break;
+        case ESP_CBOR_TYPE_TRUE: strcpy(str, "true"); break;
+        case ESP_CBOR_TYPE_NULL: strcpy(str, "null"); break;
+        case ESP_CBOR_TYPE_UNDEFINED: strcpy(str, "undefined"); break;
+        case ESP_CBOR_TYPE_SIMPLE: snprintf(str, sizeof(str), "s%" PRIu64, item->val.u); break;
+        case ESP_CBOR_TYPE_FLOAT: snprintf(str, sizeof(str), "f%g", item->val.f); break;
+        default: return espERR;
+    }
+    test_trace_add(t, str);
+    return espOK;
+}
+
+/**
+ * \brief           Decode data fed in pieces of fixed size
+ * \param[in]       data: Encoded data
+ * \param[in]       len: Length of data
+ * \param[in]       step: Length of single piece
+ * \param[out]      t: Trace of decoded items
+ * \return          Result of decoding
+ */
+static espr_t
+test_decode(const uint8_t* data, size_t len, size_t step, test_trace_t* t) {
+    esp_cbor_decoder_t d;
+
+    memset(t, 0x00, sizeof(*t));
+    esp_cbor_decoder_init(&d, test_item, t);
+    for (size_t off = 0; off < len; off += step) {
+        if (esp_cbor_decoder_feed(&d, &data[off], ESP_MIN(step, len - off)) != espOK) {
+            break;
+        }
+    }
+    return esp_cbor_decoder_finish(&d);
+}
+
+/**
+ * \brief           Decode vectors at once and byte by byte
+ */
+static void
+test_vectors(void) {
+    test_trace_t whole, bytes;
+    uint8_t data[64];
+    size_t len;
+    espr_t res;
+
+    for (size_t i = 0; i < ESP_ARRAYSIZE(vectors); ++i) {
+        const test_vector_t* v = &vectors[i];
+
+        len = test_unhex(v->hex, data, sizeof(data));
+        res = test_decode(data, len, len, &whole);
+        if (res != v->res || (v->trace != NULL && strcmp(whole.str, v->trace)) || whole.stale) {
+            printf("Vector %s: result %d, items \"%s\"%s\r\n", v->hex, (int)res, whole.str,
+                whole.stale ? ", stale string data" : "");
+            ++test_failed;
+        }
+        res = test_decode(data, len, 1, &bytes);
+        if (res != v->res || strcmp(whole.str, bytes.str) || bytes.stale) {
+            printf("Vector %s fed by bytes: result %d, items \"%s\"\r\n", v->hex, (int)res, bytes.str);
+            ++test_failed;
+        }
+    }
+}
+
+/**
+ * \brief           Encode items and decode them back
+ */
+static void
+test_round_trip(void) {
+    static const uint8_t raw[] = { 0x00, 0xFF, 0x10 };
+    esp_cbor_writer_t w;
+    test_trace_t t;
+    uint8_t buff[128], small[4];
+    esp_pbuf_p p1, p2;
+    size_t len;
+
+    esp_cbor_writer_init_buff(&w, buff, sizeof(buff));
+    TEST_CHECK(esp_cbor_map_begin(&w, ESP_CBOR_INDEFINITE) == espOK);
+    esp_cbor_text(&w, "u");
+    esp_cbor_arr_begin(&w, 4);
+    esp_cbor_uint(&w, 23);
+    esp_cbor_uint(&w, 24);
+    esp_cbor_uint(&w, 70000);
+    esp_cbor_uint(&w, UINT64_MAX);
+    esp_cbor_text(&w, "i");
+    esp_cbor_arr_begin(&w, ESP_CBOR_INDEFINITE);
+    esp_cbor_int(&w, -1);
+    esp_cbor_int(&w, -1000);
+    esp_cbor_int(&w, INT64_MIN);
+    esp_cbor_end(&w);
+    esp_cbor_textn(&w, "bytes", 1);
+    esp_cbor_bytes(&w, raw, sizeof(raw));
+    esp_cbor_text(&w, "f");
+    esp_cbor_float(&w, 1.5f);
+    esp_cbor_text(&w, "t");
+    esp_cbor_tag(&w, 1);
+    esp_cbor_uint(&w, 1363896240);
+    esp_cbor_text(&w, "s");
+    esp_cbor_map_begin(&w, 2);
+    esp_cbor_bool(&w, 1);
+    esp_cbor_bool(&w, 0);
+    esp_cbor_null(&w);
+    esp_cbor_map_begin(&w, 0);
+    TEST_CHECK(esp_cbor_end(&w) == espOK);
+    len = esp_cbor_writer_get_len(&w);
+    TEST_CHECK(!w.err);
+
+    TEST_CHECK(test_decode(buff, len, len, &t) == espOK);
+    TEST_CHECK(!strcmp(t.str, "{_ t'u' [4 u23 u24 u70000 u18446744073709551615 ] "
+                            "t'i' [_ n-1 n-1000 n-9223372036854775808 ] t'b' h'00ff10' t'f' f1.5 "
+                            "t't' tag1 u1363896240 t's' {2 true false null {0 } } }"));
+    for (size_t step = 1; step < 8; ++step) {
+        test_trace_t s;
+
+        TEST_CHECK(test_decode(buff, len, step, &s) == espOK && !strcmp(s.str, t.str));
+    }
+
+    /* Canonical integer encoding */
+    TEST_CHECK(!memcmp(&buff[3], "\x84\x17\x18\x18\x1a\x00\x01\x11\x70", 9));
+
+    /* Pbuf chain split in the middle of string */
+    p1 = esp_pbuf_new(len / 2);
+    p2 = esp_pbuf_new(len - len / 2);
+    TEST_CHECK(p1 != NULL && p2 != NULL);
+    if (p1 != NULL && p2 != NULL) {
+        esp_cbor_decoder_t d;
+        test_trace_t s;
+
+        esp_pbuf_take(p1, buff, len / 2, 0);
+        esp_pbuf_take(p2, &buff[len / 2], len - len / 2, 0);
+        esp_pbuf_cat(p1, p2);
+        memset(&s, 0x00, sizeof(s));
+        esp_cbor_decoder_init(&d, test_item, &s);
+        TEST_CHECK(esp_cbor_decoder_feed_pbuf(&d, p1) == espOK);
+        TEST_CHECK(esp_cbor_decoder_finish(&d) == espOK && !strcmp(s.str, t.str));
+        esp_pbuf_free(p1);
+    }
+
+    /* Output overflow is reported */
+    esp_cbor_writer_init_buff(&w, small, sizeof(small));
+    TEST_CHECK(esp_cbor_text(&w, "hello") != espOK);
+    TEST_CHECK(w.err);
+}
+
+/**
+ * \brief           Program entry point
+ */
+int
+main(void) {
+    if (!esp_sys_init() || !test_init_heap()) {
+        printf("Could not initialize test\r\n");
+        return 1;
+    }
+
+    test_vectors();
+    test_round_trip();
+
+    return test_result();
+}
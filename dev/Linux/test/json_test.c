@@ -0,0 +1,448 @@
+/**
+ * \file            json_test.c
+ * \brief           Streaming JSON writer and parser test
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+#include "esp/apps/esp_json.h"
+#include "system/esp_sys.h"
+#include "test.h"
+
+#define TEST_TRACE_LEN              512
+#define TEST_ECHO_PORT              7
+
+/**
+ * \brief           Parsing vector
+ */
+typedef struct {
+    const char* doc;                            /*!< JSON document */
+    espr_t res;                                 /*!< Expected result of parsing */
+    const char* trace;                          /*!< Expected tokens, `NULL` when not checked */
+} test_vector_t;
+
+/**
+ * \brief           Trace of parsed tokens
+ */
+typedef struct {
+    char str[TEST_TRACE_LEN];                   /*!< Tokens in text form */
+    uint32_t stop_at;                           /*!< Token number at which callback stops parser, `0` to never stop */
+    uint32_t count;                             /*!< Number of tokens */
+} test_trace_t;
+
+#define TEST_STR64                  "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+
+static const test_vector_t vectors[] = {
+    /* Values */
+    { "true", espOK, "true" },
+    { " false ", espOK, "false" },
+    { "null", espOK, "null" },
+    { "\"\"", espOK, "s''" },
+    { "42", espOK, "n'42'" },
+    { "-0", espOK, "n'-0'" },
+    { "12.5e+3", espOK, "n'12.5e+3'" },
+    { "[-1E-2,0.5,0]", espOK, "[ n'-1E-2' n'0.5' n'0' ]" },
+    { "{\"a\":1,\"b\":[true,null,{\"c\":\"d\"}],\"e\":{}}", espOK,
+        "{ k'a' n'1' k'b' [ true null { k'c' s'd' } ] k'e' { } }" },
+    { " \r\n\t[ ] ", espOK, "[ ]" },
+    { "[[],[[]],{}]", espOK, "[ [ ] [ [ ] ] { } ]" },
+
+    /* Escapes and surrogate pairs */
+    { "\"a\\\"b\\\\c\\/d\"", espOK, "s'a\"b\\c/d'" },
+    { "\"\\b\\f\\n\\r\\t\"", espOK, "s'\\x08\\x0c\\x0a\\x0d\\x09'" },
+    { "\"\\u0041\\u00e9\\u20AC\"", espOK, "s'A\\xc3\\xa9\\xe2\\x82\\xac'" },
+    { "\"\\ud83d\\ude00!\"", espOK, "s'\\xf0\\x9f\\x98\\x80!'" },
+    { "{\"\\u006b\":\"\\uDBFF\\uDFFF\"}", espOK, "{ k'k' s'\\xf4\\x8f\\xbf\\xbf' }" },
+    { "\"\\ud83d\"", espERR, NULL },            /* High surrogate without low one */
+    { "\"\\ud83dx\"", espERR, NULL },
+    { "\"\\ud83d\\n\"", espERR, NULL },
+    { "\"\\ud83d\\ud83d\"", espERR, NULL },
+    { "\"\\ude00\"", espERR, NULL },            /* Low surrogate alone */
+    { "\"\\u12g4\"", espERR, NULL },
+    { "\"\\x\"", espERR, NULL },
+    { "\"a\nb\"", espERR, NULL },               /* Control character in string */
+
+    /* Malformed numbers and literals */
+    { "01", espERR, NULL },
+    { "1.", espERR, NULL },
+    { "-", espERR, NULL },
+    { ".5", espERR, NULL },
+    { "1e", espERR, NULL },
+    { "+1", espERR, NULL },
+    { "[1.2.3]", espERR, NULL },
+    { "[--1]", espERR, NULL },
+    { "tru", espERR, NULL },
+    { "trux", espERR, NULL },
+    { "nul", espERR, NULL },
+
+    /* Malformed structure */
+    { "", espERR, NULL },
+    { "[", espERR, NULL },
+    { "{\"a\" 1}", espERR, NULL },
+    { "{\"a\":1,}", espERR, NULL },
+    { "[1,]", espERR, NULL },
+    { "[1 2]", espERR, NULL },
+    { "{1:2}", espERR, NULL },
+    { "]", espERR, NULL },
+    { "[}", espERR, NULL },
+    { "{\"a\":1]", espERR, NULL },
+    { "[1]x", espERR, NULL },
+    { "[1] [2]", espERR, NULL },
+    { "\"abc", espERR, NULL },
+
+    /* Depth and token length limits */
+    { "[[[[[[[[]]]]]]]]", espOK, "[ [ [ [ [ [ [ [ ] ] ] ] ] ] ] ]" },
+    { "[[[[[[[[[]]]]]]]]]", espERRMEM, NULL },
+    { "\"" TEST_STR64 "\"", espOK, "s'" TEST_STR64 "'" },
+    { "\"" TEST_STR64 "x\"", espERRMEM, NULL },
+    { "{\"" TEST_STR64 "x\":1}", espERRMEM, NULL },
+    { "\"" TEST_STR64 "\\n\"", espERRMEM, NULL },
+    { "\"" TEST_STR64 "\"", espOK, NULL },
+    { "[1234567890123456789012345678901234567890123456789012345678901234]", espOK, NULL },
+    { "[12345678901234567890123456789012345678901234567890123456789012345]", espERRMEM, NULL },
+};
+
+static char doc_conn[256], doc_http[256];
+static char echo[512];
+static size_t echo_len;
+static esp_sys_sem_t echo_sem;
+
+/**
+ * \brief           Append text to trace
+ */
+static void
+test_trace_add(test_trace_t* t, const char* str) {
+    size_t len = strlen(t->str);
+
+    snprintf(&t->str[len], sizeof(t->str) - len, "%s%s", len > 0 ? " " : "", str);
+}
+
+/**
+ * \brief           Parser callback, writes tokens to trace
+ */
+static espr_t
+test_token(esp_json_parser_t* p, esp_json_type_t type, const char* data, size_t len) {
+    test_trace_t* t = p->arg;
+    char str[TEST_TRACE_LEN / 2];
+    size_t n = 0;
+
+    if (t->stop_at > 0 && ++t->count == t->stop_at) {
+        return espERRBLOCKING;
+    }
+    switch (type) {
+        case ESP_JSON_TYPE_OBJ_BEGIN: strcpy(str, "{"); break;
+        case ESP_JSON_TYPE_OBJ_END: strcpy(str, "}"); break;
+        case ESP_JSON_TYPE_ARR_BEGIN: strcpy(str, "["); break;
+        case ESP_JSON_TYPE_ARR_END: strcpy(str, "]"); break;
+        case ESP_JSON_TYPE_TRUE: strcpy(str, "true"); break;
+        case ESP_JSON_TYPE_FALSE: strcpy(str, "false"); break;
+        case ESP_JSON_TYPE_NULL: strcpy(str, "null"); break;
+        case ESP_JSON_TYPE_KEY:
+        case ESP_JSON_TYPE_STRING:
+        case ESP_JSON_TYPE_NUMBER:
+            if (data == NULL || data[len] != '\0') {
+                return espERR;                  /* Token text must be terminated */
+            }
+            n = snprintf(str, sizeof(str), "%c'", type == ESP_JSON_TYPE_KEY ? 'k' : type == ESP_JSON_TYPE_STRING ? 's' : 'n');
+            for (size_t i = 0; i < len && n + 6 < sizeof(str); ++i) {
+                uint8_t ch = (uint8_t)data[i];
+
+                n += snprintf(&str[n], sizeof(str) - n, (ch < 0x20 || ch >= 0x7F) ? "\\x%02x" : "%c", ch);
+            }
+            snprintf(&str[n], sizeof(str) - n, "'");
+            break;
+        default:
+            return espERR;
+    }
+    if (type != ESP_JSON_TYPE_KEY && type != ESP_JSON_TYPE_STRING && type != ESP_JSON_TYPE_NUMBER
+        && (data != NULL || len != 0)) {
+        return espERR;
+    }
+    test_trace_add(t, str);
+    return espOK;
+}
+
+/**
+ * \brief           Parse document fed in pieces of fixed size
+ * \param[in]       doc: JSON document
+ * \param[in]       len: Length of document
+ * \param[in]       step: Length of single piece
+ * \param[out]      t: Trace of parsed tokens
+ * \return          Result of parsing
+ */
+static espr_t
+test_parse(const char* doc, size_t len, size_t step, test_trace_t* t) {
+    esp_json_parser_t p;
+
+    memset(t, 0x00, sizeof(*t));
+    esp_json_parser_init(&p, test_token, t);
+    for (size_t off = 0; off < len; off += step) {
+        if (esp_json_parser_feed(&p, &doc[off], ESP_MIN(step, len - off)) != espOK) {
+            break;
+        }
+    }
+    return esp_json_parser_finish(&p);
+}
+
+/**
+ * \brief           Parse vectors at once and byte by byte
+ */
+static void
+test_vectors(void) {
+    test_trace_t whole, bytes;
+    size_t len;
+    espr_t res;
+
+    for (size_t i = 0; i < ESP_ARRAYSIZE(vectors); ++i) {
+        const test_vector_t* v = &vectors[i];
+
+        len = strlen(v->doc);
+        res = test_parse(v->doc, len, len > 0 ? len : 1, &whole);
+        if (res != v->res || (v->trace != NULL && strcmp(whole.str, v->trace))) {
+            printf("Vector %s: result %d, tokens \"%s\"\r\n", v->doc, (int)res, whole.str);
+            ++test_failed;
+        }
+        res = test_parse(v->doc, len, 1, &bytes);
+        if (res != v->res || strcmp(whole.str, bytes.str)) {
+            printf("Vector %s fed by bytes: result %d, tokens \"%s\"\r\n", v->doc, (int)res, bytes.str);
+            ++test_failed;
+        }
+    }
+}
+
+/**
+ * \brief           Parser stops with value returned by callback and keeps it
+ */
+static void
+test_callback_stop(void) {
+    static const char doc[] = "[1,2,3]";
+    esp_json_parser_t p;
+    test_trace_t t;
+
+    memset(&t, 0x00, sizeof(t));
+    t.stop_at = 3;
+    esp_json_parser_init(&p, test_token, &t);
+    TEST_CHECK(esp_json_parser_feed(&p, doc, sizeof(doc) - 1) == espERRBLOCKING);
+    TEST_CHECK(!strcmp(t.str, "[ n'1'"));
+    TEST_CHECK(p.pos == 4);                     /* Stopped at comma after second number */
+    TEST_CHECK(esp_json_parser_feed(&p, "]", 1) == espERRBLOCKING);
+    TEST_CHECK(esp_json_parser_finish(&p) == espERRBLOCKING);
+}
+
+/**
+ * \brief           Write document with all value types
+ * \param[in]       w: Initialized writer
+ * \return          Result of last write
+ */
+static espr_t
+test_write_doc(esp_json_writer_t* w) {
+    esp_json_obj_begin(w, NULL);
+    esp_json_str(w, "name", "esp \"at\"\\\n\t\x01");
+    esp_json_strn(w, "bin", "a\0b", 3);
+    esp_json_int(w, "min", INT32_MIN);
+    esp_json_uint(w, "max", UINT32_MAX);
+    esp_json_arr_begin(w, "list");
+    esp_json_bool(w, NULL, 1);
+    esp_json_bool(w, NULL, 0);
+    esp_json_null(w, NULL);
+    esp_json_raw(w, NULL, "1.5e3");
+    esp_json_obj_begin(w, NULL);
+    esp_json_obj_end(w);
+    esp_json_arr_begin(w, NULL);
+    esp_json_arr_end(w);
+    esp_json_arr_end(w);
+    esp_json_str(w, "\xe2\x82\xac", "");
+    return esp_json_obj_end(w);
+}
+
+#define TEST_DOC        "{\"name\":\"esp \\\"at\\\"\\\\\\n\\t\\u0001\",\"bin\":\"a\\u0000b\","  \
+                        "\"min\":-2147483648,\"max\":4294967295,"                           \
+                        "\"list\":[true,false,null,1.5e3,{},[]],\"\xe2\x82\xac\":\"\"}"
+#define TEST_DOC_TRACE  "{ k'name' s'esp \"at\"\\\\x0a\\x09\\x01' k'bin' s'a\\x00b' "      \
+                        "k'min' n'-2147483648' k'max' n'4294967295' "                       \
+                        "k'list' [ true false null n'1.5e3' { } [ ] ] k'\\xe2\\x82\\xac' s'' }"
+
+/**
+ * \brief           Linear buffer writer and round trip through parser
+ */
+static void
+test_writer_buff(void) {
+    esp_json_writer_t w;
+    test_trace_t t;
+    char buff[256], small[16];
+
+    esp_json_writer_init_buff(&w, buff, sizeof(buff));
+    TEST_CHECK(test_write_doc(&w) == espOK);
+    TEST_CHECK(!strcmp(buff, TEST_DOC));
+    TEST_CHECK(esp_json_writer_get_len(&w) == strlen(TEST_DOC));
+    TEST_CHECK(test_parse(buff, strlen(buff), strlen(buff), &t) == espOK);
+    TEST_CHECK(!strcmp(t.str, TEST_DOC_TRACE));
+    for (size_t step = 1; step < 8; ++step) {
+        test_trace_t s;
+
+        TEST_CHECK(test_parse(buff, strlen(buff), step, &s) == espOK && !strcmp(s.str, t.str));
+    }
+
+    /* Truncated document stays terminated */
+    esp_json_writer_init_buff(&w, small, sizeof(small));
+    TEST_CHECK(test_write_doc(&w) == espERRMEM);
+    TEST_CHECK(w.err && strlen(small) == sizeof(small) - 1 && !strncmp(small, TEST_DOC, sizeof(small) - 1));
+}
+
+/**
+ * \brief           Pbuf writer and parser fed with pbuf chain
+ */
+static void
+test_writer_pbuf(void) {
+    static const size_t doc_len = sizeof(TEST_DOC) - 1;
+    esp_json_writer_t w;
+    esp_json_parser_t p;
+    test_trace_t t;
+    esp_pbuf_p pbuf, tail;
+    char buff[256];
+    size_t split;
+
+    /* Chain split inside escape sequence and inside number */
+    split = strstr(TEST_DOC, "u0001") - TEST_DOC;
+    pbuf = esp_pbuf_new(split);
+    tail = esp_pbuf_new(doc_len - split);
+    TEST_CHECK(pbuf != NULL && tail != NULL);
+    if (pbuf == NULL || tail == NULL) {
+        return;
+    }
+    esp_pbuf_cat(pbuf, tail);
+    esp_json_writer_init_pbuf(&w, pbuf);
+    TEST_CHECK(test_write_doc(&w) == espOK);
+    TEST_CHECK(esp_json_writer_get_len(&w) == doc_len);
+    TEST_CHECK(esp_pbuf_copy(pbuf, buff, doc_len, 0) == doc_len && !memcmp(buff, TEST_DOC, doc_len));
+
+    memset(&t, 0x00, sizeof(t));
+    esp_json_parser_init(&p, test_token, &t);
+    TEST_CHECK(esp_json_parser_feed_pbuf(&p, pbuf) == espOK);
+    TEST_CHECK(esp_json_parser_finish(&p) == espOK);
+    TEST_CHECK(!strcmp(t.str, TEST_DOC_TRACE));
+    esp_pbuf_free(pbuf);
+
+    /* Pbuf too small for document */
+    pbuf = esp_pbuf_new(doc_len - 1);
+    TEST_CHECK(pbuf != NULL);
+    if (pbuf != NULL) {
+        esp_json_writer_init_pbuf(&w, pbuf);
+        TEST_CHECK(test_write_doc(&w) == espERRMEM);
+        TEST_CHECK(w.err && esp_json_writer_get_len(&w) == doc_len - 1);
+        esp_pbuf_free(pbuf);
+    }
+}
+
+/**
+ * \brief           Echo connection callback, writes documents with connection and HTTP writers
+ */
+static espr_t
+test_conn_evt(esp_evt_t* evt) {
+    esp_conn_p conn = esp_conn_get_from_evt(evt);
+    esp_json_writer_t w;
+    esp_pbuf_p pbuf;
+
+    switch (esp_evt_get_type(evt)) {
+        case ESP_EVT_CONN_ACTIVE: {
+            http_state_t hs;
+
+            esp_json_writer_init_conn(&w, conn);
+            test_write_doc(&w);
+            snprintf(doc_conn, sizeof(doc_conn), "%u", (unsigned)esp_json_writer_get_len(&w));
+
+            /* HTTP writer only needs connection of request */
+            memset(&hs, 0x00, sizeof(hs));
+            hs.conn = conn;
+            esp_json_writer_init_http(&w, &hs);
+            test_write_doc(&w);
+            snprintf(doc_http, sizeof(doc_http), "%u", (unsigned)hs.written_total);
+            esp_conn_write(conn, NULL, 0, 1, NULL);
+            break;
+        }
+        case ESP_EVT_CONN_RECV:
+            pbuf = esp_evt_conn_recv_get_buff(evt);
+            echo_len += esp_pbuf_copy(pbuf, &echo[echo_len], sizeof(echo) - echo_len, 0);
+            if (echo_len >= 2 * (sizeof(TEST_DOC) - 1)) {
+                esp_sys_sem_release(&echo_sem);
+            }
+            break;
+        default:
+            break;
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Connection and HTTP writers send document through simulated echo server
+ */
+static void
+test_writer_conn(void) {
+    static const size_t doc_len = sizeof(TEST_DOC) - 1;
+    esp_conn_p conn = NULL;
+
+    if (esp_init(NULL, 1) != espOK || esp_sta_join("sim", "json", NULL, NULL, NULL, 1) != espOK
+        || esp_conn_start(&conn, ESP_CONN_TYPE_TCP, "echo.sim", TEST_ECHO_PORT, NULL, test_conn_evt, 1) != espOK) {
+        printf("Could not open echo connection\r\n");
+        ++test_failed;
+        return;
+    }
+    TEST_CHECK(esp_sys_sem_wait(&echo_sem, 5000) != ESP_SYS_TIMEOUT);
+    esp_conn_close(conn, 1);
+
+    TEST_CHECK((size_t)strtoul(doc_conn, NULL, 10) == doc_len);
+    TEST_CHECK((size_t)strtoul(doc_http, NULL, 10) == doc_len);
+    TEST_CHECK(echo_len == 2 * doc_len);
+    TEST_CHECK(!memcmp(echo, TEST_DOC, doc_len) && !memcmp(&echo[doc_len], TEST_DOC, doc_len));
+}
+
+/**
+ * \brief           Program entry point
+ */
+int
+main(void) {
+    if (!test_init_heap()
+        || !esp_sys_init() || !esp_sys_sem_create(&echo_sem, 0)) {
+        printf("Could not initialize test\r\n");
+        return 1;
+    }
+
+    test_vectors();
+    test_callback_stop();
+    test_writer_buff();
+    test_writer_pbuf();
+    test_writer_conn();
+
+    return test_result();
+}
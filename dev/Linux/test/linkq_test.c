@@ -0,0 +1,182 @@
+/**
+ * \file            linkq_test.c
+ * \brief           Link quality monitor test with simulated module
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <string.h>
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+#include "esp/esp_linkq.h"
+#include "system/esp_sys.h"
+#include "esp_sim.h"
+
+#define TEST_HEAP_SIZE              0x10000
+#include "test.h"
+
+#define TEST_INTERVAL               20
+#define TEST_TIMEOUT                3000
+#define TEST_SETTLE_SAMPLES         20
+
+static esp_sim_config_t sim_cfg = {
+    .seed = 1,
+    .esp8266 = 1,
+};
+
+static volatile uint32_t evt_changes;
+static volatile esp_linkq_level_t evt_level, evt_level_prev;
+
+/**
+ * \brief           Library event callback, records link level changes
+ * \param[in]       evt: Event information
+ * \return          \ref espOK on success, member of \ref espr_t otherwise
+ */
+static espr_t
+test_evt(esp_evt_t* evt) {
+    if (esp_evt_get_type(evt) == ESP_EVT_LINKQ_CHANGED) {
+        evt_level_prev = esp_evt_linkq_get_level_prev(evt);
+        evt_level = esp_evt_linkq_get_level(evt);
+        ++evt_changes;
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Set RSSI reported by simulated module and wait until filter settles
+ * \param[in]       rssi: RSSI in units of dBm
+ * \return          `1` on success, `0` on timeout
+ */
+static uint8_t
+test_set_rssi(int16_t rssi) {
+    esp_linkq_stats_t st;
+    uint32_t samples;
+
+    sim_cfg.rssi = rssi;
+    esp_sim_set_config(&sim_cfg);
+
+    esp_linkq_get_stats(&st);
+    samples = st.samples;
+    for (uint32_t t = esp_sys_now(); esp_sys_now() - t < TEST_TIMEOUT; esp_delay(TEST_INTERVAL)) {
+        esp_linkq_get_stats(&st);
+        if (st.samples - samples >= TEST_SETTLE_SAMPLES) {
+            return st.rssi_last == rssi && st.rssi_avg >= rssi - 1 && st.rssi_avg <= rssi + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief           Check current level, last change event and recommendations
+ * \param[in]       level: Expected level
+ * \param[in]       prev: Expected level before last change
+ * \param[in]       changes: Expected number of change events
+ * \param[in]       payload: Expected recommended payload length
+ * \param[in]       batch: Expected recommended batch
+ */
+static void
+test_check(esp_linkq_level_t level, esp_linkq_level_t prev, uint32_t changes, size_t payload, size_t batch) {
+    TEST_CHECK(esp_linkq_get_level() == level);
+    TEST_CHECK(evt_changes == changes && evt_level == level && evt_level_prev == prev);
+    TEST_CHECK(esp_linkq_get_recommended_payload() == payload);
+    TEST_CHECK(esp_linkq_get_recommended_batch() == batch);
+}
+
+/**
+ * \brief           Levels follow RSSI across thresholds, with hysteresis on the way up
+ */
+static void
+test_levels(void) {
+    size_t max_len = esp_get_conn_max_data_len();
+
+    /* Connection starts at fair level, before first sample */
+    test_check(ESP_LINKQ_LEVEL_FAIR, ESP_LINKQ_LEVEL_LOST, 1, max_len / 2, 2);
+    TEST_CHECK(esp_linkq_start(TEST_INTERVAL) == espOK);
+
+    TEST_CHECK(test_set_rssi(ESP_CFG_LINKQ_RSSI_GOOD + 10));
+    test_check(ESP_LINKQ_LEVEL_GOOD, ESP_LINKQ_LEVEL_FAIR, 2, max_len, 4);
+
+    /* Going down does not need margin */
+    TEST_CHECK(test_set_rssi(ESP_CFG_LINKQ_RSSI_GOOD - 2));
+    test_check(ESP_LINKQ_LEVEL_FAIR, ESP_LINKQ_LEVEL_GOOD, 3, max_len / 2, 2);
+
+    /* Above threshold, but within hysteresis, level stays */
+    TEST_CHECK(test_set_rssi(ESP_CFG_LINKQ_RSSI_GOOD + ESP_CFG_LINKQ_HYSTERESIS - 2));
+    test_check(ESP_LINKQ_LEVEL_FAIR, ESP_LINKQ_LEVEL_GOOD, 3, max_len / 2, 2);
+    TEST_CHECK(test_set_rssi(ESP_CFG_LINKQ_RSSI_GOOD + ESP_CFG_LINKQ_HYSTERESIS + 2));
+    test_check(ESP_LINKQ_LEVEL_GOOD, ESP_LINKQ_LEVEL_FAIR, 4, max_len, 4);
+
+    /* Smoothed RSSI passes fair level on the way down */
+    TEST_CHECK(test_set_rssi(ESP_CFG_LINKQ_RSSI_POOR - 5));
+    test_check(ESP_LINKQ_LEVEL_POOR, ESP_LINKQ_LEVEL_FAIR, 6, max_len / 4, 1);
+
+    TEST_CHECK(test_set_rssi(ESP_CFG_LINKQ_RSSI_POOR + ESP_CFG_LINKQ_HYSTERESIS - 2));
+    test_check(ESP_LINKQ_LEVEL_POOR, ESP_LINKQ_LEVEL_FAIR, 6, max_len / 4, 1);
+    TEST_CHECK(test_set_rssi(ESP_CFG_LINKQ_RSSI_POOR + ESP_CFG_LINKQ_HYSTERESIS + 2));
+    test_check(ESP_LINKQ_LEVEL_FAIR, ESP_LINKQ_LEVEL_POOR, 7, max_len / 2, 2);
+}
+
+/**
+ * \brief           Disconnect reports lost link and stops recommendations
+ */
+static void
+test_lost(void) {
+    esp_linkq_stats_t st;
+
+    TEST_CHECK(esp_linkq_stop() == espOK);
+    TEST_CHECK(esp_sta_quit(NULL, NULL, 1) == espOK);
+    for (uint32_t t = esp_sys_now(); esp_sys_now() - t < TEST_TIMEOUT && evt_changes < 8; esp_delay(10)) {}
+    test_check(ESP_LINKQ_LEVEL_LOST, ESP_LINKQ_LEVEL_FAIR, 8, 0, 0);
+
+    esp_linkq_get_stats(&st);
+    TEST_CHECK(st.disconnects == 1 && st.reconnects == 0);
+}
+
+/**
+ * \brief           Program entry point
+ */
+int
+main(void) {
+    if (!test_init_heap()) {
+        printf("Could not assign memory\r\n");
+        return 1;
+    }
+    esp_sim_set_config(&sim_cfg);
+    if (esp_init(test_evt, 1) != espOK
+        || esp_sta_join("sim", "linkq", NULL, NULL, NULL, 1) != espOK) {
+        printf("Could not initialize library\r\n");
+        return 1;
+    }
+
+    test_levels();
+    test_lost();
+
+    return test_result();
+}
@@ -0,0 +1,236 @@
+/**
+ * \file            lz_test.c
+ * \brief           LZ compression round trip test
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <string.h>
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+#include "esp/apps/esp_lz.h"
+
+#include "test.h"
+
+#define TEST_DATA_LEN               300000
+#define TEST_COMP_SIZE              ESP_LZ_MAX_COMPRESSED_LEN(TEST_DATA_LEN)
+
+/**
+ * \brief           Decoder output collected to linear buffer
+ */
+typedef struct {
+    uint8_t* data;                              /*!< Output buffer */
+    size_t size;                                /*!< Size of output buffer */
+    size_t len;                                 /*!< Number of bytes written */
+} test_out_t;
+
+static esp_lz_enc_t enc;
+static esp_lz_dec_t dec;
+static uint8_t data[TEST_DATA_LEN];
+static uint8_t comp[TEST_COMP_SIZE];
+static uint8_t dout[TEST_DATA_LEN];
+static uint32_t rnd = 1;
+
+/**
+ * \brief           Get next pseudo random number
+ * \return          Random number
+ */
+static uint32_t
+test_rand(void) {
+    rnd ^= rnd << 13;
+    rnd ^= rnd >> 17;
+    rnd ^= rnd << 5;
+    return rnd;
+}
+
+/**
+ * \brief           Fill buffer with random bytes
+ */
+static void
+test_fill_random(uint8_t* buff, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        buff[i] = (uint8_t)test_rand();
+    }
+}
+
+/**
+ * \brief           Fill buffer with repetitive text with small variations
+ */
+static void
+test_fill_text(uint8_t* buff, size_t len) {
+    static const char* words[] = { "temperature", "humidity", "pressure", "\"value\":", ", ", "\r\n" };
+    size_t i = 0, n;
+
+    while (i < len) {
+        if (test_rand() % 4 == 0) {
+            buff[i++] = (uint8_t)('0' + test_rand() % 10);
+        } else {
+            const char* w = words[test_rand() % ESP_ARRAYSIZE(words)];
+            n = ESP_MIN(strlen(w), len - i);
+            memcpy(&buff[i], w, n);
+            i += n;
+        }
+    }
+}
+
+/**
+ * \brief           Decoder output function, appends data to test buffer
+ */
+static espr_t
+test_dec_out(esp_lz_dec_t* d, const void* buff, size_t len) {
+    test_out_t* o = d->arg;
+
+    if (o->len + len > o->size) {
+        return espERRMEM;
+    }
+    memcpy(&o->data[o->len], buff, len);
+    o->len += len;
+    return espOK;
+}
+
+/**
+ * \brief           Compress data to buffer in one call and decompress it in random pieces
+ * \param[in]       len: Length of data to compress
+ * \return          Compressed length, `0` on failure
+ */
+static size_t
+test_round_trip(size_t len) {
+    test_out_t out = { dout, sizeof(dout), 0 };
+    size_t off, piece, comp_len;
+
+    esp_lz_enc_init_buff(&enc, comp, ESP_LZ_MAX_COMPRESSED_LEN(len));
+    if (esp_lz_enc_write(&enc, data, len) != espOK || esp_lz_enc_flush(&enc) != espOK) {
+        return 0;
+    }
+    comp_len = esp_lz_enc_get_len(&enc);
+
+    esp_lz_dec_init(&dec, test_dec_out, &out);
+    for (off = 0; off < comp_len; off += piece) {
+        piece = 1 + test_rand() % 7;           /* Macro evaluates arguments twice */
+        piece = ESP_MIN(piece, comp_len - off);
+        if (esp_lz_dec_feed(&dec, &comp[off], piece) != espOK) {
+            return 0;
+        }
+    }
+    return out.len == len && !memcmp(data, dout, len) ? comp_len : 0;
+}
+
+/**
+ * \brief           Random data use stored blocks and grow only by their headers
+ */
+static void
+test_random(void) {
+    size_t comp_len;
+
+    test_fill_random(data, TEST_DATA_LEN);
+    comp_len = test_round_trip(TEST_DATA_LEN);
+    printf("Random: %d bytes, compressed: %d bytes\r\n", (int)TEST_DATA_LEN, (int)comp_len);
+    TEST_CHECK(comp_len > 0);
+    TEST_CHECK(comp_len <= TEST_DATA_LEN + TEST_DATA_LEN / 32);
+
+    /* Short inputs, below and around stored block limits */
+    for (size_t len = 0; len < 2 * ESP_LZ_STORED_MAX + 20; len += 7) {
+        TEST_CHECK(test_round_trip(len) > 0 || len == 0);
+    }
+}
+
+/**
+ * \brief           Compressible data use matches
+ */
+static void
+test_text(void) {
+    size_t comp_len;
+
+    test_fill_text(data, TEST_DATA_LEN);
+    comp_len = test_round_trip(TEST_DATA_LEN);
+    printf("Text: %d bytes, compressed: %d bytes\r\n", (int)TEST_DATA_LEN, (int)comp_len);
+    TEST_CHECK(comp_len > 0);
+    TEST_CHECK(comp_len < TEST_DATA_LEN / 2);
+}
+
+/**
+ * \brief           Random and text blocks, written in pieces with flushes in between
+ */
+static void
+test_mixed(void) {
+    test_out_t out = { dout, sizeof(dout), 0 };
+    size_t off, piece, len = TEST_DATA_LEN / 4;
+
+    for (off = 0; off < len; off += piece) {
+        piece = 1 + test_rand() % 1000;
+        piece = ESP_MIN(piece, len - off);
+        if (test_rand() % 2) {
+            test_fill_random(&data[off], piece);
+        } else {
+            test_fill_text(&data[off], piece);
+        }
+    }
+
+    esp_lz_enc_init_buff(&enc, comp, sizeof(comp));
+    for (off = 0; off < len; off += piece) {
+        piece = 1 + test_rand() % 600;
+        piece = ESP_MIN(piece, len - off);
+        TEST_CHECK(esp_lz_enc_write(&enc, &data[off], piece) == espOK);
+        if (test_rand() % 8 == 0) {
+            TEST_CHECK(esp_lz_enc_flush(&enc) == espOK);
+        }
+    }
+    TEST_CHECK(esp_lz_enc_flush(&enc) == espOK);
+
+    esp_lz_dec_init(&dec, test_dec_out, &out);
+    TEST_CHECK(esp_lz_dec_feed(&dec, comp, esp_lz_enc_get_len(&enc)) == espOK);
+    TEST_CHECK(out.len == len && !memcmp(data, dout, len));
+}
+
+/**
+ * \brief           Reserved length code of distance `0` is rejected
+ */
+static void
+test_corrupted(void) {
+    static const uint8_t stream[] = { 0x01, 0x00, 0x02, 0x00 };
+    test_out_t out = { dout, sizeof(dout), 0 };
+
+    esp_lz_dec_init(&dec, test_dec_out, &out);
+    TEST_CHECK(esp_lz_dec_feed(&dec, stream, sizeof(stream)) == espERR);
+    TEST_CHECK(out.len == 0);
+}
+
+/**
+ * \brief           Program entry point
+ */
+int
+main(void) {
+    test_random();
+    test_text();
+    test_mixed();
+    test_corrupted();
+
+    return test_result();
+}
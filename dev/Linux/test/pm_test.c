@@ -0,0 +1,246 @@
+/**
+ * \file            pm_test.c
+ * \brief           Power manager test with simulated module
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <string.h>
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+#include "esp/esp_netconn.h"
+#include "system/esp_sys.h"
+#include "esp_sim.h"
+
+#define TEST_HEAP_SIZE              0x10000
+#include "test.h"
+
+#define TEST_IDLE_TIME              200
+#define TEST_WAKEUP_LATENCY         50
+#define TEST_TIMEOUT                3000
+#define TEST_ECHO_PORT              7
+
+static esp_sim_config_t sim_cfg = {
+    .seed = 1,
+    .esp8266 = 1,
+};
+
+static volatile uint32_t evt_sleeps, evt_wakeups, cmds_ok, cmds_err;
+static volatile esp_sleep_mode_t evt_mode;
+
+/**
+ * \brief           Library event callback, counts power state changes
+ * \param[in]       evt: Event information
+ * \return          \ref espOK on success, member of \ref espr_t otherwise
+ */
+static espr_t
+test_evt(esp_evt_t* evt) {
+    if (esp_evt_get_type(evt) == ESP_EVT_PM_CHANGED && esp_evt_pm_get_result(evt) == espOK) {
+        if (esp_evt_pm_get_mode(evt) != ESP_SLEEP_NONE) {
+            evt_mode = esp_evt_pm_get_mode(evt);
+            ++evt_sleeps;
+        } else {
+            ++evt_wakeups;
+        }
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Finished command callback for non-blocking commands
+ */
+static void
+test_cmd_evt(espr_t res, void* arg) {
+    ESP_UNUSED(arg);
+    if (res == espOK) {
+        ++cmds_ok;
+    } else {
+        ++cmds_err;
+    }
+}
+
+/**
+ * \brief           Wait until simulated module entered sleep given number of times
+ * \param[in]       sleeps: Expected number of sleeps
+ * \return          `1` on success, `0` on timeout
+ */
+static uint8_t
+test_wait_sleep(uint32_t sleeps) {
+    esp_sim_stats_t st;
+
+    for (uint32_t t = esp_sys_now(); esp_sys_now() - t < TEST_TIMEOUT; esp_delay(10)) {
+        esp_sim_get_stats(&st);
+        if (st.sleeps == sleeps && evt_sleeps == sleeps && esp_pm_is_sleeping()) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief           Set power manager configuration
+ * \param[in]       mode: Sleep mode
+ * \param[in]       latency: Wakeup latency in units of milliseconds
+ */
+static void
+test_pm_config(esp_sleep_mode_t mode, uint32_t latency) {
+    esp_pm_config_t cfg = {
+        .mode = mode,
+        .idle_time = TEST_IDLE_TIME,
+        .wakeup_latency = latency,
+    };
+
+    esp_pm_set_config(&cfg);
+}
+
+/**
+ * \brief           Commands queued in modem sleep are sent after single wakeup
+ */
+static void
+test_modem_sleep(void) {
+    esp_sim_stats_t st;
+    esp_pm_stats_t pst;
+    esp_ip_t ip;
+
+    test_pm_config(ESP_SLEEP_MODEM, 0);
+    TEST_CHECK(esp_pm_enable(1) == espOK);
+    TEST_CHECK(test_wait_sleep(1));
+    TEST_CHECK(evt_mode == ESP_SLEEP_MODEM);
+
+    /* Commands queued while asleep wake device up once, before first of them */
+    for (size_t i = 0; i < 3; ++i) {
+        TEST_CHECK(esp_sta_getip(NULL, NULL, NULL, test_cmd_evt, NULL, 0) == espOK);
+    }
+    TEST_CHECK(esp_sta_getip(&ip, NULL, NULL, NULL, NULL, 1) == espOK);
+    TEST_CHECK(ip.ip[0] == 192 && ip.ip[3] == 10);
+    TEST_CHECK(cmds_ok == 3 && cmds_err == 0);
+    esp_sim_get_stats(&st);
+    esp_pm_get_stats(&pst);
+    TEST_CHECK(st.wakeups == 1 && st.sleep_cmds == 0);
+    TEST_CHECK(pst.sleep_cnt == 1 && pst.wakeup_cnt == 1 && pst.wakeup_err == 0);
+    TEST_CHECK(evt_wakeups == 1);
+    TEST_CHECK(!esp_pm_is_sleeping());
+}
+
+/**
+ * \brief           Open connection sleeps when idle and wakes up for data
+ */
+static void
+test_conn_sleep(void) {
+    static const char data[] = "sleepy echo";
+    esp_netconn_p nc;
+    esp_pbuf_p pbuf;
+    esp_sim_stats_t st;
+
+    nc = esp_netconn_new(ESP_NETCONN_TYPE_TCP);
+    TEST_CHECK(nc != NULL);
+    if (nc == NULL) {
+        return;
+    }
+    esp_netconn_set_receive_timeout(nc, TEST_TIMEOUT);
+    TEST_CHECK(esp_netconn_connect(nc, "echo.sim", TEST_ECHO_PORT) == espOK);
+    TEST_CHECK(test_wait_sleep(2));
+
+    TEST_CHECK(esp_netconn_write(nc, data, sizeof(data) - 1) == espOK);
+    TEST_CHECK(esp_netconn_flush(nc) == espOK);
+    TEST_CHECK(esp_netconn_receive(nc, &pbuf) == espOK);
+    if (pbuf != NULL) {
+        TEST_CHECK(esp_pbuf_length(pbuf, 1) == sizeof(data) - 1 && !esp_pbuf_memcmp(pbuf, data, sizeof(data) - 1, 0));
+        esp_pbuf_free(pbuf);
+    }
+    esp_netconn_close(nc);
+    esp_netconn_delete(nc);
+
+    esp_sim_get_stats(&st);
+    TEST_CHECK(st.wakeups == 2 && st.sleep_cmds == 0);
+}
+
+/**
+ * \brief           Light sleep needs wakeup pin and latency before first command
+ */
+static void
+test_light_sleep(void) {
+    esp_sim_stats_t st;
+    esp_pm_stats_t pst;
+
+    sim_cfg.wakeup_latency = TEST_WAKEUP_LATENCY;
+    esp_sim_set_config(&sim_cfg);
+    test_pm_config(ESP_SLEEP_LIGHT, TEST_WAKEUP_LATENCY);
+    TEST_CHECK(test_wait_sleep(3));
+    TEST_CHECK(evt_mode == ESP_SLEEP_LIGHT);
+
+    TEST_CHECK(esp_sta_getip(NULL, NULL, NULL, NULL, NULL, 1) == espOK);
+    esp_sim_get_stats(&st);
+    esp_pm_get_stats(&pst);
+    TEST_CHECK(st.wakeups == 3 && st.sleep_cmds == 0 && st.sleep_lost == 0);
+    TEST_CHECK(pst.wakeup_cnt == 3 && pst.wakeup_time_last >= TEST_WAKEUP_LATENCY);
+}
+
+/**
+ * \brief           Disabling manager wakes device up and keeps it awake
+ */
+static void
+test_disable(void) {
+    esp_sim_stats_t st;
+
+    TEST_CHECK(test_wait_sleep(4));
+    TEST_CHECK(esp_pm_enable(0) == espOK);
+    for (uint32_t t = esp_sys_now(); esp_sys_now() - t < TEST_TIMEOUT && esp_pm_is_sleeping(); esp_delay(10)) {}
+    esp_delay(3 * TEST_IDLE_TIME);
+
+    esp_sim_get_stats(&st);
+    TEST_CHECK(!esp_pm_is_sleeping());
+    TEST_CHECK(st.sleeps == 4 && st.wakeups == 4 && st.sleep_cmds == 0 && st.sleep_lost == 0);
+    TEST_CHECK(evt_sleeps == 4 && evt_wakeups == 4);
+}
+
+/**
+ * \brief           Program entry point
+ */
+int
+main(void) {
+    if (!test_init_heap()) {
+        printf("Could not assign memory\r\n");
+        return 1;
+    }
+    esp_sim_set_config(&sim_cfg);
+    if (esp_init(test_evt, 1) != espOK
+        || esp_sta_join("sim", "pm", NULL, NULL, NULL, 1) != espOK) {
+        printf("Could not initialize library\r\n");
+        return 1;
+    }
+
+    test_modem_sleep();
+    test_conn_sleep();
+    test_light_sleep();
+    test_disable();
+
+    return test_result();
+}
@@ -0,0 +1,85 @@
+/**
+ * \file            test.h
+ * \brief           Common helpers for unit tests
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_TEST_H
+#define ESP_HDR_TEST_H
+
+#include <stdio.h>
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+
+/**
+ * \brief           Size of test heap in units of bytes, define before including this file
+ */
+#ifndef TEST_HEAP_SIZE
+#define TEST_HEAP_SIZE              0x8000
+#endif
+
+/**
+ * \brief           Check condition and count failure, test continues
+ * \param[in]       c: Condition to check
+ */
+#define TEST_CHECK(c)               do {                                        \
+    if (!(c)) {                                                                 \
+        printf("%s:%d: check failed: %s\r\n", __FILE__, __LINE__, #c);         \
+        ++test_failed;                                                          \
+    }                                                                           \
+} while (0)
+
+static uint32_t test_failed;                    /*!< Number of failed checks */
+static uint8_t test_heap[TEST_HEAP_SIZE];       /*!< Library heap */
+
+/**
+ * \brief           Assign test heap to library
+ * \return          `1` on success, `0` otherwise
+ */
+static inline uint8_t
+test_init_heap(void) {
+    esp_mem_region_t regions[] = {
+        { test_heap, sizeof(test_heap), ESP_MEM_CLASS_BULK },
+    };
+
+    return esp_mem_assignmemory(regions, ESP_ARRAYSIZE(regions));
+}
+
+/**
+ * \brief           Print test result
+ * \return          Program exit code, `0` when all checks passed
+ */
+static inline int
+test_result(void) {
+    printf("Result: %s\r\n", test_failed ? "FAIL" : "PASS");
+    return test_failed ? 1 : 0;
+}
+
+#endif /* ESP_HDR_TEST_H */
@@ -62,6 +62,7 @@ typedef struct esp_netconn {
     esp_sys_mbox_t mbox_accept;                 /*!< List of active connections waiting to be processed */
     esp_sys_mbox_t mbox_receive;                /*!< Message queue for receive mbox */
     size_t mbox_receive_entries;                /*!< Number of entries written to receive mbox */
+    size_t mbox_receive_len;                    /*!< Length of receive mbox, set on netconn creation */
 
     esp_linbuff_t buff;                         /*!< Linear buffer structure */
 
@@ -211,7 +212,7 @@ netconn_evt(esp_evt_t* evt) {
             ++nc->mbox_receive_entries;         /* Increase number of packets in receive mbox */
 #if ESP_CFG_CONN_MANUAL_TCP_RECEIVE
             /* Check against 1 less to still allow potential close event to be written to queue */
-            if (nc->mbox_receive_entries >= (ESP_CFG_NETCONN_RECEIVE_QUEUE_LEN - 1)) {
+            if (nc->mbox_receive_entries >= (nc->mbox_receive_len - 1)) {
                 conn->status.f.receive_blocked = 1; /* Block reading more data */
             }
 #endif /* ESP_CFG_CONN_MANUAL_TCP_RECEIVE */
@@ -237,6 +238,14 @@ netconn_evt(esp_evt_t* evt) {
                 }
             }
 
+            /*
+             * Detach connection from netconn.
+             * Connection handle may be reused for new connection immediately
+             * and netconn must not send data to it anymore
+             */
+            if (nc != NULL && nc->conn == conn) {
+                nc->conn = NULL;
+            }
             break;
         }
         default:
@@ -286,7 +295,7 @@ esp_netconn_new(esp_netconn_type_t type) {
         esp_evt_register(esp_evt);              /* Register global event function */
     }
     esp_core_unlock();
-    a = esp_mem_calloc(1, sizeof(*a));          /* Allocate memory for core object */
+    a = esp_mem_calloc_class(ESP_MEM_CLASS_FAST, 1, sizeof(*a));   /* Allocate memory for core object */
     if (a != NULL) {
         a->type = type;                         /* Save netconn type */
         a->conn_timeout = 0;                    /* Default connection timeout */
@@ -295,7 +304,10 @@ esp_netconn_new(esp_netconn_type_t type) {
                 "[NETCONN] Cannot create accept MBOX\r\n");
             goto free_ret;
         }
-        if (!esp_sys_mbox_create(&a->mbox_receive, ESP_CFG_NETCONN_RECEIVE_QUEUE_LEN)) {    /* Allocate memory for receiving message box */
+        esp_core_lock();
+        a->mbox_receive_len = esp.cfg.netconn_receive_queue_len;    /* Get current runtime queue length */
+        esp_core_unlock();
+        if (!esp_sys_mbox_create(&a->mbox_receive, a->mbox_receive_len)) {  /* Allocate memory for receiving message box */
             ESP_DEBUGF(ESP_CFG_DBG_NETCONN | ESP_DBG_TYPE_TRACE | ESP_DBG_LVL_DANGER,
                 "[NETCONN] Cannot create receive MBOX\r\n");
             goto free_ret;
@@ -361,6 +373,7 @@ esp_netconn_delete(esp_netconn_p nc) {
     }
     esp_core_unlock();
 
+    esp_mem_free_s((void **)&nc->buff.buff);   /* Write buffer may remain when connection closed before flush */
     esp_mem_free_s((void **)&nc);
     return espOK;
 }
@@ -563,7 +576,7 @@ esp_netconn_accept(esp_netconn_p nc, esp_netconn_p* client) {
  */
 espr_t
 esp_netconn_write(esp_netconn_p nc, const void* data, size_t btw) {
-    size_t len, sent;
+    size_t len, sent, max_len;
     const uint8_t* d = data;
     espr_t res;
 
@@ -571,6 +584,8 @@ esp_netconn_write(esp_netconn_p nc, const void* data, size_t btw) {
     ESP_ASSERT("nc->type must be TCP or SSL", nc->type == ESP_NETCONN_TYPE_TCP || nc->type == ESP_NETCONN_TYPE_SSL);
     ESP_ASSERT("nc->conn must be active", esp_conn_is_active(nc->conn));
 
+    max_len = esp_get_conn_max_data_len();      /* Use the same length for entire write operation */
+
     /*
      * Several steps are done in write process
      *
@@ -605,9 +620,9 @@ esp_netconn_write(esp_netconn_p nc, const void* data, size_t btw) {
     }
 
     /* Step 2 */
-    if (btw >= ESP_CFG_CONN_MAX_DATA_LEN) {
+    if (btw >= max_len) {
         size_t rem;
-        rem = btw % ESP_CFG_CONN_MAX_DATA_LEN;  /* Get remaining bytes for max data length */
+        rem = btw % max_len;                    /* Get remaining bytes for max data length */
         res = esp_conn_send(nc->conn, d, btw - rem, &sent, 1);  /* Write data directly */
         if (res != espOK) {
             return res;
@@ -622,8 +637,8 @@ esp_netconn_write(esp_netconn_p nc, const void* data, size_t btw) {
 
     /* Step 3 */
     if (nc->buff.buff == NULL) {                /* Check if we should allocate a new buffer */
-        nc->buff.buff = esp_mem_malloc(sizeof(*nc->buff.buff) * ESP_CFG_CONN_MAX_DATA_LEN);
-        nc->buff.len = ESP_CFG_CONN_MAX_DATA_LEN;   /* Save buffer length */
+        nc->buff.buff = esp_mem_malloc_class(ESP_MEM_CLASS_BULK, sizeof(*nc->buff.buff) * max_len);
+        nc->buff.len = max_len;                 /* Save buffer length */
         nc->buff.ptr = 0;                       /* Save buffer pointer */
     }
 
@@ -744,8 +759,10 @@ esp_netconn_receive(esp_netconn_p nc, esp_pbuf_p* pbuf) {
 #if ESP_CFG_CONN_MANUAL_TCP_RECEIVE
     else {
         esp_core_lock();
-        nc->conn->status.f.receive_blocked = 0; /* Resume reading more data */
-        esp_conn_recved(nc->conn, *pbuf);       /* Notify stack about received data */
+        if (nc->conn != NULL) {                 /* Connection may already be closed */
+            nc->conn->status.f.receive_blocked = 0; /* Resume reading more data */
+            esp_conn_recved(nc->conn, *pbuf);   /* Notify stack about received data */
+        }
         esp_core_unlock();
     }
 #endif /* ESP_CFG_CONN_MANUAL_TCP_RECEIVE */
@@ -0,0 +1,735 @@
+/**
+ * \file            esp_cbor.c
+ * \brief           Streaming CBOR encoder and decoder
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include "esp/apps/esp_cbor.h"
+
+#if ESP_CFG_CBOR_MAX_DEPTH > 32
+#error "ESP_CFG_CBOR_MAX_DEPTH must not be greater than 32!"
+#endif /* ESP_CFG_CBOR_MAX_DEPTH > 32 */
+
+/* Major types */
+#define CBOR_MAJOR_UINT                 0
+#define CBOR_MAJOR_NINT                 1
+#define CBOR_MAJOR_BYTES                2
+#define CBOR_MAJOR_TEXT                 3
+#define CBOR_MAJOR_ARR                  4
+#define CBOR_MAJOR_MAP                  5
+#define CBOR_MAJOR_TAG                  6
+#define CBOR_MAJOR_SIMPLE               7
+
+#define CBOR_AI_INDEFINITE              31      /* Additional information for indefinite length and break */
+#define CBOR_BREAK                      0xFF
+
+/* Decoder states */
+#define CBOR_STATE_HEAD                 0       /* Expecting initial byte */
+#define CBOR_STATE_ARG                  1       /* Collecting argument bytes */
+#define CBOR_STATE_STRING               2       /* Inside string payload */
+
+/**
+ * \brief           Output function for linear buffer
+ */
+static size_t
+cbor_out_buff(esp_cbor_writer_t* w, const void* data, size_t len) {
+    len = ESP_MIN(len, w->size - w->len);
+    if (len > 0) {
+        ESP_MEMCPY((uint8_t *)w->arg + w->len, data, len);
+    }
+    return len;
+}
+
+/**
+ * \brief           Output function for pbuf chain
+ */
+static size_t
+cbor_out_pbuf(esp_cbor_writer_t* w, const void* data, size_t len) {
+    len = ESP_MIN(len, w->size - w->len);
+    if (len > 0 && esp_pbuf_take(w->arg, data, len, w->len) != espOK) {
+        return 0;
+    }
+    return len;
+}
+
+/**
+ * \brief           Output function for connection write buffer
+ */
+static size_t
+cbor_out_conn(esp_cbor_writer_t* w, const void* data, size_t len) {
+    return esp_conn_write(w->arg, data, len, 0, NULL) == espOK ? len : 0;
+}
+
+/**
+ * \brief           Output function for HTTP server response
+ */
+static size_t
+cbor_out_http(esp_cbor_writer_t* w, const void* data, size_t len) {
+    return esp_http_server_write(w->arg, data, len);
+}
+
+/**
+ * \brief           Send data to writer output
+ * \param[in]       w: CBOR writer
+ * \param[in]       data: Data to output
+ * \param[in]       len: Length of data
+ * \return          \ref espOK on success, \ref espERRMEM when output did not accept all data
+ */
+static espr_t
+cbor_write(esp_cbor_writer_t* w, const void* data, size_t len) {
+    size_t written;
+
+    if (w->err) {
+        return espERRMEM;
+    }
+    written = w->out(w, data, len);
+    w->len += written;
+    if (written < len) {
+        w->err = 1;
+        return espERRMEM;
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Write item head with major type and argument in shortest form
+ * \param[in]       w: CBOR writer
+ * \param[in]       major: Major type
+ * \param[in]       val: Argument value
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+cbor_write_head(esp_cbor_writer_t* w, uint8_t major, uint64_t val) {
+    uint8_t head[9];
+    size_t len;
+
+    ESP_ASSERT("w != NULL", w != NULL);
+
+    if (val < 24) {
+        head[0] = (uint8_t)val;
+        len = 1;
+    } else if (val <= 0xFF) {
+        head[0] = 24;
+        len = 2;
+    } else if (val <= 0xFFFF) {
+        head[0] = 25;
+        len = 3;
+    } else if (val <= 0xFFFFFFFF) {
+        head[0] = 26;
+        len = 5;
+    } else {
+        head[0] = 27;
+        len = 9;
+    }
+    for (size_t i = len - 1; i > 0; --i, val >>= 8) {
+        head[i] = (uint8_t)val;                 /* Big endian argument */
+    }
+    head[0] |= major << 5;
+    return cbor_write(w, head, len);
+}
+
+/**
+ * \brief           Initialize CBOR writer with custom output function
+ * \param[in]       w: CBOR writer
+ * \param[in]       out: Output function
+ * \param[in]       arg: Output function argument, available as `w->arg`
+ */
+void
+esp_cbor_writer_init(esp_cbor_writer_t* w, esp_cbor_out_fn out, void* arg) {
+    ESP_MEMSET(w, 0x00, sizeof(*w));
+    w->out = out;
+    w->arg = arg;
+}
+
+/**
+ * \brief           Initialize CBOR writer to write to linear buffer
+ * \param[in]       w: CBOR writer
+ * \param[in]       buff: Output buffer
+ * \param[in]       size: Size of output buffer
+ */
+void
+esp_cbor_writer_init_buff(esp_cbor_writer_t* w, void* buff, size_t size) {
+    esp_cbor_writer_init(w, cbor_out_buff, buff);
+    w->size = size;
+}
+
+/**
+ * \brief           Initialize CBOR writer to write to payload of pbuf chain
+ *
+ * Data are written from beginning of the chain,
+ * use \ref esp_cbor_writer_get_len to get number of valid bytes
+ *
+ * \param[in]       w: CBOR writer
+ * \param[in]       pbuf: Allocated pbuf chain
+ */
+void
+esp_cbor_writer_init_pbuf(esp_cbor_writer_t* w, esp_pbuf_p pbuf) {
+    esp_cbor_writer_init(w, cbor_out_pbuf, pbuf);
+    w->size = esp_pbuf_length(pbuf, 1);
+}
+
+/**
+ * \brief           Initialize CBOR writer to write to connection write buffer
+ *
+ * Data are written with \ref esp_conn_write and sent when buffer is full.
+ * Call \ref esp_conn_write with `flush` set to `1` once encoding is complete.
+ *
+ * \note            Function may only be used from connection callback function
+ * \param[in]       w: CBOR writer
+ * \param[in]       conn: Connection handle
+ */
+void
+esp_cbor_writer_init_conn(esp_cbor_writer_t* w, esp_conn_p conn) {
+    esp_cbor_writer_init(w, cbor_out_conn, conn);
+}
+
+/**
+ * \brief           Initialize CBOR writer to write to HTTP server response
+ *
+ * Use it from SSI callback of file with \ref ESP_CBOR_HTTP_CONTENT_TYPE header
+ *
+ * \param[in]       w: CBOR writer
+ * \param[in]       hs: HTTP state
+ */
+void
+esp_cbor_writer_init_http(esp_cbor_writer_t* w, http_state_t* hs) {
+    esp_cbor_writer_init(w, cbor_out_http, hs);
+}
+
+/**
+ * \brief           Write unsigned integer
+ * \param[in]       w: CBOR writer
+ * \param[in]       num: Number to write
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_uint(esp_cbor_writer_t* w, uint64_t num) {
+    return cbor_write_head(w, CBOR_MAJOR_UINT, num);
+}
+
+/**
+ * \brief           Write signed integer
+ * \param[in]       w: CBOR writer
+ * \param[in]       num: Number to write
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_int(esp_cbor_writer_t* w, int64_t num) {
+    if (num < 0) {
+        return cbor_write_head(w, CBOR_MAJOR_NINT, (uint64_t)(-1 - num));
+    }
+    return cbor_write_head(w, CBOR_MAJOR_UINT, (uint64_t)num);
+}
+
+/**
+ * \brief           Write byte string
+ * \param[in]       w: CBOR writer
+ * \param[in]       data: Data to write
+ * \param[in]       len: Length of data
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_bytes(esp_cbor_writer_t* w, const void* data, size_t len) {
+    ESP_ASSERT("data != NULL || len == 0", data != NULL || len == 0);
+
+    cbor_write_head(w, CBOR_MAJOR_BYTES, len);
+    return len > 0 ? cbor_write(w, data, len) : (w->err ? espERRMEM : espOK);
+}
+
+/**
+ * \brief           Write `0` terminated text string
+ * \param[in]       w: CBOR writer
+ * \param[in]       str: UTF-8 string to write
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_text(esp_cbor_writer_t* w, const char* str) {
+    ESP_ASSERT("str != NULL", str != NULL);
+    return esp_cbor_textn(w, str, strlen(str));
+}
+
+/**
+ * \brief           Write text string with known length
+ * \param[in]       w: CBOR writer
+ * \param[in]       str: UTF-8 string to write
+ * \param[in]       len: Length of string in bytes
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_textn(esp_cbor_writer_t* w, const char* str, size_t len) {
+    ESP_ASSERT("str != NULL || len == 0", str != NULL || len == 0);
+
+    cbor_write_head(w, CBOR_MAJOR_TEXT, len);
+    return len > 0 ? cbor_write(w, str, len) : (w->err ? espERRMEM : espOK);
+}
+
+/**
+ * \brief           Begin array
+ * \param[in]       w: CBOR writer
+ * \param[in]       count: Number of items in array or \ref ESP_CBOR_INDEFINITE
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_arr_begin(esp_cbor_writer_t* w, uint32_t count) {
+    uint8_t head = (CBOR_MAJOR_ARR << 5) | CBOR_AI_INDEFINITE;
+
+    if (count == ESP_CBOR_INDEFINITE) {
+        return cbor_write(w, &head, 1);
+    }
+    return cbor_write_head(w, CBOR_MAJOR_ARR, count);
+}
+
+/**
+ * \brief           Begin map
+ *
+ * Every pair is written as key item followed by value item
+ *
+ * \param[in]       w: CBOR writer
+ * \param[in]       count: Number of key-value pairs or \ref ESP_CBOR_INDEFINITE
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_map_begin(esp_cbor_writer_t* w, uint32_t count) {
+    uint8_t head = (CBOR_MAJOR_MAP << 5) | CBOR_AI_INDEFINITE;
+
+    if (count == ESP_CBOR_INDEFINITE) {
+        return cbor_write(w, &head, 1);
+    }
+    return cbor_write_head(w, CBOR_MAJOR_MAP, count);
+}
+
+/**
+ * \brief           End indefinite length array or map
+ * \param[in]       w: CBOR writer
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_end(esp_cbor_writer_t* w) {
+    uint8_t brk = CBOR_BREAK;
+
+    return cbor_write(w, &brk, 1);
+}
+
+/**
+ * \brief           Write tag for next item
+ * \param[in]       w: CBOR writer
+ * \param[in]       tag: Tag number, for example `1` for epoch based date/time
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_tag(esp_cbor_writer_t* w, uint64_t tag) {
+    return cbor_write_head(w, CBOR_MAJOR_TAG, tag);
+}
+
+/**
+ * \brief           Write boolean value
+ * \param[in]       w: CBOR writer
+ * \param[in]       val: Value to write, `0` for `false`, any other for `true`
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_bool(esp_cbor_writer_t* w, uint8_t val) {
+    return cbor_write_head(w, CBOR_MAJOR_SIMPLE, val ? 21 : 20);
+}
+
+/**
+ * \brief           Write `null` value
+ * \param[in]       w: CBOR writer
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_null(esp_cbor_writer_t* w) {
+    return cbor_write_head(w, CBOR_MAJOR_SIMPLE, 22);
+}
+
+/**
+ * \brief           Write single precision floating point value
+ * \param[in]       w: CBOR writer
+ * \param[in]       f: Value to write
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_float(esp_cbor_writer_t* w, float f) {
+    uint8_t data[5];
+    uint32_t bits;
+
+    ESP_MEMCPY(&bits, &f, sizeof(bits));
+    data[0] = (CBOR_MAJOR_SIMPLE << 5) | 26;
+    data[1] = (uint8_t)(bits >> 24);
+    data[2] = (uint8_t)(bits >> 16);
+    data[3] = (uint8_t)(bits >> 8);
+    data[4] = (uint8_t)bits;
+    return cbor_write(w, data, sizeof(data));
+}
+
+/**
+ * \brief           Publish data encoded to linear buffer as MQTT message
+ * \param[in]       client: MQTT client
+ * \param[in]       topic: Topic to publish to
+ * \param[in]       w: CBOR writer initialized with \ref esp_cbor_writer_init_buff
+ * \param[in]       qos: Quality of service. This parameter can be a value of \ref esp_mqtt_qos_t enumeration
+ * \param[in]       retain: Retain parameter value
+ * \param[in]       arg: User custom argument used in callback
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cbor_mqtt_publish(esp_mqtt_client_p client, const char* topic, const esp_cbor_writer_t* w,
+                        esp_mqtt_qos_t qos, uint8_t retain, void* arg) {
+    ESP_ASSERT("w != NULL", w != NULL);
+    ESP_ASSERT("w->out == cbor_out_buff", w->out == cbor_out_buff);
+    ESP_ASSERT("w->len <= 0xFFFF", w->len <= 0xFFFF);
+
+    if (w->err) {
+        return espERRMEM;
+    }
+    return esp_mqtt_client_publish(client, topic, w->arg, (uint16_t)w->len, qos, retain, arg);
+}
+
+/**
+ * \brief           Convert half precision float to double
+ * \param[in]       h: Half precision bits
+ * \return          Floating point value
+ */
+static double
+cbor_half_to_double(uint16_t h) {
+    uint32_t exp = (h >> 10) & 0x1F, mant = h & 0x3FF, bits;
+    float f;
+
+    if (exp == 0) {                             /* Zero and subnormal values */
+        f = (float)mant / 16777216.0f;
+        return (h & 0x8000) ? -f : f;
+    }
+    bits = (uint32_t)(h & 0x8000) << 16;
+    bits |= (exp == 0x1F ? 0xFF : exp - 15 + 127) << 23;
+    bits |= mant << 13;
+    ESP_MEMCPY(&f, &bits, sizeof(f));
+    return f;
+}
+
+/**
+ * \brief           Report item to user
+ * \param[in]       d: CBOR decoder
+ * \param[in]       type: Item type
+ * \return          Result of user callback
+ */
+static espr_t
+cbor_emit(esp_cbor_decoder_t* d, esp_cbor_type_t type) {
+    d->item.type = type;
+    return d->fn != NULL ? d->fn(d, &d->item) : espOK;
+}
+
+/**
+ * \brief           Account completed item in parent containers
+ *
+ * Definite length containers are closed when their last item completes
+ *
+ * \param[in]       d: CBOR decoder
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+cbor_item_done(esp_cbor_decoder_t* d) {
+    espr_t res;
+
+    d->state = CBOR_STATE_HEAD;
+    while (d->depth > 0) {
+        if (d->remaining[d->depth - 1] == ESP_CBOR_INDEFINITE) {
+            d->odd ^= ESP_U32(1) << (d->depth - 1);   /* Track key and value of indefinite map */
+            break;
+        }
+        if (--d->remaining[d->depth - 1] > 0) {
+            break;
+        }
+        --d->depth;
+        d->item.val.u = 0;
+        d->item.data = NULL;
+        d->item.len = 0;
+        res = cbor_emit(d, ((d->nest >> d->depth) & 0x01) ? ESP_CBOR_TYPE_MAP_END : ESP_CBOR_TYPE_ARR_END);
+        if (res != espOK) {
+            return res;
+        }
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Open array or map in decoder
+ * \param[in]       d: CBOR decoder
+ * \param[in]       is_map: Set to `1` for map, `0` for array
+ * \param[in]       indefinite: Set to `1` for indefinite length container
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+cbor_open(esp_cbor_decoder_t* d, uint8_t is_map, uint8_t indefinite) {
+    uint64_t count = indefinite ? ESP_CBOR_INDEFINITE : d->item.val.u;
+    uint32_t bit;
+    espr_t res;
+
+    if (d->depth >= ESP_CFG_CBOR_MAX_DEPTH) {
+        return espERRMEM;
+    }
+    if (!indefinite && count >= (is_map ? ESP_CBOR_INDEFINITE / 2 : ESP_CBOR_INDEFINITE)) {
+        return espERRMEM;
+    }
+    d->item.val.u = count;
+    if ((res = cbor_emit(d, is_map ? ESP_CBOR_TYPE_MAP_BEGIN : ESP_CBOR_TYPE_ARR_BEGIN)) != espOK) {
+        return res;
+    }
+    if (count == 0) {                           /* Empty container is complete immediately */
+        d->item.val.u = 0;
+        if ((res = cbor_emit(d, is_map ? ESP_CBOR_TYPE_MAP_END : ESP_CBOR_TYPE_ARR_END)) != espOK) {
+            return res;
+        }
+        return cbor_item_done(d);
+    }
+    bit = ESP_U32(1) << d->depth;
+    d->nest = is_map ? (d->nest | bit) : (d->nest & ~bit);
+    d->odd &= ~bit;
+    d->remaining[d->depth] = indefinite ? ESP_CBOR_INDEFINITE : (uint32_t)(is_map ? count * 2 : count);
+    ++d->depth;
+    d->state = CBOR_STATE_HEAD;
+    return espOK;
+}
+
+/**
+ * \brief           Process item once head and argument are complete
+ * \param[in]       d: CBOR decoder
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+cbor_process_item(esp_cbor_decoder_t* d) {
+    uint8_t major = d->head >> 5, ai = d->head & 0x1F;
+    uint64_t val = d->item.val.u;
+    espr_t res;
+
+    switch (major) {
+        case CBOR_MAJOR_UINT:
+            res = cbor_emit(d, ESP_CBOR_TYPE_UINT);
+            break;
+        case CBOR_MAJOR_NINT:
+            if (val <= (uint64_t)INT64_MAX) {
+                d->item.val.i = -1 - (int64_t)val;
+            }
+            res = cbor_emit(d, ESP_CBOR_TYPE_NINT);
+            break;
+        case CBOR_MAJOR_BYTES:
+        case CBOR_MAJOR_TEXT:
+            if (val > 0) {
+                d->state = CBOR_STATE_STRING;
+                return espOK;
+            }
+            res = cbor_emit(d, major == CBOR_MAJOR_BYTES ? ESP_CBOR_TYPE_BYTES : ESP_CBOR_TYPE_TEXT);
+            break;
+        case CBOR_MAJOR_ARR:
+        case CBOR_MAJOR_MAP:
+            return cbor_open(d, major == CBOR_MAJOR_MAP, 0);
+        case CBOR_MAJOR_TAG:
+            d->state = CBOR_STATE_HEAD;         /* Tag is not an item on its own */
+            return cbor_emit(d, ESP_CBOR_TYPE_TAG);
+        default:
+            if (ai == 25) {
+                d->item.val.f = cbor_half_to_double((uint16_t)val);
+                res = cbor_emit(d, ESP_CBOR_TYPE_FLOAT);
+            } else if (ai == 26) {
+                uint32_t bits = (uint32_t)val;
+                float f;
+
+                ESP_MEMCPY(&f, &bits, sizeof(f));
+                d->item.val.f = f;
+                res = cbor_emit(d, ESP_CBOR_TYPE_FLOAT);
+            } else if (ai == 27) {
+                double f;
+
+                ESP_MEMCPY(&f, &val, sizeof(f));
+                d->item.val.f = f;
+                res = cbor_emit(d, ESP_CBOR_TYPE_FLOAT);
+            } else if (val >= 20 && val <= 23) {
+                res = cbor_emit(d, (esp_cbor_type_t)(ESP_CBOR_TYPE_FALSE + (val - 20)));
+            } else {
+                res = cbor_emit(d, ESP_CBOR_TYPE_SIMPLE);
+            }
+            break;
+    }
+    return res == espOK ? cbor_item_done(d) : res;
+}
+
+/**
+ * \brief           Process initial byte of item
+ * \param[in]       d: CBOR decoder
+ * \param[in]       b: Initial byte
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+cbor_process_head(esp_cbor_decoder_t* d, uint8_t b) {
+    uint8_t major = b >> 5, ai = b & 0x1F;
+    espr_t res;
+
+    /* Tag must be followed by data item */
+    if (b == CBOR_BREAK && d->tagged) {
+        return espERR;
+    }
+    d->tagged = major == CBOR_MAJOR_TAG;
+
+    d->head = b;
+    d->item.val.u = 0;
+    d->item.data = NULL;
+    d->item.len = 0;
+    d->item.off = 0;
+    if (ai < 24) {
+        d->item.val.u = ai;
+        return cbor_process_item(d);
+    } else if (ai < 28) {
+        d->arg_len = (uint8_t)(1 << (ai - 24));
+        d->state = CBOR_STATE_ARG;
+        return espOK;
+    } else if (ai != CBOR_AI_INDEFINITE) {
+        return espERR;
+    }
+
+    /* Indefinite length container or break */
+    if (major == CBOR_MAJOR_ARR || major == CBOR_MAJOR_MAP) {
+        return cbor_open(d, major == CBOR_MAJOR_MAP, 1);
+    } else if (b == CBOR_BREAK) {
+        if (d->depth == 0 || d->remaining[d->depth - 1] != ESP_CBOR_INDEFINITE
+            || ((d->nest & d->odd) >> (d->depth - 1)) & 0x01) {   /* Map key without value */
+            return espERR;
+        }
+        --d->depth;
+        res = cbor_emit(d, ((d->nest >> d->depth) & 0x01) ? ESP_CBOR_TYPE_MAP_END : ESP_CBOR_TYPE_ARR_END);
+        return res == espOK ? cbor_item_done(d) : res;
+    }
+    return espERR;                              /* Indefinite length strings are not supported */
+}
+
+/**
+ * \brief           Initialize CBOR decoder
+ * \param[in]       d: CBOR decoder
+ * \param[in]       fn: Item callback function
+ * \param[in]       arg: User argument, available as `d->arg`
+ */
+void
+esp_cbor_decoder_init(esp_cbor_decoder_t* d, esp_cbor_decoder_fn fn, void* arg) {
+    ESP_MEMSET(d, 0x00, sizeof(*d));
+    d->fn = fn;
+    d->arg = arg;
+    d->res = espOK;
+    d->state = CBOR_STATE_HEAD;
+}
+
+/**
+ * \brief           Feed decoder with next piece of data
+ *
+ * Piece may end anywhere, also in the middle of item head or string.
+ * Multiple top level items are decoded one after another
+ *
+ * \param[in]       d: CBOR decoder
+ * \param[in]       data: Encoded data
+ * \param[in]       len: Length of data
+ * \return          \ref espOK on success, \ref espERR on malformed data,
+ *                      \ref espERRMEM when nesting limit is exceeded,
+ *                      or value returned by user callback.
+ *                      Once decoder stops, further calls return the same value
+ */
+espr_t
+esp_cbor_decoder_feed(esp_cbor_decoder_t* d, const void* data, size_t len) {
+    const uint8_t* p = data;
+    size_t chunk;
+
+    ESP_ASSERT("d != NULL", d != NULL);
+    ESP_ASSERT("data != NULL || len == 0", data != NULL || len == 0);
+
+    while (len > 0 && d->res == espOK) {
+        if (d->state == CBOR_STATE_STRING) {
+            /* Report string data directly from input */
+            chunk = (size_t)ESP_MIN((uint64_t)len, d->item.val.u - d->item.off);
+            d->item.data = p;
+            d->item.len = chunk;
+            d->res = cbor_emit(d, (d->head >> 5) == CBOR_MAJOR_BYTES ? ESP_CBOR_TYPE_BYTES : ESP_CBOR_TYPE_TEXT);
+            d->item.off += chunk;
+            if (d->res == espOK && d->item.off == d->item.val.u) {
+                d->res = cbor_item_done(d);
+            }
+        } else {
+            chunk = 1;
+            if (d->state == CBOR_STATE_ARG) {
+                d->item.val.u = (d->item.val.u << 8) | *p;
+                if (--d->arg_len == 0) {
+                    d->res = cbor_process_item(d);
+                }
+            } else {
+                d->res = cbor_process_head(d, *p);
+            }
+        }
+        if (d->res == espOK) {
+            d->pos += chunk;
+        }
+        p += chunk;
+        len -= chunk;
+    }
+    return d->res;
+}
+
+/**
+ * \brief           Feed decoder with all pbufs in chain, segment by segment
+ * \param[in]       d: CBOR decoder
+ * \param[in]       pbuf: Pbuf chain, such as one received on connection
+ * \return          Same as \ref esp_cbor_decoder_feed
+ */
+espr_t
+esp_cbor_decoder_feed_pbuf(esp_cbor_decoder_t* d, const esp_pbuf_p pbuf) {
+    const void* data;
+    size_t off = 0, len;
+
+    ESP_ASSERT("d != NULL", d != NULL);
+    ESP_ASSERT("pbuf != NULL", pbuf != NULL);
+
+    while ((data = esp_pbuf_get_linear_addr(pbuf, off, &len)) != NULL && len > 0) {
+        if (esp_cbor_decoder_feed(d, data, len) != espOK) {
+            break;
+        }
+        off += len;
+    }
+    return d->res;
+}
+
+/**
+ * \brief           Notify decoder that data are complete
+ * \param[in]       d: CBOR decoder
+ * \return          \ref espOK when all items were complete,
+ *                      \ref espERR when data end inside item or after tag, or error returned during decoding
+ */
+espr_t
+esp_cbor_decoder_finish(esp_cbor_decoder_t* d) {
+    ESP_ASSERT("d != NULL", d != NULL);
+
+    if (d->res == espOK && (d->state != CBOR_STATE_HEAD || d->depth > 0 || d->tagged)) {
+        d->res = espERR;
+    }
+    return d->res;
+}
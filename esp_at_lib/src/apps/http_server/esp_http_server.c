@@ -34,6 +34,10 @@
 #include "esp/apps/esp_http_server.h"
 #include "esp/esp_mem.h"
 #include <ctype.h>
+#if HTTP_USE_METRICS
+#include <stdarg.h>
+#include <stdio.h>
+#endif /* HTTP_USE_METRICS */
 
 #define ESP_CFG_DBG_SERVER_TRACE            (ESP_CFG_DBG_SERVER | ESP_DBG_TYPE_TRACE)
 #define ESP_CFG_DBG_SERVER_TRACE_WARNING    (ESP_CFG_DBG_SERVER | ESP_DBG_TYPE_TRACE | ESP_DBG_LVL_WARNING)
@@ -203,6 +207,234 @@ strcmpa(const char* a, const char* b) {
     }
 }
 
+#if HTTP_USE_METRICS
+
+/* Request metrics for all routes */
+static http_metrics_t http_metrics;
+
+/**
+ * \brief           Add sample to latency histogram
+ * \param[in]       h: Histogram to update
+ * \param[in]       ms: Latency in units of milliseconds
+ */
+static void
+http_metrics_hist_add(http_metrics_hist_t* h, uint32_t ms) {
+    size_t i;
+
+    for (i = 0; i < HTTP_METRICS_HIST_LEN - 1 && ms >= ((uint32_t)HTTP_METRICS_HIST_BASE << i); ++i) {}
+    ++h->buckets[i];
+    ++h->count;
+    h->sum += ms;
+    if (ms > h->max) {
+        h->max = ms;
+    }
+}
+
+/**
+ * \brief           Find or create route entry for request URI
+ * \param[in]       uri: Request URI, optionally followed by parameters
+ * \return          Route entry, last entry is shared by all routes not fitting to table
+ */
+static http_route_metrics_t*
+http_metrics_get_route(const char* uri) {
+    http_route_metrics_t* r;
+    size_t len;
+
+    len = strcspn(uri, "?");                    /* Parameters are not part of route */
+    if (len > HTTP_METRICS_URI_LEN) {
+        len = HTTP_METRICS_URI_LEN;
+    }
+    if (len > 0) {
+        for (size_t i = 0; i < HTTP_METRICS_MAX_ROUTES - 1; ++i) {
+            r = &http_metrics.routes[i];
+            if (r->uri[0] == '\0') {            /* First free entry, route is new */
+                ESP_MEMCPY(r->uri, uri, len);
+                r->uri[len] = '\0';
+                return r;
+            }
+            if (!strncmp(r->uri, uri, len) && r->uri[len] == '\0') {
+                return r;
+            }
+        }
+    }
+    r = &http_metrics.routes[HTTP_METRICS_MAX_ROUTES - 1];
+    if (r->uri[0] == '\0') {
+        strcpy(r->uri, "*");
+    }
+    return r;
+}
+
+/**
+ * \brief           Start metrics for new request
+ * \param[in]       hs: HTTP state
+ * \param[in]       uri: Request URI or `NULL` if it could not be parsed
+ */
+static void
+http_metrics_request(http_state_t* hs, const char* uri) {
+    ++http_metrics.requests;
+    hs->metrics_start = esp_sys_now();
+    hs->metrics_active = 1;
+    if (uri != NULL) {
+        hs->metrics_route = http_metrics_get_route(uri);
+        ++hs->metrics_route->requests;
+    }
+}
+
+/**
+ * \brief           Account successfully sent response data
+ * \param[in]       hs: HTTP state
+ * \param[in]       len: Number of bytes sent
+ */
+static void
+http_metrics_sent(http_state_t* hs, size_t len) {
+    if (hs->metrics_route == NULL) {
+        return;
+    }
+    hs->metrics_route->bytes_sent += len;
+    if (!hs->metrics_first_byte) {
+        hs->metrics_first_byte = 1;
+        http_metrics_hist_add(&hs->metrics_route->ttfb, esp_sys_now() - hs->metrics_start);
+    }
+}
+
+/**
+ * \brief           Finish request metrics when server completed the response
+ * \param[in]       hs: HTTP state
+ */
+static void
+http_metrics_complete(http_state_t* hs) {
+    if (!hs->metrics_active) {
+        return;
+    }
+    hs->metrics_active = 0;
+    if (hs->metrics_route != NULL) {
+        if (hs->metrics_status >= 100 && hs->metrics_status < 600) {
+            ++hs->metrics_route->status[hs->metrics_status / 100 - 1];
+        }
+        http_metrics_hist_add(&hs->metrics_route->complete, esp_sys_now() - hs->metrics_start);
+    }
+}
+
+/**
+ * \brief           Update metrics when connection is closed
+ * \param[in]       hs: HTTP state
+ */
+static void
+http_metrics_close(http_state_t* hs) {
+    if (hs->metrics_active) {                   /* Response was not completed */
+        hs->metrics_active = 0;
+        ++http_metrics.aborted;
+        if (hs->metrics_route != NULL) {
+            ++hs->metrics_route->aborted;
+        }
+    }
+    --http_metrics.conns_active;
+}
+
+/**
+ * \brief           Append formatted string to report buffer
+ * \param[in]       buff: Output buffer, may be `NULL` when `size` is `0`
+ * \param[in]       size: Size of output buffer
+ * \param[in]       pos: Current length of report
+ * \param[in]       fmt: Format string
+ * \return          New length of report, regardless of available buffer size
+ */
+static size_t
+http_metrics_printf(char* buff, size_t size, size_t pos, const char* fmt, ...) {
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = pos < size ? vsnprintf(&buff[pos], size - pos, fmt, ap) : vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    return len > 0 ? pos + len : pos;
+}
+
+/**
+ * \brief           Append histogram line to report buffer
+ * \param[in]       buff: Output buffer, may be `NULL` when `size` is `0`
+ * \param[in]       size: Size of output buffer
+ * \param[in]       pos: Current length of report
+ * \param[in]       name: Histogram name
+ * \param[in]       h: Histogram to print
+ * \return          New length of report, regardless of available buffer size
+ */
+static size_t
+http_metrics_print_hist(char* buff, size_t size, size_t pos, const char* name, const http_metrics_hist_t* h) {
+    pos = http_metrics_printf(buff, size, pos, "  %s ms: count %u, avg %u, max %u,", name,
+        (unsigned)h->count, (unsigned)(h->count > 0 ? h->sum / h->count : 0), (unsigned)h->max);
+    for (size_t i = 0; i < HTTP_METRICS_HIST_LEN - 1; ++i) {
+        pos = http_metrics_printf(buff, size, pos, " <%u: %u",
+            (unsigned)((uint32_t)HTTP_METRICS_HIST_BASE << i), (unsigned)h->buckets[i]);
+    }
+    return http_metrics_printf(buff, size, pos, " >=%u: %u\n",
+        (unsigned)((uint32_t)HTTP_METRICS_HIST_BASE << (HTTP_METRICS_HIST_LEN - 2)), (unsigned)h->buckets[HTTP_METRICS_HIST_LEN - 1]);
+}
+
+/**
+ * \brief           Write plain text metrics report
+ * \param[in]       buff: Output buffer, may be `NULL` when `size` is `0`
+ * \param[in]       size: Size of output buffer including terminating `0`
+ * \return          Length of full report excluding terminating `0`
+ */
+static size_t
+http_metrics_print(char* buff, size_t size) {
+    const http_route_metrics_t* r;
+    size_t pos;
+
+    pos = http_metrics_printf(buff, size, 0, "conns active: %u, max: %u, total: %u\n",
+        (unsigned)http_metrics.conns_active, (unsigned)http_metrics.conns_max, (unsigned)http_metrics.conns_total);
+    pos = http_metrics_printf(buff, size, pos, "requests: %u, rejected: %u, aborted: %u\n",
+        (unsigned)http_metrics.requests, (unsigned)http_metrics.rejected, (unsigned)http_metrics.aborted);
+    for (size_t i = 0; i < HTTP_METRICS_MAX_ROUTES; ++i) {
+        r = &http_metrics.routes[i];
+        if (r->uri[0] == '\0') {
+            continue;
+        }
+        pos = http_metrics_printf(buff, size, pos, "route %s\n  requests: %u, aborted: %u, bytes sent: %u\n",
+            r->uri, (unsigned)r->requests, (unsigned)r->aborted, (unsigned)r->bytes_sent);
+        pos = http_metrics_printf(buff, size, pos, "  status 1xx: %u, 2xx: %u, 3xx: %u, 4xx: %u, 5xx: %u\n",
+            (unsigned)r->status[0], (unsigned)r->status[1], (unsigned)r->status[2],
+            (unsigned)r->status[3], (unsigned)r->status[4]);
+        pos = http_metrics_print_hist(buff, size, pos, "ttfb", &r->ttfb);
+        pos = http_metrics_print_hist(buff, size, pos, "complete", &r->complete);
+    }
+    return pos;
+}
+
+#if HTTP_USE_METRICS_STATUS
+/**
+ * \brief           Prepare metrics report as response file for built-in status route
+ * \param[in]       hs: HTTP state
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+http_metrics_open_report(http_state_t* hs) {
+    static const char hdr[] = ""
+        "HTTP/1.1 200 OK" CRLF
+        "Server: " HTTP_SERVER_NAME CRLF
+        "Content-Type: text/plain" CRLF
+        CRLF;
+    size_t len;
+
+    len = http_metrics_print(NULL, 0);
+    hs->metrics_report = esp_mem_malloc_class(ESP_MEM_CLASS_BULK, sizeof(hdr) + len);
+    if (hs->metrics_report == NULL) {
+        return 0;
+    }
+    ESP_MEMCPY(hs->metrics_report, hdr, sizeof(hdr) - 1);
+    len = http_metrics_print(&hs->metrics_report[sizeof(hdr) - 1], len + 1);
+
+    /* Serve report as static file */
+    hs->resp_file.data = (const uint8_t *)hs->metrics_report;
+    hs->resp_file.size = (uint32_t)(sizeof(hdr) - 1 + len);
+    hs->resp_file.is_static = 1;
+    return 1;
+}
+#endif /* HTTP_USE_METRICS_STATUS */
+
+#endif /* HTTP_USE_METRICS */
+
 /**
  * \brief           Parse URI from HTTP request and copy it to linear memory location
  * \param[in]       p: Chain of pbufs from request
@@ -424,6 +656,13 @@ http_get_file_from_uri(http_state_t* hs, const char* uri) {
 
     ESP_MEMSET(&hs->resp_file, 0x00, sizeof(hs->resp_file));
     uri_len = strlen(uri);                      /* Get URI total length */
+#if HTTP_USE_METRICS_STATUS
+    if (!strncmp(uri, HTTP_METRICS_STATUS_URI, sizeof(HTTP_METRICS_STATUS_URI) - 1)
+        && (uri[sizeof(HTTP_METRICS_STATUS_URI) - 1] == '\0' || uri[sizeof(HTTP_METRICS_STATUS_URI) - 1] == '?')) {
+        hs->resp_file_opened = http_metrics_open_report(hs);
+        uri = HTTP_METRICS_STATUS_URI;
+    } else
+#endif /* HTTP_USE_METRICS_STATUS */
     if ((uri_len == 1 && uri[0] == '/') ||      /* Index file only requested */
         (uri_len > 1 && uri[0] == '/' && uri[1] == '?')) {  /* Index file + parameters */
         size_t i;
@@ -465,6 +704,10 @@ http_get_file_from_uri(http_state_t* hs, const char* uri) {
         hs->resp_file_opened = http_fs_data_open_file(hi, &hs->resp_file, uri); /* Give me a new file now */
     }
 
+#if HTTP_USE_METRICS
+    hs->metrics_status = hs->resp_file_opened ? 200 : 404;  /* Only fallback below answers with 404 */
+#endif /* HTTP_USE_METRICS */
+
     /*
      * We still don't have a file!
      * Try with 404 error page if available by user
@@ -552,7 +795,7 @@ read_resp_file(http_state_t* hs) {
 
     /* Is our memory set for some reason? */
     if (hs->buff != NULL) {                     /* Do we have already something in our buffer? */
-        if (!hs->resp_file.is_static) {         /* If file is not static... */
+        if (!hs->resp_file.is_static && hs->resp_file.data == NULL) {   /* If file is not static or memory mapped... */
             esp_mem_free_s((void **)&hs->buff); /* ...free the memory... */
         }
         hs->buff = NULL;                        /* ...and reset pointer */
@@ -566,20 +809,20 @@ read_resp_file(http_state_t* hs) {
     if (hs->buff == NULL) {                     /* Do we have a buffer empty? */
         len = http_fs_data_read_file(hi, &hs->resp_file, NULL, 0, NULL);    /* Get number of remaining bytes to read in file */
         if (len > 0) {                              /* Is there anything to read? On static files, this should be valid only once */
-            if (hs->resp_file.is_static) {      /* On static files... */
+            if (hs->resp_file.is_static || hs->resp_file.data != NULL) {    /* On static or memory mapped files... */
                 len = http_fs_data_read_file(hi, &hs->resp_file, (void **)&hs->buff, len, NULL);    /* ...simply set file pointer */
                 hs->buff_len = len;             /* Set buffer length */
                 if (len == 0) {                 /* Empty read? */
                     hs->buff = NULL;            /* Reset buffer */
                 }
             } else {
-                if (len > ESP_CFG_CONN_MAX_DATA_LEN) {  /* Limit to maximal length */
-                    len = ESP_CFG_CONN_MAX_DATA_LEN;
+                if (len > esp_get_conn_max_data_len()) {/* Limit to maximal length */
+                    len = esp_get_conn_max_data_len();
                 }
                 hs->buff_ptr = 0;               /* Reset read pointer */
                 do {
                     hs->buff_len = len;
-                    hs->buff = (const void *)esp_mem_malloc(sizeof(*hs->buff) * hs->buff_len);
+                    hs->buff = (const void *)esp_mem_malloc_class(ESP_MEM_CLASS_BULK, sizeof(*hs->buff) * hs->buff_len);
                     if (hs->buff != NULL) {     /* Is memory ready? */
                         /* Read file directly and stop everything */
                         if (!http_fs_data_read_file(hi, &hs->resp_file, (void **)&hs->buff, hs->buff_len, NULL)) {
@@ -861,6 +1104,9 @@ send_response(http_state_t* hs, uint8_t ft) {
     }
 
     if (close) {
+#if HTTP_USE_METRICS
+        http_metrics_complete(hs);
+#endif /* HTTP_USE_METRICS */
         esp_conn_close(hs->conn, 0);            /* Close the connection as no file opened in this case */
     }
 }
@@ -885,13 +1131,22 @@ http_evt(esp_evt_t* evt) {
         case ESP_EVT_CONN_ACTIVE: {
             ESP_DEBUGF(ESP_CFG_DBG_SERVER_TRACE_WARNING, "[HTTP SERVER] Conn %d active\r\n",
                 (int)esp_conn_getnum(conn));
-            hs = esp_mem_calloc(1, sizeof(*hs));
+            hs = esp_mem_calloc_class(ESP_MEM_CLASS_FAST, 1, sizeof(*hs));
             if (hs != NULL) {
                 hs->conn = conn;                /* Save connection handle */
                 esp_conn_set_arg(conn, hs);     /* Set argument for connection */
+#if HTTP_USE_METRICS
+                ++http_metrics.conns_total;
+                if (++http_metrics.conns_active > http_metrics.conns_max) {
+                    http_metrics.conns_max = http_metrics.conns_active;
+                }
+#endif /* HTTP_USE_METRICS */
             } else {
                 ESP_DEBUGF(ESP_CFG_DBG_SERVER_TRACE_WARNING,
                     "[HTTP SERVER] Cannot allocate memory for http state\r\n");
+#if HTTP_USE_METRICS
+                ++http_metrics.rejected;
+#endif /* HTTP_USE_METRICS */
                 close = 1;                      /* No memory, close the connection */
             }
             break;
@@ -927,6 +1182,9 @@ http_evt(esp_evt_t* evt) {
 
                         /* Parse the URI, process request and open response file */
                         http_uri_parsed = http_parse_uri(hs->p) == espOK;
+#if HTTP_USE_METRICS
+                        http_metrics_request(hs, http_uri_parsed ? http_uri : NULL);
+#endif /* HTTP_USE_METRICS */
 
 #if HTTP_SUPPORT_POST
                         /* Check for request method used on this connection */
@@ -1010,9 +1268,18 @@ http_evt(esp_evt_t* evt) {
                             } else {
                                 hs->req_method = HTTP_METHOD_NOTALLOWED;
                                 hs->process_resp = 1;
+#if HTTP_USE_METRICS
+                                hs->metrics_status = 405;
+#endif /* HTTP_USE_METRICS */
                             }
                         }
 
+#if HTTP_USE_METRICS
+                        if (!http_uri_parsed || hs->req_method == HTTP_METHOD_NOTALLOWED) {
+                            ++http_metrics.rejected;
+                        }
+#endif /* HTTP_USE_METRICS */
+
                         /*
                          * If uri was parsed succssfully and if method is allowed,
                          * then open and prepare file for future response
@@ -1075,6 +1342,9 @@ http_evt(esp_evt_t* evt) {
                 ESP_DEBUGF(ESP_CFG_DBG_SERVER_TRACE,
                     "[HTTP SERVER] data sent with %d bytes\r\n", (int)len);
                 hs->sent_total += len;          /* Increase number of bytes sent */
+#if HTTP_USE_METRICS
+                http_metrics_sent(hs, len);
+#endif /* HTTP_USE_METRICS */
                 send_response(hs, 0);           /* Send more data if possible */
             } else {
                 ESP_DEBUGW(ESP_CFG_DBG_SERVER_TRACE_DANGER, res != espOK,
@@ -1102,13 +1372,21 @@ http_evt(esp_evt_t* evt) {
                     hs->p = NULL;
                 }
                 if (hs->resp_file_opened) {     /* Is file opened? */
-                    uint8_t is_static = hs->resp_file.is_static;
+                    uint8_t is_static = hs->resp_file.is_static || hs->resp_file.data != NULL;
                     http_fs_data_close_file(hi, &hs->resp_file);    /* Close file at this point */
                     if (!is_static && hs->buff != NULL) {
                         esp_mem_free_s((void **)&hs->buff);
                     }
                     hs->resp_file_opened = 0;   /* File is not opened anymore */
                 }
+#if HTTP_USE_METRICS
+#if HTTP_USE_METRICS_STATUS
+                if (hs->metrics_report != NULL) {
+                    esp_mem_free_s((void **)&hs->metrics_report);
+                }
+#endif /* HTTP_USE_METRICS_STATUS */
+                http_metrics_close(hs);
+#endif /* HTTP_USE_METRICS */
                 esp_mem_free_s((void **)&hs);
             }
             break;
@@ -1163,3 +1441,68 @@ esp_http_server_write(http_state_t* hs, const void* data, size_t len) {
     hs->written_total += len;                   /* Increase total length */
     return len;
 }
+
+#if HTTP_USE_METRICS || __DOXYGEN__
+
+/**
+ * \brief           Get copy of HTTP server request metrics
+ * \param[out]      metrics: Pointer to output structure
+ * \return          \ref espOK on success, member of \ref espr_t otherwise
+ */
+espr_t
+esp_http_server_get_metrics(http_metrics_t* metrics) {
+    ESP_ASSERT("metrics != NULL", metrics != NULL);
+
+    esp_core_lock();
+    ESP_MEMCPY(metrics, &http_metrics, sizeof(*metrics));
+    esp_core_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Reset HTTP server request metrics
+ * \note            Number of active connections is preserved and
+ *                  routes stay in the table with counters set to `0`
+ * \return          \ref espOK on success, member of \ref espr_t otherwise
+ */
+espr_t
+esp_http_server_reset_metrics(void) {
+    uint32_t conns_active;
+
+    esp_core_lock();
+    conns_active = http_metrics.conns_active;
+    for (size_t i = 0; i < HTTP_METRICS_MAX_ROUTES; ++i) {
+        http_route_metrics_t* r = &http_metrics.routes[i];
+        ESP_MEMSET((char *)r + sizeof(r->uri), 0x00, sizeof(*r) - sizeof(r->uri));
+    }
+    http_metrics.conns_max = conns_active;
+    http_metrics.conns_total = 0;
+    http_metrics.requests = 0;
+    http_metrics.rejected = 0;
+    http_metrics.aborted = 0;
+    esp_core_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Write plain text report of HTTP server request metrics
+ *
+ * This is the same report as sent by built-in status route, without HTTP headers.
+ * Call function with `buff` set to `NULL` and `size` set to `0` to get required length.
+ *
+ * \param[out]      buff: Output buffer, may be `NULL` when `size` is `0`
+ * \param[in]       size: Size of output buffer including terminating `0`
+ * \return          Length of full report excluding terminating `0`.
+ *                  Report was truncated if return value is greater or equal to `size`
+ */
+size_t
+esp_http_server_metrics_report(char* buff, size_t size) {
+    size_t len;
+
+    esp_core_lock();
+    len = http_metrics_print(buff, size);
+    esp_core_unlock();
+    return len;
+}
+
+#endif /* HTTP_USE_METRICS || __DOXYGEN__ */
@@ -139,6 +139,7 @@ http_fs_data_open_file(const http_init_t* hi, http_fs_file_t* file, const char*
     file->fptr = 0;
     if (hi != NULL && hi->fs_open != NULL) {    /* Is user defined file system ready? */
         file->rem_open_files = &http_fs_opened_files_cnt;   /* Set pointer to opened files */
+        file->data = NULL;                      /* User may set it for memory mapped file */
         res = hi->fs_open(file, path);          /* Try to read file from user file system */
         if (res) {
             ++http_fs_opened_files_cnt;         /* Increase number of opened files */
@@ -179,7 +180,7 @@ http_fs_data_read_file(const http_init_t* hi, http_fs_file_t* file, void** buff,
 
     len = file->size - file->fptr;              /* Calculate remaining length */
     if (buff == NULL) {                         /* If there is no buffer */
-        if (file->is_static) {                  /* Check static file */
+        if (file->is_static || file->data != NULL) {/* Check static or memory mapped file */
             return len;                         /* Simply return difference */
         } else if (hi != NULL && hi->fs_read != NULL) { /* Check for read function */
             return hi->fs_read(file, NULL, 0);  /* Call a function for dynamic file check */
@@ -188,7 +189,7 @@ http_fs_data_read_file(const http_init_t* hi, http_fs_file_t* file, void** buff,
     }
 
     len = ESP_MIN(btr, len);                    /* Get number of bytes we can read */
-    if (file->is_static) {                      /* Is file static? */
+    if (file->is_static || file->data != NULL) {/* Is file static or memory mapped? */
         *buff = (void *)&file->data[file->fptr];/* Set a new address pointer only */
     } else if (hi != NULL && hi->fs_read != NULL) {
         len = hi->fs_read(file, *buff, len);    /* Read and return number of bytes read */
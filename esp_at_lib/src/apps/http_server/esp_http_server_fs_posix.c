@@ -0,0 +1,293 @@
+/**
+ * \file            esp_http_server_fs_posix.c
+ * \brief           POSIX file system with snapshot cache for HTTP server
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include "esp/apps/esp_http_server.h"
+#include "esp/apps/esp_http_server_fs.h"
+#include "esp/esp_mem.h"
+
+#if !__DOXYGEN__
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Files are copied with pread to private anonymous mappings, one copy per cache fill.
+ * File data pointer is set to the snapshot on open and server sends data from it,
+ * requests for cached file are served without copying.
+ *
+ * File itself is not mapped. Access to file mapping beyond end of file,
+ * truncated on disk while request is in progress, would raise SIGBUS.
+ * Snapshot is not affected by any later change of the file.
+ *
+ * Mappings are kept in cache after file is closed and reused on next request
+ * for the same path, as long as file on disk has not been modified.
+ * Entry is unmapped when it is replaced by other file or when file changes.
+ *
+ * Functions are called from processing thread only, no locking is required.
+ */
+
+/**
+ * \brief           Mapped file entry
+ */
+typedef struct {
+    char path[HTTP_MAX_URI_LEN];                /*!< Request path, empty when entry is not in cache */
+    void* addr;                                 /*!< Mapping address or `NULL` if entry is not used */
+    size_t size;                                /*!< File size in units of bytes */
+    dev_t dev;                                  /*!< File device, to detect file replacement */
+    ino_t ino;                                  /*!< File inode, to detect file replacement */
+    struct timespec mtime;                      /*!< Last file modification time */
+    uint16_t refs;                              /*!< Number of opened files using this entry */
+    uint32_t last_used;                         /*!< Value of \ref fs_use_cnt on last open, for LRU replacement */
+    uint8_t is_alloc;                           /*!< Set to `1` when entry is allocated outside cache table */
+} fs_map_t;
+
+static fs_map_t fs_cache[HTTP_FS_POSIX_CACHE_SIZE];
+static uint32_t fs_use_cnt;
+static char fs_path[sizeof(HTTP_FS_POSIX_ROOT) + HTTP_MAX_URI_LEN];
+
+/* Data pointer for empty files, as they cannot be mapped */
+static const uint8_t fs_empty_data[1];
+
+/**
+ * \brief           Check if mapping matches file on disk
+ * \param[in]       m: Mapped entry
+ * \param[in]       st: File status
+ * \return          `1` if entry is up to date, `0` otherwise
+ */
+static uint8_t
+fs_map_is_valid(const fs_map_t* m, const struct stat* st) {
+    return m->size == (size_t)st->st_size && m->dev == st->st_dev && m->ino == st->st_ino
+        && m->mtime.tv_sec == st->st_mtim.tv_sec && m->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+/**
+ * \brief           Unmap entry and release it
+ * \param[in]       m: Mapped entry
+ */
+static void
+fs_map_release(fs_map_t* m) {
+    munmap(m->addr, m->size);
+    if (m->is_alloc) {
+        esp_mem_free(m);
+    } else {
+        ESP_MEMSET(m, 0x00, sizeof(*m));
+    }
+}
+
+/**
+ * \brief           Read file to new read-only anonymous mapping
+ * \param[in]       fd: File descriptor
+ * \param[in]       size: File size in units of bytes
+ * \return          Mapping address or `NULL` on failure or when file was truncated meanwhile
+ */
+static void*
+fs_map_snapshot(int fd, size_t size) {
+    uint8_t* addr;
+    size_t off = 0;
+    ssize_t len;
+
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+    while (off < size) {
+        len = pread(fd, &addr[off], size - off, (off_t)off);
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {                         /* Read error or file truncated */
+            munmap(addr, size);
+            return NULL;
+        }
+        off += (size_t)len;
+    }
+    mprotect(addr, size, PROT_READ);            /* Served data are never modified */
+    return addr;
+}
+
+/**
+ * \brief           Find free cache entry or least recently used one, which is not opened
+ * \return          Cache entry or `NULL` if all entries are in use
+ */
+static fs_map_t*
+fs_cache_get_free(void) {
+    fs_map_t* m = NULL;
+
+    for (size_t i = 0; i < HTTP_FS_POSIX_CACHE_SIZE; ++i) {
+        if (fs_cache[i].addr == NULL) {
+            return &fs_cache[i];
+        }
+        if (fs_cache[i].refs == 0
+            && (m == NULL || (int32_t)(fs_cache[i].last_used - m->last_used) < 0)) {
+            m = &fs_cache[i];
+        }
+    }
+    if (m != NULL) {
+        fs_map_release(m);
+    }
+    return m;
+}
+
+/**
+ * \brief           Open a file of specific path
+ * \param[in]       file: File structure to fill if file is successfully open
+ * \param[in]       path: File path to open in format "/js/scripts.js" or "/index.html"
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+http_fs_open(http_fs_file_t* file, const char* path) {
+    struct stat st;
+    fs_map_t* m = NULL;
+    void* addr;
+    int fd;
+
+    /* Do not allow access outside root directory */
+    if (path == NULL || path[0] != '/' || strstr(path, "/..") != NULL
+        || strlen(path) >= HTTP_MAX_URI_LEN) {
+        return 0;
+    }
+    sprintf(fs_path, "%s%s", HTTP_FS_POSIX_ROOT, path);
+    if ((fd = open(fs_path, O_RDONLY)) < 0) {
+        return 0;
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (uintmax_t)st.st_size > UINT32_MAX) {
+        close(fd);
+        return 0;
+    }
+
+    /* Empty files cannot be mapped */
+    if (st.st_size == 0) {
+        close(fd);
+        file->data = fs_empty_data;
+        file->size = 0;
+        file->arg = NULL;
+        return 1;
+    }
+
+    /* Check if file is already mapped */
+    for (size_t i = 0; i < HTTP_FS_POSIX_CACHE_SIZE; ++i) {
+        if (fs_cache[i].addr != NULL && !strcmp(fs_cache[i].path, path)) {
+            if (fs_map_is_valid(&fs_cache[i], &st)) {
+                m = &fs_cache[i];
+            } else if (fs_cache[i].refs == 0) {
+                fs_map_release(&fs_cache[i]);
+            } else {
+                fs_cache[i].path[0] = '\0';     /* Remove from cache, unmapped on last close */
+            }
+            break;
+        }
+    }
+
+    /* Map file to new entry */
+    if (m == NULL) {
+        if ((addr = fs_map_snapshot(fd, (size_t)st.st_size)) == NULL) {
+            close(fd);
+            return 0;
+        }
+        if ((m = fs_cache_get_free()) == NULL) {    /* All cache entries are in use */
+            if ((m = esp_mem_calloc(1, sizeof(*m))) == NULL) {
+                munmap(addr, (size_t)st.st_size);
+                close(fd);
+                return 0;
+            }
+            m->is_alloc = 1;
+        } else {
+            strcpy(m->path, path);
+        }
+        m->addr = addr;
+        m->size = (size_t)st.st_size;
+        m->dev = st.st_dev;
+        m->ino = st.st_ino;
+        m->mtime = st.st_mtim;
+    }
+    close(fd);                                  /* Snapshot does not depend on file */
+
+    m->last_used = ++fs_use_cnt;
+    ++m->refs;
+    file->data = m->addr;                       /* Server sends directly from mapping */
+    file->size = (uint32_t)m->size;
+    file->arg = m;
+    return 1;
+}
+
+/**
+ * \brief           Read a file content
+ *
+ * Server uses file data pointer set on open, hence this function is called
+ * only by other users of file system.
+ *
+ * \param[in]       file: File handle to read
+ * \param[out]      buff: Buffer to read data to. When set to NULL, function should return remaining available data to read
+ * \param[in]       btr: Number of bytes to read. Has no meaning when buff = NULL
+ * \return          Number of bytes read or number of bytes available to read
+ */
+uint32_t
+http_fs_read(http_fs_file_t* file, void* buff, size_t btr) {
+    uint32_t len;
+
+    len = file->size - file->fptr;              /* Calculate remaining length */
+    if (buff == NULL) {
+        return len;
+    }
+    len = ESP_MIN(len, (uint32_t)btr);
+    ESP_MEMCPY(buff, &file->data[file->fptr], len);
+    return len;
+}
+
+/**
+ * \brief           Close a file handle
+ *
+ * Mapping is kept in cache for next requests.
+ *
+ * \param[in]       file: File handle
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+http_fs_close(http_fs_file_t* file) {
+    fs_map_t* m;
+
+    m = file->arg;                              /* Get file argument */
+    if (m != NULL) {
+        if (--m->refs == 0 && m->path[0] == '\0') { /* Entry not in cache anymore */
+            fs_map_release(m);
+        }
+        file->arg = NULL;
+    }
+    return 1;
+}
+
+#endif /* !__DOXYGEN__ */
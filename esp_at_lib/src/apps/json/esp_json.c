@@ -0,0 +1,885 @@
+/**
+ * \file            esp_json.c
+ * \brief           Streaming JSON writer and parser
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include "esp/apps/esp_json.h"
+#include "esp/esp_utils.h"
+
+#if ESP_CFG_JSON_MAX_DEPTH > 32
+#error "ESP_CFG_JSON_MAX_DEPTH must not be greater than 32!"
+#endif /* ESP_CFG_JSON_MAX_DEPTH > 32 */
+
+/* Parser states */
+#define JSON_STATE_VALUE                0       /* Expecting any value */
+#define JSON_STATE_VALUE_FIRST          1       /* Expecting first array value or array end */
+#define JSON_STATE_KEY_FIRST            2       /* Expecting first object key or object end */
+#define JSON_STATE_KEY                  3       /* Expecting object key after comma */
+#define JSON_STATE_COLON                4       /* Expecting colon after key */
+#define JSON_STATE_NEXT                 5       /* Expecting comma or end of container after value */
+#define JSON_STATE_STRING               6       /* Inside string */
+#define JSON_STATE_ESCAPE               7       /* After backslash in string */
+#define JSON_STATE_UNICODE              8       /* Inside `\uXXXX` escape sequence */
+#define JSON_STATE_NUMBER               9       /* Inside number */
+#define JSON_STATE_LITERAL              10      /* Inside `true`, `false` or `null` */
+#define JSON_STATE_DONE                 11      /* Top level value completed */
+
+#define JSON_IS_WS(ch)                  ((ch) == ' ' || (ch) == '\t' || (ch) == '\r' || (ch) == '\n')
+#define JSON_IS_DIGIT(ch)               ((ch) >= '0' && (ch) <= '9')
+
+/**
+ * \brief           Output function for linear buffer
+ *
+ * Buffer is always kept `0` terminated, data not fitting to buffer are dropped
+ */
+static size_t
+json_out_buff(esp_json_writer_t* w, const void* data, size_t len) {
+    char* buff = w->arg;
+    size_t avail;
+
+    avail = w->size > w->len + 1 ? w->size - w->len - 1 : 0;
+    len = ESP_MIN(len, avail);
+    if (len > 0) {
+        ESP_MEMCPY(&buff[w->len], data, len);
+        buff[w->len + len] = '\0';
+    }
+    return len;
+}
+
+/**
+ * \brief           Output function for pbuf chain
+ */
+static size_t
+json_out_pbuf(esp_json_writer_t* w, const void* data, size_t len) {
+    len = ESP_MIN(len, w->size - w->len);
+    if (len > 0 && esp_pbuf_take(w->arg, data, len, w->len) != espOK) {
+        return 0;
+    }
+    return len;
+}
+
+/**
+ * \brief           Output function for connection write buffer
+ */
+static size_t
+json_out_conn(esp_json_writer_t* w, const void* data, size_t len) {
+    return esp_conn_write(w->arg, data, len, 0, NULL) == espOK ? len : 0;
+}
+
+/**
+ * \brief           Output function for HTTP server response
+ */
+static size_t
+json_out_http(esp_json_writer_t* w, const void* data, size_t len) {
+    return esp_http_server_write(w->arg, data, len);
+}
+
+/**
+ * \brief           Send data to writer output
+ * \param[in]       w: JSON writer
+ * \param[in]       data: Data to output
+ * \param[in]       len: Length of data
+ * \return          \ref espOK on success, \ref espERRMEM when output did not accept all data
+ */
+static espr_t
+json_write(esp_json_writer_t* w, const void* data, size_t len) {
+    size_t written;
+
+    if (w->err) {
+        return espERRMEM;
+    }
+    written = w->out(w, data, len);
+    w->len += written;
+    if (written < len) {
+        w->err = 1;
+        return espERRMEM;
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Write string with quotes and escape sequences
+ * \param[in]       w: JSON writer
+ * \param[in]       str: String to write
+ * \param[in]       len: Length of string
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+json_write_str(esp_json_writer_t* w, const char* str, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    char esc[6];
+    size_t start = 0, esc_len;
+    uint8_t ch;
+
+    json_write(w, "\"", 1);
+    for (size_t i = 0; i < len; ++i) {
+        ch = (uint8_t)str[i];
+        esc_len = 2;
+        esc[0] = '\\';
+        switch (ch) {
+            case '"':   esc[1] = '"'; break;
+            case '\\':  esc[1] = '\\'; break;
+            case '\n':  esc[1] = 'n'; break;
+            case '\r':  esc[1] = 'r'; break;
+            case '\t':  esc[1] = 't'; break;
+            default:
+                if (ch >= 0x20) {
+                    continue;                   /* Character is written as part of plain run */
+                }
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = hex[ch >> 4];
+                esc[5] = hex[ch & 0x0F];
+                esc_len = 6;
+                break;
+        }
+        if (i > start) {
+            json_write(w, &str[start], i - start);
+        }
+        json_write(w, esc, esc_len);
+        start = i + 1;
+    }
+    if (len > start) {
+        json_write(w, &str[start], len - start);
+    }
+    return json_write(w, "\"", 1);
+}
+
+/**
+ * \brief           Write element separator and optional key before new value
+ * \param[in]       w: JSON writer
+ * \param[in]       key: Key name for object member or `NULL` for array element
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+json_write_prefix(esp_json_writer_t* w, const char* key) {
+    uint32_t bit;
+
+    if (w->depth > 0) {
+        bit = ESP_U32(1) << (w->depth - 1);
+        if (w->first & bit) {
+            w->first &= ~bit;
+        } else {
+            json_write(w, ",", 1);
+        }
+    }
+    if (key != NULL) {
+        json_write_str(w, key, strlen(key));
+        json_write(w, ":", 1);
+    }
+    return w->err ? espERRMEM : espOK;
+}
+
+/**
+ * \brief           Open object or array
+ * \param[in]       w: JSON writer
+ * \param[in]       key: Key name or `NULL`
+ * \param[in]       ch: Opening character
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+json_write_open(esp_json_writer_t* w, const char* key, char ch) {
+    ESP_ASSERT("w != NULL", w != NULL);
+    ESP_ASSERT("w->depth < ESP_CFG_JSON_MAX_DEPTH", w->depth < ESP_CFG_JSON_MAX_DEPTH);
+
+    json_write_prefix(w, key);
+    w->first |= ESP_U32(1) << w->depth;
+    ++w->depth;
+    return json_write(w, &ch, 1);
+}
+
+/**
+ * \brief           Close object or array
+ * \param[in]       w: JSON writer
+ * \param[in]       ch: Closing character
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+json_write_close(esp_json_writer_t* w, char ch) {
+    ESP_ASSERT("w != NULL", w != NULL);
+    ESP_ASSERT("w->depth > 0", w->depth > 0);
+
+    --w->depth;
+    return json_write(w, &ch, 1);
+}
+
+/**
+ * \brief           Initialize JSON writer with custom output function
+ * \param[in]       w: JSON writer
+ * \param[in]       out: Output function
+ * \param[in]       arg: Output function argument, available as `w->arg`
+ */
+void
+esp_json_writer_init(esp_json_writer_t* w, esp_json_out_fn out, void* arg) {
+    ESP_MEMSET(w, 0x00, sizeof(*w));
+    w->out = out;
+    w->arg = arg;
+}
+
+/**
+ * \brief           Initialize JSON writer to write to linear buffer
+ *
+ * Buffer is kept `0` terminated after every write.
+ * When document does not fit, \ref espERRMEM is returned and document is truncated
+ *
+ * \param[in]       w: JSON writer
+ * \param[in]       buff: Output buffer
+ * \param[in]       size: Size of output buffer including terminating `0`
+ */
+void
+esp_json_writer_init_buff(esp_json_writer_t* w, char* buff, size_t size) {
+    esp_json_writer_init(w, json_out_buff, buff);
+    w->size = size;
+    if (size > 0) {
+        buff[0] = '\0';
+    }
+}
+
+/**
+ * \brief           Initialize JSON writer to write to payload of pbuf chain
+ *
+ * Document is written from beginning of the chain,
+ * use \ref esp_json_writer_get_len to get number of valid bytes
+ *
+ * \param[in]       w: JSON writer
+ * \param[in]       pbuf: Allocated pbuf chain
+ */
+void
+esp_json_writer_init_pbuf(esp_json_writer_t* w, esp_pbuf_p pbuf) {
+    esp_json_writer_init(w, json_out_pbuf, pbuf);
+    w->size = esp_pbuf_length(pbuf, 1);
+}
+
+/**
+ * \brief           Initialize JSON writer to write to connection write buffer
+ *
+ * Data are written with \ref esp_conn_write and sent when buffer is full.
+ * Call \ref esp_conn_write with `flush` set to `1` once document is complete.
+ *
+ * \note            Function may only be used from connection callback function
+ * \param[in]       w: JSON writer
+ * \param[in]       conn: Connection handle
+ */
+void
+esp_json_writer_init_conn(esp_json_writer_t* w, esp_conn_p conn) {
+    esp_json_writer_init(w, json_out_conn, conn);
+}
+
+/**
+ * \brief           Initialize JSON writer to write to HTTP server response
+ *
+ * Use it from CGI or SSI callback to generate JSON content
+ *
+ * \param[in]       w: JSON writer
+ * \param[in]       hs: HTTP state
+ */
+void
+esp_json_writer_init_http(esp_json_writer_t* w, http_state_t* hs) {
+    esp_json_writer_init(w, json_out_http, hs);
+}
+
+/**
+ * \brief           Begin new object
+ * \param[in]       w: JSON writer
+ * \param[in]       key: Key name when inside object, `NULL` otherwise
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_json_obj_begin(esp_json_writer_t* w, const char* key) {
+    return json_write_open(w, key, '{');
+}
+
+/**
+ * \brief           End current object
+ * \param[in]       w: JSON writer
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_json_obj_end(esp_json_writer_t* w) {
+    return json_write_close(w, '}');
+}
+
+/**
+ * \brief           Begin new array
+ * \param[in]       w: JSON writer
+ * \param[in]       key: Key name when inside object, `NULL` otherwise
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_json_arr_begin(esp_json_writer_t* w, const char* key) {
+    return json_write_open(w, key, '[');
+}
+
+/**
+ * \brief           End current array
+ * \param[in]       w: JSON writer
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_json_arr_end(esp_json_writer_t* w) {
+    return json_write_close(w, ']');
+}
+
+/**
+ * \brief           Write string value
+ * \param[in]       w: JSON writer
+ * \param[in]       key: Key name when inside object, `NULL` otherwise
+ * \param[in]       str: `0` terminated string, escaped during write
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_json_str(esp_json_writer_t* w, const char* key, const char* str) {
+    ESP_ASSERT("str != NULL", str != NULL);
+    return esp_json_strn(w, key, str, strlen(str));
+}
+
+/**
+ * \brief           Write string value with known length
+ * \param[in]       w: JSON writer
+ * \param[in]       key: Key name when inside object, `NULL` otherwise
+ * \param[in]       str: String, may contain `0` characters
+ * \param[in]       len: Length of string
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_json_strn(esp_json_writer_t* w, const char* key, const char* str, size_t len) {
+    ESP_ASSERT("w != NULL", w != NULL);
+    ESP_ASSERT("str != NULL || len == 0", str != NULL || len == 0);
+
+    json_write_prefix(w, key);
+    return json_write_str(w, str, len);
+}
+
+/**
+ * \brief           Write signed integer value
+ * \param[in]       w: JSON writer
+ * \param[in]       key: Key name when inside object, `NULL` otherwise
+ * \param[in]       num: Number to write
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_json_int(esp_json_writer_t* w, const char* key, int32_t num) {
+    char str[12];
+
+    esp_i32_to_str(num, str);
+    return esp_json_raw(w, key, str);
+}
+
+/**
+ * \brief           Write unsigned integer value
+ * \param[in]       w: JSON writer
+ * \param[in]       key: Key name when inside object, `NULL` otherwise
+ * \param[in]       num: Number to write
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_json_uint(esp_json_writer_t* w, const char* key, uint32_t num) {
+    char str[11];
+
+    esp_u32_to_str(num, str);
+    return esp_json_raw(w, key, str);
+}
+
+/**
+ * \brief           Write boolean value
+ * \param[in]       w: JSON writer
+ * \param[in]       key: Key name when inside object, `NULL` otherwise
+ * \param[in]       val: Value to write, `0` for `false`, any other for `true`
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_json_bool(esp_json_writer_t* w, const char* key, uint8_t val) {
+    return esp_json_raw(w, key, val ? "true" : "false");
+}
+
+/**
+ * \brief           Write `null` value
+ * \param[in]       w: JSON writer
+ * \param[in]       key: Key name when inside object, `NULL` otherwise
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_json_null(esp_json_writer_t* w, const char* key) {
+    return esp_json_raw(w, key, "null");
+}
+
+/**
+ * \brief           Write value without any escaping
+ *
+ * Use it for preformatted numbers, such as floating point values
+ *
+ * \param[in]       w: JSON writer
+ * \param[in]       key: Key name when inside object, `NULL` otherwise
+ * \param[in]       raw: `0` terminated valid JSON value
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_json_raw(esp_json_writer_t* w, const char* key, const char* raw) {
+    ESP_ASSERT("w != NULL", w != NULL);
+    ESP_ASSERT("raw != NULL", raw != NULL);
+
+    json_write_prefix(w, key);
+    return json_write(w, raw, strlen(raw));
+}
+
+/**
+ * \brief           Check if collected token is valid JSON number
+ * \param[in]       s: Token
+ * \param[in]       len: Token length
+ * \return          `1` if valid, `0` otherwise
+ */
+static uint8_t
+json_number_valid(const char* s, size_t len) {
+    size_t i = 0, start;
+
+    if (i < len && s[i] == '-') {
+        ++i;
+    }
+    if (i < len && s[i] == '0') {               /* Leading zero must be alone */
+        ++i;
+    } else {
+        for (start = i; i < len && JSON_IS_DIGIT(s[i]); ++i) {}
+        if (i == start) {
+            return 0;
+        }
+    }
+    if (i < len && s[i] == '.') {
+        for (start = ++i; i < len && JSON_IS_DIGIT(s[i]); ++i) {}
+        if (i == start) {
+            return 0;
+        }
+    }
+    if (i < len && (s[i] == 'e' || s[i] == 'E')) {
+        ++i;
+        if (i < len && (s[i] == '+' || s[i] == '-')) {
+            ++i;
+        }
+        for (start = i; i < len && JSON_IS_DIGIT(s[i]); ++i) {}
+        if (i == start) {
+            return 0;
+        }
+    }
+    return i == len;
+}
+
+/**
+ * \brief           Add character to token
+ * \param[in]       p: JSON parser
+ * \param[in]       ch: Character to add
+ * \return          \ref espOK on success, \ref espERRMEM when token is too long
+ */
+static espr_t
+json_token_add(esp_json_parser_t* p, char ch) {
+    if (p->token_len >= ESP_CFG_JSON_TOKEN_LEN) {
+        return espERRMEM;
+    }
+    p->token[p->token_len++] = ch;
+    return espOK;
+}
+
+/**
+ * \brief           Add unicode code point to token in UTF-8 encoding
+ * \param[in]       p: JSON parser
+ * \param[in]       cp: Code point
+ * \return          \ref espOK on success, \ref espERRMEM when token is too long
+ */
+static espr_t
+json_token_add_utf8(esp_json_parser_t* p, uint32_t cp) {
+    char utf8[4];
+    size_t len;
+
+    if (cp < 0x80) {
+        utf8[0] = (char)cp;
+        len = 1;
+    } else if (cp < 0x800) {
+        utf8[0] = (char)(0xC0 | (cp >> 6));
+        utf8[1] = (char)(0x80 | (cp & 0x3F));
+        len = 2;
+    } else if (cp < 0x10000) {
+        utf8[0] = (char)(0xE0 | (cp >> 12));
+        utf8[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        utf8[2] = (char)(0x80 | (cp & 0x3F));
+        len = 3;
+    } else {
+        utf8[0] = (char)(0xF0 | (cp >> 18));
+        utf8[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        utf8[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        utf8[3] = (char)(0x80 | (cp & 0x3F));
+        len = 4;
+    }
+    if (p->token_len + len > ESP_CFG_JSON_TOKEN_LEN) {
+        return espERRMEM;
+    }
+    ESP_MEMCPY(&p->token[p->token_len], utf8, len);
+    p->token_len += len;
+    return espOK;
+}
+
+/**
+ * \brief           Report token to user
+ * \param[in]       p: JSON parser
+ * \param[in]       type: Token type
+ * \return          Result of user callback
+ */
+static espr_t
+json_emit(esp_json_parser_t* p, esp_json_type_t type) {
+    const char* data = NULL;
+    size_t len = 0;
+
+    if (type == ESP_JSON_TYPE_KEY || type == ESP_JSON_TYPE_STRING || type == ESP_JSON_TYPE_NUMBER) {
+        p->token[p->token_len] = '\0';
+        data = p->token;
+        len = p->token_len;
+    }
+    p->token_len = 0;
+    return p->fn != NULL ? p->fn(p, type, data, len) : espOK;
+}
+
+/**
+ * \brief           Set next state after complete value
+ * \param[in]       p: JSON parser
+ */
+static void
+json_value_done(esp_json_parser_t* p) {
+    p->state = p->depth > 0 ? JSON_STATE_NEXT : JSON_STATE_DONE;
+}
+
+/**
+ * \brief           Open object or array in parser
+ * \param[in]       p: JSON parser
+ * \param[in]       is_arr: Set to `1` for array, `0` for object
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+json_open(esp_json_parser_t* p, uint8_t is_arr) {
+    uint32_t bit;
+
+    if (p->depth >= ESP_CFG_JSON_MAX_DEPTH) {
+        return espERRMEM;
+    }
+    bit = ESP_U32(1) << p->depth;
+    p->nest = is_arr ? (p->nest | bit) : (p->nest & ~bit);
+    ++p->depth;
+    p->state = is_arr ? JSON_STATE_VALUE_FIRST : JSON_STATE_KEY_FIRST;
+    return json_emit(p, is_arr ? ESP_JSON_TYPE_ARR_BEGIN : ESP_JSON_TYPE_OBJ_BEGIN);
+}
+
+/**
+ * \brief           Close object or array in parser
+ * \param[in]       p: JSON parser
+ * \param[in]       is_arr: Set to `1` for array, `0` for object
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+json_close(esp_json_parser_t* p, uint8_t is_arr) {
+    if (p->depth == 0 || ((p->nest >> (p->depth - 1)) & 0x01) != is_arr) {
+        return espERR;
+    }
+    --p->depth;
+    json_value_done(p);
+    return json_emit(p, is_arr ? ESP_JSON_TYPE_ARR_END : ESP_JSON_TYPE_OBJ_END);
+}
+
+/**
+ * \brief           Start parsing new value
+ * \param[in]       p: JSON parser
+ * \param[in]       ch: First character of value
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+json_value_start(esp_json_parser_t* p, char ch) {
+    switch (ch) {
+        case '{':   return json_open(p, 0);
+        case '[':   return json_open(p, 1);
+        case '"':
+            p->is_key = 0;
+            p->state = JSON_STATE_STRING;
+            return espOK;
+        case 't':   p->lit = "true"; break;
+        case 'f':   p->lit = "false"; break;
+        case 'n':   p->lit = "null"; break;
+        default:
+            if (ch == '-' || JSON_IS_DIGIT(ch)) {
+                p->state = JSON_STATE_NUMBER;
+                return json_token_add(p, ch);
+            }
+            return espERR;
+    }
+    p->lit_pos = 1;
+    p->state = JSON_STATE_LITERAL;
+    return espOK;
+}
+
+/**
+ * \brief           Process single character
+ * \param[in]       p: JSON parser
+ * \param[in]       ch: Character to process
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+json_process(esp_json_parser_t* p, char ch) {
+    uint8_t is_ws = JSON_IS_WS(ch);
+    espr_t res;
+
+    switch (p->state) {
+        case JSON_STATE_VALUE_FIRST:
+            if (ch == ']') {
+                return json_close(p, 1);
+            }
+            /* Fallthrough */
+        case JSON_STATE_VALUE:
+            return is_ws ? espOK : json_value_start(p, ch);
+        case JSON_STATE_KEY_FIRST:
+            if (ch == '}') {
+                return json_close(p, 0);
+            }
+            /* Fallthrough */
+        case JSON_STATE_KEY:
+            if (is_ws) {
+                return espOK;
+            }
+            if (ch != '"') {
+                return espERR;
+            }
+            p->is_key = 1;
+            p->state = JSON_STATE_STRING;
+            return espOK;
+        case JSON_STATE_COLON:
+            if (is_ws) {
+                return espOK;
+            }
+            if (ch != ':') {
+                return espERR;
+            }
+            p->state = JSON_STATE_VALUE;
+            return espOK;
+        case JSON_STATE_NEXT:
+            if (is_ws) {
+                return espOK;
+            } else if (ch == ',') {
+                p->state = ((p->nest >> (p->depth - 1)) & 0x01) ? JSON_STATE_VALUE : JSON_STATE_KEY;
+                return espOK;
+            } else if (ch == ']' || ch == '}') {
+                return json_close(p, ch == ']');
+            }
+            return espERR;
+        case JSON_STATE_STRING:
+            if (p->surrogate != 0 && ch != '\\') {  /* High surrogate must be followed by low one */
+                return espERR;
+            }
+            if (ch == '"') {
+                if (p->is_key) {
+                    p->state = JSON_STATE_COLON;
+                    return json_emit(p, ESP_JSON_TYPE_KEY);
+                }
+                json_value_done(p);
+                return json_emit(p, ESP_JSON_TYPE_STRING);
+            } else if (ch == '\\') {
+                p->state = JSON_STATE_ESCAPE;
+                return espOK;
+            } else if ((uint8_t)ch < 0x20) {
+                return espERR;
+            }
+            return json_token_add(p, ch);
+        case JSON_STATE_ESCAPE:
+            if (p->surrogate != 0 && ch != 'u') {
+                return espERR;
+            }
+            p->state = JSON_STATE_STRING;
+            switch (ch) {
+                case '"':
+                case '\\':
+                case '/':   return json_token_add(p, ch);
+                case 'b':   return json_token_add(p, '\b');
+                case 'f':   return json_token_add(p, '\f');
+                case 'n':   return json_token_add(p, '\n');
+                case 'r':   return json_token_add(p, '\r');
+                case 't':   return json_token_add(p, '\t');
+                case 'u':
+                    p->ucode = 0;
+                    p->lit_pos = 0;
+                    p->state = JSON_STATE_UNICODE;
+                    return espOK;
+                default:    return espERR;
+            }
+        case JSON_STATE_UNICODE:
+            if (JSON_IS_DIGIT(ch)) {
+                p->ucode = (p->ucode << 4) | (uint32_t)(ch - '0');
+            } else if (ch >= 'a' && ch <= 'f') {
+                p->ucode = (p->ucode << 4) | (uint32_t)(ch - 'a' + 10);
+            } else if (ch >= 'A' && ch <= 'F') {
+                p->ucode = (p->ucode << 4) | (uint32_t)(ch - 'A' + 10);
+            } else {
+                return espERR;
+            }
+            if (++p->lit_pos < 4) {
+                return espOK;
+            }
+            p->state = JSON_STATE_STRING;
+            if (p->ucode >= 0xD800 && p->ucode <= 0xDBFF) {
+                if (p->surrogate != 0) {
+                    return espERR;
+                }
+                p->surrogate = p->ucode;
+                return espOK;
+            } else if (p->ucode >= 0xDC00 && p->ucode <= 0xDFFF) {
+                if (p->surrogate == 0) {
+                    return espERR;
+                }
+                p->ucode = 0x10000 + ((p->surrogate - 0xD800) << 10) + (p->ucode - 0xDC00);
+                p->surrogate = 0;
+            } else if (p->surrogate != 0) {
+                return espERR;
+            }
+            return json_token_add_utf8(p, p->ucode);
+        case JSON_STATE_NUMBER:
+            if (JSON_IS_DIGIT(ch) || ch == '.' || ch == 'e' || ch == 'E' || ch == '+' || ch == '-') {
+                return json_token_add(p, ch);
+            }
+            if (!json_number_valid(p->token, p->token_len)) {
+                return espERR;
+            }
+            json_value_done(p);
+            if ((res = json_emit(p, ESP_JSON_TYPE_NUMBER)) != espOK) {
+                return res;
+            }
+            return json_process(p, ch);         /* Character after number belongs to next state */
+        case JSON_STATE_LITERAL:
+            if (ch != p->lit[p->lit_pos]) {
+                return espERR;
+            }
+            if (p->lit[++p->lit_pos] != '\0') {
+                return espOK;
+            }
+            json_value_done(p);
+            return json_emit(p, p->lit[0] == 't' ? ESP_JSON_TYPE_TRUE :
+                                p->lit[0] == 'f' ? ESP_JSON_TYPE_FALSE : ESP_JSON_TYPE_NULL);
+        case JSON_STATE_DONE:
+            return is_ws ? espOK : espERR;
+        default:
+            return espERR;
+    }
+}
+
+/**
+ * \brief           Initialize JSON parser
+ * \param[in]       p: JSON parser
+ * \param[in]       fn: Token callback function
+ * \param[in]       arg: User argument, available as `p->arg`
+ */
+void
+esp_json_parser_init(esp_json_parser_t* p, esp_json_parser_fn fn, void* arg) {
+    ESP_MEMSET(p, 0x00, sizeof(*p));
+    p->fn = fn;
+    p->arg = arg;
+    p->res = espOK;
+    p->state = JSON_STATE_VALUE;
+}
+
+/**
+ * \brief           Feed parser with next piece of document
+ *
+ * Piece may end anywhere, also in the middle of token
+ *
+ * \param[in]       p: JSON parser
+ * \param[in]       data: Document data
+ * \param[in]       len: Length of data
+ * \return          \ref espOK on success, \ref espERR on syntax error,
+ *                      \ref espERRMEM when token or nesting limit is exceeded,
+ *                      or value returned by user callback.
+ *                      Once parser stops, further calls return the same value
+ */
+espr_t
+esp_json_parser_feed(esp_json_parser_t* p, const void* data, size_t len) {
+    const char* d = data;
+
+    ESP_ASSERT("p != NULL", p != NULL);
+    ESP_ASSERT("data != NULL || len == 0", data != NULL || len == 0);
+
+    for (; len > 0 && p->res == espOK; --len, ++d) {
+        p->res = json_process(p, *d);
+        if (p->res == espOK) {
+            ++p->pos;
+        }
+    }
+    return p->res;
+}
+
+/**
+ * \brief           Feed parser with all pbufs in chain, segment by segment
+ * \param[in]       p: JSON parser
+ * \param[in]       pbuf: Pbuf chain, such as one received on connection
+ * \return          Same as \ref esp_json_parser_feed
+ */
+espr_t
+esp_json_parser_feed_pbuf(esp_json_parser_t* p, const esp_pbuf_p pbuf) {
+    const void* data;
+    size_t off = 0, len;
+
+    ESP_ASSERT("p != NULL", p != NULL);
+    ESP_ASSERT("pbuf != NULL", pbuf != NULL);
+
+    while ((data = esp_pbuf_get_linear_addr(pbuf, off, &len)) != NULL && len > 0) {
+        if (esp_json_parser_feed(p, data, len) != espOK) {
+            break;
+        }
+        off += len;
+    }
+    return p->res;
+}
+
+/**
+ * \brief           Notify parser that document is complete
+ *
+ * Top level number is only reported here, as it has no terminating character
+ *
+ * \param[in]       p: JSON parser
+ * \return          \ref espOK when complete top level value was parsed,
+ *                      \ref espERR when document is incomplete, or error returned during parsing
+ */
+espr_t
+esp_json_parser_finish(esp_json_parser_t* p) {
+    ESP_ASSERT("p != NULL", p != NULL);
+
+    if (p->res == espOK && p->state == JSON_STATE_NUMBER && p->depth == 0) {
+        if (json_number_valid(p->token, p->token_len)) {
+            p->state = JSON_STATE_DONE;
+            p->res = json_emit(p, ESP_JSON_TYPE_NUMBER);
+        } else {
+            p->res = espERR;
+        }
+    }
+    if (p->res == espOK && p->state != JSON_STATE_DONE) {
+        p->res = espERR;
+    }
+    return p->res;
+}
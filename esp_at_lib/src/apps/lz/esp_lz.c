@@ -0,0 +1,570 @@
+/**
+ * \file            esp_lz.c
+ * \brief           Streaming LZ compression
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include "esp/apps/esp_lz.h"
+
+#if ESP_CFG_LZ_WINDOW_BITS < 9 || ESP_CFG_LZ_WINDOW_BITS > 12
+#error "ESP_CFG_LZ_WINDOW_BITS must be between 9 and 12!"
+#endif /* ESP_CFG_LZ_WINDOW_BITS < 9 || ESP_CFG_LZ_WINDOW_BITS > 12 */
+
+#define LZ_LEN_BITS                     (16 - ESP_CFG_LZ_WINDOW_BITS)
+#define LZ_POS_NONE                     0xFFFF
+#define LZ_CODE_END                     0       /* Length code of end of group marker */
+#define LZ_CODE_STORED                  1       /* Length code of stored block marker */
+#define LZ_STORED_MIN                   32      /* Shorter runs cost less as literal groups than with stored header */
+#define LZ_HASH(b)                      (((((uint32_t)(b)[0] << 8) ^ ((uint32_t)(b)[1] << 4) ^ (b)[2]) * 2654435761U) >> (32 - ESP_CFG_LZ_HASH_BITS))
+
+/* Decoder states */
+#define LZ_STATE_FLAGS                  0       /* Expecting group flag byte */
+#define LZ_STATE_TOKEN                  1       /* Expecting literal or first match byte */
+#define LZ_STATE_MATCH                  2       /* Expecting second match byte */
+#define LZ_STATE_STORED_LEN             3       /* Expecting stored block length */
+#define LZ_STATE_STORED                 4       /* Expecting stored block data */
+
+/**
+ * \brief           Output function for linear buffer
+ */
+static size_t
+lz_out_buff(esp_lz_enc_t* e, const void* data, size_t len) {
+    len = ESP_MIN(len, e->size - e->len);
+    if (len > 0) {
+        ESP_MEMCPY((uint8_t *)e->arg + e->len, data, len);
+    }
+    return len;
+}
+
+/**
+ * \brief           Output function for connection write buffer
+ */
+static size_t
+lz_out_conn(esp_lz_enc_t* e, const void* data, size_t len) {
+    return esp_conn_write(e->arg, data, len, 0, NULL) == espOK ? len : 0;
+}
+
+#if ESP_CFG_NETCONN
+
+/**
+ * \brief           Output function for netconn
+ */
+static size_t
+lz_out_netconn(esp_lz_enc_t* e, const void* data, size_t len) {
+    return esp_netconn_write(e->arg, data, len) == espOK ? len : 0;
+}
+
+#endif /* ESP_CFG_NETCONN */
+
+/**
+ * \brief           Send data to output
+ * \param[in]       e: LZ encoder
+ * \param[in]       data: Data to send
+ * \param[in]       len: Length of data
+ */
+static void
+lz_write(esp_lz_enc_t* e, const void* data, size_t len) {
+    size_t written;
+
+    if (!e->err) {
+        written = e->out(e, data, len);
+        e->len += written;
+        if (written < len) {
+            e->err = 1;
+        }
+    }
+}
+
+/**
+ * \brief           Send literals of literal-only groups to output
+ *
+ * Long runs are sent as stored block, short runs as literal groups,
+ * whichever is shorter
+ *
+ * \param[in]       e: LZ encoder
+ */
+static void
+lz_raw_out(esp_lz_enc_t* e) {
+    uint8_t hdr[4];
+
+    if (e->raw_len >= LZ_STORED_MIN) {
+        hdr[0] = 0x01;                          /* First token is match */
+        hdr[1] = 0x00;                          /* Distance 0 with stored block code */
+        hdr[2] = LZ_CODE_STORED;
+        hdr[3] = (uint8_t)(e->raw_len - 1);
+        lz_write(e, hdr, sizeof(hdr));
+        lz_write(e, e->raw, e->raw_len);
+    } else {
+        hdr[0] = 0x00;                          /* All tokens are literals */
+        for (uint16_t i = 0; i < e->raw_len; i += 8) {
+            lz_write(e, hdr, 1);
+            lz_write(e, &e->raw[i], 8);
+        }
+    }
+    e->raw_len = 0;
+}
+
+/**
+ * \brief           Send completed group to output
+ *
+ * Literal-only group is larger than its input,
+ * its literals are kept for stored block instead
+ *
+ * \param[in]       e: LZ encoder
+ */
+static void
+lz_group_out(esp_lz_enc_t* e) {
+    if (e->grp_cnt == 8 && e->grp[0] == 0) {
+        if (e->raw_len + 8 > ESP_LZ_STORED_MAX) {
+            lz_raw_out(e);
+        }
+        ESP_MEMCPY(&e->raw[e->raw_len], &e->grp[1], 8);
+        e->raw_len += 8;
+    } else {
+        lz_raw_out(e);                          /* Keep order of data */
+        lz_write(e, e->grp, e->grp_len);
+    }
+    e->grp_cnt = 0;
+    e->grp_len = 0;
+}
+
+/**
+ * \brief           Add literal or match token to current group
+ * \param[in]       e: LZ encoder
+ * \param[in]       dist: Match distance, `0` for literal or end of group marker
+ * \param[in]       len: Match length or literal value
+ * \param[in]       is_match: Set to `1` for match token
+ */
+static void
+lz_token(esp_lz_enc_t* e, uint16_t dist, uint16_t len, uint8_t is_match) {
+    uint16_t v;
+
+    if (e->grp_cnt == 0) {
+        e->grp[0] = 0;
+        e->grp_len = 1;
+    }
+    if (is_match) {
+        e->grp[0] |= 1 << e->grp_cnt;
+        v = (uint16_t)((dist << LZ_LEN_BITS) | (len - ESP_LZ_MIN_MATCH));
+        e->grp[e->grp_len++] = (uint8_t)(v >> 8);
+        e->grp[e->grp_len++] = (uint8_t)v;
+    } else {
+        e->grp[e->grp_len++] = (uint8_t)len;
+    }
+    if (++e->grp_cnt == 8) {
+        lz_group_out(e);
+    }
+}
+
+/**
+ * \brief           Insert buffer position to hash chain
+ * \param[in]       e: LZ encoder
+ * \param[in]       pos: Position with at least `3` bytes available
+ * \return          Previous position with same hash or `LZ_POS_NONE`
+ */
+static uint16_t
+lz_insert(esp_lz_enc_t* e, uint16_t pos) {
+    uint32_t h = LZ_HASH(&e->buf[pos]);
+    uint16_t cand = e->head[h];
+
+    e->prev[pos & (ESP_LZ_WINDOW_SIZE - 1)] = cand;
+    e->head[h] = pos;
+    return cand;
+}
+
+/**
+ * \brief           Encode single token at current position
+ * \param[in]       e: LZ encoder
+ */
+static void
+lz_encode_one(esp_lz_enc_t* e) {
+    uint16_t avail, cand, best_len = 0, best_dist = 0, len;
+    const uint8_t* cur = &e->buf[e->pos];
+
+    avail = ESP_MIN(ESP_LZ_MAX_MATCH, e->end - e->pos);
+    if (avail >= ESP_LZ_MIN_MATCH) {
+        cand = lz_insert(e, e->pos);
+        for (size_t chain = 0; cand != LZ_POS_NONE && cand < e->pos
+                && e->pos - cand < ESP_LZ_WINDOW_SIZE && chain < ESP_CFG_LZ_MAX_CHAIN; ++chain) {
+            if (e->buf[cand + best_len] == cur[best_len]) {
+                for (len = 0; len < avail && e->buf[cand + len] == cur[len]; ++len) {}
+                if (len > best_len) {
+                    best_len = len;
+                    best_dist = e->pos - cand;
+                    if (len == avail) {
+                        break;
+                    }
+                }
+            }
+            cand = e->prev[cand & (ESP_LZ_WINDOW_SIZE - 1)];
+        }
+    }
+    if (best_len >= ESP_LZ_MIN_MATCH) {
+        lz_token(e, best_dist, best_len, 1);
+        for (uint16_t i = 1; i < best_len; ++i) {  /* Keep skipped positions searchable */
+            if (e->end - (e->pos + i) >= ESP_LZ_MIN_MATCH) {
+                lz_insert(e, e->pos + i);
+            }
+        }
+        e->pos += best_len;
+    } else {
+        lz_token(e, 0, *cur, 0);
+        ++e->pos;
+    }
+}
+
+/**
+ * \brief           Drop oldest window half from buffer to make space for new input
+ * \param[in]       e: LZ encoder
+ */
+static void
+lz_slide(esp_lz_enc_t* e) {
+    ESP_MEMCPY(e->buf, &e->buf[ESP_LZ_WINDOW_SIZE], ESP_LZ_WINDOW_SIZE);  /* Halves do not overlap */
+    e->pos -= ESP_LZ_WINDOW_SIZE;
+    e->end -= ESP_LZ_WINDOW_SIZE;
+    for (size_t i = 0; i < ESP_ARRAYSIZE(e->head); ++i) {
+        e->head[i] = (e->head[i] == LZ_POS_NONE || e->head[i] < ESP_LZ_WINDOW_SIZE) ? LZ_POS_NONE : e->head[i] - ESP_LZ_WINDOW_SIZE;
+    }
+    for (size_t i = 0; i < ESP_ARRAYSIZE(e->prev); ++i) {
+        e->prev[i] = (e->prev[i] == LZ_POS_NONE || e->prev[i] < ESP_LZ_WINDOW_SIZE) ? LZ_POS_NONE : e->prev[i] - ESP_LZ_WINDOW_SIZE;
+    }
+}
+
+/**
+ * \brief           Initialize LZ encoder with custom output function
+ * \param[in]       e: LZ encoder
+ * \param[in]       out: Output function
+ * \param[in]       arg: Output function argument, available as `e->arg`
+ */
+void
+esp_lz_enc_init(esp_lz_enc_t* e, esp_lz_out_fn out, void* arg) {
+    ESP_MEMSET(e, 0x00, sizeof(*e));
+    ESP_MEMSET(e->head, 0xFF, sizeof(e->head));
+    ESP_MEMSET(e->prev, 0xFF, sizeof(e->prev));
+    e->out = out;
+    e->arg = arg;
+}
+
+/**
+ * \brief           Initialize LZ encoder to write to linear buffer
+ * \param[in]       e: LZ encoder
+ * \param[in]       buff: Output buffer
+ * \param[in]       size: Size of output buffer, see \ref ESP_LZ_MAX_COMPRESSED_LEN
+ */
+void
+esp_lz_enc_init_buff(esp_lz_enc_t* e, void* buff, size_t size) {
+    esp_lz_enc_init(e, lz_out_buff, buff);
+    e->size = size;
+}
+
+/**
+ * \brief           Initialize LZ encoder to write to connection write buffer
+ *
+ * Compressed data are written with \ref esp_conn_write.
+ * Call \ref esp_conn_write with `flush` set to `1` after \ref esp_lz_enc_flush
+ *
+ * \note            Function may only be used from connection callback function
+ * \param[in]       e: LZ encoder
+ * \param[in]       conn: Connection handle
+ */
+void
+esp_lz_enc_init_conn(esp_lz_enc_t* e, esp_conn_p conn) {
+    esp_lz_enc_init(e, lz_out_conn, conn);
+}
+
+#if ESP_CFG_NETCONN || __DOXYGEN__
+
+/**
+ * \brief           Initialize LZ encoder to write to netconn
+ *
+ * Compressed data are written with \ref esp_netconn_write.
+ * Call \ref esp_netconn_flush after \ref esp_lz_enc_flush
+ *
+ * \param[in]       e: LZ encoder
+ * \param[in]       nc: Netconn handle of TCP type
+ */
+void
+esp_lz_enc_init_netconn(esp_lz_enc_t* e, esp_netconn_p nc) {
+    esp_lz_enc_init(e, lz_out_netconn, nc);
+}
+
+#endif /* ESP_CFG_NETCONN || __DOXYGEN__ */
+
+/**
+ * \brief           Compress data
+ *
+ * Data are compressed once enough lookahead is available,
+ * last bytes may stay in encoder until more data arrive or \ref esp_lz_enc_flush is called
+ *
+ * \param[in]       e: LZ encoder
+ * \param[in]       data: Data to compress
+ * \param[in]       len: Length of data
+ * \return          \ref espOK on success, \ref espERRMEM when output did not accept all data
+ */
+espr_t
+esp_lz_enc_write(esp_lz_enc_t* e, const void* data, size_t len) {
+    const uint8_t* d = data;
+    size_t copy_len;
+
+    ESP_ASSERT("e != NULL", e != NULL);
+    ESP_ASSERT("data != NULL || len == 0", data != NULL || len == 0);
+
+    e->in_len += len;
+    while (len > 0 && !e->err) {
+        if (e->end == sizeof(e->buf)) {
+            lz_slide(e);
+        }
+        copy_len = ESP_MIN(len, sizeof(e->buf) - e->end);
+        ESP_MEMCPY(&e->buf[e->end], d, copy_len);
+        e->end += copy_len;
+        d += copy_len;
+        len -= copy_len;
+        while (e->end - e->pos >= ESP_LZ_MAX_MATCH) {
+            lz_encode_one(e);
+        }
+    }
+    return e->err ? espERRMEM : espOK;
+}
+
+/**
+ * \brief           Compress all pending data and end current group
+ *
+ * History is kept, further data can be written and compressed against it.
+ * Decoder outputs all data written before flush once it receives flushed stream
+ *
+ * \param[in]       e: LZ encoder
+ * \return          \ref espOK on success, \ref espERRMEM when output did not accept all data
+ */
+espr_t
+esp_lz_enc_flush(esp_lz_enc_t* e) {
+    ESP_ASSERT("e != NULL", e != NULL);
+
+    while (e->pos < e->end) {
+        lz_encode_one(e);
+    }
+    if (e->grp_cnt > 0) {
+        lz_token(e, 0, ESP_LZ_MIN_MATCH + LZ_CODE_END, 1);  /* End of group marker */
+        if (e->grp_cnt > 0) {
+            lz_group_out(e);
+        }
+    }
+    lz_raw_out(e);
+    return e->err ? espERRMEM : espOK;
+}
+
+/**
+ * \brief           Flush encoder and publish compressed buffer as MQTT message
+ *
+ * Encoder must be initialized with \ref esp_lz_enc_init_buff before every message,
+ * so that every message can be decompressed on its own
+ *
+ * \param[in]       client: MQTT client
+ * \param[in]       topic: Topic to publish to
+ * \param[in]       e: LZ encoder with compressed message
+ * \param[in]       qos: Quality of service. This parameter can be a value of \ref esp_mqtt_qos_t enumeration
+ * \param[in]       retain: Retain parameter value
+ * \param[in]       arg: User custom argument used in callback
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_lz_mqtt_publish(esp_mqtt_client_p client, const char* topic, esp_lz_enc_t* e,
+                    esp_mqtt_qos_t qos, uint8_t retain, void* arg) {
+    espr_t res;
+
+    ESP_ASSERT("e != NULL", e != NULL);
+    ESP_ASSERT("e->out == lz_out_buff", e->out == lz_out_buff);
+
+    if ((res = esp_lz_enc_flush(e)) != espOK) {
+        return res;
+    }
+    if (e->len > 0xFFFF) {
+        return espERRMEM;
+    }
+    return esp_mqtt_client_publish(client, topic, e->arg, (uint16_t)e->len, qos, retain, arg);
+}
+
+/**
+ * \brief           Report decompressed data from window to user
+ * \param[in]       d: LZ decoder
+ * \param[in]       end: Window position up to which data are reported
+ * \return          Result of user function
+ */
+static espr_t
+lz_dec_report(esp_lz_dec_t* d, size_t end) {
+    espr_t res = espOK;
+
+    if (end > d->flushed && d->fn != NULL) {
+        res = d->fn(d, &d->win[d->flushed], end - d->flushed);
+    }
+    d->flushed = (uint16_t)(end & (ESP_LZ_WINDOW_SIZE - 1));
+    return res;
+}
+
+/**
+ * \brief           Put decompressed byte to window
+ * \param[in]       d: LZ decoder
+ * \param[in]       b: Byte value
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+lz_dec_put(esp_lz_dec_t* d, uint8_t b) {
+    d->win[d->wpos] = b;
+    d->wpos = (d->wpos + 1) & (ESP_LZ_WINDOW_SIZE - 1);
+    ++d->len;
+    return d->wpos == 0 ? lz_dec_report(d, ESP_LZ_WINDOW_SIZE) : espOK;
+}
+
+/**
+ * \brief           Move to next token in group
+ * \param[in]       d: LZ decoder
+ */
+static void
+lz_dec_next(esp_lz_dec_t* d) {
+    d->flags >>= 1;
+    d->state = --d->cnt > 0 ? LZ_STATE_TOKEN : LZ_STATE_FLAGS;
+}
+
+/**
+ * \brief           Initialize LZ decoder
+ * \param[in]       d: LZ decoder
+ * \param[in]       fn: Output function for decompressed data
+ * \param[in]       arg: User argument, available as `d->arg`
+ */
+void
+esp_lz_dec_init(esp_lz_dec_t* d, esp_lz_dec_fn fn, void* arg) {
+    ESP_MEMSET(d, 0x00, sizeof(*d));
+    d->fn = fn;
+    d->arg = arg;
+    d->res = espOK;
+    d->state = LZ_STATE_FLAGS;
+}
+
+/**
+ * \brief           Decompress next piece of compressed stream
+ *
+ * Decompressed data are reported to output function before function returns
+ *
+ * \param[in]       d: LZ decoder
+ * \param[in]       data: Compressed data
+ * \param[in]       len: Length of data
+ * \return          \ref espOK on success, \ref espERR on corrupted stream,
+ *                      or value returned by output function.
+ *                      Once decoder stops, further calls return the same value
+ */
+espr_t
+esp_lz_dec_feed(esp_lz_dec_t* d, const void* data, size_t len) {
+    const uint8_t* p = data;
+    uint16_t v, dist, mlen;
+
+    ESP_ASSERT("d != NULL", d != NULL);
+    ESP_ASSERT("data != NULL || len == 0", data != NULL || len == 0);
+
+    for (; len > 0 && d->res == espOK; --len, ++p) {
+        switch (d->state) {
+            case LZ_STATE_FLAGS:
+                d->flags = *p;
+                d->cnt = 8;
+                d->state = LZ_STATE_TOKEN;
+                break;
+            case LZ_STATE_TOKEN:
+                if (d->flags & 0x01) {
+                    d->b0 = *p;
+                    d->state = LZ_STATE_MATCH;
+                } else {
+                    d->res = lz_dec_put(d, *p);
+                    lz_dec_next(d);
+                }
+                break;
+            case LZ_STATE_MATCH:
+                v = (uint16_t)((d->b0 << 8) | *p);
+                dist = v >> LZ_LEN_BITS;
+                mlen = (v & ((1 << LZ_LEN_BITS) - 1)) + ESP_LZ_MIN_MATCH;
+                if (dist == 0) {
+                    if (mlen == ESP_LZ_MIN_MATCH + LZ_CODE_END) {
+                        d->state = LZ_STATE_FLAGS;
+                    } else if (mlen == ESP_LZ_MIN_MATCH + LZ_CODE_STORED) {
+                        d->state = LZ_STATE_STORED_LEN;
+                    } else {
+                        d->res = espERR;
+                    }
+                    break;
+                }
+                if (dist > d->len) {
+                    d->res = espERR;
+                    break;
+                }
+                for (; mlen > 0 && d->res == espOK; --mlen) {
+                    d->res = lz_dec_put(d, d->win[(d->wpos - dist) & (ESP_LZ_WINDOW_SIZE - 1)]);
+                }
+                lz_dec_next(d);
+                break;
+            case LZ_STATE_STORED_LEN:
+                d->raw = (uint16_t)*p + 1;
+                d->state = LZ_STATE_STORED;
+                break;
+            case LZ_STATE_STORED:
+                d->res = lz_dec_put(d, *p);
+                if (--d->raw == 0) {            /* Stored block ends group */
+                    d->state = LZ_STATE_FLAGS;
+                }
+                break;
+            default:
+                d->res = espERR;
+                break;
+        }
+    }
+    if (d->res == espOK) {
+        d->res = lz_dec_report(d, d->wpos);
+    }
+    return d->res;
+}
+
+/**
+ * \brief           Decompress all pbufs in chain, segment by segment
+ * \param[in]       d: LZ decoder
+ * \param[in]       pbuf: Pbuf chain, such as one received on connection
+ * \return          Same as \ref esp_lz_dec_feed
+ */
+espr_t
+esp_lz_dec_feed_pbuf(esp_lz_dec_t* d, const esp_pbuf_p pbuf) {
+    const void* data;
+    size_t off = 0, len;
+
+    ESP_ASSERT("d != NULL", d != NULL);
+    ESP_ASSERT("pbuf != NULL", pbuf != NULL);
+
+    while ((data = esp_pbuf_get_linear_addr(pbuf, off, &len)) != NULL && len > 0) {
+        if (esp_lz_dec_feed(d, data, len) != espOK) {
+            break;
+        }
+        off += len;
+    }
+    return d->res;
+}
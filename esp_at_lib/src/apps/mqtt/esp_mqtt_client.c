@@ -56,7 +56,8 @@ typedef struct esp_mqtt_client {
 
     uint16_t last_packet_id;                    /*!< Packet ID used on last packet */
 
-    esp_mqtt_request_t requests[ESP_CFG_MQTT_MAX_REQUESTS]; /*!< List of requests */
+    esp_mqtt_request_t* requests;               /*!< List of requests */
+    size_t requests_len;                        /*!< Number of entries in requests list */
 
     uint8_t* rx_buff;                           /*!< Raw RX buffer */
     size_t rx_buff_len;                         /*!< Length of raw RX buffer */
@@ -67,6 +68,13 @@ typedef struct esp_mqtt_client {
     uint8_t msg_rem_len_mult;                   /*!< Multiplier for remaining length */
     uint32_t msg_curr_pos;                      /*!< Current buffer write pointer */
 
+#if ESP_CFG_MQTT_METRICS || __DOXYGEN__
+    esp_mqtt_client_metrics_t metrics;          /*!< Runtime metrics */
+    uint32_t ping_time;                         /*!< Time when last PINGREQ was written */
+    uint8_t ping_pending;                       /*!< Set to `1` when PINGRESP is expected */
+    esp_mqtt_disconnect_reason_t close_reason;  /*!< Reason of connection close initiated by client */
+#endif /* ESP_CFG_MQTT_METRICS || __DOXYGEN__ */
+
     void* arg;                                  /*!< User argument */
 } esp_mqtt_client_t;
 
@@ -160,6 +168,60 @@ create_packet_id(esp_mqtt_client_p client) {
     return client->last_packet_id;
 }
 
+#if ESP_CFG_MQTT_METRICS || __DOXYGEN__
+
+/******************************************************************************************************/
+/******************************************************************************************************/
+/* MQTT metrics helper functions                                                                      */
+/******************************************************************************************************/
+/******************************************************************************************************/
+
+/**
+ * \brief           Add sample to latency histogram
+ * \param[in]       h: Histogram to update
+ * \param[in]       start: Start time of measured operation in units of milliseconds
+ */
+static void
+metrics_hist_add(esp_mqtt_hist_t* h, uint32_t start) {
+    uint32_t ms = esp_sys_now() - start;
+    size_t i;
+
+    for (i = 0; i < ESP_MQTT_METRICS_HIST_LEN - 1 && ms >= ((uint32_t)ESP_CFG_MQTT_METRICS_HIST_BASE << i); ++i) {}
+    ++h->buckets[i];
+    ++h->count;
+    h->sum += ms;
+    if (ms > h->max) {
+        h->max = ms;
+    }
+}
+
+/**
+ * \brief           Add packet to packet counter
+ * \param[in]       c: Array of counters indexed by packet type
+ * \param[in]       hdr: First byte of packet
+ * \param[in]       len: Total packet length including fixed header
+ */
+static void
+metrics_pkt_add(esp_mqtt_pkt_count_t* c, uint8_t hdr, uint32_t len) {
+    c = &c[(hdr >> 0x04) & 0x0F];
+    ++c->packets;
+    c->bytes += len;
+}
+
+/**
+ * \brief           Set reason for connection close initiated by client
+ * \param[in]       client: MQTT client
+ * \param[in]       reason: Disconnect reason
+ */
+static void
+metrics_set_close_reason(esp_mqtt_client_p client, esp_mqtt_disconnect_reason_t reason) {
+    if (client->close_reason == ESP_MQTT_DISCONNECT_REASON_END) {   /* Keep first reason */
+        client->close_reason = reason;
+    }
+}
+
+#endif /* ESP_CFG_MQTT_METRICS || __DOXYGEN__ */
+
 /******************************************************************************************************/
 /******************************************************************************************************/
 /* MQTT requests helper function                                                                      */
@@ -179,7 +241,7 @@ request_create(esp_mqtt_client_p client, uint16_t packet_id, void* arg) {
     uint16_t i;
 
     /* Try to find a new request which does not have IN_USE flag set */
-    for (request = NULL, i = 0; i < ESP_CFG_MQTT_MAX_REQUESTS; ++i) {
+    for (request = NULL, i = 0; i < client->requests_len; ++i) {
         if (!(client->requests[i].status & MQTT_REQUEST_FLAG_IN_USE)) {
             request = &client->requests[i];     /* We have empty request */
             break;
@@ -189,6 +251,13 @@ request_create(esp_mqtt_client_p client, uint16_t packet_id, void* arg) {
         request->packet_id = packet_id;         /* Set request packet ID */
         request->arg = arg;                     /* Set user argument */
         request->status = MQTT_REQUEST_FLAG_IN_USE; /* Reset everything at this point */
+#if ESP_CFG_MQTT_METRICS
+        if (++client->metrics.requests_in_use > client->metrics.requests_max) {
+            client->metrics.requests_max = client->metrics.requests_in_use;
+        }
+    } else {
+        ++client->metrics.requests_full;
+#endif /* ESP_CFG_MQTT_METRICS */
     }
     return request;
 }
@@ -201,6 +270,9 @@ request_create(esp_mqtt_client_p client, uint16_t packet_id, void* arg) {
 static void
 request_delete(esp_mqtt_client_p client, esp_mqtt_request_t* request) {
     request->status = 0;                        /* Reset status to make request unused */
+#if ESP_CFG_MQTT_METRICS
+    --client->metrics.requests_in_use;
+#endif /* ESP_CFG_MQTT_METRICS */
     ESP_UNUSED(client);
 }
 
@@ -225,7 +297,7 @@ request_set_pending(esp_mqtt_client_p client, esp_mqtt_request_t* request) {
 static esp_mqtt_request_t *
 request_get_pending(esp_mqtt_client_p client, int32_t pkt_id) {
     /* Try to find a new request which does not have IN_USE flag set */
-    for (size_t i = 0; i < ESP_CFG_MQTT_MAX_REQUESTS; ++i) {
+    for (size_t i = 0; i < client->requests_len; ++i) {
         if ((client->requests[i].status & MQTT_REQUEST_FLAG_PENDING)
             && (pkt_id == -1 || client->requests[i].packet_id == (uint16_t)pkt_id)) {
             return &client->requests[i];
@@ -281,6 +353,9 @@ write_fixed_header(esp_mqtt_client_p client, mqtt_msg_type_t type, uint8_t dup,
 
     b = ESP_U8(((ESP_U8(type)) << 0x04) | (ESP_U8(!!dup) << 0x03) | ((ESP_U8(qos) & 0x03) << 0x01) | ESP_U8(!!retain));
     esp_buff_write(&client->tx_buff, &b, 1);    /* Write start of packet parameters */
+#if ESP_CFG_MQTT_METRICS
+    metrics_pkt_add(client->metrics.tx, b, 2 + rem_len + (rem_len > 0x7F) + (rem_len > 0x3FFF));
+#endif /* ESP_CFG_MQTT_METRICS */
 
     ESP_DEBUGF(ESP_CFG_DBG_MQTT_TRACE,
         "[MQTT] Writing packet type %s to output buffer\r\n", mqtt_msg_type_to_str(type));
@@ -347,7 +422,13 @@ output_check_enough_memory(esp_mqtt_client_p client, uint16_t rem_len) {
         rem_len >>= 7;                          /* Encoded with 7 bits per byte */
     } while (rem_len > 0);
 
-    return ESP_U16(esp_buff_get_free(&client->tx_buff)) >= total_len ? total_len : 0;
+    if (ESP_U16(esp_buff_get_free(&client->tx_buff)) < total_len) {
+#if ESP_CFG_MQTT_METRICS
+        ++client->metrics.tx_buff_full;
+#endif /* ESP_CFG_MQTT_METRICS */
+        return 0;
+    }
+    return total_len;
 }
 
 /**
@@ -395,6 +476,13 @@ send_data(esp_mqtt_client_p client) {
     size_t len;
     const void* addr;
 
+#if ESP_CFG_MQTT_METRICS
+    len = esp_buff_get_full(&client->tx_buff);  /* Track output buffer usage, packets were just written */
+    if (len > client->metrics.tx_buff_max) {
+        client->metrics.tx_buff_max = (uint32_t)len;
+    }
+#endif /* ESP_CFG_MQTT_METRICS */
+
     if (client->is_sending) {                   /* We are currently sending data */
         return;
     }
@@ -505,6 +593,9 @@ mqtt_process_incoming_message(esp_mqtt_client_p client) {
     uint16_t pkt_id;
 
     msg_type = MQTT_RCV_GET_PACKET_TYPE(client->msg_hdr_byte);  /* Get packet type from message header byte */
+#if ESP_CFG_MQTT_METRICS
+    metrics_pkt_add(client->metrics.rx, client->msg_hdr_byte, 1 + client->msg_rem_len_mult + client->msg_rem_len);
+#endif /* ESP_CFG_MQTT_METRICS */
 
     /* Debug message */
     ESP_DEBUGF(ESP_CFG_DBG_MQTT_STATE,
@@ -517,6 +608,13 @@ mqtt_process_incoming_message(esp_mqtt_client_p client) {
             if (client->conn_state == ESP_MQTT_CONNECTING) {
                 if (err == ESP_MQTT_CONN_STATUS_ACCEPTED) {
                     client->conn_state = ESP_MQTT_CONNECTED;
+#if ESP_CFG_MQTT_METRICS
+                    if (client->metrics.connects++ > 0) {
+                        ++client->metrics.reconnects;
+                    }
+                } else {
+                    metrics_set_close_reason(client, ESP_MQTT_DISCONNECT_REASON_REFUSED);
+#endif /* ESP_CFG_MQTT_METRICS */
                 }
                 ESP_DEBUGF(ESP_CFG_DBG_MQTT_TRACE,
                     "[MQTT] CONNACK received with result: %d\r\n", (int)err);
@@ -585,6 +683,12 @@ mqtt_process_incoming_message(esp_mqtt_client_p client) {
         }
         case MQTT_MSG_TYPE_PINGRESP: {          /* Respond to PINGREQ received */
             ESP_DEBUGF(ESP_CFG_DBG_MQTT_TRACE, "[MQTT] Ping response received\r\n");
+#if ESP_CFG_MQTT_METRICS
+            if (client->ping_pending) {
+                client->ping_pending = 0;
+                metrics_hist_add(&client->metrics.keep_alive_rtt, client->ping_time);
+            }
+#endif /* ESP_CFG_MQTT_METRICS */
 
             client->evt.type = ESP_MQTT_EVT_KEEP_ALIVE;
             client->evt_fn(client, &client->evt);
@@ -630,6 +734,9 @@ mqtt_process_incoming_message(esp_mqtt_client_p client) {
                      */
                     } else if (msg_type == MQTT_MSG_TYPE_PUBCOMP
                             || msg_type == MQTT_MSG_TYPE_PUBACK) {
+#if ESP_CFG_MQTT_METRICS
+                        metrics_hist_add(&client->metrics.pub_ack[msg_type == MQTT_MSG_TYPE_PUBACK ? 1 : 2], request->timeout_start_time);
+#endif /* ESP_CFG_MQTT_METRICS */
                         client->evt.type = ESP_MQTT_EVT_PUBLISH;
                         client->evt.evt.publish.arg = request->arg;
                         client->evt.evt.publish.res = espOK;
@@ -741,6 +848,9 @@ mqtt_parse_incoming(esp_mqtt_client_p client, esp_pbuf_p pbuf) {
                         } else {
                             ESP_DEBUGF(ESP_CFG_DBG_MQTT_TRACE_WARNING,
                                 "[MQTT] Packet too big for rx buffer. Packet discarded\r\n");
+#if ESP_CFG_MQTT_METRICS
+                            ++client->metrics.rx_dropped;
+#endif /* ESP_CFG_MQTT_METRICS */
                         }
                         client->parser_state = MQTT_PARSER_STATE_INIT;  /* Go to initial state and listen for next received packet */
                     }
@@ -876,6 +986,9 @@ mqtt_data_sent_cb(esp_mqtt_client_p client, size_t sent_len, uint8_t successful)
         ESP_DEBUGF(ESP_CFG_DBG_MQTT_TRACE_WARNING,
                     "[MQTT] Failed to send %d bytes. Manually closing down..\r\n", (int)sent_len);
 
+#if ESP_CFG_MQTT_METRICS
+        metrics_set_close_reason(client, ESP_MQTT_DISCONNECT_REASON_SEND_FAILED);
+#endif /* ESP_CFG_MQTT_METRICS */
         mqtt_close(client);
         return 0;
     }
@@ -891,6 +1004,9 @@ mqtt_data_sent_cb(esp_mqtt_client_p client, size_t sent_len, uint8_t successful)
         if (client->sent_total >= request->expected_sent_len) {
             void* arg = request->arg;
 
+#if ESP_CFG_MQTT_METRICS
+            metrics_hist_add(&client->metrics.pub_ack[0], request->timeout_start_time);
+#endif /* ESP_CFG_MQTT_METRICS */
             request_delete(client, request);    /* Delete request and make space for next command */
 
             /* Call published callback */
@@ -935,6 +1051,12 @@ mqtt_poll_cb(esp_mqtt_client_p client) {
             write_fixed_header(client, MQTT_MSG_TYPE_PINGREQ, 0, (esp_mqtt_qos_t)0, 0, 0);  /* Write PINGREQ command to output buffer */
             send_data(client);                  /* Force send data */
             client->poll_time = 0;              /* Reset polling time */
+#if ESP_CFG_MQTT_METRICS
+            if (!client->ping_pending) {        /* Measure from first unanswered request */
+                client->ping_pending = 1;
+                client->ping_time = esp_sys_now();
+            }
+#endif /* ESP_CFG_MQTT_METRICS */
 
             ESP_DEBUGF(ESP_CFG_DBG_MQTT_TRACE, "[MQTT] Sending PINGREQ packet\r\n");
         } else {
@@ -966,6 +1088,14 @@ mqtt_closed_cb(esp_mqtt_client_p client, espr_t res, uint8_t forced) {
      * when we are connected or in disconnecting mode
      */
     client->conn_state = ESP_MQTT_CONN_DISCONNECTED;/* Connection is disconnected, ready to be established again */
+#if ESP_CFG_MQTT_METRICS
+    if (client->close_reason == ESP_MQTT_DISCONNECT_REASON_END) {
+        client->close_reason = forced ? ESP_MQTT_DISCONNECT_REASON_USER : ESP_MQTT_DISCONNECT_REASON_REMOTE;
+    }
+    ++client->metrics.disconnects[client->close_reason];
+    client->close_reason = ESP_MQTT_DISCONNECT_REASON_END;
+    client->ping_pending = 0;
+#endif /* ESP_CFG_MQTT_METRICS */
     client->evt.evt.disconnect.is_accepted = state == ESP_MQTT_CONNECTED || state == ESP_MQTT_CONN_DISCONNECTING;   /* Set connection state */
     client->evt.type = ESP_MQTT_EVT_DISCONNECT; /* Connection disconnected from server */
     client->evt_fn(client, &client->evt);       /* Notify upper layer about closed connection */
@@ -979,7 +1109,10 @@ mqtt_closed_cb(esp_mqtt_client_p client, espr_t res, uint8_t forced) {
         request_delete(client, request);        /* Delete request */
         request_send_err_callback(client, status, arg); /* Send error callback to user */
     }
-    ESP_MEMSET(client->requests, 0x00, sizeof(client->requests));
+    ESP_MEMSET(client->requests, 0x00, sizeof(*client->requests) * client->requests_len);
+#if ESP_CFG_MQTT_METRICS
+    client->metrics.requests_in_use = 0;
+#endif /* ESP_CFG_MQTT_METRICS */
 
     client->is_sending = client->sent_total = client->written_total = 0;
     client->parser_state = MQTT_PARSER_STATE_INIT;
@@ -1022,6 +1155,9 @@ mqtt_conn_cb(esp_evt_t* evt) {
             client = esp_evt_conn_error_get_arg(evt);   /* Get connection argument */
             if (client != NULL) {
                 client->conn_state = ESP_MQTT_CONN_DISCONNECTED;/* Set back to disconnected state */
+#if ESP_CFG_MQTT_METRICS
+                ++client->metrics.disconnects[ESP_MQTT_DISCONNECT_REASON_TCP_FAILED];
+#endif /* ESP_CFG_MQTT_METRICS */
                 /* Notify user upper layer */
                 client->evt.type = ESP_MQTT_EVT_CONNECT;
                 client->evt.evt.connect.status = ESP_MQTT_CONN_STATUS_TCP_FAILED;   /* TCP connection failed */
@@ -1079,13 +1215,27 @@ mqtt_conn_cb(esp_evt_t* evt) {
 esp_mqtt_client_t *
 esp_mqtt_client_new(size_t tx_buff_len, size_t rx_buff_len) {
     esp_mqtt_client_p client;
+    esp_runtime_cfg_t cfg;
 
+    esp_runtime_cfg_get(&cfg);                  /* Get number of requests to allocate */
     client = esp_mem_malloc(sizeof(*client));
     if (client != NULL) {
         ESP_MEMSET(client, 0x00, sizeof(*client));
         client->conn_state = ESP_MQTT_CONN_DISCONNECTED;/* Set to disconnected mode */
+#if ESP_CFG_MQTT_METRICS
+        client->metrics.tx_buff_size = (uint32_t)tx_buff_len;
+        client->close_reason = ESP_MQTT_DISCONNECT_REASON_END;
+#endif /* ESP_CFG_MQTT_METRICS */
+
+        client->requests_len = cfg.mqtt_max_requests > 0 ? cfg.mqtt_max_requests : ESP_CFG_MQTT_MAX_REQUESTS;
+        client->requests = esp_mem_calloc(client->requests_len, sizeof(*client->requests));
+        if (client->requests == NULL) {
+            esp_mem_free_s((void **)&client);
+            return NULL;
+        }
 
         if (!esp_buff_init(&client->tx_buff, tx_buff_len)) {
+            esp_mem_free_s((void **)&client->requests);
             esp_mem_free_s((void **)&client);
         }
         if (client != NULL) {
@@ -1093,6 +1243,7 @@ esp_mqtt_client_new(size_t tx_buff_len, size_t rx_buff_len) {
             client->rx_buff = esp_mem_malloc(rx_buff_len);
             if (client->rx_buff == NULL) {
                 esp_buff_free(&client->tx_buff);
+                esp_mem_free_s((void **)&client->requests);
                 esp_mem_free_s((void **)&client);
             }
         }
@@ -1110,6 +1261,7 @@ esp_mqtt_client_delete(esp_mqtt_client_p client) {
     if (client != NULL) {
         esp_mem_free_s((void **)&client->rx_buff);
         esp_buff_free(&client->tx_buff);
+        esp_mem_free_s((void **)&client->requests);
         esp_mem_free_s((void **)&client);
     }
 }
@@ -1163,6 +1315,11 @@ esp_mqtt_client_disconnect(esp_mqtt_client_p client) {
     if (client->conn_state != ESP_MQTT_CONN_DISCONNECTED
         && client->conn_state != ESP_MQTT_CONN_DISCONNECTING) {
         res = mqtt_close(client);               /* Close client connection */
+#if ESP_CFG_MQTT_METRICS
+        if (res == espOK) {
+            metrics_set_close_reason(client, ESP_MQTT_DISCONNECT_REASON_USER);
+        }
+#endif /* ESP_CFG_MQTT_METRICS */
     }
     esp_core_unlock();
     return res;
@@ -1307,3 +1464,48 @@ void *
 esp_mqtt_client_get_arg(esp_mqtt_client_p client) {
     return client->arg;
 }
+
+#if ESP_CFG_MQTT_METRICS || __DOXYGEN__
+
+/**
+ * \brief           Get copy of client runtime metrics
+ * \param[in]       client: MQTT client
+ * \param[out]      metrics: Pointer to output structure
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_mqtt_client_get_metrics(esp_mqtt_client_p client, esp_mqtt_client_metrics_t* metrics) {
+    ESP_ASSERT("client != NULL", client != NULL);
+    ESP_ASSERT("metrics != NULL", metrics != NULL);
+
+    esp_core_lock();
+    ESP_MEMCPY(metrics, &client->metrics, sizeof(*metrics));
+    esp_core_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Reset client runtime metrics
+ * \note            Number of used request slots and output buffer size are preserved
+ * \param[in]       client: MQTT client
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_mqtt_client_reset_metrics(esp_mqtt_client_p client) {
+    uint32_t in_use, tx_buff_size;
+
+    ESP_ASSERT("client != NULL", client != NULL);
+
+    esp_core_lock();
+    in_use = client->metrics.requests_in_use;
+    tx_buff_size = client->metrics.tx_buff_size;
+    ESP_MEMSET(&client->metrics, 0x00, sizeof(client->metrics));
+    client->metrics.requests_in_use = in_use;
+    client->metrics.requests_max = in_use;
+    client->metrics.tx_buff_size = tx_buff_size;
+    client->ping_pending = 0;
+    esp_core_unlock();
+    return espOK;
+}
+
+#endif /* ESP_CFG_MQTT_METRICS || __DOXYGEN__ */
@@ -521,3 +521,21 @@ void
 esp_mqtt_client_api_buf_free(esp_mqtt_client_api_buf_p p) {
     esp_mem_free_s((void **)&p);
 }
+
+#if ESP_CFG_MQTT_METRICS || __DOXYGEN__
+
+/**
+ * \brief           Get copy of runtime metrics of underlying MQTT client
+ * \param[in]       client: MQTT API client handle
+ * \param[out]      metrics: Pointer to output structure
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ * \sa              esp_mqtt_client_get_metrics
+ */
+espr_t
+esp_mqtt_client_api_get_metrics(esp_mqtt_client_api_p client, esp_mqtt_client_metrics_t* metrics) {
+    ESP_ASSERT("client != NULL", client != NULL);
+
+    return esp_mqtt_client_get_metrics(client->mc, metrics);
+}
+
+#endif /* ESP_CFG_MQTT_METRICS || __DOXYGEN__ */
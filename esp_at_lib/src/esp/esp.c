@@ -61,6 +61,131 @@ def_callback(esp_evt_t* evt) {
     return espOK;
 }
 
+/**
+ * \brief           Limit runtime configuration value
+ * \param[in]       val: Requested value. Set to `0` to use default value
+ * \param[in]       min: Minimal allowed value
+ * \param[in]       max: Compile-time value, used as default and upper bound
+ * \return          Value to use
+ */
+static size_t
+runtime_cfg_limit(size_t val, size_t min, size_t max) {
+    if (val == 0 || val > max) {
+        return max;
+    }
+    return val < min ? min : val;
+}
+
+/**
+ * \brief           Apply runtime configuration to global structure
+ * \param[in]       cfg: Configuration to apply. Fields set to `0` are set to default value
+ * \param[in]       init: Set to `1` to also apply values, which may only be changed before \ref esp_init
+ */
+static void
+runtime_cfg_apply(const esp_runtime_cfg_t* cfg, uint8_t init) {
+    if (init) {
+        esp.cfg.rcv_buff_size = runtime_cfg_limit(cfg->rcv_buff_size, 16, ESP_CFG_RCV_BUFF_SIZE);
+        esp.cfg.producer_mbox_size = runtime_cfg_limit(cfg->producer_mbox_size, 1, ESP_CFG_THREAD_PRODUCER_MBOX_SIZE);
+        esp.cfg.process_mbox_size = runtime_cfg_limit(cfg->process_mbox_size, 1, ESP_CFG_THREAD_PROCESS_MBOX_SIZE);
+    }
+    esp.cfg.conn_max_data_len = runtime_cfg_limit(cfg->conn_max_data_len, 1, ESP_CFG_CONN_MAX_DATA_LEN);
+    esp.cfg.conn_max_recv_buff_size = runtime_cfg_limit(cfg->conn_max_recv_buff_size, 1, ESP_CFG_CONN_MAX_RECV_BUFF_SIZE);
+    esp.cfg.netconn_receive_queue_len = runtime_cfg_limit(cfg->netconn_receive_queue_len, 2, ESP_CFG_NETCONN_RECEIVE_QUEUE_LEN);
+    esp.cfg.mqtt_max_requests = runtime_cfg_limit(cfg->mqtt_max_requests, 1, ESP_CFG_MQTT_MAX_REQUESTS);
+}
+
+/**
+ * \brief           Set buffer and queue sizes to be used by \ref esp_init
+ * \note            Function must be called before \ref esp_init.
+ *                  Use \ref esp_runtime_cfg_tune to change values afterwards
+ * \param[in]       cfg: Configuration to use. Fields set to `0` use compile-time default value,
+ *                      values above compile-time value are limited to it
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_runtime_cfg_set(const esp_runtime_cfg_t* cfg) {
+    ESP_ASSERT("cfg != NULL", cfg != NULL);
+
+    if (esp.status.f.initialized) {
+        return espERR;
+    }
+    runtime_cfg_apply(cfg, 1);
+    return espOK;
+}
+
+/**
+ * \brief           Change buffer and queue sizes while stack is running
+ *
+ * Only values which do not affect already allocated resources may be changed.
+ * Queue and buffer sizes of threads are fixed after \ref esp_init and must be `0`
+ * or equal to currently used value.
+ *
+ * \param[in]       cfg: New configuration. Fields set to `0` keep current value,
+ *                      values above compile-time value are limited to it
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_runtime_cfg_tune(const esp_runtime_cfg_t* cfg) {
+    esp_runtime_cfg_t c;
+
+    ESP_ASSERT("cfg != NULL", cfg != NULL);
+    ESP_ASSERT("esp_init must be called first", esp.status.f.initialized);
+
+    esp_core_lock();
+    if ((cfg->rcv_buff_size > 0 && cfg->rcv_buff_size != esp.cfg.rcv_buff_size)
+        || (cfg->producer_mbox_size > 0 && cfg->producer_mbox_size != esp.cfg.producer_mbox_size)
+        || (cfg->process_mbox_size > 0 && cfg->process_mbox_size != esp.cfg.process_mbox_size)) {
+        esp_core_unlock();
+        return espPARERR;
+    }
+    c = esp.cfg;                                /* Keep current values for fields set to 0 */
+    if (cfg->conn_max_data_len > 0) {
+        c.conn_max_data_len = cfg->conn_max_data_len;
+    }
+    if (cfg->conn_max_recv_buff_size > 0) {
+        c.conn_max_recv_buff_size = cfg->conn_max_recv_buff_size;
+    }
+    if (cfg->netconn_receive_queue_len > 0) {
+        c.netconn_receive_queue_len = cfg->netconn_receive_queue_len;
+    }
+    if (cfg->mqtt_max_requests > 0) {
+        c.mqtt_max_requests = cfg->mqtt_max_requests;
+    }
+    runtime_cfg_apply(&c, 0);
+    esp_core_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Get currently used buffer and queue sizes
+ * \note            Before \ref esp_init is called, values set with \ref esp_runtime_cfg_set are returned,
+ *                  or `0` when not set
+ * \param[out]      cfg: Pointer to output structure
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_runtime_cfg_get(esp_runtime_cfg_t* cfg) {
+    ESP_ASSERT("cfg != NULL", cfg != NULL);
+
+    if (esp.status.f.initialized) {
+        esp_core_lock();
+        *cfg = esp.cfg;
+        esp_core_unlock();
+    } else {
+        *cfg = esp.cfg;
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Get maximal number of bytes sent to device with single send command
+ * \return          Current runtime value, limited by \ref ESP_CFG_CONN_MAX_DATA_LEN
+ */
+size_t
+esp_get_conn_max_data_len(void) {
+    return esp.cfg.conn_max_data_len > 0 ? esp.cfg.conn_max_data_len : ESP_CFG_CONN_MAX_DATA_LEN;
+}
+
 /**
  * \brief           Init and prepare ESP stack for device operation
  * \note            Function must be called from operating system thread context. 
@@ -69,6 +194,9 @@ def_callback(esp_evt_t* evt) {
  *                      otherwise manual call to \ref esp_reset is required to setup device
  *                  - When \ref ESP_CFG_RESTORE_ON_INIT is enabled, restore sequence will be sent to device.
  *
+ *                  - Buffer and queue sizes are taken from \ref esp_runtime_cfg_set when called before,
+ *                      otherwise compile-time values are used
+ *
  * \param[in]       evt_func: Global event callback function for all major events
  * \param[in]       blocking: Status whether command should be blocking or not.
  *                      Used when \ref ESP_CFG_RESET_ON_INIT or \ref ESP_CFG_RESTORE_ON_INIT are enabled.
@@ -85,6 +213,9 @@ esp_init(esp_evt_fn evt_func, const uint32_t blocking) {
 
     esp.evt_server = NULL;                      /* Set default server callback function */
 
+    runtime_cfg_apply(&esp.cfg, 1);             /* Fill unset buffer and queue sizes with defaults */
+    esp.ipd_info_policy = (esp_ipd_info_t)ESP_CFG_IPD_INFO_POLICY;
+
     if (!esp_sys_init()) {                      /* Init low-level system */
         goto cleanup;
     }
@@ -96,12 +227,12 @@ esp_init(esp_evt_fn evt_func, const uint32_t blocking) {
     }
 
     /* Create message queues */
-    if (!esp_sys_mbox_create(&esp.mbox_producer, ESP_CFG_THREAD_PRODUCER_MBOX_SIZE)) {  /* Producer */
+    if (!esp_sys_mbox_create(&esp.mbox_producer, esp.cfg.producer_mbox_size)) {  /* Producer */
         ESP_DEBUGF(ESP_CFG_DBG_INIT | ESP_DBG_LVL_SEVERE | ESP_DBG_TYPE_TRACE,
             "[CORE] Cannot allocate producer mbox queue!\r\n");
         goto cleanup;
     }
-    if (!esp_sys_mbox_create(&esp.mbox_process, ESP_CFG_THREAD_PROCESS_MBOX_SIZE)) {  /* Process */
+    if (!esp_sys_mbox_create(&esp.mbox_process, esp.cfg.process_mbox_size)) {  /* Process */
         ESP_DEBUGF(ESP_CFG_DBG_INIT | ESP_DBG_LVL_SEVERE | ESP_DBG_TYPE_TRACE,
             "[CORE] Cannot allocate process mbox queue!\r\n");
         goto cleanup;
@@ -131,7 +262,7 @@ esp_init(esp_evt_fn evt_func, const uint32_t blocking) {
     esp_ll_init(&esp.ll);                       /* Init low-level communication */
 
 #if !ESP_CFG_INPUT_USE_PROCESS
-    esp_buff_init(&esp.buff, ESP_CFG_RCV_BUFF_SIZE);    /* Init buffer for input data */
+    esp_buff_init(&esp.buff, esp.cfg.rcv_buff_size);   /* Init buffer for input data */
 #endif /* !ESP_CFG_INPUT_USE_PROCESS */
 
     esp.status.f.initialized = 1;               /* We are initialized now */
@@ -0,0 +1,442 @@
+/**
+ * \file            esp_capture.c
+ * \brief           AT link capture tap
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include "esp/esp_private.h"
+#include "esp/esp_capture.h"
+#include "esp/esp_buff.h"
+#include "esp/esp_mem.h"
+
+#if ESP_CFG_CAPTURE || __DOXYGEN__
+
+/* pcapng block types and options */
+#define PCAPNG_BT_SHB               0x0A0D0D0AUL
+#define PCAPNG_BT_IDB               0x00000001UL
+#define PCAPNG_BT_EPB               0x00000006UL
+#define PCAPNG_BYTE_ORDER_MAGIC     0x1A2B3C4DUL
+#define PCAPNG_LINKTYPE_USER0       147
+#define PCAPNG_OPT_ENDOFOPT         0
+#define PCAPNG_OPT_SHB_USERAPPL     4
+#define PCAPNG_OPT_IF_NAME          2
+#define PCAPNG_OPT_IF_TSRESOL       9
+#define PCAPNG_OPT_EPB_FLAGS        2
+#define PCAPNG_EPB_FLAG_INBOUND     0x01
+#define PCAPNG_EPB_FLAG_OUTBOUND    0x02
+
+/* Padding to 32-bit boundary */
+#define PCAPNG_PAD(len)             (((len) + 3) & ~((size_t)3))
+
+/* EPB overhead: 7 header words, flags option, end of options and trailing length */
+#define PCAPNG_EPB_OVERHEAD         (7 * 4 + 8 + 4 + 4)
+
+/* Application and interface names written to header */
+#define CAPTURE_APPL                "ESP-AT library"
+#define CAPTURE_IF_NAME             "esp-at"
+
+/* SHB and IDB lengths, written once on start */
+#define PCAPNG_SHB_LEN              (7 * 4 + 4 + PCAPNG_PAD(sizeof(CAPTURE_APPL) - 1) + 4)
+#define PCAPNG_IDB_LEN              (5 * 4 + 4 + PCAPNG_PAD(sizeof(CAPTURE_IF_NAME) - 1) + 4 + 4 + 4)
+
+/**
+ * \brief           Capture tap state
+ */
+typedef struct {
+    uint8_t running;                            /*!< Set to `1` when capture is active */
+    uint8_t use_ring;                           /*!< Set to `1` when output goes to RAM ring buffer */
+    esp_capture_out_fn out_fn;                  /*!< Output function when ring buffer is not used */
+    void* out_arg;                              /*!< Custom argument for output function */
+    esp_buff_t ring;                            /*!< RAM ring buffer for records */
+    uint8_t tx_buff[ESP_CFG_CAPTURE_TX_BUFF_SIZE];  /*!< Transmit aggregation buffer */
+    size_t tx_len;                              /*!< Number of bytes waiting in transmit buffer */
+    uint64_t tx_time;                           /*!< Timestamp of first byte in transmit buffer */
+    esp_capture_stats_t stats;                  /*!< Capture statistics */
+    esp_sys_mutex_t mutex;                      /*!< Capture lock, independent of core lock */
+} esp_capture_t;
+
+static esp_capture_t cap;
+
+/**
+ * \brief           Create capture lock on first start
+ *
+ * Lock is never deleted, so input thread may take it
+ * at any time after first start without core lock
+ *
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+capture_lock_init(void) {
+    uint8_t res;
+
+    esp_core_lock();
+    res = esp_sys_mutex_isvalid(&cap.mutex) || esp_sys_mutex_create(&cap.mutex);
+    esp_core_unlock();
+    return res;
+}
+
+/**
+ * \brief           Lock capture state
+ * \return          `1` when locked, `0` when capture was never started
+ */
+static uint8_t
+capture_lock(void) {
+    return esp_sys_mutex_isvalid(&cap.mutex) && esp_sys_mutex_lock(&cap.mutex);
+}
+
+/**
+ * \brief           Unlock capture state
+ */
+static void
+capture_unlock(void) {
+    esp_sys_mutex_unlock(&cap.mutex);
+}
+
+/**
+ * \brief           Write raw data to capture output
+ * \param[in]       data: Data to write
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+capture_out(const void* data, size_t len) {
+    if (cap.use_ring) {
+        esp_buff_write(&cap.ring, data, len);
+    } else if (cap.out_fn != NULL) {
+        cap.out_fn(data, len, cap.out_arg);
+    }
+}
+
+/**
+ * \brief           Write 32-bit value in host byte order
+ * \param[in]       val: Value to write
+ */
+static void
+capture_out_u32(uint32_t val) {
+    capture_out(&val, sizeof(val));
+}
+
+/**
+ * \brief           Write zero padding up to 32-bit boundary
+ * \param[in]       len: Length of data written before padding
+ */
+static void
+capture_out_pad(size_t len) {
+    static const uint8_t zeros[4] = {0};
+
+    capture_out(zeros, PCAPNG_PAD(len) - len);
+}
+
+/**
+ * \brief           Write block option
+ * \param[in]       code: Option code
+ * \param[in]       data: Option value
+ * \param[in]       len: Length of option value in units of bytes
+ */
+static void
+capture_out_opt(uint16_t code, const void* data, uint16_t len) {
+    uint16_t hdr[2];
+
+    hdr[0] = code;
+    hdr[1] = len;
+    capture_out(hdr, sizeof(hdr));
+    capture_out(data, len);
+    capture_out_pad(len);
+}
+
+/**
+ * \brief           Write section header and interface description blocks
+ */
+static void
+capture_write_header(void) {
+    static const char appl[] = CAPTURE_APPL;
+    static const char if_name[] = CAPTURE_IF_NAME;
+    static const uint8_t tsresol = 6;           /* Microseconds */
+    uint16_t ver[2] = {1, 0};                   /* Major and minor version */
+    uint16_t link[2] = {PCAPNG_LINKTYPE_USER0, 0};  /* Link type and reserved field */
+    uint32_t len;
+
+    /* Section header block */
+    len = PCAPNG_SHB_LEN;
+    capture_out_u32(PCAPNG_BT_SHB);
+    capture_out_u32(len);
+    capture_out_u32(PCAPNG_BYTE_ORDER_MAGIC);
+    capture_out(ver, sizeof(ver));
+    capture_out_u32(0xFFFFFFFFUL);              /* Section length not specified */
+    capture_out_u32(0xFFFFFFFFUL);
+    capture_out_opt(PCAPNG_OPT_SHB_USERAPPL, appl, sizeof(appl) - 1);
+    capture_out_u32(PCAPNG_OPT_ENDOFOPT);
+    capture_out_u32(len);
+
+    /* Interface description block */
+    len = PCAPNG_IDB_LEN;
+    capture_out_u32(PCAPNG_BT_IDB);
+    capture_out_u32(len);
+    capture_out(link, sizeof(link));
+    capture_out_u32(0);                         /* No snap length */
+    capture_out_opt(PCAPNG_OPT_IF_NAME, if_name, sizeof(if_name) - 1);
+    capture_out_opt(PCAPNG_OPT_IF_TSRESOL, &tsresol, 1);
+    capture_out_u32(PCAPNG_OPT_ENDOFOPT);
+    capture_out_u32(len);
+}
+
+/**
+ * \brief           Write single enhanced packet block
+ * \param[in]       flags: Direction flags
+ * \param[in]       time: Timestamp in units of microseconds
+ * \param[in]       data: Packet data
+ * \param[in]       len: Length of packet data in units of bytes
+ */
+static void
+capture_write_packet(uint32_t flags, uint64_t time, const void* data, size_t len) {
+    uint32_t blen = (uint32_t)(PCAPNG_EPB_OVERHEAD + PCAPNG_PAD(len));
+
+    if (cap.use_ring && esp_buff_get_free(&cap.ring) < blen) {
+        ++cap.stats.dropped;                    /* Never write partial records */
+        return;
+    }
+    capture_out_u32(PCAPNG_BT_EPB);
+    capture_out_u32(blen);
+    capture_out_u32(0);                         /* Interface ID */
+    capture_out_u32((uint32_t)(time >> 32));
+    capture_out_u32((uint32_t)time);
+    capture_out_u32((uint32_t)len);             /* Captured length */
+    capture_out_u32((uint32_t)len);             /* Original length */
+    capture_out(data, len);
+    capture_out_pad(len);
+    capture_out_opt(PCAPNG_OPT_EPB_FLAGS, &flags, sizeof(flags));
+    capture_out_u32(PCAPNG_OPT_ENDOFOPT);
+    capture_out_u32(blen);
+    ++cap.stats.records;
+}
+
+/**
+ * \brief           Write pending transmit data as single record
+ */
+static void
+capture_tx_flush(void) {
+    if (cap.tx_len > 0) {
+        capture_write_packet(PCAPNG_EPB_FLAG_OUTBOUND, cap.tx_time, cap.tx_buff, cap.tx_len);
+        cap.tx_len = 0;
+    }
+}
+
+/**
+ * \brief           Record data and send it with low-level send function
+ * \note            Function is called with core locked, capture lock is taken inside
+ * \param[in]       data: Data to send. Set to `NULL` to flush
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Value returned by low-level send function
+ */
+size_t
+espi_capture_send(const void* data, size_t len) {
+    if (cap.running && capture_lock()) {
+        if (cap.running && data != NULL && len > 0) {
+            const uint8_t* d = data;
+            size_t rem = len, n;
+
+            cap.stats.tx_bytes += (uint32_t)len;
+            while (rem > 0) {
+                if (cap.tx_len == 0) {
+                    cap.tx_time = ESP_CFG_CAPTURE_TIME_US();
+                }
+                n = ESP_MIN(rem, sizeof(cap.tx_buff) - cap.tx_len);
+                ESP_MEMCPY(&cap.tx_buff[cap.tx_len], d, n);
+                cap.tx_len += n;
+                d += n;
+                rem -= n;
+                if (cap.tx_len == sizeof(cap.tx_buff)) {
+                    capture_tx_flush();
+                }
+            }
+        } else if (cap.running) {
+            capture_tx_flush();
+        }
+        capture_unlock();
+    }
+    return esp.ll.send_fn(data, len);
+}
+
+/**
+ * \brief           Record data received from device
+ *
+ * Function is called from \ref esp_input without core lock
+ * and takes capture lock only, so input thread never waits for processing thread
+ *
+ * \param[in]       data: Received data
+ * \param[in]       len: Length of data in units of bytes
+ */
+void
+espi_capture_recv(const void* data, size_t len) {
+    uint64_t time;
+
+    if (!cap.running || len == 0) {
+        return;
+    }
+    time = ESP_CFG_CAPTURE_TIME_US();
+    if (capture_lock()) {
+        if (cap.running) {
+            capture_tx_flush();                 /* Keep records in time order */
+            cap.stats.rx_bytes += (uint32_t)len;
+            capture_write_packet(PCAPNG_EPB_FLAG_INBOUND, time, data, len);
+        }
+        capture_unlock();
+    }
+}
+
+/**
+ * \brief           Start capture and write records with output function
+ * \note            Output function is called with capture lock held, from processing thread
+ *                  or from thread calling \ref esp_input. It must not block for long time
+ *                  and must not call library functions
+ * \param[in]       out_fn: Function called with every chunk of capture file
+ * \param[in]       arg: Custom argument passed to output function
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_capture_start(esp_capture_out_fn out_fn, void* arg) {
+    ESP_ASSERT("out_fn != NULL", out_fn != NULL);
+
+    if (!capture_lock_init()) {
+        return espERRMEM;
+    }
+    capture_lock();
+    esp_capture_stop();
+    cap.out_fn = out_fn;
+    cap.out_arg = arg;
+    cap.use_ring = 0;
+    ESP_MEMSET(&cap.stats, 0x00, sizeof(cap.stats));
+    capture_write_header();
+    cap.stats.start_time = esp_sys_now();
+    cap.running = 1;
+    capture_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Start capture to RAM ring buffer
+ *
+ * Application reads capture file from ring with \ref esp_capture_read.
+ * When ring is full, new records are dropped until application reads old ones.
+ *
+ * \param[in]       size: Size of ring buffer in units of bytes.
+ *                      Must hold file header and at least one record
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_capture_start_ring(size_t size) {
+    espr_t res = espOK;
+
+    /* Ring keeps one byte free, truncated header would make file invalid */
+    ESP_ASSERT("size > header", size > PCAPNG_SHB_LEN + PCAPNG_IDB_LEN + PCAPNG_EPB_OVERHEAD + PCAPNG_PAD(1));
+
+    if (!capture_lock_init()) {
+        return espERRMEM;
+    }
+    capture_lock();
+    esp_capture_stop();
+    if (esp_buff_init(&cap.ring, size)) {
+        cap.use_ring = 1;
+        ESP_MEMSET(&cap.stats, 0x00, sizeof(cap.stats));
+        capture_write_header();
+        cap.stats.start_time = esp_sys_now();
+        cap.running = 1;
+    } else {
+        res = espERRMEM;
+    }
+    capture_unlock();
+    return res;
+}
+
+/**
+ * \brief           Stop capture
+ * \note            Ring buffer memory is released. Read remaining data before stopping
+ * \note            Statistics remain available until next start
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_capture_stop(void) {
+    if (!capture_lock()) {
+        return espOK;                           /* Never started */
+    }
+    if (cap.running) {
+        capture_tx_flush();
+    }
+    cap.running = 0;
+    if (cap.use_ring) {
+        esp_buff_free(&cap.ring);
+        cap.use_ring = 0;
+    }
+    cap.out_fn = NULL;
+    cap.tx_len = 0;
+    capture_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Read capture data from RAM ring buffer
+ * \param[out]      data: Output buffer
+ * \param[in]       len: Size of output buffer in units of bytes
+ * \return          Number of bytes written to output buffer
+ */
+size_t
+esp_capture_read(void* data, size_t len) {
+    size_t res = 0;
+
+    if (data != NULL && capture_lock()) {
+        if (cap.use_ring) {
+            res = esp_buff_read(&cap.ring, data, len);
+        }
+        capture_unlock();
+    }
+    return res;
+}
+
+/**
+ * \brief           Get capture statistics
+ *
+ * Use byte counters together with `start_time` to calculate AT link utilisation
+ *
+ * \param[out]      stats: Pointer to output structure
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_capture_get_stats(esp_capture_stats_t* stats) {
+    ESP_ASSERT("stats != NULL", stats != NULL);
+
+    if (capture_lock()) {
+        ESP_MEMCPY(stats, &cap.stats, sizeof(*stats));
+        capture_unlock();
+    } else {
+        ESP_MEMSET(stats, 0x00, sizeof(*stats));
+    }
+    return espOK;
+}
+
+#endif /* ESP_CFG_CAPTURE || __DOXYGEN__ */
@@ -36,18 +36,27 @@
 #if ESP_CFG_MODE_STATION
 #include "esp/esp_sta.h"
 #endif /* ESP_CFG_MODE_STATION */
+#if ESP_CFG_THREAD_STACK_STATS
+#include "system/esp_sys.h"
+#endif /* ESP_CFG_THREAD_STACK_STATS */
 #include "cli/cli.h"
 #include "cli/cli_config.h"
 
 #if ESP_CFG_MODE_STATION
 static void cli_station_info(cli_printf cliprintf, int argc, char** argv);
 #endif /* ESP_CFG_MODE_STATION */
+#if ESP_CFG_THREAD_STACK_STATS
+static void cli_thread_stacks(cli_printf cliprintf, int argc, char** argv);
+#endif /* ESP_CFG_THREAD_STACK_STATS */
 
 static const cli_command_t
 commands[] = {
 #if ESP_CFG_MODE_STATION
     { "station-info",       "Get current station info",                 cli_station_info },
 #endif /* ESP_CFG_MODE_STATION */
+#if ESP_CFG_THREAD_STACK_STATS
+    { "thread-stacks",      "Get stack high-water marks of threads",    cli_thread_stacks },
+#endif /* ESP_CFG_THREAD_STACK_STATS */
 
 };
 
@@ -88,3 +97,34 @@ cli_station_info(cli_printf cliprintf, int argc, char** argv) {
 }
 
 #endif /* ESP_CFG_MODE_STATION || __DOXYGEN__ */
+
+#if ESP_CFG_THREAD_STACK_STATS || __DOXYGEN__
+
+/**
+ * \brief           CLI command for reading maximal stack usage of library threads
+ * \param[in]       cliprintf: Pointer to CLI printf function
+ * \param[in]       argc: Number fo arguments in argv
+ * \param[in]       argv: Pointer to the commands arguments
+ */
+static void
+cli_thread_stacks(cli_printf cliprintf, int argc, char** argv) {
+    esp_sys_thread_stack_t stats[ESP_CFG_THREAD_STACK_STATS_MAX];
+    size_t cnt;
+
+    cnt = esp_sys_thread_get_stack_stats(stats, ESP_ARRAYSIZE(stats));
+    if (cnt == 0) {
+        cliprintf("Error: No thread stack info available"CLI_NL);
+        return;
+    }
+
+    cliprintf("  %-16s %10s %10s"CLI_NL, "Thread", "Size", "Used max");
+    for (size_t i = 0; i < cnt; ++i) {
+        cliprintf("  %-16s %10u %10u"CLI_NL, stats[i].name != NULL ? stats[i].name : "?",
+            (unsigned)stats[i].size, (unsigned)stats[i].used_max);
+    }
+
+    ESP_UNUSED(argc);
+    ESP_UNUSED(argv);
+}
+
+#endif /* ESP_CFG_THREAD_STACK_STATS || __DOXYGEN__ */
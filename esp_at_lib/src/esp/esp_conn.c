@@ -100,6 +100,22 @@ manual_tcp_read_data_evt_fn(espr_t res, void* arg) {
     espi_conn_manual_tcp_try_read_data(conn);
 }
 
+#if ESP_CFG_CONN_RATE_LIMIT
+
+/**
+ * \brief           Timeout callback when receive rate limit allows next read
+ * \param[in]       arg: Connection handle
+ */
+static void
+manual_tcp_rate_timeout_cb(void* arg) {
+    esp_conn_p conn = arg;
+
+    conn->status.f.receive_rate_wait = 0;
+    espi_conn_manual_tcp_try_read_data(conn);
+}
+
+#endif /* ESP_CFG_CONN_RATE_LIMIT */
+
 /**
  * \brief           Manually start data read operation with desired length on specific connection
  * \param[in]       conn: Connection handle
@@ -109,6 +125,9 @@ manual_tcp_read_data_evt_fn(espr_t res, void* arg) {
 espr_t
 espi_conn_manual_tcp_try_read_data(esp_conn_p conn) {
     uint32_t blocking = 0;
+#if ESP_CFG_CONN_RATE_LIMIT
+    uint32_t wait;
+#endif /* ESP_CFG_CONN_RATE_LIMIT */
     espr_t res = espOK;
     ESP_MSG_VAR_DEFINE(msg);
 
@@ -126,6 +145,17 @@ espi_conn_manual_tcp_try_read_data(esp_conn_p conn) {
         return espERR;
     }
 
+#if ESP_CFG_CONN_RATE_LIMIT
+    /* Data stay in device until receive bucket is out of debt */
+    if ((wait = espi_conn_rate_wait(conn, 1, 0)) > 0) {
+        if (!conn->status.f.receive_rate_wait) {
+            conn->status.f.receive_rate_wait = 1;
+            esp_timeout_add(wait, manual_tcp_rate_timeout_cb, conn);
+        }
+        return espINPROG;
+    }
+#endif /* ESP_CFG_CONN_RATE_LIMIT */
+
     ESP_MSG_VAR_ALLOC(msg, blocking);           /* Allocate first, will return on failure */
     ESP_MSG_VAR_SET_EVT(msg, manual_tcp_read_data_evt_fn, conn);/* Set event callback function */
     ESP_MSG_VAR_REF(msg).cmd_def = ESP_CMD_TCPIP_CIPRECVDATA;
@@ -185,6 +215,268 @@ espi_conn_get_val_id(esp_conn_p conn) {
     return val_id;
 }
 
+#if ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__
+
+/**
+ * \brief           Refill token bucket with tokens gathered since last refill
+ * \param[in]       b: Bucket to refill
+ * \param[in]       now: Current time in units of milliseconds
+ */
+static void
+rate_refill(esp_rate_bucket_t* b, uint32_t now) {
+    uint64_t add;
+
+    if (b->limit.rate == 0) {
+        return;
+    }
+    add = ((uint64_t)(now - b->time) * b->limit.rate) / 1000;
+    if ((int64_t)b->tokens + (int64_t)add >= (int64_t)b->limit.burst) {
+        b->tokens = (int32_t)b->limit.burst;
+        b->time = now;
+    } else if (add > 0) {
+        b->tokens += (int32_t)add;
+        b->time += (uint32_t)((add * 1000) / b->limit.rate);    /* Keep remainder for next refill */
+    }
+}
+
+/**
+ * \brief           Get time until bucket allows data of specific length
+ *
+ * Bucket must be out of debt and charge must not put it to debt larger than burst size.
+ * Data longer than twice the burst size only wait for full bucket
+ *
+ * \param[in]       b: Bucket to check
+ * \param[in]       len: Number of bytes to pass, `0` to only check for debt
+ * \return          Time in units of milliseconds, `0` when data may be sent
+ */
+static uint32_t
+rate_wait(const esp_rate_bucket_t* b, size_t len) {
+    int64_t need = 0;
+
+    if (b->limit.rate == 0) {
+        return 0;
+    }
+    if (len > b->limit.burst) {
+        need = ESP_MIN((int64_t)len - (int64_t)b->limit.burst, (int64_t)b->limit.burst);
+    }
+    if (b->tokens >= need) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)(need - b->tokens) * 1000 + b->limit.rate - 1) / b->limit.rate);
+}
+
+/**
+ * \brief           Take tokens from bucket, bucket may go to debt of up to burst size
+ * \param[in]       b: Bucket to charge
+ * \param[in]       len: Number of bytes
+ * \return          `1` if bucket just ran out of tokens, `0` otherwise
+ */
+static uint8_t
+rate_charge(esp_rate_bucket_t* b, size_t len) {
+    int64_t tokens;
+    uint8_t charged;
+
+    if (b->limit.rate == 0) {
+        return 0;
+    }
+    tokens = (int64_t)b->tokens - (int64_t)len;
+    if (tokens < -(int64_t)b->limit.burst) {    /* Debt is never larger than burst */
+        tokens = -(int64_t)b->limit.burst;
+    }
+    charged = b->tokens >= 0 && tokens < 0;
+    b->tokens = (int32_t)tokens;
+    return charged;
+}
+
+/**
+ * \brief           Set new limit to bucket and fill it
+ * \param[in]       b: Bucket to configure
+ * \param[in]       limit: New limit. Set to `NULL` to keep current one
+ */
+static void
+rate_configure(esp_rate_bucket_t* b, const esp_conn_rate_limit_t* limit) {
+    if (limit != NULL) {
+        b->limit = *limit;
+        if (b->limit.burst == 0) {
+            b->limit.burst = b->limit.rate;
+        }
+        b->limit.burst = ESP_MIN(b->limit.burst, (uint32_t)INT32_MAX);
+        b->tokens = (int32_t)b->limit.burst;
+        b->time = esp_sys_now();
+    }
+}
+
+/**
+ * \brief           Get time connection must wait before more data may pass in specific direction
+ * \note            Core must be locked before calling this function
+ * \param[in]       conn: Connection handle
+ * \param[in]       is_rx: Set to `1` for receive direction, `0` for transmit
+ * \param[in]       len: Number of bytes to pass, `0` to only check for debt
+ * \return          Time in units of milliseconds, `0` when data may pass
+ */
+uint32_t
+espi_conn_rate_wait(esp_conn_p conn, uint8_t is_rx, size_t len) {
+    esp_rate_bucket_t* b = is_rx ? &conn->rate_rx : &conn->rate_tx;
+    esp_rate_bucket_t* g = is_rx ? &esp.rate_rx : &esp.rate_tx;
+    uint32_t now = esp_sys_now();
+
+    rate_refill(b, now);
+    rate_refill(g, now);
+    return ESP_MAX(rate_wait(b, len), rate_wait(g, len));
+}
+
+/**
+ * \brief           Charge connection and global bucket for data in specific direction
+ *
+ * Sends \ref ESP_EVT_CONN_THROTTLED to connection callback when any of buckets runs out of tokens
+ *
+ * \note            Core must be locked before calling this function
+ * \param[in]       conn: Connection handle
+ * \param[in]       is_rx: Set to `1` for receive direction, `0` for transmit
+ * \param[in]       len: Number of bytes
+ */
+void
+espi_conn_rate_charge(esp_conn_p conn, uint8_t is_rx, size_t len) {
+    esp_rate_bucket_t* b = is_rx ? &conn->rate_rx : &conn->rate_tx;
+    esp_rate_bucket_t* g = is_rx ? &esp.rate_rx : &esp.rate_tx;
+    uint8_t conn_empty, global_empty;
+    esp_evt_t evt;
+
+    espi_conn_rate_wait(conn, is_rx, 0);        /* Refill both buckets first */
+    conn_empty = rate_charge(b, len);
+    global_empty = rate_charge(g, len);
+    if ((conn_empty || global_empty) && conn->evt_func != NULL) {
+        /* Use separate event structure, function may be called from inside of another event */
+        ESP_MEMSET(&evt, 0x00, sizeof(evt));
+        evt.type = ESP_EVT_CONN_THROTTLED;
+        evt.evt.conn_throttled.conn = conn;
+        evt.evt.conn_throttled.is_rx = is_rx;
+        evt.evt.conn_throttled.is_global = global_empty;
+        evt.evt.conn_throttled.wait = ESP_MAX(rate_wait(b, 0), rate_wait(g, 0));
+        ESP_EVT_STAMP(&evt);
+        conn->evt_func(&evt);
+    }
+}
+
+/**
+ * \brief           Check if connection has send messages waiting for transmit tokens
+ * \note            Core must be locked before calling this function
+ * \param[in]       conn: Connection handle
+ * \return          `1` if messages are held, `0` otherwise
+ */
+static uint8_t
+rate_tx_is_held(esp_conn_p conn) {
+    for (esp_msg_t* m = esp.rate_tx_held; m != NULL; m = m->msg.conn_send.held_next) {
+        if (m->msg.conn_send.conn == conn) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void rate_tx_release(void);
+
+/**
+ * \brief           Timeout callback when transmit buckets may allow held messages
+ * \param[in]       arg: Timeout argument, not used
+ */
+static void
+rate_tx_timeout_cb(void* arg) {
+    ESP_UNUSED(arg);
+    rate_tx_release();
+}
+
+/**
+ * \brief           Charge send message and put it to producer queue
+ *
+ * Error to put message to queue is reported with \ref ESP_EVT_CONN_SEND event,
+ * as non-blocking send function already returned success
+ *
+ * \note            Core must be locked before calling this function
+ * \param[in]       msg: Send message
+ */
+static void
+rate_tx_send(esp_msg_t* msg) {
+    esp_conn_p conn = msg->msg.conn_send.conn;
+    const void* data = msg->msg.conn_send.data;
+    uint8_t fau = msg->msg.conn_send.fau;
+    espr_t res;
+
+    espi_conn_rate_charge(conn, 0, msg->msg.conn_send.btw);
+    if ((res = espi_send_msg_to_producer_mbox(msg, espi_initiate_cmd, 60000)) != espOK) {
+        if (fau) {
+            esp_mem_free((void *)data);
+        }
+        esp.evt.type = ESP_EVT_CONN_SEND;
+        esp.evt.evt.conn_data_send.res = res;
+        esp.evt.evt.conn_data_send.conn = conn;
+        esp.evt.evt.conn_data_send.sent = 0;
+        espi_send_conn_cb(conn, NULL);
+    }
+}
+
+/**
+ * \brief           Put held send messages to producer queue when their buckets are out of debt
+ *
+ * Messages of closed connections are released immediately and fail in processing thread.
+ * Once message of connection stays held, bucket is in debt for all later messages
+ * of the same connection, hence order of data on connection is kept.
+ *
+ * \note            Core must be locked before calling this function
+ */
+static void
+rate_tx_release(void) {
+    esp_msg_t** p = &esp.rate_tx_held;
+    esp_msg_t* m;
+    esp_conn_p conn;
+    uint32_t wait, next = 0;
+
+    while ((m = *p) != NULL) {
+        conn = m->msg.conn_send.conn;
+        wait = 0;
+        if (conn->status.f.active && m->msg.conn_send.val_id == conn->val_id) {
+            wait = espi_conn_rate_wait(conn, 0, m->msg.conn_send.btw);
+        }
+        if (wait > 0) {
+            next = next == 0 ? wait : ESP_MIN(next, wait);
+            p = &m->msg.conn_send.held_next;
+        } else {
+            *p = m->msg.conn_send.held_next;
+            m->msg.conn_send.held_next = NULL;
+            rate_tx_send(m);
+        }
+    }
+    esp_timeout_remove(rate_tx_timeout_cb);     /* Single timeout for all held messages */
+    if (next > 0) {
+        esp_timeout_add(next, rate_tx_timeout_cb, NULL);
+    }
+}
+
+/**
+ * \brief           Hold non-blocking send message until transmit tokens are available
+ * \note            Core must be locked before calling this function
+ * \param[in]       msg: Send message
+ * \return          `1` if message is held, `0` if it may be sent immediately
+ */
+static uint8_t
+rate_tx_hold(esp_msg_t* msg) {
+    esp_conn_p conn = msg->msg.conn_send.conn;
+    esp_msg_t** p;
+    uint32_t wait;
+
+    if ((wait = espi_conn_rate_wait(conn, 0, msg->msg.conn_send.btw)) == 0 && !rate_tx_is_held(conn)) {
+        return 0;
+    }
+    for (p = &esp.rate_tx_held; *p != NULL; p = &(*p)->msg.conn_send.held_next) {}
+    *p = msg;                                   /* Append to keep order of send calls */
+
+    /* Release is not called here, function may be called from inside of another event */
+    esp_timeout_add(wait > 0 ? wait : 1, rate_tx_timeout_cb, NULL);
+    return 1;
+}
+
+#endif /* ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__ */
+
 /**
  * \brief           Send data on already active connection of type UDP to specific remote IP and port
  * \note            In case IP and port values are not set, it will behave as normal send function (suitable for TCP too)
@@ -211,6 +503,21 @@ conn_send(esp_conn_p conn, const esp_ip_t* const ip, esp_port_t port, const void
         *bw = 0;
     }
 
+#if ESP_CFG_CONN_RATE_LIMIT
+    /* Blocking send waits for tokens and for held messages before command reaches producer queue */
+    if (blocking) {
+        uint32_t wait;
+
+        esp_core_lock();
+        while (((wait = espi_conn_rate_wait(conn, 0, btw)) > 0 || rate_tx_is_held(conn)) && conn->status.f.active) {
+            esp_core_unlock();
+            esp_delay(wait > 0 ? wait : 1);
+            esp_core_lock();
+        }
+        esp_core_unlock();
+    }
+#endif /* ESP_CFG_CONN_RATE_LIMIT */
+
     CONN_CHECK_CLOSED_IN_CLOSING(conn);         /* Check if we can continue */
 
     ESP_MSG_VAR_ALLOC(msg, blocking);
@@ -225,6 +532,20 @@ conn_send(esp_conn_p conn, const esp_ip_t* const ip, esp_port_t port, const void
     ESP_MSG_VAR_REF(msg).msg.conn_send.fau = fau;
     ESP_MSG_VAR_REF(msg).msg.conn_send.val_id = espi_conn_get_val_id(conn);
 
+#if ESP_CFG_EVT_TIMESTAMP
+    ESP_MSG_VAR_REF(msg).msg.conn_send.time_queued = ESP_CFG_EVT_TIMESTAMP_NOW();
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+#if ESP_CFG_CONN_RATE_LIMIT
+    esp_core_lock();
+    /* Non-blocking send is held by library until tokens are available */
+    if (!blocking && rate_tx_hold(&ESP_MSG_VAR_REF(msg))) {
+        esp_core_unlock();
+        return espOK;
+    }
+    espi_conn_rate_charge(conn, 0, btw);
+    esp_core_unlock();
+#endif /* ESP_CFG_CONN_RATE_LIMIT */
+
     return espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, 60000);
 }
 
@@ -443,7 +764,8 @@ esp_conn_send(esp_conn_p conn, const void* data, size_t btw, size_t* const bw,
  * \note            Since this feature is not supported yet by AT commands, function is only prototype
  *                  and should be used in connection callback when data are received
  *
- * \note            Function is not thread safe and may only be called from connection event function
+ * \note            Function may be called from connection event function or from other thread,
+ *                  when event was delivered through \ref ESP_EVT_POLL
  *
  * \param[in]       conn: Connection handle
  * \param[in]       pbuf: Packet buffer received on connection
@@ -454,12 +776,14 @@ esp_conn_recved(esp_conn_p conn, esp_pbuf_p pbuf) {
 #if ESP_CFG_CONN_MANUAL_TCP_RECEIVE
     size_t len;
     len = esp_pbuf_length(pbuf, 1);             /* Get length of pbuf */
+    esp_core_lock();
     if (conn->tcp_not_ack_bytes >= len) {       /* Check length of not-acknowledged bytes */
         conn->tcp_not_ack_bytes -= len;
     } else {
         /* Warning here, de-sync happened somewhere! */
     }
     espi_conn_manual_tcp_try_read_data(conn);   /* Try to read more connection data */
+    esp_core_unlock();
 #else /* ESP_CFG_CONN_MANUAL_TCP_RECEIVE */
     ESP_UNUSED(conn);
     ESP_UNUSED(pbuf);
@@ -609,6 +933,35 @@ esp_conn_set_ssl_buffersize(size_t size, const uint32_t blocking) {
     return espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, 1000);
 }
 
+/**
+ * \brief           Set policy for remote IP and port information in `+IPD` statement
+ *
+ * Remote information costs AT port bandwidth and parsing time on every received packet.
+ * \e TCP and \e SSL connections have fixed remote endpoint, known when connection is started,
+ * so information is only necessary for \e UDP connections receiving from multiple peers.
+ *
+ * \note            With \ref ESP_IPD_INFO_AUTO, information is enabled before \e UDP connection is started
+ *                  and disabled again on next connection start when no \e UDP connection is active
+ * \param[in]       policy: New policy. This parameter can be a value of \ref esp_ipd_info_t enumeration
+ * \param[in]       evt_fn: Callback function called when command has finished. Set to `NULL` when not used
+ * \param[in]       evt_arg: Custom argument for event callback function
+ * \param[in]       blocking: Status whether command should be blocking or not
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_conn_set_ipd_info_policy(esp_ipd_info_t policy, const esp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking) {
+    ESP_MSG_VAR_DEFINE(msg);
+
+    ESP_ASSERT("policy <= ESP_IPD_INFO_NEVER", policy <= ESP_IPD_INFO_NEVER);
+
+    ESP_MSG_VAR_ALLOC(msg, blocking);
+    ESP_MSG_VAR_SET_EVT(msg, evt_fn, evt_arg);
+    ESP_MSG_VAR_REF(msg).cmd_def = ESP_CMD_TCPIP_CIPDINFO;
+    ESP_MSG_VAR_REF(msg).msg.tcpip_dinfo.policy = policy;
+
+    return espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, 1000);
+}
+
 /**
  * \brief           Get connection from connection based event
  * \param[in]       evt: Event which happened for connection
@@ -622,6 +975,12 @@ esp_conn_get_from_evt(esp_evt_t* evt) {
         case ESP_EVT_CONN_RECV: return esp_evt_conn_recv_get_conn(evt);
         case ESP_EVT_CONN_SEND: return esp_evt_conn_send_get_conn(evt);
         case ESP_EVT_CONN_POLL: return esp_evt_conn_poll_get_conn(evt);
+#if ESP_CFG_CONN_RATE_LIMIT
+        case ESP_EVT_CONN_THROTTLED: return esp_evt_conn_throttled_get_conn(evt);
+#endif /* ESP_CFG_CONN_RATE_LIMIT */
+#if ESP_CFG_CONN_SENDBUF
+        case ESP_EVT_CONN_SEND_FAIL: return esp_evt_conn_send_fail_get_conn(evt);
+#endif /* ESP_CFG_CONN_SENDBUF */
         default: return NULL;
     }
 }
@@ -642,12 +1001,14 @@ esp_conn_get_from_evt(esp_evt_t* evt) {
 espr_t
 esp_conn_write(esp_conn_p conn, const void* data, size_t btw, uint8_t flush,
                 size_t* const mem_available) {
-    size_t len;
+    size_t len, max_len;
 
     const uint8_t* d = data;
 
     ESP_ASSERT("conn != NULL", conn != NULL);
 
+    max_len = esp_get_conn_max_data_len();      /* Use the same length for entire write operation */
+
     /*
      * Steps during write process:
      *
@@ -683,12 +1044,12 @@ esp_conn_write(esp_conn_p conn, const void* data, size_t btw, uint8_t flush,
     }
 
     /* Step 2 */
-    while (btw >= ESP_CFG_CONN_MAX_DATA_LEN) {
+    while (btw >= max_len) {
         uint8_t* buff;
-        buff = esp_mem_malloc(sizeof(*buff) * ESP_CFG_CONN_MAX_DATA_LEN);
+        buff = esp_mem_malloc_class(ESP_MEM_CLASS_BULK, sizeof(*buff) * max_len);
         if (buff != NULL) {
-            ESP_MEMCPY(buff, d, ESP_CFG_CONN_MAX_DATA_LEN); /* Copy data to buffer */
-            if (conn_send(conn, NULL, 0, buff, ESP_CFG_CONN_MAX_DATA_LEN, NULL, 1, 0) != espOK) {
+            ESP_MEMCPY(buff, d, max_len);       /* Copy data to buffer */
+            if (conn_send(conn, NULL, 0, buff, max_len, NULL, 1, 0) != espOK) {
                 ESP_DEBUGF(ESP_CFG_DBG_CONN | ESP_DBG_TYPE_TRACE,
                     "[CONN] Free write buffer: %p\r\n", (void *)buff);
                 esp_mem_free_s((void **)&buff);
@@ -698,14 +1059,14 @@ esp_conn_write(esp_conn_p conn, const void* data, size_t btw, uint8_t flush,
             return espERRMEM;
         }
 
-        btw -= ESP_CFG_CONN_MAX_DATA_LEN;       /* Decrease remaining length */
-        d += ESP_CFG_CONN_MAX_DATA_LEN;         /* Advance data pointer */
+        btw -= max_len;                         /* Decrease remaining length */
+        d += max_len;                           /* Advance data pointer */
     }
 
     /* Step 3 */
     if (conn->buff.buff == NULL) {
-        conn->buff.buff = esp_mem_malloc(sizeof(*conn->buff.buff) * ESP_CFG_CONN_MAX_DATA_LEN);
-        conn->buff.len = ESP_CFG_CONN_MAX_DATA_LEN;
+        conn->buff.buff = esp_mem_malloc_class(ESP_MEM_CLASS_BULK, sizeof(*conn->buff.buff) * max_len);
+        conn->buff.len = max_len;
         conn->buff.ptr = 0;
 
         ESP_DEBUGW(ESP_CFG_DBG_CONN | ESP_DBG_TYPE_TRACE, conn->buff.buff != NULL,
@@ -755,6 +1116,128 @@ esp_conn_get_total_recved_count(esp_conn_p conn) {
     return tot;
 }
 
+/**
+ * \brief           Get number of data segments queued in module, not yet acknowledged with `SEND OK`
+ *
+ * Segments are queued with `AT+CIPSENDBUF` command when \ref ESP_CFG_CONN_SENDBUF is enabled.
+ * Value `0` means every byte reported with \ref ESP_EVT_CONN_SEND was also sent by module.
+ *
+ * \param[in]       conn: Connection handle
+ * \return          Number of pending segments, always `0` when buffered send is disabled
+ */
+size_t
+esp_conn_get_sendbuf_pending(esp_conn_p conn) {
+    size_t pending = 0;
+
+#if ESP_CFG_CONN_SENDBUF
+    if (conn != NULL) {
+        esp_core_lock();
+        pending = conn->sendbuf.pending;
+        esp_core_unlock();
+    }
+#else /* ESP_CFG_CONN_SENDBUF */
+    ESP_UNUSED(conn);
+#endif /* !ESP_CFG_CONN_SENDBUF */
+    return pending;
+}
+
+/**
+ * \brief           Get number of currently active connections
+ * \return          Number of active connections
+ */
+size_t
+esp_conn_get_active_count(void) {
+    size_t cnt = 0;
+
+    esp_core_lock();
+    for (size_t i = 0; i < ESP_CFG_MAX_CONNS; ++i) {
+        if (esp.m.conns[i].status.f.active) {
+            ++cnt;
+        }
+    }
+    esp_core_unlock();
+    return cnt;
+}
+
+/**
+ * \brief           Get statistics of received network data
+ * \note            Use it to check efficiency of receive buffer allocation,
+ *                  see \ref ESP_CFG_IPD_ADAPTIVE
+ * \param[out]      stats: Pointer to output structure
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_conn_get_ipd_stats(esp_conn_ipd_stats_t* stats) {
+    ESP_ASSERT("stats != NULL", stats != NULL);
+
+    esp_core_lock();
+    *stats = esp.ipd_stats;
+    esp_core_unlock();
+    return espOK;
+}
+
+#if ESP_CFG_CONN_ADAPTIVE_CHUNK || __DOXYGEN__
+
+/**
+ * \brief           Get adaptive `AT+CIPSEND` chunk size and statistics of connection
+ * \note            Size is `0` until first data are sent on connection
+ * \param[in]       conn: Connection handle
+ * \param[out]      stats: Pointer to output structure
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_conn_get_chunk_stats(esp_conn_p conn, esp_conn_chunk_stats_t* stats) {
+    ESP_ASSERT("conn != NULL", conn != NULL);
+    ESP_ASSERT("stats != NULL", stats != NULL);
+
+    esp_core_lock();
+    *stats = conn->chunk.stats;
+    esp_core_unlock();
+    return espOK;
+}
+
+#endif /* ESP_CFG_CONN_ADAPTIVE_CHUNK || __DOXYGEN__ */
+
+#if ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__
+
+/**
+ * \brief           Set token bucket rate limit on connection
+ * \note            Limit is valid until connection is closed.
+ *                  Set it on \ref ESP_EVT_CONN_ACTIVE event to limit connection from the beginning
+ * \param[in]       conn: Connection handle
+ * \param[in]       tx: Transmit limit. Set to `NULL` to keep current limit
+ * \param[in]       rx: Receive limit. Set to `NULL` to keep current limit
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_conn_set_rate_limit(esp_conn_p conn, const esp_conn_rate_limit_t* tx, const esp_conn_rate_limit_t* rx) {
+    ESP_ASSERT("conn != NULL", conn != NULL);
+
+    esp_core_lock();
+    rate_configure(&conn->rate_tx, tx);
+    rate_configure(&conn->rate_rx, rx);
+    esp_core_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Set token bucket rate limit shared by all connections
+ * \note            Data are charged to global and connection limit, slower one decides
+ * \param[in]       tx: Transmit limit. Set to `NULL` to keep current limit
+ * \param[in]       rx: Receive limit. Set to `NULL` to keep current limit
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_conn_set_global_rate_limit(const esp_conn_rate_limit_t* tx, const esp_conn_rate_limit_t* rx) {
+    esp_core_lock();
+    rate_configure(&esp.rate_tx, tx);
+    rate_configure(&esp.rate_rx, rx);
+    esp_core_unlock();
+    return espOK;
+}
+
+#endif /* ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__ */
+
 /**
  * \brief           Get connection remote IP address
  * \param[in]       conn: Connection handle
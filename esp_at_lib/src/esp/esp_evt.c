@@ -112,6 +112,48 @@ esp_evt_get_type(esp_evt_t* cc) {
     return cc->type;
 }
 
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+
+/**
+ * \brief           Get global sequence number of event
+ *
+ * Number is increased for every dispatched event. Gaps between consecutive
+ * events seen by single callback belong to events dispatched to other callbacks
+ *
+ * \param[in]       cc: Event handle
+ * \return          Sequence number
+ */
+uint32_t
+esp_evt_get_seq(esp_evt_t* cc) {
+    return cc->seq;
+}
+
+/**
+ * \brief           Get arrival time of input data which triggered event
+ *
+ * Time is taken when data were passed to \ref esp_input or \ref esp_input_process.
+ * For events not triggered by received data, it is equal to dispatch time
+ *
+ * \param[in]       cc: Event handle
+ * \return          Time in units of \ref ESP_CFG_EVT_TIMESTAMP_NOW
+ */
+uint32_t
+esp_evt_get_time_input(esp_evt_t* cc) {
+    return cc->time_input;
+}
+
+/**
+ * \brief           Get time when event was dispatched to callback
+ * \param[in]       cc: Event handle
+ * \return          Time in units of \ref ESP_CFG_EVT_TIMESTAMP_NOW
+ */
+uint32_t
+esp_evt_get_time_dispatch(esp_evt_t* cc) {
+    return cc->time_dispatch;
+}
+
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
+
 /**
  * \brief           Check if detected reset was forced by user
  * \param[in]       cc: Event handle
@@ -236,6 +278,44 @@ esp_evt_conn_send_get_result(esp_evt_t* cc) {
     return cc->evt.conn_data_send.res;
 }
 
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+
+/**
+ * \brief           Get time when send request was queued by application
+ * \param[in]       cc: Event handle
+ * \return          Time in units of \ref ESP_CFG_EVT_TIMESTAMP_NOW
+ */
+uint32_t
+esp_evt_conn_send_get_time_queued(esp_evt_t* cc) {
+    return cc->evt.conn_data_send.time_queued;
+}
+
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
+
+#if ESP_CFG_CONN_SENDBUF || __DOXYGEN__
+
+/**
+ * \brief           Get connection handle of failed segment
+ * \param[in]       cc: Event handle
+ * \return          Connection handle
+ */
+esp_conn_p
+esp_evt_conn_send_fail_get_conn(esp_evt_t* cc) {
+    return cc->evt.conn_send_fail.conn;
+}
+
+/**
+ * \brief           Get ID of failed segment, as reported by module
+ * \param[in]       cc: Event handle
+ * \return          Segment ID
+ */
+uint32_t
+esp_evt_conn_send_fail_get_segment(esp_evt_t* cc) {
+    return cc->evt.conn_send_fail.seg_id;
+}
+
+#endif /* ESP_CFG_CONN_SENDBUF || __DOXYGEN__ */
+
 /**
  * \brief           Get connection handle
  * \param[in]       cc: Event handle
@@ -306,6 +386,50 @@ esp_evt_conn_poll_get_conn(esp_evt_t* cc) {
     return cc->evt.conn_poll.conn;
 }
 
+#if ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__
+
+/**
+ * \brief           Get throttled connection handle
+ * \param[in]       cc: Event handle
+ * \return          Connection handle
+ */
+esp_conn_p
+esp_evt_conn_throttled_get_conn(esp_evt_t* cc) {
+    return cc->evt.conn_throttled.conn;
+}
+
+/**
+ * \brief           Check if receive direction is throttled
+ * \param[in]       cc: Event handle
+ * \return          `1` for receive direction, `0` for transmit
+ */
+uint8_t
+esp_evt_conn_throttled_is_rx(esp_evt_t* cc) {
+    return cc->evt.conn_throttled.is_rx;
+}
+
+/**
+ * \brief           Check if global limit throttles connection
+ * \param[in]       cc: Event handle
+ * \return          `1` if global bucket ran out of tokens, `0` if only connection bucket did
+ */
+uint8_t
+esp_evt_conn_throttled_is_global(esp_evt_t* cc) {
+    return cc->evt.conn_throttled.is_global;
+}
+
+/**
+ * \brief           Get time until connection may pass more data
+ * \param[in]       cc: Event handle
+ * \return          Time in units of milliseconds
+ */
+uint32_t
+esp_evt_conn_throttled_get_wait(esp_evt_t* cc) {
+    return cc->evt.conn_throttled.wait;
+}
+
+#endif /* ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__ */
+
 /**
  * \brief           Get connection error type
  * \param[in]       cc: Event handle
@@ -518,6 +642,74 @@ esp_evt_ping_get_time(esp_evt_t* cc) {
 
 #endif /* ESP_CFG_PING || __DOXYGEN__ */
 
+#if ESP_CFG_LINKQ || __DOXYGEN__
+
+/**
+ * \brief           Get new link quality level
+ * \param[in]       cc: Event handle
+ * \return          Member of \ref esp_linkq_level_t enumeration
+ */
+esp_linkq_level_t
+esp_evt_linkq_get_level(esp_evt_t* cc) {
+    return cc->evt.linkq.level;
+}
+
+/**
+ * \brief           Get link quality level before the change
+ * \param[in]       cc: Event handle
+ * \return          Member of \ref esp_linkq_level_t enumeration
+ */
+esp_linkq_level_t
+esp_evt_linkq_get_level_prev(esp_evt_t* cc) {
+    return cc->evt.linkq.level_prev;
+}
+
+/**
+ * \brief           Get smoothed RSSI at the moment of level change
+ * \param[in]       cc: Event handle
+ * \return          RSSI value in units of dBm
+ */
+int16_t
+esp_evt_linkq_get_rssi(esp_evt_t* cc) {
+    return cc->evt.linkq.rssi;
+}
+
+#endif /* ESP_CFG_LINKQ || __DOXYGEN__ */
+
+#if ESP_CFG_PM || __DOXYGEN__
+
+/**
+ * \brief           Get result of sleep or wakeup command
+ * \param[in]       cc: Event handle
+ * \return          Member of \ref espr_t enumeration
+ */
+espr_t
+esp_evt_pm_get_result(esp_evt_t* cc) {
+    return cc->evt.pm.res;
+}
+
+/**
+ * \brief           Get active sleep mode
+ * \param[in]       cc: Event handle
+ * \return          Member of \ref esp_sleep_mode_t enumeration, \ref ESP_SLEEP_NONE when device is awake
+ */
+esp_sleep_mode_t
+esp_evt_pm_get_mode(esp_evt_t* cc) {
+    return cc->evt.pm.mode;
+}
+
+/**
+ * \brief           Get time device needed to wake up
+ * \param[in]       cc: Event handle
+ * \return          Wakeup time in units of milliseconds
+ */
+uint32_t
+esp_evt_pm_get_wakeup_time(esp_evt_t* cc) {
+    return cc->evt.pm.wakeup_time;
+}
+
+#endif /* ESP_CFG_PM || __DOXYGEN__ */
+
 
 /**
  * \brief           Get server command result
@@ -50,10 +50,35 @@ static uint32_t esp_recv_calls;
  */
 espr_t
 esp_input(const void* data, size_t len) {
+#if ESP_CFG_EVT_TIMESTAMP
+    uint32_t time = ESP_CFG_EVT_TIMESTAMP_NOW();
+    size_t written, next;
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+
     if (!esp.status.f.initialized || esp.buff.buff == NULL) {
         return espERR;
     }
+#if ESP_CFG_CAPTURE
+    espi_capture_recv(data, len);               /* Record received data */
+#endif /* ESP_CFG_CAPTURE */
+#if ESP_CFG_EVT_TIMESTAMP
+    written = esp_buff_write(&esp.buff, data, len); /* Write data to buffer */
+
+    /*
+     * Record arrival time for processing thread.
+     * Mark is added after data, processing thread may see data first
+     * and use current time for them instead.
+     */
+    esp.evt_ts.written += (uint32_t)written;
+    next = (esp.evt_ts.marks_w + 1) % ESP_CFG_EVT_TIMESTAMP_INPUT_MARKS;
+    if (written > 0 && next != esp.evt_ts.marks_r) {
+        esp.evt_ts.marks[esp.evt_ts.marks_w].end = esp.evt_ts.written;
+        esp.evt_ts.marks[esp.evt_ts.marks_w].time = time;
+        esp.evt_ts.marks_w = next;
+    }
+#else /* ESP_CFG_EVT_TIMESTAMP */
     esp_buff_write(&esp.buff, data, len);       /* Write data to buffer */
+#endif /* !ESP_CFG_EVT_TIMESTAMP */
     esp_sys_mbox_putnow(&esp.mbox_process, NULL);   /* Write empty box, don't care if write fails */
     esp_recv_total_len += len;                  /* Update total number of received bytes */
     ++esp_recv_calls;                           /* Update number of calls */
@@ -87,8 +112,22 @@ esp_input_process(const void* data, size_t len) {
     ++esp_recv_calls;                           /* Update number of calls */
 
     if (len > 0) {
+#if ESP_CFG_EVT_TIMESTAMP
+        uint32_t time = ESP_CFG_EVT_TIMESTAMP_NOW();    /* Arrival time, before waiting for core lock */
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+
         esp_core_lock();
+#if ESP_CFG_CAPTURE
+        espi_capture_recv(data, len);           /* Record received data */
+#endif /* ESP_CFG_CAPTURE */
+#if ESP_CFG_EVT_TIMESTAMP
+        esp.evt_ts.input_time = time;
+        esp.evt_ts.input_time_valid = 1;
+#endif /* ESP_CFG_EVT_TIMESTAMP */
         res = espi_process(data, len);          /* Process input data */
+#if ESP_CFG_EVT_TIMESTAMP
+        esp.evt_ts.input_time_valid = 0;
+#endif /* ESP_CFG_EVT_TIMESTAMP */
         esp_core_unlock();
     }
     return res;
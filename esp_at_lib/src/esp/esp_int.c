@@ -54,12 +54,19 @@ typedef struct {
 #define RECV_LEN()                          ((size_t)recv_buff.len)
 #define RECV_IDX(index)                     recv_buff.data[index]
 
+/* Low-level send, routed through capture tap when enabled */
+#if ESP_CFG_CAPTURE
+#define AT_PORT_LL_SEND(d, l)               espi_capture_send((d), (l))
+#else /* ESP_CFG_CAPTURE */
+#define AT_PORT_LL_SEND(d, l)               esp.ll.send_fn((d), (l))
+#endif /* !ESP_CFG_CAPTURE */
+
 /* Send data over AT port */
-#define AT_PORT_SEND_STR(str)               esp.ll.send_fn((const void *)(str), (size_t)strlen(str))
-#define AT_PORT_SEND_CONST_STR(str)         esp.ll.send_fn((const void *)(str), (size_t)(sizeof(str) - 1))
-#define AT_PORT_SEND_CHR(str)               esp.ll.send_fn((const void *)(str), (size_t)1)
-#define AT_PORT_SEND_FLUSH()                esp.ll.send_fn(NULL, 0)
-#define AT_PORT_SEND(d, l)                  esp.ll.send_fn((const void *)(d), (size_t)(l))
+#define AT_PORT_SEND_STR(str)               AT_PORT_LL_SEND((const void *)(str), (size_t)strlen(str))
+#define AT_PORT_SEND_CONST_STR(str)         AT_PORT_LL_SEND((const void *)(str), (size_t)(sizeof(str) - 1))
+#define AT_PORT_SEND_CHR(str)               AT_PORT_LL_SEND((const void *)(str), (size_t)1)
+#define AT_PORT_SEND_FLUSH()                AT_PORT_LL_SEND(NULL, 0)
+#define AT_PORT_SEND(d, l)                  AT_PORT_LL_SEND((const void *)(d), (size_t)(l))
 #define AT_PORT_SEND_WITH_FLUSH(d, l)       do { AT_PORT_SEND((d), (l)); AT_PORT_SEND_FLUSH(); } while (0)
 
 /* Beginning and end of every AT command */
@@ -90,6 +97,20 @@ static espr_t espi_process_sub_cmd(esp_msg_t* msg, uint8_t* is_ok, uint8_t* is_e
     }                                               \
 } while (0)
 
+#if ESP_CFG_LINKQ
+#define LINKQ_SEND_RESULT(err)      espi_linkq_send_result(err)
+#define LINKQ_WIFI_STATUS(c)        espi_linkq_wifi_status(c)
+#else /* ESP_CFG_LINKQ */
+#define LINKQ_SEND_RESULT(err)
+#define LINKQ_WIFI_STATUS(c)
+#endif /* !ESP_CFG_LINKQ */
+
+#if ESP_CFG_EVT_TIMESTAMP
+#define CONN_SEND_DATA_SEND_EVT_TIME(m)     esp.evt.evt.conn_data_send.time_queued = (m)->msg.conn_send.time_queued
+#else /* ESP_CFG_EVT_TIMESTAMP */
+#define CONN_SEND_DATA_SEND_EVT_TIME(m)
+#endif /* !ESP_CFG_EVT_TIMESTAMP */
+
 /**
  * \brief           Send connection callback for "data send"
  * \param[in]       m: Connection send message
@@ -101,7 +122,9 @@ static espr_t espi_process_sub_cmd(esp_msg_t* msg, uint8_t* is_ok, uint8_t* is_e
     esp.evt.evt.conn_data_send.res = err;           \
     esp.evt.evt.conn_data_send.conn = (m)->msg.conn_send.conn;  \
     esp.evt.evt.conn_data_send.sent = (m)->msg.conn_send.sent_all;   \
+    CONN_SEND_DATA_SEND_EVT_TIME(m);                \
     espi_send_conn_cb((m)->msg.conn_send.conn, NULL);   \
+    LINKQ_SEND_RESULT(err);                         \
 } while (0)
 
 /**
@@ -334,6 +357,10 @@ espi_reset_everything(uint8_t forced) {
      *          - Start over init procedure
      */
 
+#if ESP_CFG_IPD_ADAPTIVE
+    espi_ipd_flush();                           /* Send pending data before connections are closed */
+#endif /* ESP_CFG_IPD_ADAPTIVE */
+
     /* Step 1: Close all connections in memory */
     reset_connections(forced);
 
@@ -341,10 +368,15 @@ espi_reset_everything(uint8_t forced) {
     esp.m.sta.has_ip = 0;
     if (esp.m.sta.is_connected) {
         espi_send_cb(ESP_EVT_WIFI_DISCONNECTED);
+        esp.m.sta.is_connected = 0;
+        LINKQ_WIFI_STATUS(0);
     }
-    esp.m.sta.is_connected = 0;
 #endif /* ESP_CFG_MODE_STATION */
 
+#if ESP_CFG_PM
+    espi_pm_reset();
+#endif /* ESP_CFG_PM */
+
     /* Check if IPD active */
     if (esp.m.ipd.buff != NULL) {
         esp_pbuf_free(esp.m.ipd.buff);
@@ -373,6 +405,31 @@ espi_reset_everything(uint8_t forced) {
     }
 }
 
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+
+/**
+ * \brief           Get arrival time of input data currently being processed
+ * \return          Arrival time or current time when no input data are processed
+ */
+uint32_t
+espi_evt_input_time(void) {
+    return esp.evt_ts.input_time_valid ? esp.evt_ts.input_time : ESP_CFG_EVT_TIMESTAMP_NOW();
+}
+
+/**
+ * \brief           Set sequence number and timestamps of event before dispatch
+ * \note            Core must be locked before calling this function
+ * \param[in]       evt: Event to dispatch
+ */
+void
+espi_evt_stamp(esp_evt_t* evt) {
+    evt->seq = ++esp.evt_ts.seq;
+    evt->time_dispatch = ESP_CFG_EVT_TIMESTAMP_NOW();
+    evt->time_input = esp.evt_ts.input_time_valid ? esp.evt_ts.input_time : evt->time_dispatch;
+}
+
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
+
 /**
  * \brief           Process callback function to user with specific type
  * \param[in]       type: Callback event type
@@ -381,6 +438,7 @@ espi_reset_everything(uint8_t forced) {
 espr_t
 espi_send_cb(esp_evt_type_t type) {
     esp.evt.type = type;                        /* Set callback type to process */
+    ESP_EVT_STAMP(&esp.evt);
 
     /* Call callback function for all registered functions */
     for (esp_evt_func_t* link = esp.evt_func; link != NULL; link = link->next) {
@@ -401,6 +459,7 @@ espi_send_conn_cb(esp_conn_t* conn, esp_evt_fn evt) {
     if (conn->status.f.in_closing && esp.evt.type != ESP_EVT_CONN_CLOSE) {  /* Do not continue if in closing mode */
         /* return espOK; */
     }
+    ESP_EVT_STAMP(&esp.evt);
 
     if (evt != NULL) {                          /* Try with user connection */
         return evt(&esp.evt);                   /* Call temporary function */
@@ -426,6 +485,68 @@ espi_send_conn_cb(esp_conn_t* conn, esp_evt_fn evt) {
     return esp_conn_close(conn, 0);
 }
 
+#if ESP_CFG_CONN_ADAPTIVE_CHUNK || __DOXYGEN__
+
+/**
+ * \brief           Get chunk size for next `AT+CIPSEND` command on connection
+ * \param[in]       c: Connection handle
+ * \return          Chunk size in units of bytes
+ */
+static size_t
+espi_conn_chunk_size(esp_conn_t* c) {
+    size_t min = ESP_MIN((size_t)ESP_CFG_CONN_ADAPTIVE_CHUNK_MIN, esp.cfg.conn_max_data_len);
+
+    if (c->chunk.stats.size == 0 || c->chunk.stats.size > esp.cfg.conn_max_data_len) {
+        c->chunk.stats.size = esp.cfg.conn_max_data_len;    /* Start optimistic or follow runtime change */
+    } else if (c->chunk.stats.size < min) {
+        c->chunk.stats.size = min;
+    }
+    return c->chunk.stats.size;
+}
+
+/**
+ * \brief           Update chunk size after chunk was sent or failed
+ * \param[in]       c: Connection handle
+ * \param[in]       len: Number of bytes in chunk
+ * \param[in]       sent: Set to `1` when chunk was sent, `0` on failure
+ * \param[in]       time: Time between data write and `SEND OK` in units of milliseconds,
+ *                      `0` when not known
+ */
+static void
+espi_conn_chunk_update(esp_conn_t* c, size_t len, uint8_t sent, uint32_t time) {
+    esp_conn_chunk_stats_t* st = &c->chunk.stats;
+    size_t size = espi_conn_chunk_size(c);
+    size_t min = ESP_MIN((size_t)ESP_CFG_CONN_ADAPTIVE_CHUNK_MIN, esp.cfg.conn_max_data_len);
+    uint8_t slow = 0;
+
+    if (sent && time > 0 && len > 0) {
+        uint32_t per_kb = (uint32_t)(((uint64_t)time * 1024) / len);
+
+        /* Module retransmits on degrading link, time per byte rises before send fails */
+        slow = st->time_per_kb > 0 && per_kb > 2 * st->time_per_kb + 2;
+        st->time_per_kb = st->time_per_kb > 0 ? (st->time_per_kb * 7 + per_kb) / 8 : per_kb;
+    }
+    if (!sent || slow) {
+        if (!sent) {
+            ++st->fails;
+        }
+        size = ESP_MAX(sent ? size - size / 4 : size / 2, min); /* Halve on failure, reduce less when slow */
+        c->chunk.ok_cnt = 0;
+        if (size < st->size) {
+            st->size = size;
+            ++st->shrinks;
+        }
+    } else if (++c->chunk.ok_cnt >= 4) {
+        c->chunk.ok_cnt = 0;
+        if (size < esp.cfg.conn_max_data_len) { /* Probe upward */
+            st->size = ESP_MIN(size + ESP_MAX(size / 4, (size_t)ESP_CFG_CONN_ADAPTIVE_CHUNK_MIN / 2), esp.cfg.conn_max_data_len);
+            ++st->grows;
+        }
+    }
+}
+
+#endif /* ESP_CFG_CONN_ADAPTIVE_CHUNK || __DOXYGEN__ */
+
 /**
  * \brief           Process and send data from device buffer
  * \return          Member of \ref espr_t enumeration
@@ -440,7 +561,30 @@ espi_tcpip_process_send_data(void) {
         CONN_SEND_DATA_SEND_EVT(esp.msg, espCLOSED);
         return espERR;
     }
-    esp.msg->msg.conn_send.sent = ESP_MIN(esp.msg->msg.conn_send.btw, ESP_CFG_CONN_MAX_DATA_LEN);
+#if ESP_CFG_CONN_ADAPTIVE_CHUNK
+    esp.msg->msg.conn_send.sent = ESP_MIN(esp.msg->msg.conn_send.btw, espi_conn_chunk_size(c));
+#else /* ESP_CFG_CONN_ADAPTIVE_CHUNK */
+    esp.msg->msg.conn_send.sent = ESP_MIN(esp.msg->msg.conn_send.btw, esp.cfg.conn_max_data_len);
+#endif /* !ESP_CFG_CONN_ADAPTIVE_CHUNK */
+
+#if ESP_CFG_CONN_SENDBUF
+    /* Buffered send is only available for TCP connections on supported firmware */
+    esp.msg->msg.conn_send.buffered = c->type == ESP_CONN_TYPE_TCP
+                                        && esp.m.device != ESP_DEVICE_ESP32
+                                        && !esp.m.sendbuf_unsupported;
+    if (esp.msg->msg.conn_send.buffered) {
+        if (c->sendbuf.pending >= ESP_CFG_CONN_SENDBUF_SEGMENTS) {
+            esp.msg->msg.conn_send.wait_segment = 1;/* Continue when module reports next segment as sent */
+            return espOK;
+        }
+        AT_PORT_SEND_BEGIN_AT();
+        AT_PORT_SEND_CONST_STR("+CIPSENDBUF=");
+        espi_send_number(ESP_U32(c->num), 0, 0);/* Send connection number */
+        espi_send_number(ESP_U32(esp.msg->msg.conn_send.sent), 0, 1);   /* Send length number */
+        AT_PORT_SEND_END_AT();
+        return espOK;
+    }
+#endif /* ESP_CFG_CONN_SENDBUF */
 
     AT_PORT_SEND_BEGIN_AT();
     AT_PORT_SEND_CONST_STR("+CIPSEND=");
@@ -466,6 +610,16 @@ espi_tcpip_process_send_data(void) {
  */
 static uint8_t
 espi_tcpip_process_data_sent(uint8_t sent) {
+#if ESP_CFG_CONN_ADAPTIVE_CHUNK
+    uint32_t time = esp_sys_now() - esp.msg->msg.conn_send.time_sent;
+
+#if ESP_CFG_CONN_SENDBUF
+    if (esp.msg->msg.conn_send.buffered) {
+        time = 0;                               /* Buffered data are only accepted to module, time is not relevant */
+    }
+#endif /* ESP_CFG_CONN_SENDBUF */
+    espi_conn_chunk_update(esp.msg->msg.conn_send.conn, esp.msg->msg.conn_send.sent, sent, time);
+#endif /* ESP_CFG_CONN_ADAPTIVE_CHUNK */
     if (sent) {                                 /* Data were successfully sent */
         esp.msg->msg.conn_send.sent_all += esp.msg->msg.conn_send.sent;
         esp.msg->msg.conn_send.btw -= esp.msg->msg.conn_send.sent;
@@ -476,6 +630,9 @@ espi_tcpip_process_data_sent(uint8_t sent) {
         esp.msg->msg.conn_send.tries = 0;
     } else {                                    /* We were not successful */
         ++esp.msg->msg.conn_send.tries;         /* Increase number of tries */
+#if ESP_CFG_LINKQ
+        espi_linkq_send_retry();
+#endif /* ESP_CFG_LINKQ */
         if (esp.msg->msg.conn_send.tries == ESP_CFG_MAX_SEND_RETRIES) { /* In case we reached max number of retransmissions */
             return 1;                           /* Return 1 and indicate error */
         }
@@ -489,6 +646,48 @@ espi_tcpip_process_data_sent(uint8_t sent) {
     return 1;                                   /* Everything was sent, we can stop execution */
 }
 
+#if ESP_CFG_CONN_SENDBUF || __DOXYGEN__
+
+/**
+ * \brief           Process asynchronous `<link>,<segment>,SEND OK` or `<link>,<segment>,SEND FAIL` report
+ * \param[in]       str: Received string starting with connection number
+ * \param[in]       sent: Set to `1` for `SEND OK`, `0` for `SEND FAIL`
+ * \return          `1` if data send command waits for this segment and shall continue, `0` otherwise
+ */
+static uint8_t
+espi_tcpip_process_sendbuf_segment(const char* str, uint8_t sent) {
+    esp_conn_t* c;
+    uint32_t num, seg;
+
+    num = espi_parse_number(&str);              /* Parse connection number */
+    seg = espi_parse_number(&str);              /* Parse segment ID */
+    if (num >= ESP_CFG_MAX_CONNS) {
+        return 0;
+    }
+    c = &esp.m.conns[num];
+    if (c->sendbuf.pending > 0) {
+        --c->sendbuf.pending;
+    }
+    if (!sent) {
+#if ESP_CFG_CONN_ADAPTIVE_CHUNK
+        espi_conn_chunk_update(c, 0, 0, 0);
+#endif /* ESP_CFG_CONN_ADAPTIVE_CHUNK */
+        ESP_DEBUGF(ESP_CFG_DBG_CONN | ESP_DBG_TYPE_TRACE | ESP_DBG_LVL_WARNING,
+            "[CONN] Segment %d on connection %d failed\r\n", (int)seg, (int)num);
+
+        /* Data were already reported as sent, notify application separately */
+        esp.evt.type = ESP_EVT_CONN_SEND_FAIL;
+        esp.evt.evt.conn_send_fail.conn = c;
+        esp.evt.evt.conn_send_fail.seg_id = seg;
+        espi_send_conn_cb(c, NULL);
+    }
+
+    /* Check if send command waits for free segment on this connection */
+    return CMD_IS_CUR(ESP_CMD_TCPIP_CIPSEND) && esp.msg->msg.conn_send.conn == c && esp.msg->msg.conn_send.wait_segment;
+}
+
+#endif /* ESP_CFG_CONN_SENDBUF || __DOXYGEN__ */
+
 /**
  * \brief           Send error event to application layer
  * \param[in]       msg: Message from user with connection start
@@ -504,6 +703,7 @@ espi_send_conn_error_cb(esp_msg_t* msg, espr_t error) {
     esp.evt.evt.conn_error.err = error;
 
     /* Call callback specified by user on connection startup */
+    ESP_EVT_STAMP(&esp.evt);
     esp.msg->msg.conn_start.evt_func(&esp.evt);
     ESP_UNUSED(msg);
 }
@@ -719,6 +919,7 @@ espi_parse_received(esp_recv_t* rcv) {
         if (!strncmp(&rcv->data[5], "CONNECTED", 9)) {
             esp.m.sta.is_connected = 1;         /* Wifi is connected */
             espi_send_cb(ESP_EVT_WIFI_CONNECTED);   /* Call user callback function */
+            LINKQ_WIFI_STATUS(1);
             if (!CMD_IS_CUR(ESP_CMD_WIFI_CWJAP)) {  /* In case of auto connection */
                 esp_sta_getip(NULL, NULL, NULL, NULL, NULL, 0);  /* Get new IP address */
             }
@@ -726,6 +927,7 @@ espi_parse_received(esp_recv_t* rcv) {
             esp.m.sta.is_connected = 0;         /* Wifi is disconnected */
             esp.m.sta.has_ip = 0;               /* There is no valid IP */
             espi_send_cb(ESP_EVT_WIFI_DISCONNECTED);/* Call user callback function */
+            LINKQ_WIFI_STATUS(0);
         } else if (!strncmp(&rcv->data[5], "GOT IP", 6)) {
             esp.m.sta.has_ip = 1;               /* Wifi got IP address */
             espi_send_cb(ESP_EVT_WIFI_GOT_IP);  /* Call user callback function */
@@ -806,6 +1008,51 @@ espi_parse_received(esp_recv_t* rcv) {
             if (is_ok) {                        /* Check for OK and clear as we have to check for "> " statement after OK */
                 is_ok = 0;                      /* Do not reach on OK */
             }
+#if ESP_CFG_CONN_SENDBUF
+            if (esp.msg->msg.conn_send.buffered) {
+                esp_conn_t* c = esp.msg->msg.conn_send.conn;
+                if (esp.msg->msg.conn_send.wait_send_ok_err) {
+                    if (!strncmp("Recv ", rcv->data, 5)) {  /* Data were accepted to module buffer */
+                        esp.msg->msg.conn_send.wait_send_ok_err = 0;
+                        esp.m.sendbuf_ok = 1;
+                        ++c->sendbuf.pending;
+                        is_ok = espi_tcpip_process_data_sent(1);
+                        if (is_ok && c->status.f.active) {
+                            CONN_SEND_DATA_SEND_EVT(esp.msg, espOK);
+                        }
+                    } else if (is_error) {
+                        esp.msg->msg.conn_send.wait_send_ok_err = 0;
+                        is_error = espi_tcpip_process_data_sent(0);
+                        if (is_error && c->status.f.active) {
+                            CONN_SEND_DATA_SEND_EVT(esp.msg, espERR);
+                        }
+                    }
+                } else if (!strncmp("busy", rcv->data, 4)) {
+                    esp.msg->msg.conn_send.busy = 1;/* Module buffer is full */
+                } else if (!strncmp("link is not valid", rcv->data, 17)) {
+                    esp.msg->msg.conn_send.link_invalid = 1;
+                } else if (is_error) {
+                    if (esp.msg->msg.conn_send.busy) {
+                        esp.msg->msg.conn_send.busy = 0;
+                        if (c->sendbuf.pending > 0) {
+                            esp.msg->msg.conn_send.wait_segment = 1;/* Retry after next SEND OK */
+                            is_error = 0;
+                        } else {
+                            is_error = espi_tcpip_process_data_sent(0);
+                        }
+                    } else if (!esp.m.sendbuf_ok && !esp.msg->msg.conn_send.link_invalid && c->status.f.active) {
+                        /* Plain ERROR without reason on first use, firmware does not know the command */
+                        ESP_DEBUGF(ESP_CFG_DBG_CONN | ESP_DBG_TYPE_TRACE | ESP_DBG_LVL_WARNING,
+                            "[CONN] AT+CIPSENDBUF not supported, using AT+CIPSEND\r\n");
+                        esp.m.sendbuf_unsupported = 1;
+                        is_error = espi_tcpip_process_send_data() != espOK;
+                    }
+                    if (is_error && c->status.f.active) {
+                        CONN_SEND_DATA_SEND_EVT(esp.msg, espERR);
+                    }
+                }
+            } else
+#endif /* ESP_CFG_CONN_SENDBUF */
             if (esp.msg->msg.conn_send.wait_send_ok_err) {
                 if (!strncmp("SEND OK", rcv->data, 7)) {    /* Data were sent successfully */
                     esp.msg->msg.conn_send.wait_send_ok_err = 0;
@@ -929,9 +1176,19 @@ espi_parse_received(esp_recv_t* rcv) {
                     if (esp.msg->msg.conn_send.conn == conn) {
                         /** \todo: Find better idea to handle what to do in this case */
                         //is_error = 1;           /* Set as error to stop processing or waiting for connection */
+#if ESP_CFG_CONN_SENDBUF
+                        if (esp.msg->msg.conn_send.wait_segment) {
+                            esp.msg->msg.conn_send.wait_segment = 0;
+                            CONN_SEND_DATA_SEND_EVT(esp.msg, espCLOSED);
+                            is_error = 1;       /* Segment will never be reported, stop waiting */
+                        }
+#endif /* ESP_CFG_CONN_SENDBUF */
                     }
                 }
             }
+#if ESP_CFG_CONN_SENDBUF
+            conn->sendbuf.pending = 0;          /* Module drops queued segments */
+#endif /* ESP_CFG_CONN_SENDBUF */
 
             /* Check if write buffer is set */
             if (conn->buff.buff != NULL) {
@@ -940,6 +1197,16 @@ espi_parse_received(esp_recv_t* rcv) {
                 esp_mem_free_s((void **)&conn->buff.buff);
             }
         }
+#if ESP_CFG_CONN_SENDBUF
+    } else if (rcv->len > 11 && ESP_CHARISNUM(rcv->data[0])
+                && ((s = strstr(rcv->data, ",SEND OK" CRLF)) != NULL || (s = strstr(rcv->data, ",SEND FAIL" CRLF)) != NULL)) {
+        if (espi_tcpip_process_sendbuf_segment(rcv->data, s[6] == 'O')) {
+            esp.msg->msg.conn_send.wait_segment = 0;
+            if (espi_tcpip_process_send_data() != espOK) {  /* Queue next segment */
+                is_error = 1;                   /* Connection closed, event was already sent */
+            }
+        }
+#endif /* ESP_CFG_CONN_SENDBUF */
     } else if (is_error && CMD_IS_CUR(ESP_CMD_TCPIP_CIPSTART)) {
         /*
          * Notify user about failed connection,
@@ -985,6 +1252,53 @@ espi_parse_received(esp_recv_t* rcv) {
 }
 
 #if !ESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+
+/**
+ * \brief           Set arrival time for next data from input buffer
+ * \param[in]       len: Number of bytes available for processing, must be greater than `0`
+ * \return          Number of bytes received with single \ref esp_input call, to process with this arrival time.
+ *                      Never `0` when `len` is greater than `0`
+ */
+static size_t
+input_time_begin(size_t len) {
+    esp_evt_ts_t* ts = &esp.evt_ts;
+    size_t r = ts->marks_r;
+
+    /* Skip marks of already processed data, they would limit length to zero */
+    while (r != ts->marks_w && (int32_t)(ts->marks[r].end - ts->processed) <= 0) {
+        r = (r + 1) % ESP_CFG_EVT_TIMESTAMP_INPUT_MARKS;
+    }
+    ts->marks_r = r;
+    if (r != ts->marks_w) {
+        len = ESP_MIN(len, (size_t)(ts->marks[r].end - ts->processed));
+        ts->input_time = ts->marks[r].time;
+    } else {
+        ts->input_time = ESP_CFG_EVT_TIMESTAMP_NOW();   /* Mark not written yet */
+    }
+    ts->input_time_valid = 1;
+    return len;
+}
+
+/**
+ * \brief           Release arrival times of processed data
+ * \param[in]       len: Number of processed bytes
+ */
+static void
+input_time_end(size_t len) {
+    esp_evt_ts_t* ts = &esp.evt_ts;
+    size_t r = ts->marks_r;
+
+    ts->processed += (uint32_t)len;
+    while (r != ts->marks_w && (int32_t)(ts->marks[r].end - ts->processed) <= 0) {
+        r = (r + 1) % ESP_CFG_EVT_TIMESTAMP_INPUT_MARKS;
+    }
+    ts->marks_r = r;
+    ts->input_time_valid = 0;
+}
+
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
+
 /**
  * \brief           Process data from input buffer
  * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
@@ -1006,6 +1320,9 @@ espi_process_buffer(void) {
              * in linear block of data to process
              */
             data = esp_buff_get_linear_block_read_address(&esp.buff);
+#if ESP_CFG_EVT_TIMESTAMP
+            len = input_time_begin(len);        /* Process data of single input at a time */
+#endif /* ESP_CFG_EVT_TIMESTAMP */
 
             /* Process actual received data */
             espi_process(data, len);
@@ -1015,12 +1332,142 @@ espi_process_buffer(void) {
              * the buffer memory and start over
              */
             esp_buff_skip(&esp.buff, len);
+#if ESP_CFG_EVT_TIMESTAMP
+            input_time_end(len);
+#endif /* ESP_CFG_EVT_TIMESTAMP */
         }
     } while (len);
     return espOK;
 }
 #endif /* !ESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__ */
 
+/**
+ * \brief           Send received packet buffer to application and release library reference
+ * \param[in]       conn: Connection handle data were received on
+ * \param[in]       pbuf: Packet buffer with received data
+ * \return          Result of connection callback function
+ */
+static espr_t
+ipd_send_buff(esp_conn_p conn, esp_pbuf_p pbuf) {
+    espr_t res;
+#if ESP_CFG_CONN_MANUAL_TCP_RECEIVE
+    size_t pbuf_len;
+
+    pbuf_len = esp_pbuf_length(pbuf, 1);
+    conn->tcp_not_ack_bytes += pbuf_len;
+    if (conn->tcp_available_bytes >= pbuf_len) {
+        conn->tcp_available_bytes -= pbuf_len;
+    }
+#endif /* ESP_CFG_CONN_MANUAL_TCP_RECEIVE */
+
+    conn->total_recved += pbuf->tot_len;        /* Increase number of bytes received */
+#if ESP_CFG_CONN_RATE_LIMIT
+    espi_conn_rate_charge(conn, 1, pbuf->tot_len);
+#endif /* ESP_CFG_CONN_RATE_LIMIT */
+
+    /*
+     * Send data buffer to upper layer
+     *
+     * From this moment, user is responsible for packet
+     * buffer and must free it manually
+     */
+#if ESP_CFG_EVT_TIMESTAMP
+    pbuf->time_dispatch = ESP_CFG_EVT_TIMESTAMP_NOW();
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+    esp.evt.type = ESP_EVT_CONN_RECV;
+    esp.evt.evt.conn_data_recv.buff = pbuf;
+    esp.evt.evt.conn_data_recv.conn = conn;
+    res = espi_send_conn_cb(conn, NULL);
+
+    esp_pbuf_free(pbuf);                        /* Free packet buffer at this point */
+    ESP_DEBUGF(ESP_CFG_DBG_IPD | ESP_DBG_TYPE_TRACE,
+        "[IPD] Free packet buffer\r\n");
+    return res;
+}
+
+#if ESP_CFG_IPD_ADAPTIVE || __DOXYGEN__
+
+/**
+ * \brief           Send pending coalesced packet buffer to application
+ */
+static void
+ipd_coal_send(void) {
+    esp_pbuf_p pbuf = esp.m.ipd.coal_buff;
+
+    if (pbuf == NULL) {
+        return;
+    }
+    esp.m.ipd.coal_buff = NULL;
+    esp_pbuf_set_length(pbuf, esp.m.ipd.coal_used);  /* Buffer may be larger than received data */
+    ipd_send_buff(esp.m.ipd.coal_conn, pbuf);
+}
+
+/**
+ * \brief           Send pending received data to application and finish current burst
+ *
+ * Number of bytes received in finished burst is used
+ * to size packet buffers of next burst on the same connection
+ */
+void
+espi_ipd_flush(void) {
+    esp_conn_p conn = esp.m.ipd.run_conn;
+
+    ipd_coal_send();
+    if (conn != NULL) {
+        if (conn->ipd_burst_avg == 0) {
+            conn->ipd_burst_avg = esp.m.ipd.run_len;
+        } else {
+            conn->ipd_burst_avg = (3 * conn->ipd_burst_avg + esp.m.ipd.run_len) / 4;
+        }
+        esp.m.ipd.run_conn = NULL;
+        esp.m.ipd.run_len = 0;
+    }
+}
+
+/**
+ * \brief           Get packet buffer for new `+IPD` data
+ *
+ * Pending buffer is reused when it has enough free space for entire packet.
+ * Otherwise new buffer is allocated, large enough for expected remaining data of current burst.
+ *
+ * \param[in]       len: Number of bytes to read in first buffer, already limited to maximal buffer size
+ * \return          Packet buffer, with \ref esp_ipd_t.buff_ptr set to first free byte, or `NULL` on failure
+ */
+static esp_pbuf_p
+ipd_get_buff(size_t len) {
+    esp_conn_p conn = esp.m.ipd.conn;
+    esp_pbuf_p pbuf;
+    size_t size, done;
+
+    /* Store to pending buffer if complete packet fits */
+    if (esp.m.ipd.coal_buff != NULL && esp.m.ipd.coal_conn == conn
+        && esp.m.ipd.tot_len <= esp.m.ipd.coal_buff->len - esp.m.ipd.coal_used) {
+        pbuf = esp.m.ipd.coal_buff;
+        esp.m.ipd.coal_buff = NULL;
+        esp.m.ipd.buff_ptr = esp.m.ipd.coal_used;
+        ++esp.ipd_stats.coalesced;
+        return pbuf;
+    }
+    ipd_coal_send();
+
+    /* Expect remaining data of typical burst on this connection */
+    size = len;
+    done = esp.m.ipd.run_len - esp.m.ipd.tot_len;
+    if (conn->type != ESP_CONN_TYPE_UDP && conn->ipd_burst_avg > done + size) {
+        size = ESP_MIN(conn->ipd_burst_avg - done, esp.cfg.conn_max_recv_buff_size);
+    }
+    pbuf = esp_pbuf_new(size);
+    if (pbuf == NULL && size > len) {
+        pbuf = esp_pbuf_new(len);               /* Retry with exact length on low memory */
+    }
+    if (pbuf != NULL) {
+        ++esp.ipd_stats.allocs;
+    }
+    return pbuf;
+}
+
+#endif /* ESP_CFG_IPD_ADAPTIVE || __DOXYGEN__ */
+
 /**
  * \brief           Process input data received from ESP device
  * \param[in]       data: Pointer to data to process
@@ -1039,6 +1486,11 @@ espi_process(const void* data, size_t data_len) {
     if (!esp.status.f.dev_present) {
         return espERRNODEVICE;
     }
+#if ESP_CFG_PM
+    if (d_len > 0) {
+        espi_pm_activity();                     /* Received data reset idle time */
+    }
+#endif /* ESP_CFG_PM */
 
     while (d_len > 0) {                         /* Read entire set of characters from buffer */
         ch = *d;                                /* Get next character */
@@ -1083,36 +1535,25 @@ espi_process(const void* data, size_t data_len) {
 
                 /* Call user callback function with received data */
                 if (esp.m.ipd.buff != NULL) {     /* Do we have valid buffer? */
-#if ESP_CFG_CONN_MANUAL_TCP_RECEIVE
-                    size_t pbuf_len;
-
-                    pbuf_len = esp_pbuf_length(esp.m.ipd.buff, 1);
-                    esp.m.ipd.conn->tcp_not_ack_bytes += pbuf_len;
-                    if (esp.m.ipd.conn->tcp_available_bytes >= pbuf_len) {
-                        esp.m.ipd.conn->tcp_available_bytes -= pbuf_len;
-                    }
-#endif /* ESP_CFG_CONN_MANUAL_TCP_RECEIVE */
-
-                    esp.m.ipd.conn->total_recved += esp.m.ipd.buff->tot_len;  /* Increase number of bytes received */
-                    
-                    /*
-                     * Send data buffer to upper layer
-                     *
-                     * From this moment, user is responsible for packet
-                     * buffer and must free it manually
-                     */
-                    esp.evt.type = ESP_EVT_CONN_RECV;
-                    esp.evt.evt.conn_data_recv.buff = esp.m.ipd.buff;
-                    esp.evt.evt.conn_data_recv.conn = esp.m.ipd.conn;
-                    res = espi_send_conn_cb(esp.m.ipd.conn, NULL);
-
-                    esp_pbuf_free(esp.m.ipd.buff);  /* Free packet buffer at this point */
-                    ESP_DEBUGF(ESP_CFG_DBG_IPD | ESP_DBG_TYPE_TRACE,
-                        "[IPD] Free packet buffer\r\n");
-                    if (res == espOKIGNOREMORE) {   /* We should ignore more data */
-                        ESP_DEBUGF(ESP_CFG_DBG_IPD | ESP_DBG_TYPE_TRACE,
-                            "[IPD] Ignoring more data from this IPD if available\r\n");
-                        esp.m.ipd.buff = NULL;  /* Set to NULL to ignore more data if possibly available */
+#if ESP_CFG_EVT_TIMESTAMP
+                    esp.m.ipd.buff->time_input = espi_evt_input_time(); /* Time of last byte */
+#endif /* ESP_CFG_EVT_TIMESTAMP */
+#if ESP_CFG_IPD_ADAPTIVE
+                    /* Keep TCP buffer with free space for next packet on the same connection */
+                    if (esp.m.ipd.rem_len == 0 && esp.m.ipd.buff_ptr < esp.m.ipd.buff->len
+                        && esp.m.ipd.conn->type != ESP_CONN_TYPE_UDP) {
+                        esp.m.ipd.coal_buff = esp.m.ipd.buff;
+                        esp.m.ipd.coal_conn = esp.m.ipd.conn;
+                        esp.m.ipd.coal_used = esp.m.ipd.buff_ptr;
+                    } else
+#endif /* ESP_CFG_IPD_ADAPTIVE */
+                    {
+                        res = ipd_send_buff(esp.m.ipd.conn, esp.m.ipd.buff);
+                        if (res == espOKIGNOREMORE) {   /* We should ignore more data */
+                            ESP_DEBUGF(ESP_CFG_DBG_IPD | ESP_DBG_TYPE_TRACE,
+                                "[IPD] Ignoring more data from this IPD if available\r\n");
+                            esp.m.ipd.buff = NULL;  /* Set to NULL to ignore more data if possibly available */
+                        }
                     }
 
                     /*
@@ -1122,7 +1563,7 @@ espi_process(const void* data, size_t data_len) {
                      *  - Connection is not in closing state
                      */
                     if (esp.m.ipd.buff != NULL && esp.m.ipd.rem_len > 0 && !esp.m.ipd.conn->status.f.in_closing) {
-                        size_t new_len = ESP_MIN(esp.m.ipd.rem_len, ESP_CFG_CONN_MAX_RECV_BUFF_SIZE);   /* Calculate new buffer length */
+                        size_t new_len = ESP_MIN(esp.m.ipd.rem_len, esp.cfg.conn_max_recv_buff_size);   /* Calculate new buffer length */
 
                         ESP_DEBUGF(ESP_CFG_DBG_IPD | ESP_DBG_TYPE_TRACE,
                             "[IPD] Allocating new packet buffer of size: %d bytes\r\n", (int)new_len);
@@ -1132,7 +1573,10 @@ espi_process(const void* data, size_t data_len) {
                             esp.m.ipd.buff == NULL, "[IPD] Buffer allocation failed for %d bytes\r\n", (int)new_len);
 
                         if (esp.m.ipd.buff != NULL) {
+                            ++esp.ipd_stats.allocs;
                             esp_pbuf_set_ip(esp.m.ipd.buff, &esp.m.ipd.ip, esp.m.ipd.port); /* Set IP and port for received data */
+                        } else {
+                            ++esp.ipd_stats.failed;
                         }
                     } else {
                         esp.m.ipd.buff = NULL;  /* Reset it */
@@ -1171,6 +1615,11 @@ espi_process(const void* data, size_t data_len) {
                     switch (ch) {
                         case '\n':
                             RECV_ADD(ch);       /* Add character to input buffer */
+#if ESP_CFG_IPD_ADAPTIVE
+                            if (RECV_LEN() > CRLF_LEN) {
+                                espi_ipd_flush();   /* Deliver received data before processing next message */
+                            }
+#endif /* ESP_CFG_IPD_ADAPTIVE */
                             espi_parse_received(&recv_buff);/* Parse received string */
                             RECV_RESET();       /* Reset received string */
                             break;
@@ -1187,6 +1636,9 @@ espi_process(const void* data, size_t data_len) {
                             /* Now actually send the data prepared before */
                             AT_PORT_SEND_WITH_FLUSH(&esp.msg->msg.conn_send.data[esp.msg->msg.conn_send.ptr], esp.msg->msg.conn_send.sent);
                             esp.msg->msg.conn_send.wait_send_ok_err = 1;    /* Now we are waiting for "SEND OK" or "SEND ERROR" */
+#if ESP_CFG_CONN_ADAPTIVE_CHUNK
+                            esp.msg->msg.conn_send.time_sent = esp_sys_now();
+#endif /* ESP_CFG_CONN_ADAPTIVE_CHUNK */
                         }
                     }
 
@@ -1233,7 +1685,16 @@ espi_process(const void* data, size_t data_len) {
                                 "[IPD] Data on connection %d with total size %d byte(s)\r\n",
                                 (int)esp.m.ipd.conn->num, (int)esp.m.ipd.tot_len);
 
-                            len = ESP_MIN(esp.m.ipd.rem_len, ESP_CFG_CONN_MAX_RECV_BUFF_SIZE);
+                            len = ESP_MIN(esp.m.ipd.rem_len, esp.cfg.conn_max_recv_buff_size);
+                            ++esp.ipd_stats.packets;
+                            esp.m.ipd.buff_ptr = 0; /* Reset buffer write pointer */
+#if ESP_CFG_IPD_ADAPTIVE
+                            if (esp.m.ipd.run_conn != esp.m.ipd.conn) {
+                                espi_ipd_flush();   /* Data on another connection finish current burst */
+                                esp.m.ipd.run_conn = esp.m.ipd.conn;
+                            }
+                            esp.m.ipd.run_len += esp.m.ipd.tot_len;
+#endif /* ESP_CFG_IPD_ADAPTIVE */
 
                             /*
                              * Read received data in case of:
@@ -1242,9 +1703,18 @@ espi_process(const void* data, size_t data_len) {
                              *  - Connection is not in closing mode
                              */
                             if (esp.m.ipd.conn->status.f.active && !esp.m.ipd.conn->status.f.in_closing) {
+#if ESP_CFG_IPD_ADAPTIVE
+                                esp.m.ipd.buff = ipd_get_buff(len); /* Get new or partially used packet buffer */
+#else /* ESP_CFG_IPD_ADAPTIVE */
                                 esp.m.ipd.buff = esp_pbuf_new(len); /* Allocate new packet buffer */
+                                if (esp.m.ipd.buff != NULL) {
+                                    ++esp.ipd_stats.allocs;
+                                }
+#endif /* !ESP_CFG_IPD_ADAPTIVE */
                                 if (esp.m.ipd.buff != NULL) {
                                     esp_pbuf_set_ip(esp.m.ipd.buff, &esp.m.ipd.ip, esp.m.ipd.port); /* Set IP and port for received data */
+                                } else {
+                                    ++esp.ipd_stats.failed;
                                 }
                                 ESP_DEBUGW(ESP_CFG_DBG_IPD | ESP_DBG_TYPE_TRACE | ESP_DBG_LVL_WARNING, esp.m.ipd.buff == NULL,
                                     "[IPD] Buffer allocation failed for %d byte(s)\r\n", (int)len);
@@ -1255,7 +1725,6 @@ espi_process(const void* data, size_t data_len) {
                                     (int)esp.m.ipd.conn->num, (int)len);
                             }
                             esp.m.ipd.conn->status.f.data_received = 1; /* We have first received data */
-                            esp.m.ipd.buff_ptr = 0; /* Reset buffer write pointer */
                         }
                         RECV_RESET();           /* Reset received buffer */
                     }
@@ -1277,6 +1746,9 @@ espi_process(const void* data, size_t data_len) {
         ch_prev2 = ch_prev1;                    /* Save previous character as previous previous */
         ch_prev1 = ch;                          /* Set current as previous */
     }
+#if ESP_CFG_IPD_ADAPTIVE
+    espi_ipd_flush();                           /* Do not keep received data after input block is processed */
+#endif /* ESP_CFG_IPD_ADAPTIVE */
     return espOK;
 }
 
@@ -1300,6 +1772,35 @@ espi_process(const void* data, size_t data_len) {
     }                                           \
 } while (0)
 
+/**
+ * \brief           Check if remote IP and port should be included in `+IPD` statement
+ * \param[in]       msg: Pointer to current message
+ * \return          `1` if information is required, `0` otherwise
+ */
+static uint8_t
+espi_ipd_info_required(esp_msg_t* msg) {
+    switch (esp.ipd_info_policy) {
+        case ESP_IPD_INFO_NEVER:
+            return 0;
+        case ESP_IPD_INFO_AUTO: {
+            /* UDP may receive from any peer, information is required for it */
+            if (msg->cmd_def == ESP_CMD_TCPIP_CIPSTART
+                && msg->msg.conn_start.type == ESP_CONN_TYPE_UDP) {
+                return 1;
+            }
+            for (size_t i = 0; i < ESP_CFG_MAX_CONNS; ++i) {
+                if (esp.m.conns[i].status.f.active
+                    && esp.m.conns[i].type == ESP_CONN_TYPE_UDP) {
+                    return 1;
+                }
+            }
+            return 0;
+        }
+        default:
+            return 1;
+    }
+}
+
 /**
  * \brief           Get next sub command for reset or restore sequence
  * \param[in]       msg: Pointer to current message
@@ -1375,6 +1876,9 @@ espi_get_reset_sub_cmd(esp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, uint8_
 static espr_t
 espi_process_sub_cmd(esp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, uint8_t* is_ready) {
     esp_cmd_t n_cmd = ESP_CMD_IDLE;
+    if (CMD_IS_CUR(ESP_CMD_TCPIP_CIPDINFO) && *is_ok) {
+        esp.m.ipd_info = esp.m.ipd_info_set;    /* Module accepted new +IPD info setup */
+    }
     if (CMD_IS_DEF(ESP_CMD_RESET)) {            /* Device is in reset mode */
         n_cmd = espi_get_reset_sub_cmd(msg, is_ok, is_error, is_ready);
         if (n_cmd == ESP_CMD_IDLE) {            /* Last command? */
@@ -1467,10 +1971,16 @@ espi_process_sub_cmd(esp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, uint8_t*
 #endif
     } else if (CMD_IS_DEF(ESP_CMD_TCPIP_CIPSTART)) {/* Is our intention to join to access point? */
         if (msg->i == 0 && CMD_IS_CUR(ESP_CMD_TCPIP_CIPSTATUS)) {   /* Was the current command status info? */
-            SET_NEW_CMD_COND(ESP_CMD_TCPIP_CIPSTART, *is_ok);   /* Now actually start connection */
-        } else if (msg->i == 1 && CMD_IS_CUR(ESP_CMD_TCPIP_CIPSTART)) {
+            if (espi_ipd_info_required(msg) != esp.m.ipd_info) {
+                SET_NEW_CMD_COND(ESP_CMD_TCPIP_CIPDINFO, *is_ok);   /* Update +IPD info first */
+            } else {
+                SET_NEW_CMD_COND(ESP_CMD_TCPIP_CIPSTART, *is_ok);   /* Now actually start connection */
+            }
+        } else if (CMD_IS_CUR(ESP_CMD_TCPIP_CIPDINFO)) {
+            SET_NEW_CMD(ESP_CMD_TCPIP_CIPSTART);    /* Start connection, cached address is used on failure */
+        } else if (CMD_IS_CUR(ESP_CMD_TCPIP_CIPSTART)) {
             SET_NEW_CMD(ESP_CMD_TCPIP_CIPSTATUS);   /* Go to status mode */
-        } else if (msg->i == 2 && CMD_IS_CUR(ESP_CMD_TCPIP_CIPSTATUS)) {
+        } else if (msg->i > 0 && CMD_IS_CUR(ESP_CMD_TCPIP_CIPSTATUS)) {
             /* Check if connect actually succeeded */
             if (!msg->msg.conn_start.success) {
                 *is_ok = 0;
@@ -1504,7 +2014,7 @@ espi_process_sub_cmd(esp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, uint8_t*
                     SET_NEW_CMD(ESP_CMD_TCPIP_CIPRECVLEN);
                 } else {
                     /* Number of bytes to read */
-                    len = ESP_MIN(ESP_CFG_CONN_MAX_DATA_LEN, msg->msg.ciprecvdata.conn->tcp_available_bytes);
+                    len = ESP_MIN(esp.cfg.conn_max_data_len, msg->msg.ciprecvdata.conn->tcp_available_bytes);
                     if (len > 0) {
                         esp_pbuf_p p = NULL;
 
@@ -1562,6 +2072,10 @@ espi_process_sub_cmd(esp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, uint8_t*
         if (CMD_IS_CUR(ESP_CMD_WIFI_CWDHCP_SET)) {
             SET_NEW_CMD(ESP_CMD_WIFI_CWDHCP_GET);
         }
+#if ESP_CFG_PM
+    } else if (CMD_IS_DEF(ESP_CMD_SLEEP)) {
+        espi_pm_sleep_result(msg, *is_ok ? espOK : espERR);
+#endif /* ESP_CFG_PM */
     }
 
     /* Are we enabling server mode for some reason? */
@@ -1667,6 +2181,21 @@ espi_initiate_cmd(esp_msg_t* msg) {
             AT_PORT_SEND_END_AT();
             break;
         }
+        case ESP_CMD_SLEEP: {                   /* Set sleep mode */
+            uint32_t mode = ESP_U32(msg->msg.sleep.mode);
+
+#if ESP_CFG_ESP32
+            /* ESP32 uses different numbers for light and modem sleep */
+            if (esp.m.device == ESP_DEVICE_ESP32 && msg->msg.sleep.mode != ESP_SLEEP_NONE) {
+                mode = msg->msg.sleep.mode == ESP_SLEEP_LIGHT ? 2 : 1;
+            }
+#endif /* ESP_CFG_ESP32 */
+            AT_PORT_SEND_BEGIN_AT();
+            AT_PORT_SEND_CONST_STR("+SLEEP=");
+            espi_send_number(mode, 0, 0);
+            AT_PORT_SEND_END_AT();
+            break;
+        }
         case ESP_CMD_UART: {                    /* Change UART parameters for AT port */
             AT_PORT_SEND_BEGIN_AT();
             AT_PORT_SEND_CONST_STR("+UART_CUR=");
@@ -2085,8 +2614,13 @@ espi_initiate_cmd(esp_msg_t* msg) {
             break;
         }
         case ESP_CMD_TCPIP_CIPDINFO: {          /* Set info data on +IPD command */
+            if (CMD_IS_DEF(ESP_CMD_TCPIP_CIPDINFO)) {
+                esp.ipd_info_policy = msg->msg.tcpip_dinfo.policy;
+            }
+            esp.m.ipd_info_set = espi_ipd_info_required(msg);
             AT_PORT_SEND_BEGIN_AT();
-            AT_PORT_SEND_CONST_STR("+CIPDINFO=1");
+            AT_PORT_SEND_CONST_STR("+CIPDINFO=");
+            espi_send_number(ESP_U32(esp.m.ipd_info_set), 0, 0);
             AT_PORT_SEND_END_AT();
             break;
         }
@@ -2280,10 +2814,16 @@ espi_send_msg_to_producer_mbox(esp_msg_t* msg, espr_t (*process_fn)(esp_msg_t *)
     }
     msg->block_time = max_block_time;           /* Set blocking status if necessary */
     msg->fn = process_fn;                       /* Save processing function to be called as callback */
+#if ESP_CFG_PM
+    espi_pm_msg_enqueue(msg);                   /* Wake device up first if necessary */
+#endif /* ESP_CFG_PM */
     if (msg->is_blocking) {
         esp_sys_mbox_put(&esp.mbox_producer, msg);  /* Write message to producer queue and wait forever */
     } else {
         if (!esp_sys_mbox_putnow(&esp.mbox_producer, msg)) {    /* Write message to producer queue immediately */
+#if ESP_CFG_PM
+            espi_pm_msg_done(msg);
+#endif /* ESP_CFG_PM */
             ESP_MSG_VAR_FREE(msg);              /* Release message */
             return espERRMEM;
         }
@@ -2375,6 +2915,14 @@ espi_process_events_for_timeout_or_error(esp_msg_t* msg, espr_t err) {
         }
 #endif /* ESP_CFG_DNS */
 
+#if ESP_CFG_PM
+        case ESP_CMD_SLEEP: {
+            /* Sleep or wakeup error */
+            espi_pm_sleep_result(msg, err);
+            break;
+        }
+#endif /* ESP_CFG_PM */
+
         default: break;
     }
 }
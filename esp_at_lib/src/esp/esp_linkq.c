@@ -0,0 +1,325 @@
+/**
+ * \file            esp_linkq.c
+ * \brief           Link quality monitor
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include "esp/esp_private.h"
+#include "esp/esp_linkq.h"
+#include "esp/esp_timeout.h"
+#include "esp/esp_mem.h"
+
+#if ESP_CFG_LINKQ || __DOXYGEN__
+
+/* Fixed point scale for smoothed values */
+#define LINKQ_FP_SHIFT              4
+#define LINKQ_FAIL_SHIFT            3
+
+/**
+ * \brief           Link quality monitor state
+ */
+typedef struct {
+    uint8_t running;                            /*!< Set to `1` when periodic sampling is active */
+    uint8_t sampling;                           /*!< Set to `1` when RSSI read command is in progress */
+    uint8_t was_connected;                      /*!< Set to `1` once station has been connected at least once */
+    uint32_t interval;                          /*!< Sampling interval in units of milliseconds */
+    int32_t rssi_avg_fp;                        /*!< Smoothed RSSI in fixed point format */
+    int32_t fail_ratio_fp;                      /*!< Smoothed failure ratio in percent, fixed point format */
+    esp_sta_info_ap_t info;                     /*!< Access point info used as command output */
+    esp_linkq_stats_t stats;                    /*!< Statistics exposed to application */
+} esp_linkq_t;
+
+static esp_linkq_t lq;
+
+/**
+ * \brief           Calculate new link level from smoothed values
+ * \return          Member of \ref esp_linkq_level_t enumeration
+ */
+static esp_linkq_level_t
+linkq_calc_level(void) {
+    esp_linkq_level_t level, cur = lq.stats.level;
+    int16_t good = ESP_CFG_LINKQ_RSSI_GOOD, poor = ESP_CFG_LINKQ_RSSI_POOR;
+
+    if (!esp.m.sta.is_connected) {
+        return ESP_LINKQ_LEVEL_LOST;
+    }
+
+    /* Require additional margin to move one level up */
+    if (cur < ESP_LINKQ_LEVEL_GOOD) {
+        good += ESP_CFG_LINKQ_HYSTERESIS;
+    }
+    if (cur < ESP_LINKQ_LEVEL_FAIR) {
+        poor += ESP_CFG_LINKQ_HYSTERESIS;
+    }
+
+    if (lq.stats.samples == 0) {                /* No RSSI information yet */
+        level = ESP_LINKQ_LEVEL_FAIR;
+    } else if (lq.stats.rssi_avg >= good) {
+        level = ESP_LINKQ_LEVEL_GOOD;
+    } else if (lq.stats.rssi_avg >= poor) {
+        level = ESP_LINKQ_LEVEL_FAIR;
+    } else {
+        level = ESP_LINKQ_LEVEL_POOR;
+    }
+
+    /* Degrade level when sends keep failing, regardless of RSSI */
+    if (lq.stats.fail_ratio >= ESP_CFG_LINKQ_FAIL_RATIO && level > ESP_LINKQ_LEVEL_POOR) {
+        --level;
+    }
+    return level;
+}
+
+/**
+ * \brief           Update link level and notify application on change
+ */
+static void
+linkq_update_level(void) {
+    esp_linkq_level_t level, prev = lq.stats.level;
+
+    level = linkq_calc_level();
+    if (level != prev) {
+        lq.stats.level = level;
+        ESP_DEBUGF(ESP_CFG_DBG_LINKQ | ESP_DBG_TYPE_TRACE,
+            "[LINKQ] Level changed from %d to %d, RSSI: %d, fail ratio: %d\r\n",
+            (int)prev, (int)level, (int)lq.stats.rssi_avg, (int)lq.stats.fail_ratio);
+
+        esp.evt.evt.linkq.level = level;
+        esp.evt.evt.linkq.level_prev = prev;
+        esp.evt.evt.linkq.rssi = lq.stats.rssi_avg;
+        espi_send_cb(ESP_EVT_LINKQ_CHANGED);
+    }
+}
+
+/**
+ * \brief           RSSI read command finished callback
+ * \param[in]       res: Command result
+ * \param[in]       arg: Custom argument, not used
+ */
+static void
+linkq_sample_evt_fn(espr_t res, void* arg) {
+    ESP_UNUSED(arg);
+
+    lq.sampling = 0;
+    if (res != espOK || !lq.running) {
+        return;
+    }
+
+    lq.stats.rssi_last = lq.info.rssi;
+    if (lq.stats.samples++ == 0) {              /* First sample initializes filter */
+        lq.rssi_avg_fp = (int32_t)lq.info.rssi * (1 << LINKQ_FP_SHIFT);
+    } else {
+        lq.rssi_avg_fp += ((int32_t)lq.info.rssi * (1 << LINKQ_FP_SHIFT) - lq.rssi_avg_fp) / (1 << ESP_CFG_LINKQ_SMOOTH_SHIFT);
+    }
+    lq.stats.rssi_avg = (int16_t)(lq.rssi_avg_fp / (1 << LINKQ_FP_SHIFT));
+    linkq_update_level();
+}
+
+/**
+ * \brief           Periodic sampling timeout callback
+ * \param[in]       arg: Custom argument, not used
+ */
+static void
+linkq_timeout_cb(void* arg) {
+    ESP_UNUSED(arg);
+
+    if (!lq.running) {
+        return;
+    }
+    if (!lq.sampling && esp.m.sta.is_connected) {
+        if (esp_sta_get_ap_info(&lq.info, linkq_sample_evt_fn, NULL, 0) == espOK) {
+            lq.sampling = 1;
+        }
+    }
+    esp_timeout_add(lq.interval, linkq_timeout_cb, NULL);
+}
+
+/**
+ * \brief           Notify monitor about station connection status change
+ * \param[in]       connected: Set to `1` when station connected, `0` when disconnected
+ */
+void
+espi_linkq_wifi_status(uint8_t connected) {
+    if (connected) {
+        if (lq.was_connected) {
+            ++lq.stats.reconnects;
+        }
+        lq.was_connected = 1;
+    } else {
+        ++lq.stats.disconnects;
+    }
+    linkq_update_level();
+}
+
+/**
+ * \brief           Notify monitor about finished send operation
+ * \param[in]       res: Send operation result
+ */
+void
+espi_linkq_send_result(espr_t res) {
+    int32_t sample;
+
+    if (res == espOK) {
+        ++lq.stats.send_ok;
+        sample = 0;
+    } else if (res == espERR) {
+        ++lq.stats.send_failed;
+        sample = 100 * (1 << LINKQ_FP_SHIFT);
+    } else {
+        return;                                 /* Closed connection is not a link problem */
+    }
+    lq.fail_ratio_fp += (sample - lq.fail_ratio_fp) / (1 << LINKQ_FAIL_SHIFT);
+    lq.stats.fail_ratio = (uint8_t)(lq.fail_ratio_fp / (1 << LINKQ_FP_SHIFT));
+    linkq_update_level();
+}
+
+/**
+ * \brief           Notify monitor about `SEND FAIL` retransmission
+ */
+void
+espi_linkq_send_retry(void) {
+    ++lq.stats.send_retries;
+}
+
+/**
+ * \brief           Start periodic RSSI sampling
+ * \param[in]       interval: Sampling interval in units of milliseconds.
+ *                      Set to `0` to use \ref ESP_CFG_LINKQ_INTERVAL
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_linkq_start(uint32_t interval) {
+    espr_t res = espOK;
+
+    esp_core_lock();
+    lq.interval = interval > 0 ? interval : ESP_CFG_LINKQ_INTERVAL;
+    if (!lq.running) {
+        lq.running = 1;
+        res = esp_timeout_add(0, linkq_timeout_cb, NULL);
+        if (res != espOK) {
+            lq.running = 0;
+        }
+    }
+    esp_core_unlock();
+    return res;
+}
+
+/**
+ * \brief           Stop periodic RSSI sampling
+ * \note            Send and reconnect counters are still updated when sampling is stopped
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_linkq_stop(void) {
+    esp_core_lock();
+    lq.running = 0;
+    esp_timeout_remove(linkq_timeout_cb);
+    esp_core_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Copy current link statistics
+ * \param[out]      stats: Pointer to output structure
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_linkq_get_stats(esp_linkq_stats_t* stats) {
+    ESP_ASSERT("stats != NULL", stats != NULL);
+
+    esp_core_lock();
+    ESP_MEMCPY(stats, &lq.stats, sizeof(*stats));
+    esp_core_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Reset statistics counters and smoothing filters
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_linkq_reset_stats(void) {
+    esp_core_lock();
+    lq.rssi_avg_fp = 0;
+    lq.fail_ratio_fp = 0;
+    ESP_MEMSET(&lq.stats, 0x00, sizeof(lq.stats));
+    lq.stats.level = linkq_calc_level();
+    esp_core_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Get current link level
+ * \return          Member of \ref esp_linkq_level_t enumeration
+ */
+esp_linkq_level_t
+esp_linkq_get_level(void) {
+    esp_linkq_level_t level;
+
+    esp_core_lock();
+    level = lq.stats.level;
+    esp_core_unlock();
+    return level;
+}
+
+/**
+ * \brief           Get recommended maximal payload length for single send operation
+ *
+ * On weak links, smaller packets are less likely to fail
+ * and cost less airtime when retransmission is necessary.
+ *
+ * \return          Number of bytes application should send at a time, `0` when link is lost
+ */
+size_t
+esp_linkq_get_recommended_payload(void) {
+    size_t max_len = esp_get_conn_max_data_len();
+
+    switch (esp_linkq_get_level()) {
+        case ESP_LINKQ_LEVEL_GOOD: return max_len;
+        case ESP_LINKQ_LEVEL_FAIR: return ESP_MAX(max_len / 2, 1);
+        case ESP_LINKQ_LEVEL_POOR: return ESP_MAX(max_len / 4, 1);
+        default: return 0;
+    }
+}
+
+/**
+ * \brief           Get recommended number of send operations to queue before waiting for result
+ * \return          Number of outstanding sends, `0` when link is lost
+ */
+size_t
+esp_linkq_get_recommended_batch(void) {
+    switch (esp_linkq_get_level()) {
+        case ESP_LINKQ_LEVEL_GOOD: return 4;
+        case ESP_LINKQ_LEVEL_FAIR: return 2;
+        case ESP_LINKQ_LEVEL_POOR: return 1;
+        default: return 0;
+    }
+}
+
+#endif /* ESP_CFG_LINKQ || __DOXYGEN__ */
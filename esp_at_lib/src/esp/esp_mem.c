@@ -60,6 +60,49 @@ typedef struct mem_block {
 static mem_block_t start_block;                 /*!< First block data for allocations */
 static mem_block_t* end_block;                  /*!< Pointer to last block in linked list */
 static size_t mem_available_bytes;              /*!< Number of available bytes for allocations */
+static esp_mem_stats_t mem_stats;               /*!< Allocation statistics */
+
+#if ESP_CFG_MEM_AFFINITY || __DOXYGEN__
+
+#if !__DOXYGEN__
+typedef struct {
+    const uint8_t* start;                       /*!< First address of region used for blocks */
+    const uint8_t* end;                         /*!< End block address of region */
+    esp_mem_region_stats_t stats;               /*!< Region statistics */
+} mem_region_t;
+#endif /* !__DOXYGEN__ */
+
+static mem_region_t mem_regions[ESP_CFG_MEM_MAX_REGIONS];   /*!< Assigned regions */
+static size_t mem_regions_cnt;                  /*!< Number of assigned regions */
+
+/**
+ * \brief           Order of classes tried for allocation of each class
+ */
+static const esp_mem_class_t
+mem_class_order[ESP_MEM_CLASS_END][ESP_MEM_CLASS_END] = {
+    { ESP_MEM_CLASS_DEFAULT, ESP_MEM_CLASS_BULK, ESP_MEM_CLASS_FAST },  /* ESP_MEM_CLASS_DEFAULT, keep fast memory for hot objects */
+    { ESP_MEM_CLASS_FAST, ESP_MEM_CLASS_DEFAULT, ESP_MEM_CLASS_BULK },  /* ESP_MEM_CLASS_FAST */
+    { ESP_MEM_CLASS_BULK, ESP_MEM_CLASS_DEFAULT, ESP_MEM_CLASS_FAST },  /* ESP_MEM_CLASS_BULK */
+};
+
+/**
+ * \brief           Get region block belongs to
+ * \param[in]       block: Memory block
+ * \return          Region on success, `NULL` otherwise
+ */
+static mem_region_t *
+mem_get_region(const mem_block_t* block) {
+    const uint8_t* addr = (const void *)block;
+
+    for (size_t i = 0; i < mem_regions_cnt; ++i) {
+        if (addr >= mem_regions[i].start && addr < mem_regions[i].end) {
+            return &mem_regions[i];
+        }
+    }
+    return NULL;
+}
+
+#endif /* ESP_CFG_MEM_AFFINITY || __DOXYGEN__ */
 
 /**
  * \brief           Insert a new block to linked list of free blocks
@@ -122,6 +165,16 @@ mem_assignmem(const esp_mem_region_t* regions, size_t len) {
     if (end_block != NULL) {                    /* Regions already defined */
         return 0;
     }
+#if ESP_CFG_MEM_AFFINITY
+    if (len > ESP_CFG_MEM_MAX_REGIONS) {        /* Regions are tracked for memory class */
+        return 0;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        if ((size_t)regions[i].mem_class >= (size_t)ESP_MEM_CLASS_END) {
+            return 0;
+        }
+    }
+#endif /* ESP_CFG_MEM_AFFINITY */
 
     /* Check if region address are linear and rising */
     mem_start_addr = (uint8_t *)0;
@@ -195,20 +248,36 @@ mem_assignmem(const esp_mem_region_t* regions, size_t len) {
 
         /* Set number of free bytes available to allocate in region */
         mem_available_bytes += first_block->size;
+
+#if ESP_CFG_MEM_AFFINITY
+        mem_regions[mem_regions_cnt].start = mem_start_addr;
+        mem_regions[mem_regions_cnt].end = (const void *)end_block;
+        mem_regions[mem_regions_cnt].stats.mem_class = regions->mem_class;
+        mem_regions[mem_regions_cnt].stats.total = first_block->size;
+        mem_regions[mem_regions_cnt].stats.available = first_block->size;
+        mem_regions[mem_regions_cnt].stats.min_available = first_block->size;
+        ++mem_regions_cnt;
+#endif /* ESP_CFG_MEM_AFFINITY */
     }
+    mem_stats.total = mem_available_bytes;
+    mem_stats.min_available = mem_available_bytes;
 
     return 1;                                   /* Regions set as expected */
 }
 
 /**
  * \brief           Allocate memory of specific size
+ * \param[in]       mem_class: Preferred memory class
  * \param[in]       size: Number of bytes to allocate
  * \return          Memory address on success, `NULL` otherwise
  */
 static void *
-mem_alloc(size_t size) {
+mem_alloc(esp_mem_class_t mem_class, size_t size) {
     mem_block_t *prev, *curr, *next;
     void* retval = NULL;
+#if ESP_CFG_MEM_AFFINITY
+    mem_region_t* region = NULL;
+#endif /* ESP_CFG_MEM_AFFINITY */
 
     if (end_block == NULL) {                    /* If end block is not yet defined */
         return NULL;                            /* Invalid, not initialized */
@@ -220,6 +289,7 @@ mem_alloc(size_t size) {
 
     size = MEM_ALIGN(size) + MEMBLOCK_METASIZE; /* Increase size for metadata */
     if (size > mem_available_bytes) {           /* Check if we have enough memory available */
+        ++mem_stats.failed_cnt;
         return 0;
     }
 
@@ -228,12 +298,30 @@ mem_alloc(size_t size) {
      * Go through free blocks until enough memory is found
      * or end block is reached (no next free block)
      */
+#if ESP_CFG_MEM_AFFINITY
+    /*
+     * Try classes in fallback order,
+     * end blocks of regions have zero size and are never selected
+     */
+    curr = end_block;
+    for (size_t i = 0; curr == end_block && i < ESP_MEM_CLASS_END; ++i) {
+        prev = &start_block;
+        for (curr = prev->next; curr != end_block; prev = curr, curr = curr->next) {
+            if (curr->size >= size && (region = mem_get_region(curr)) != NULL
+                && region->stats.mem_class == mem_class_order[mem_class][i]) {
+                break;
+            }
+        }
+    }
+#else /* ESP_CFG_MEM_AFFINITY */
+    ESP_UNUSED(mem_class);
     prev = &start_block;                        /* Set first first block as previous */
     curr = prev->next;                          /* Set next block as current */
     while ((curr->size < size) && (curr->next != NULL)) {
         prev = curr;
         curr = curr->next;
     }
+#endif /* !ESP_CFG_MEM_AFFINITY */
 
     /*
      * Possible improvements
@@ -241,7 +329,9 @@ mem_alloc(size_t size) {
      *
      * Feature may be very risky later because of fragmentation
      */
-    if (curr != end_block) {                    /* We found empty block of enough memory available */
+    if (curr == end_block) {
+        ++mem_stats.failed_cnt;                 /* Allocation failed, no free blocks of required size */
+    } else {                                    /* We found empty block of enough memory available */
         retval = (void *)((uint8_t *)prev->next + MEMBLOCK_METASIZE);    /* Set return value */
         prev->next = curr->next;  /* Since block is now allocated, remove it from free chain */
 
@@ -261,12 +351,24 @@ mem_alloc(size_t size) {
              */
             mem_insertfreeblock(next);          /* Insert free memory block to list of free memory blocks (linked list chain) */
         }
+        mem_available_bytes -= curr->size;      /* Decrease available memory by actual block size, as freed later */
         curr->size |= MEM_ALLOC_BIT;            /* Set allocated bit = memory is allocated */
         curr->next = NULL;                      /* Clear next free block pointer as there is no one */
 
-        mem_available_bytes -= size;            /* Decrease available memory */
-    } else {
-        /* Allocation failed, no free blocks of required size */
+        if (mem_available_bytes < mem_stats.min_available) {
+            mem_stats.min_available = mem_available_bytes;
+        }
+        ++mem_stats.alloc_cnt;
+#if ESP_CFG_MEM_AFFINITY
+        region->stats.available -= curr->size & ~MEM_ALLOC_BIT;
+        if (region->stats.available < region->stats.min_available) {
+            region->stats.min_available = region->stats.available;
+        }
+        ++region->stats.alloc_cnt;
+        if (region->stats.mem_class != mem_class) {
+            ++region->stats.fallback_cnt;
+        }
+#endif /* ESP_CFG_MEM_AFFINITY */
     }
     return retval;
 }
@@ -297,22 +399,32 @@ mem_free(void* ptr) {
          */
         block->size &= ~MEM_ALLOC_BIT;          /* Clear allocated bit */
         mem_available_bytes += block->size;     /* Increase available bytes back */
+#if ESP_CFG_MEM_AFFINITY
+        {
+            mem_region_t* region = mem_get_region(block);
+            if (region != NULL) {
+                region->stats.available += block->size;
+            }
+        }
+#endif /* ESP_CFG_MEM_AFFINITY */
         mem_insertfreeblock(block);             /* Insert block to list of free blocks */
+        ++mem_stats.free_cnt;
     }
 }
 
 /**
  * \brief           Allocate memory of specific size
+ * \param[in]       mem_class: Preferred memory class
  * \param[in]       num: Number of elements to allocate
  * \param[in]       size: Size of element in units of bytes
  * \return          Memory address on success, `NULL` otherwise
  */
 static void *
-mem_calloc(size_t num, size_t size) {
+mem_calloc(esp_mem_class_t mem_class, size_t num, size_t size) {
     void* ptr;
     size_t tot_len = num * size;
 
-    if ((ptr = mem_alloc(tot_len)) != NULL) {   /* Try to allocate memory */
+    if ((ptr = mem_alloc(mem_class, tot_len)) != NULL) {/* Try to allocate memory */
         ESP_MEMSET(ptr, 0x00, tot_len);         /* Reset entire memory */
     }
     return ptr;
@@ -330,13 +442,22 @@ static void *
 mem_realloc(void* ptr, size_t size) {
     void* new_ptr;
     size_t old_size;
+    esp_mem_class_t mem_class = ESP_MEM_CLASS_DEFAULT;
 
     if (ptr == NULL) {                          /* If pointer is not valid */
-        return mem_alloc(size);                 /* Only allocate memory */
+        return mem_alloc(mem_class, size);      /* Only allocate memory */
     }
 
+#if ESP_CFG_MEM_AFFINITY
+    {
+        mem_region_t* region = mem_get_region(MEM_BLOCK_FROM_PTR(ptr));
+        if (region != NULL) {
+            mem_class = region->stats.mem_class;/* Keep class of original memory */
+        }
+    }
+#endif /* ESP_CFG_MEM_AFFINITY */
     old_size = MEM_BLOCK_USER_SIZE(ptr);        /* Get size of old pointer */
-    new_ptr = mem_alloc(size);                  /* Try to allocate new memory block */
+    new_ptr = mem_alloc(mem_class, size);       /* Try to allocate new memory block */
     if (new_ptr != NULL) {
         ESP_MEMCPY(new_ptr, ptr, ESP_MIN(size, old_size));  /* Copy old data to new array */
         mem_free(ptr);                          /* Free old pointer */
@@ -354,7 +475,7 @@ void *
 esp_mem_malloc(size_t size) {
     void* ptr;
     esp_core_lock();
-    ptr = mem_calloc(1, size);                  /* Allocate memory and return pointer */
+    ptr = mem_calloc(ESP_MEM_CLASS_DEFAULT, 1, size);   /* Allocate memory and return pointer */
     esp_core_unlock();
     ESP_DEBUGW(ESP_CFG_DBG_MEM | ESP_DBG_TYPE_TRACE, ptr == NULL,
         "[MEM] Allocation failed: %d bytes\r\n", (int)size);
@@ -395,7 +516,7 @@ void *
 esp_mem_calloc(size_t num, size_t size) {
     void* ptr;
     esp_core_lock();
-    ptr = mem_calloc(num, size);               /* Allocate memory and clear it to 0. Then return pointer */
+    ptr = mem_calloc(ESP_MEM_CLASS_DEFAULT, num, size); /* Allocate memory and clear it to 0. Then return pointer */
     esp_core_unlock();
     ESP_DEBUGW(ESP_CFG_DBG_MEM | ESP_DBG_TYPE_TRACE, ptr == NULL,
         "[MEM] Callocation failed: %d bytes\r\n", (int)size * (int)num);
@@ -404,6 +525,60 @@ esp_mem_calloc(size_t num, size_t size) {
     return ptr;
 }
 
+/**
+ * \brief           Allocate memory of specific size from preferred memory class
+ * \note            Memory class is ignored when \ref ESP_CFG_MEM_AFFINITY is disabled
+ * \param[in]       mem_class: Preferred memory class. Other classes are used when regions of this class are exhausted
+ * \param[in]       size: Number of bytes to allocate
+ * \return          Memory address on success, `NULL` otherwise
+ */
+void *
+esp_mem_malloc_class(esp_mem_class_t mem_class, size_t size) {
+    return esp_mem_calloc_class(mem_class, 1, size);
+}
+
+/**
+ * \brief           Allocate memory of specific size from preferred memory class and set memory to zero
+ * \note            Memory class is ignored when \ref ESP_CFG_MEM_AFFINITY is disabled
+ * \param[in]       mem_class: Preferred memory class. Other classes are used when regions of this class are exhausted
+ * \param[in]       num: Number of elements to allocate
+ * \param[in]       size: Size of each element
+ * \return          Memory address on success, `NULL` otherwise
+ */
+void *
+esp_mem_calloc_class(esp_mem_class_t mem_class, size_t num, size_t size) {
+    return espi_mem_calloc_class_cnt(mem_class, num, size, NULL);
+}
+
+/**
+ * \brief           Allocate memory from preferred class and count allocation in the same locked section
+ * \note            Used by packet buffers to track live allocations without taking core lock again
+ * \param[in]       mem_class: Preferred memory class
+ * \param[in]       num: Number of elements to allocate
+ * \param[in]       size: Size of each element
+ * \param[in,out]   cnt: Counter increased on successful allocation. Set to `NULL` if not used
+ * \return          Memory address on success, `NULL` otherwise
+ */
+void *
+espi_mem_calloc_class_cnt(esp_mem_class_t mem_class, size_t num, size_t size, size_t* cnt) {
+    void* ptr;
+
+    if ((size_t)mem_class >= (size_t)ESP_MEM_CLASS_END) {
+        mem_class = ESP_MEM_CLASS_DEFAULT;
+    }
+    esp_core_lock();
+    ptr = mem_calloc(mem_class, num, size);
+    if (ptr != NULL && cnt != NULL) {
+        ++(*cnt);
+    }
+    esp_core_unlock();
+    ESP_DEBUGW(ESP_CFG_DBG_MEM | ESP_DBG_TYPE_TRACE, ptr == NULL,
+        "[MEM] Allocation failed: %d bytes, class: %d\r\n", (int)size * (int)num, (int)mem_class);
+    ESP_DEBUGW(ESP_CFG_DBG_MEM | ESP_DBG_TYPE_TRACE, ptr != NULL,
+        "[MEM] Allocation OK: %d bytes, class: %d, addr: %p\r\n", (int)size * (int)num, (int)mem_class, ptr);
+    return ptr;
+}
+
 /**
  * \brief           Free memory
  * \param[in]       ptr: Pointer to memory previously returned using \ref esp_mem_malloc,
@@ -438,7 +613,101 @@ esp_mem_assignmemory(const esp_mem_region_t* regions, size_t len) {
     return ret;
 }
 
-#endif /* !ESP_CFG_MEM_CUSTOM || __DOXYGEN__ */
+/**
+ * \brief           Get memory allocator statistics
+ *
+ * Compare `available` with `largest_free` to detect heap fragmentation
+ *
+ * \param[out]      stats: Pointer to output structure
+ * \return          `1` on success, `0` otherwise
+ * \note            Function is not available when \ref ESP_CFG_MEM_CUSTOM is `1`
+ */
+uint8_t
+esp_mem_get_stats(esp_mem_stats_t* stats) {
+    mem_block_t* b;
+
+    if (stats == NULL) {
+        return 0;
+    }
+    esp_core_lock();
+    ESP_MEMCPY(stats, &mem_stats, sizeof(*stats));
+    stats->available = mem_available_bytes;
+    stats->largest_free = 0;
+    stats->free_blocks = 0;
+    if (end_block != NULL) {
+        for (b = start_block.next; b != NULL && b != end_block; b = b->next) {
+            if (b->size == 0) {                 /* Skip end blocks of previous regions */
+                continue;
+            }
+            ++stats->free_blocks;
+            if (b->size - MEMBLOCK_METASIZE > stats->largest_free) {
+                stats->largest_free = b->size - MEMBLOCK_METASIZE;
+            }
+        }
+    }
+    esp_core_unlock();
+    return 1;
+}
+
+/**
+ * \brief           Get statistics of single memory region
+ * \param[in]       index: Region index, in order regions were assigned with \ref esp_mem_assignmemory.
+ *                      Regions too small for allocations are not counted
+ * \param[out]      stats: Pointer to output structure
+ * \return          `1` on success, `0` otherwise
+ * \note            Function is available only when \ref ESP_CFG_MEM_AFFINITY is enabled
+ */
+uint8_t
+esp_mem_get_region_stats(size_t index, esp_mem_region_stats_t* stats) {
+#if ESP_CFG_MEM_AFFINITY
+    uint8_t res = 0;
+
+    if (stats == NULL) {
+        return 0;
+    }
+    esp_core_lock();
+    if (index < mem_regions_cnt) {
+        ESP_MEMCPY(stats, &mem_regions[index].stats, sizeof(*stats));
+        res = 1;
+    }
+    esp_core_unlock();
+    return res;
+#else /* ESP_CFG_MEM_AFFINITY */
+    ESP_UNUSED(index);
+    ESP_UNUSED(stats);
+    return 0;
+#endif /* !ESP_CFG_MEM_AFFINITY */
+}
+
+#else /* !ESP_CFG_MEM_CUSTOM || __DOXYGEN__ */
+
+void *
+esp_mem_malloc_class(esp_mem_class_t mem_class, size_t size) {
+    ESP_UNUSED(mem_class);
+    return esp_mem_malloc(size);
+}
+
+void *
+esp_mem_calloc_class(esp_mem_class_t mem_class, size_t num, size_t size) {
+    ESP_UNUSED(mem_class);
+    return esp_mem_calloc(num, size);
+}
+
+void *
+espi_mem_calloc_class_cnt(esp_mem_class_t mem_class, size_t num, size_t size, size_t* cnt) {
+    void* ptr;
+
+    ESP_UNUSED(mem_class);
+    ptr = esp_mem_calloc(num, size);
+    if (ptr != NULL && cnt != NULL) {
+        esp_core_lock();                        /* Custom allocator has no core lock section to share */
+        ++(*cnt);
+        esp_core_unlock();
+    }
+    return ptr;
+}
+
+#endif /* ESP_CFG_MEM_CUSTOM && !__DOXYGEN__ */
 
 /**
  * \brief           Free memory in safe way by invalidating pointer after freeing
@@ -355,6 +355,10 @@ espi_parse_ipd(const char* str) {
 
         ESP_MEMCPY(&esp.m.conns[conn].remote_ip, &esp.m.ipd.ip, sizeof(esp.m.ipd.ip));
         ESP_MEMCPY(&esp.m.conns[conn].remote_port, &esp.m.ipd.port, sizeof(esp.m.ipd.port));
+    } else {
+        /* Information disabled, use remote address known from connection start */
+        ESP_MEMCPY(&esp.m.ipd.ip, &c->remote_ip, sizeof(esp.m.ipd.ip));
+        esp.m.ipd.port = c->remote_port;
     }
 
     /*
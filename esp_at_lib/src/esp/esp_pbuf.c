@@ -39,6 +39,8 @@
 #define SIZEOF_PBUF_STRUCT          ESP_MEM_ALIGN(sizeof(esp_pbuf_t))
 #define SET_NEW_LEN(v, len)         do { if ((v) != NULL) { *(v) = (len); } } while (0)
 
+static size_t pbuf_count;                       /*!< Number of currently allocated pbufs */
+
 /**
  * \brief           Skip pbufs for desired offset
  * \param[in]       p: Source pbuf to skip
@@ -71,7 +73,8 @@ esp_pbuf_p
 esp_pbuf_new(size_t len) {
     esp_pbuf_p p;
 
-    p = esp_mem_malloc(SIZEOF_PBUF_STRUCT + sizeof(*p->payload) * len);
+    p = espi_mem_calloc_class_cnt(len <= ESP_CFG_MEM_FAST_PBUF_LEN ? ESP_MEM_CLASS_FAST : ESP_MEM_CLASS_BULK,
+            1, SIZEOF_PBUF_STRUCT + sizeof(*p->payload) * len, &pbuf_count);
     ESP_DEBUGW(ESP_CFG_DBG_PBUF | ESP_DBG_TYPE_TRACE, p == NULL,
         "[PBUF] Failed to allocate %d bytes\r\n", (int)len);
     ESP_DEBUGW(ESP_CFG_DBG_PBUF | ESP_DBG_TYPE_TRACE, p != NULL,
@@ -82,6 +85,10 @@ esp_pbuf_new(size_t len) {
         p->len = len;                           /* Set payload length */
         p->payload = (void *)(((char *)p) + SIZEOF_PBUF_STRUCT);/* Set pointer to payload data */
         p->ref = 1;                             /* Single reference is used on this pbuf */
+#if ESP_CFG_EVT_TIMESTAMP
+        p->time_input = 0;
+        p->time_dispatch = 0;
+#endif /* ESP_CFG_EVT_TIMESTAMP */
     }
     return p;
 }
@@ -106,6 +113,9 @@ esp_pbuf_free(esp_pbuf_p pbuf) {
     for (p = pbuf; p != NULL;) {
         esp_core_lock();
         ref = --p->ref;                         /* Decrease current value and save it */
+        if (ref == 0) {
+            --pbuf_count;                       /* Track number of live pbufs */
+        }
         esp_core_unlock();
         if (ref == 0) {                         /* Did we reach 0 and are ready to free it? */
             ESP_DEBUGF(ESP_CFG_DBG_PBUF | ESP_DBG_TYPE_TRACE,
@@ -503,6 +513,38 @@ esp_pbuf_set_ip(esp_pbuf_p pbuf, const esp_ip_t* ip, esp_port_t port) {
     }
 }
 
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+
+/**
+ * \brief           Get arrival time of last received byte in packet buffer
+ *
+ * Time is taken when byte was passed to \ref esp_input or \ref esp_input_process.
+ * Value is `0` for packet buffers allocated by application
+ *
+ * \param[in]       pbuf: Packet buffer
+ * \return          Time in units of \ref ESP_CFG_EVT_TIMESTAMP_NOW
+ */
+uint32_t
+esp_pbuf_get_time_input(const esp_pbuf_p pbuf) {
+    return pbuf != NULL ? pbuf->time_input : 0;
+}
+
+/**
+ * \brief           Get time when received packet buffer was passed to application
+ *
+ * Difference to \ref esp_pbuf_get_time_input is time data spent inside the stack.
+ * Value is `0` for packet buffers allocated by application
+ *
+ * \param[in]       pbuf: Packet buffer
+ * \return          Time in units of \ref ESP_CFG_EVT_TIMESTAMP_NOW
+ */
+uint32_t
+esp_pbuf_get_time_dispatch(const esp_pbuf_p pbuf) {
+    return pbuf != NULL ? pbuf->time_dispatch : 0;
+}
+
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
+
 /**
  * \brief           Advance pbuf payload pointer by number of len bytes.
  *                  It can only advance single pbuf in a chain
@@ -574,3 +616,20 @@ esp_pbuf_dump(esp_pbuf_p p, uint8_t seq) {
             "[PBUF] Dump end\r\n");
     }
 }
+
+/**
+ * \brief           Get number of currently allocated packet buffers
+ *
+ * Value keeps growing when application does not free received pbufs
+ *
+ * \return          Number of allocated pbufs
+ */
+size_t
+esp_pbuf_get_count(void) {
+    size_t cnt;
+
+    esp_core_lock();
+    cnt = pbuf_count;
+    esp_core_unlock();
+    return cnt;
+}
@@ -0,0 +1,378 @@
+/**
+ * \file            esp_pm.c
+ * \brief           Power manager
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include "esp/esp_private.h"
+#include "esp/esp_pm.h"
+#include "esp/esp_timeout.h"
+#include "esp/esp_mem.h"
+
+#if ESP_CFG_PM || __DOXYGEN__
+
+/**
+ * \brief           Power manager device state
+ */
+typedef enum {
+    PM_STATE_AWAKE = 0x00,                      /*!< Device is awake */
+    PM_STATE_SLEEP_PENDING,                     /*!< Sleep command is in producer queue */
+    PM_STATE_SLEEPING,                          /*!< Device is in sleep mode */
+    PM_STATE_WAKEUP_PENDING,                    /*!< Wakeup command is in producer queue */
+} pm_state_t;
+
+/**
+ * \brief           Power manager structure
+ */
+typedef struct {
+    uint8_t enabled;                            /*!< Set to `1` when automatic sleep is enabled */
+    pm_state_t state;                           /*!< Current device state */
+    esp_sleep_mode_t mode;                      /*!< Sleep mode device is (or will be) in */
+    size_t pending;                             /*!< Number of messages in producer queue or in execution */
+    uint32_t last_activity;                     /*!< Time of last command or received data */
+    uint32_t sleep_start;                       /*!< Time when device entered sleep mode */
+    uint32_t wakeup_start;                      /*!< Time when wakeup has been requested */
+    esp_pm_stats_t stats;                       /*!< Statistics */
+} esp_pm_t;
+
+static esp_pm_t pm;
+static esp_pm_config_t pm_config = {
+    ESP_CFG_PM_SLEEP_MODE, ESP_CFG_PM_IDLE_TIME, ESP_CFG_PM_WAKEUP_LATENCY
+};
+
+/**
+ * \brief           Send sleep mode command to producer queue
+ * \param[in]       mode: Sleep mode to set. Use \ref ESP_SLEEP_NONE to wake device up
+ * \param[in]       evt_fn: Callback function called when command has finished. Set to `NULL` when not used
+ * \param[in]       evt_arg: Custom argument for event callback function
+ * \param[in]       blocking: Status whether command should be blocking or not
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+pm_send_sleep_cmd(esp_sleep_mode_t mode,
+                    const esp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking) {
+    ESP_MSG_VAR_DEFINE(msg);
+
+    ESP_MSG_VAR_ALLOC(msg, blocking);
+    ESP_MSG_VAR_SET_EVT(msg, evt_fn, evt_arg);
+    ESP_MSG_VAR_REF(msg).cmd_def = ESP_CMD_SLEEP;
+    ESP_MSG_VAR_REF(msg).msg.sleep.mode = mode;
+
+    return espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, 1000);
+}
+
+/**
+ * \brief           Idle check timeout callback
+ * \param[in]       arg: Custom argument, not used
+ */
+static void
+pm_idle_timeout_cb(void* arg) {
+    uint32_t elapsed, next = pm_config.idle_time;
+
+    ESP_UNUSED(arg);
+    if (!pm.enabled) {
+        return;
+    }
+
+    elapsed = esp_sys_now() - pm.last_activity;
+    if (elapsed < pm_config.idle_time) {
+        next = pm_config.idle_time - elapsed;   /* Check again when idle time expires */
+    } else if (pm.state == PM_STATE_AWAKE && pm.pending == 0 && esp.msg == NULL
+        && !esp.m.ipd.read && esp.status.f.dev_present
+        && pm_config.mode != ESP_SLEEP_NONE
+#if ESP_CFG_MODE_STATION
+        && esp.m.sta.is_connected
+#endif /* ESP_CFG_MODE_STATION */
+    ) {
+        ESP_DEBUGF(ESP_CFG_DBG_PM | ESP_DBG_TYPE_TRACE,
+            "[PM] Idle for %d ms, entering sleep mode %d\r\n", (int)elapsed, (int)pm_config.mode);
+        pm_send_sleep_cmd(pm_config.mode, NULL, NULL, 0);
+    }
+    esp_timeout_add(next > 0 ? next : 1, pm_idle_timeout_cb, NULL);
+}
+
+/**
+ * \brief           Send power state changed event to application
+ * \param[in]       res: Command result
+ * \param[in]       wakeup_time: Time needed to wake device up
+ */
+static void
+pm_send_evt(espr_t res, uint32_t wakeup_time) {
+    esp.evt.evt.pm.res = res;
+    esp.evt.evt.pm.mode = pm.state == PM_STATE_AWAKE ? ESP_SLEEP_NONE : pm.mode;
+    esp.evt.evt.pm.wakeup_time = wakeup_time;
+    espi_send_cb(ESP_EVT_PM_CHANGED);
+}
+
+/**
+ * \brief           Notify power manager about new message for producer queue
+ *
+ * If device sleeps or is about to sleep, wakeup command is queued before message
+ *
+ * \param[in]       msg: Message to be written to producer queue
+ */
+void
+espi_pm_msg_enqueue(esp_msg_t* msg) {
+    esp_core_lock();
+    ++pm.pending;
+    if (msg->cmd_def == ESP_CMD_SLEEP) {
+        if (msg->msg.sleep.mode != ESP_SLEEP_NONE) {
+            pm.mode = msg->msg.sleep.mode;
+            pm.state = PM_STATE_SLEEP_PENDING;
+        } else {
+            pm.state = PM_STATE_WAKEUP_PENDING;
+            pm.wakeup_start = esp_sys_now();
+            if (pm.mode == ESP_SLEEP_LIGHT && esp.ll.wakeup_fn != NULL) {
+                esp.ll.wakeup_fn(1);            /* Start wakeup now to hide latency */
+            }
+        }
+    } else if (pm.state == PM_STATE_SLEEP_PENDING || pm.state == PM_STATE_SLEEPING) {
+        pm_state_t state = pm.state;
+
+        ESP_DEBUGF(ESP_CFG_DBG_PM | ESP_DBG_TYPE_TRACE,
+            "[PM] Command %d queued while sleeping, waking device up\r\n", (int)msg->cmd_def);
+        if (pm_send_sleep_cmd(ESP_SLEEP_NONE, NULL, NULL, 0) != espOK) {
+            pm.state = state;                   /* Wakeup not queued, try again with next message */
+        }
+    }
+    esp_core_unlock();
+}
+
+/**
+ * \brief           Notify power manager message has been processed or dropped
+ * \param[in]       msg: Processed message
+ */
+void
+espi_pm_msg_done(esp_msg_t* msg) {
+    ESP_UNUSED(msg);
+
+    esp_core_lock();
+    if (pm.pending > 0) {
+        --pm.pending;
+    }
+    pm.last_activity = esp_sys_now();
+    esp_core_unlock();
+}
+
+/**
+ * \brief           Notify power manager about data received from device
+ */
+void
+espi_pm_activity(void) {
+    pm.last_activity = esp_sys_now();
+}
+
+/**
+ * \brief           Wait remaining wakeup latency before wakeup command is sent to device
+ */
+void
+espi_pm_wakeup_wait(void) {
+    uint32_t elapsed;
+
+    if (pm.mode == ESP_SLEEP_LIGHT && esp.ll.wakeup_fn != NULL) {
+        elapsed = esp_sys_now() - pm.wakeup_start;
+        if (elapsed < pm_config.wakeup_latency) {
+            esp_delay(pm_config.wakeup_latency - elapsed);
+        }
+    }
+}
+
+/**
+ * \brief           Process sleep command result
+ * \param[in]       msg: Sleep command message
+ * \param[in]       res: Command result
+ */
+void
+espi_pm_sleep_result(esp_msg_t* msg, espr_t res) {
+    uint32_t now = esp_sys_now(), wakeup_time = 0;
+
+    if (msg->msg.sleep.mode != ESP_SLEEP_NONE) {
+        if (res == espOK) {
+            ++pm.stats.sleep_cnt;
+            pm.sleep_start = now;
+            if (pm.state == PM_STATE_SLEEP_PENDING) {
+                pm.state = PM_STATE_SLEEPING;
+            }
+        } else {
+            ++pm.stats.wakeup_err;
+            pm.mode = ESP_SLEEP_NONE;
+            if (pm.state == PM_STATE_SLEEP_PENDING) {
+                pm.state = PM_STATE_AWAKE;
+            }
+        }
+        ESP_DEBUGF(ESP_CFG_DBG_PM | ESP_DBG_TYPE_TRACE,
+            "[PM] Sleep mode %d result: %d\r\n", (int)msg->msg.sleep.mode, (int)res);
+    } else {
+        if (pm.mode != ESP_SLEEP_NONE) {        /* Was device actually sleeping? */
+            if (res == espOK) {
+                wakeup_time = now - pm.wakeup_start;
+                ++pm.stats.wakeup_cnt;
+                pm.stats.wakeup_time_last = wakeup_time;
+                if (wakeup_time > pm.stats.wakeup_time_max) {
+                    pm.stats.wakeup_time_max = wakeup_time;
+                }
+            } else {
+                ++pm.stats.wakeup_err;
+            }
+            pm.stats.sleep_time += now - pm.sleep_start;
+        }
+        if (pm.mode == ESP_SLEEP_LIGHT && esp.ll.wakeup_fn != NULL) {
+            esp.ll.wakeup_fn(0);
+        }
+
+        /* Consider device awake even on failure, next sleep command will retry */
+        pm.mode = ESP_SLEEP_NONE;
+        pm.state = PM_STATE_AWAKE;
+        ESP_DEBUGF(ESP_CFG_DBG_PM | ESP_DBG_TYPE_TRACE,
+            "[PM] Wakeup result: %d, time: %d ms\r\n", (int)res, (int)wakeup_time);
+    }
+    pm_send_evt(res, wakeup_time);
+}
+
+/**
+ * \brief           Reset power manager state after device reset
+ */
+void
+espi_pm_reset(void) {
+    if (pm.mode == ESP_SLEEP_LIGHT && esp.ll.wakeup_fn != NULL) {
+        esp.ll.wakeup_fn(0);
+    }
+    pm.mode = ESP_SLEEP_NONE;
+    pm.state = PM_STATE_AWAKE;
+    pm.last_activity = esp_sys_now();
+}
+
+/**
+ * \brief           Enable or disable automatic sleep management
+ * \note            When disabled while device sleeps, wakeup command is sent to device
+ * \param[in]       en: Set to `1` to enable, `0` to disable
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_pm_enable(uint8_t en) {
+    espr_t res = espOK;
+
+    esp_core_lock();
+    if (en && !pm.enabled) {
+        pm.enabled = 1;
+        pm.last_activity = esp_sys_now();
+        res = esp_timeout_add(pm_config.idle_time, pm_idle_timeout_cb, NULL);
+        if (res != espOK) {
+            pm.enabled = 0;
+        }
+    } else if (!en && pm.enabled) {
+        pm.enabled = 0;
+        esp_timeout_remove(pm_idle_timeout_cb);
+        if (pm.state == PM_STATE_SLEEP_PENDING || pm.state == PM_STATE_SLEEPING) {
+            res = pm_send_sleep_cmd(ESP_SLEEP_NONE, NULL, NULL, 0);
+        }
+    }
+    esp_core_unlock();
+    return res;
+}
+
+/**
+ * \brief           Set power manager configuration
+ * \param[in]       config: Pointer to new configuration
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_pm_set_config(const esp_pm_config_t* config) {
+    ESP_ASSERT("config != NULL", config != NULL);
+    ESP_ASSERT("config->idle_time > 0", config->idle_time > 0);
+
+    esp_core_lock();
+    ESP_MEMCPY(&pm_config, config, sizeof(pm_config));
+    esp_core_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Get current power manager configuration
+ * \param[out]      config: Pointer to output configuration
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_pm_get_config(esp_pm_config_t* config) {
+    ESP_ASSERT("config != NULL", config != NULL);
+
+    esp_core_lock();
+    ESP_MEMCPY(config, &pm_config, sizeof(*config));
+    esp_core_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Get power manager statistics
+ * \param[out]      stats: Pointer to output statistics
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_pm_get_stats(esp_pm_stats_t* stats) {
+    ESP_ASSERT("stats != NULL", stats != NULL);
+
+    esp_core_lock();
+    ESP_MEMCPY(stats, &pm.stats, sizeof(*stats));
+    esp_core_unlock();
+    return espOK;
+}
+
+/**
+ * \brief           Check if device is in sleep mode
+ * \return          `1` if sleeping or about to sleep, `0` otherwise
+ */
+uint8_t
+esp_pm_is_sleeping(void) {
+    uint8_t res;
+
+    esp_core_lock();
+    res = ESP_U8(pm.state == PM_STATE_SLEEP_PENDING || pm.state == PM_STATE_SLEEPING);
+    esp_core_unlock();
+    return res;
+}
+
+/**
+ * \brief           Manually set sleep mode of device
+ *
+ * Device is woken up automatically before next command even when sleep mode is set manually.
+ *
+ * \param[in]       mode: Sleep mode to set. Use \ref ESP_SLEEP_NONE to wake device up
+ * \param[in]       evt_fn: Callback function called when command has finished. Set to `NULL` when not used
+ * \param[in]       evt_arg: Custom argument for event callback function
+ * \param[in]       blocking: Status whether command should be blocking or not
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_pm_set_sleep_mode(esp_sleep_mode_t mode,
+                        const esp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking) {
+    return pm_send_sleep_cmd(mode, evt_fn, evt_arg, blocking);
+}
+
+#endif /* ESP_CFG_PM || __DOXYGEN__ */
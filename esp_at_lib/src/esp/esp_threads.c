@@ -86,6 +86,13 @@ esp_thread_produce(void* const arg) {
             espi_reset_everything(1);           /* Reset stack before trying to reset */
         }
 
+#if ESP_CFG_PM
+        /* Wakeup message must wait for device to become ready */
+        if (res == espOK && msg->cmd_def == ESP_CMD_SLEEP && msg->msg.sleep.mode == ESP_SLEEP_NONE) {
+            espi_pm_wakeup_wait();
+        }
+#endif /* ESP_CFG_PM */
+
         /*
          * Try to call function to process this message
          * Usually it should be function to transmit data to AT port
@@ -159,6 +166,10 @@ esp_thread_produce(void* const arg) {
         }
 #endif /* ESP_CFG_USE_API_FUNC_EVT */
 
+#if ESP_CFG_PM
+        espi_pm_msg_done(msg);                  /* Notify power manager about finished command */
+#endif /* ESP_CFG_PM */
+
         /*
          * In case message is blocking,
          * release semaphore and notify finished with processing
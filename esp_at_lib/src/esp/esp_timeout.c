@@ -124,7 +124,7 @@ esp_timeout_add(uint32_t time, esp_timeout_fn fn, void* arg) {
 
     ESP_ASSERT("fn != NULL", fn != NULL);
 
-    to = esp_mem_calloc(1, sizeof(*to));        /* Allocate memory for timeout structure */
+    to = esp_mem_calloc_class(ESP_MEM_CLASS_FAST, 1, sizeof(*to));  /* Allocate memory for timeout structure */
     if (to == NULL) {
         return espERR;
     }
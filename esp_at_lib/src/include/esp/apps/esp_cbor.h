@@ -0,0 +1,212 @@
+/**
+ * \file            esp_cbor.h
+ * \brief           Streaming CBOR encoder and decoder
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_APP_CBOR_H
+#define ESP_HDR_APP_CBOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp/esp.h"
+#include "esp/apps/esp_http_server.h"
+#include "esp/apps/esp_mqtt_client.h"
+
+/**
+ * \ingroup         ESP_APPS
+ * \defgroup        ESP_APP_CBOR Streaming CBOR
+ * \brief           CBOR (RFC 7049) encoder and decoder without dynamic allocation
+ * \{
+ *
+ * Encoder emits items directly to output function.
+ * Built-in outputs are linear buffer, pbuf chain, connection write buffer and HTTP server response.
+ *
+ * Decoder is fed with arbitrary pieces of data, such as pbufs received on connection,
+ * and calls user function for every decoded item.
+ * String contents are reported in chunks pointing directly to input data, without copying.
+ *
+ * \note            Indefinite length arrays and maps are supported, indefinite length strings are not
+ */
+
+/**
+ * \brief           Item count for indefinite length array or map,
+ *                  container must be closed with \ref esp_cbor_end
+ */
+#define ESP_CBOR_INDEFINITE                     ((uint32_t)0xFFFFFFFF)
+
+/**
+ * \brief           HTTP content type header for CBOR responses
+ */
+#define ESP_CBOR_HTTP_CONTENT_TYPE              "Content-Type: application/cbor\r\n"
+
+struct esp_cbor_writer;
+struct esp_cbor_decoder;
+
+/**
+ * \brief           Encoder output function
+ * \param[in]       w: CBOR writer
+ * \param[in]       data: Data to output
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Number of bytes accepted by output
+ */
+typedef size_t  (*esp_cbor_out_fn)(struct esp_cbor_writer* w, const void* data, size_t len);
+
+/**
+ * \brief           CBOR writer structure
+ */
+typedef struct esp_cbor_writer {
+    esp_cbor_out_fn out;                        /*!< Output function */
+    void* arg;                                  /*!< Output function argument */
+    size_t size;                                /*!< Output capacity for buffer and pbuf outputs */
+    size_t len;                                 /*!< Number of bytes accepted by output so far */
+    uint8_t err;                                /*!< Set to `1` when output did not accept all data */
+} esp_cbor_writer_t;
+
+/**
+ * \brief           List of item types reported by decoder
+ */
+typedef enum {
+    ESP_CBOR_TYPE_UINT,                         /*!< Unsigned integer, value in `val.u` */
+    ESP_CBOR_TYPE_NINT,                         /*!< Negative integer, value in `val.i`. Values below `INT64_MIN` are reported as `-1 - val.u` */
+    ESP_CBOR_TYPE_BYTES,                        /*!< Byte string chunk */
+    ESP_CBOR_TYPE_TEXT,                         /*!< Text string chunk */
+    ESP_CBOR_TYPE_ARR_BEGIN,                    /*!< Array begin, item count in `val.u` or \ref ESP_CBOR_INDEFINITE */
+    ESP_CBOR_TYPE_MAP_BEGIN,                    /*!< Map begin, pair count in `val.u` or \ref ESP_CBOR_INDEFINITE */
+    ESP_CBOR_TYPE_ARR_END,                      /*!< Array end */
+    ESP_CBOR_TYPE_MAP_END,                      /*!< Map end */
+    ESP_CBOR_TYPE_TAG,                          /*!< Tag number in `val.u`, applies to next item */
+    ESP_CBOR_TYPE_FALSE,                        /*!< Simple value `false` */
+    ESP_CBOR_TYPE_TRUE,                         /*!< Simple value `true` */
+    ESP_CBOR_TYPE_NULL,                         /*!< Simple value `null` */
+    ESP_CBOR_TYPE_UNDEFINED,                    /*!< Simple value `undefined` */
+    ESP_CBOR_TYPE_SIMPLE,                       /*!< Other simple value, number in `val.u` */
+    ESP_CBOR_TYPE_FLOAT,                        /*!< Half, single or double precision float, value in `val.f` */
+} esp_cbor_type_t;
+
+/**
+ * \brief           Decoded item
+ */
+typedef struct {
+    esp_cbor_type_t type;                       /*!< Item type */
+    union {
+        uint64_t u;                             /*!< Unsigned value or count */
+        int64_t i;                              /*!< Signed value */
+        double f;                               /*!< Floating point value */
+    } val;                                      /*!< Item value */
+    const uint8_t* data;                        /*!< String chunk data, pointing to input data */
+    size_t len;                                 /*!< String chunk length */
+    size_t off;                                 /*!< Offset of chunk in string, total string length is in `val.u` */
+} esp_cbor_item_t;
+
+/**
+ * \brief           Decoder item callback function
+ *
+ * For strings, function is called once per input piece containing part of the string.
+ * String is complete when `item->off + item->len == item->val.u`
+ *
+ * \param[in]       d: CBOR decoder
+ * \param[in]       item: Decoded item
+ * \return          \ref espOK to continue decoding, any other value stops decoder and is returned from feed function
+ */
+typedef espr_t  (*esp_cbor_decoder_fn)(struct esp_cbor_decoder* d, const esp_cbor_item_t* item);
+
+/**
+ * \brief           CBOR decoder structure
+ */
+typedef struct esp_cbor_decoder {
+    esp_cbor_decoder_fn fn;                     /*!< Item callback function */
+    void* arg;                                  /*!< User argument */
+    espr_t res;                                 /*!< Result of decoding, kept once decoder stops */
+    size_t pos;                                 /*!< Number of bytes processed so far */
+    uint8_t state;                              /*!< Internal state */
+    uint8_t head;                               /*!< Initial byte of current item */
+    uint8_t arg_len;                            /*!< Remaining length of argument bytes */
+    uint8_t depth;                              /*!< Current nesting depth */
+    uint8_t tagged;                             /*!< Set to `1` when tag waits for its data item */
+    uint32_t nest;                              /*!< Bit per nesting level, set for map and cleared for array */
+    uint32_t odd;                               /*!< Bit per nesting level, set when indefinite map waits for value */
+    uint32_t remaining[ESP_CFG_CBOR_MAX_DEPTH]; /*!< Remaining items per nesting level or \ref ESP_CBOR_INDEFINITE */
+    esp_cbor_item_t item;                       /*!< Item being decoded */
+} esp_cbor_decoder_t;
+
+void        esp_cbor_writer_init(esp_cbor_writer_t* w, esp_cbor_out_fn out, void* arg);
+void        esp_cbor_writer_init_buff(esp_cbor_writer_t* w, void* buff, size_t size);
+void        esp_cbor_writer_init_pbuf(esp_cbor_writer_t* w, esp_pbuf_p pbuf);
+void        esp_cbor_writer_init_conn(esp_cbor_writer_t* w, esp_conn_p conn);
+void        esp_cbor_writer_init_http(esp_cbor_writer_t* w, http_state_t* hs);
+
+espr_t      esp_cbor_uint(esp_cbor_writer_t* w, uint64_t num);
+espr_t      esp_cbor_int(esp_cbor_writer_t* w, int64_t num);
+espr_t      esp_cbor_bytes(esp_cbor_writer_t* w, const void* data, size_t len);
+espr_t      esp_cbor_text(esp_cbor_writer_t* w, const char* str);
+espr_t      esp_cbor_textn(esp_cbor_writer_t* w, const char* str, size_t len);
+espr_t      esp_cbor_arr_begin(esp_cbor_writer_t* w, uint32_t count);
+espr_t      esp_cbor_map_begin(esp_cbor_writer_t* w, uint32_t count);
+espr_t      esp_cbor_end(esp_cbor_writer_t* w);
+espr_t      esp_cbor_tag(esp_cbor_writer_t* w, uint64_t tag);
+espr_t      esp_cbor_bool(esp_cbor_writer_t* w, uint8_t val);
+espr_t      esp_cbor_null(esp_cbor_writer_t* w);
+espr_t      esp_cbor_float(esp_cbor_writer_t* w, float f);
+
+espr_t      esp_cbor_mqtt_publish(esp_mqtt_client_p client, const char* topic, const esp_cbor_writer_t* w, esp_mqtt_qos_t qos, uint8_t retain, void* arg);
+
+/**
+ * \brief           Get number of bytes accepted by writer output
+ * \param[in]       w: CBOR writer
+ * \return          Length of encoded data
+ * \hideinitializer
+ */
+#define     esp_cbor_writer_get_len(w)          ((w)->len)
+
+void        esp_cbor_decoder_init(esp_cbor_decoder_t* d, esp_cbor_decoder_fn fn, void* arg);
+espr_t      esp_cbor_decoder_feed(esp_cbor_decoder_t* d, const void* data, size_t len);
+espr_t      esp_cbor_decoder_feed_pbuf(esp_cbor_decoder_t* d, const esp_pbuf_p pbuf);
+espr_t      esp_cbor_decoder_finish(esp_cbor_decoder_t* d);
+
+/**
+ * \brief           Get current nesting depth of decoder
+ * \param[in]       d: CBOR decoder
+ * \return          Nesting depth, `0` for top level item
+ * \hideinitializer
+ */
+#define     esp_cbor_decoder_get_depth(d)       ((d)->depth)
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_HDR_APP_CBOR_H */
@@ -157,6 +157,95 @@ extern "C" {
 #define HTTP_SERVER_NAME                    "ESP8266 AT Lib"
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` request metrics per route
+ *
+ * When enabled, server counts requests, response codes, bytes sent
+ * and keeps latency histograms for every requested URI path.
+ *
+ * \sa              esp_http_server_get_metrics
+ */
+#ifndef HTTP_USE_METRICS
+#define HTTP_USE_METRICS                    0
+#endif
+
+/**
+ * \brief           Maximal number of routes tracked by metrics
+ *
+ * When table is full, requests for new routes are accounted
+ * in last entry with URI set to `*`
+ *
+ * \note            This has effect only when \ref HTTP_USE_METRICS is enabled
+ */
+#ifndef HTTP_METRICS_MAX_ROUTES
+#define HTTP_METRICS_MAX_ROUTES             8
+#endif
+
+/**
+ * \brief           Maximal length of route URI in metrics table, excluding parameters
+ *
+ * Longer paths are truncated
+ *
+ * \note            This has effect only when \ref HTTP_USE_METRICS is enabled
+ */
+#ifndef HTTP_METRICS_URI_LEN
+#define HTTP_METRICS_URI_LEN                32
+#endif
+
+/**
+ * \brief           Upper bound of first latency histogram bucket in units of milliseconds
+ *
+ * Every next bucket has doubled upper bound, last bucket counts all slower requests
+ *
+ * \note            This has effect only when \ref HTTP_USE_METRICS is enabled
+ */
+#ifndef HTTP_METRICS_HIST_BASE
+#define HTTP_METRICS_HIST_BASE              8
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` built-in status route with metrics report
+ *
+ * Route is available at \ref HTTP_METRICS_STATUS_URI and responds with plain text report.
+ * User file system and CGI handlers are not checked for this URI.
+ *
+ * \note            In order to use this, \ref HTTP_USE_METRICS must be enabled
+ */
+#ifndef HTTP_USE_METRICS_STATUS
+#define HTTP_USE_METRICS_STATUS             0
+#endif
+
+/**
+ * \brief           URI of built-in status route
+ */
+#ifndef HTTP_METRICS_STATUS_URI
+#define HTTP_METRICS_STATUS_URI             "/status"
+#endif
+
+/**
+ * \brief           Root directory of files served by POSIX file system
+ *
+ * Request path is appended to root directory, ex. `/index.html` is opened as `www/index.html`
+ *
+ * \note            This has effect only when `esp_http_server_fs_posix.c` is used as file system
+ */
+#ifndef HTTP_FS_POSIX_ROOT
+#define HTTP_FS_POSIX_ROOT                  "www"
+#endif
+
+/**
+ * \brief           Number of files kept in memory by POSIX file system between requests
+ *
+ * File is read to private memory on open, hence files may be modified or truncated on disk
+ * while they are being sent. Cached file is read again only when it is modified on disk.
+ * When all entries are opened, file is kept only for duration of single request
+ *
+ * \note            This has effect only when `esp_http_server_fs_posix.c` is used as file system
+ */
+#ifndef HTTP_FS_POSIX_CACHE_SIZE
+#define HTTP_FS_POSIX_CACHE_SIZE            8
+#endif
+
 /**
  * \}
  */
@@ -315,7 +404,9 @@ typedef struct {
  * \brief           HTTP response file structure
  */
 typedef struct http_fs_file {
-    const uint8_t* data;                        /*!< Pointer to data array in case file is static */
+    const uint8_t* data;                        /*!< Pointer to data array in case file is static.
+                                                        User file system may set it on open when file is mapped to memory,
+                                                        data is then sent directly and read function is not called */
     uint8_t is_static;                          /*!< Flag indicating file is static and no dynamic read is required */
 
     uint32_t size;                              /*!< Total length of file */
@@ -371,8 +462,66 @@ typedef struct http_state {
     size_t ssi_tag_buff_written;                /*!< Number of bytes written so far to output buffer in case tag is not valid */
     size_t ssi_tag_len;                         /*!< Length of SSI tag */
     size_t ssi_tag_process_more;                /*!< Set to `1` when we have to process tag multiple times */
+
+#if HTTP_USE_METRICS || __DOXYGEN__
+    /* Request metrics */
+    struct http_route_metrics* metrics_route;   /*!< Route entry of current request, `NULL` when request was rejected */
+    uint32_t metrics_start;                     /*!< Time when request headers were received */
+    uint16_t metrics_status;                    /*!< Response status code */
+    uint8_t metrics_active;                     /*!< Set to `1` when request is in progress */
+    uint8_t metrics_first_byte;                 /*!< Set to `1` once first response byte was sent */
+#if HTTP_USE_METRICS_STATUS || __DOXYGEN__
+    char* metrics_report;                       /*!< Allocated report for built-in status route */
+#endif /* HTTP_USE_METRICS_STATUS || __DOXYGEN__ */
+#endif /* HTTP_USE_METRICS || __DOXYGEN__ */
 } http_state_t;
 
+#if HTTP_USE_METRICS || __DOXYGEN__
+
+/**
+ * \brief           Number of buckets in latency histogram
+ */
+#define HTTP_METRICS_HIST_LEN               8
+
+/**
+ * \brief           Latency histogram
+ */
+typedef struct {
+    uint32_t buckets[HTTP_METRICS_HIST_LEN];    /*!< Bucket `i` counts latencies below `HTTP_METRICS_HIST_BASE << i` milliseconds,
+                                                        last bucket counts all others */
+    uint32_t count;                             /*!< Number of samples */
+    uint32_t sum;                               /*!< Sum of all samples in units of milliseconds */
+    uint32_t max;                               /*!< Maximal sample in units of milliseconds */
+} http_metrics_hist_t;
+
+/**
+ * \brief           Metrics of single route
+ */
+typedef struct http_route_metrics {
+    char uri[HTTP_METRICS_URI_LEN + 1];         /*!< Request path without parameters, empty string when entry is not used */
+    uint32_t requests;                          /*!< Number of requests */
+    uint32_t status[5];                         /*!< Number of completed responses per status class, index `0` for `1xx` to index `4` for `5xx` */
+    uint32_t aborted;                           /*!< Number of responses not completed because connection was closed */
+    uint32_t bytes_sent;                        /*!< Number of response bytes sent, including headers */
+    http_metrics_hist_t ttfb;                   /*!< Time from request to first response byte sent */
+    http_metrics_hist_t complete;               /*!< Time from request to last response byte sent */
+} http_route_metrics_t;
+
+/**
+ * \brief           HTTP server metrics
+ */
+typedef struct {
+    uint32_t conns_active;                      /*!< Number of currently active connections */
+    uint32_t conns_max;                         /*!< Maximal number of active connections at the same time */
+    uint32_t conns_total;                       /*!< Number of accepted connections */
+    uint32_t requests;                          /*!< Number of received requests */
+    uint32_t rejected;                          /*!< Number of rejected requests: no memory, invalid URI or method not allowed */
+    uint32_t aborted;                           /*!< Number of transfers aborted before response was completed */
+    http_route_metrics_t routes[HTTP_METRICS_MAX_ROUTES];   /*!< Metrics per route */
+} http_metrics_t;
+
+#endif /* HTTP_USE_METRICS || __DOXYGEN__ */
+
 /**
  * \brief           Write string to HTTP server output
  * \note            May only be called from SSI callback function
@@ -386,6 +535,12 @@ typedef struct http_state {
 espr_t      esp_http_server_init(const http_init_t* init, esp_port_t port);
 size_t      esp_http_server_write(http_state_t* hs, const void* data, size_t len);
 
+#if HTTP_USE_METRICS || __DOXYGEN__
+espr_t      esp_http_server_get_metrics(http_metrics_t* metrics);
+espr_t      esp_http_server_reset_metrics(void);
+size_t      esp_http_server_metrics_report(char* buff, size_t size);
+#endif /* HTTP_USE_METRICS || __DOXYGEN__ */
+
 /**
  * \}
  */
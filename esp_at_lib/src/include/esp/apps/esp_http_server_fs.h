@@ -45,6 +45,13 @@ extern "C" {
  * \defgroup        ESP_APP_HTTP_SERVER_FS_FAT FAT File System
  * \brief           FATFS file system implementation for dynamic files
  * \{
+ *
+ * Same functions are implemented by FATFS (`esp_http_server_fs_fat.c`),
+ * Win32 (`esp_http_server_fs_win32.c`) and POSIX (`esp_http_server_fs_posix.c`) file systems.
+ *
+ * POSIX file system is not zero-copy. It reads every file once to snapshot in private anonymous mapping
+ * and keeps snapshots in cache, see \ref HTTP_FS_POSIX_CACHE_SIZE.
+ * File data pointer is set to snapshot on open, requests served from cache send data without further copying.
  */
 
 uint8_t     http_fs_open(http_fs_file_t* file, const char* path);
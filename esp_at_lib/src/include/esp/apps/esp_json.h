@@ -0,0 +1,176 @@
+/**
+ * \file            esp_json.h
+ * \brief           Streaming JSON writer and parser
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_APP_JSON_H
+#define ESP_HDR_APP_JSON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp/esp.h"
+#include "esp/apps/esp_http_server.h"
+
+/**
+ * \ingroup         ESP_APPS
+ * \defgroup        ESP_APP_JSON Streaming JSON
+ * \brief           JSON writer and SAX style parser without dynamic allocation
+ * \{
+ *
+ * Writer emits document directly to output function, one token at a time.
+ * Built-in outputs are linear buffer, pbuf chain, connection write buffer and HTTP server response.
+ *
+ * Parser is fed with arbitrary pieces of document, such as pbufs received on connection,
+ * and calls user function for every key and value.
+ * Keys, strings and numbers split across pieces are collected in parser structure.
+ */
+
+struct esp_json_writer;
+struct esp_json_parser;
+
+/**
+ * \brief           Writer output function
+ * \param[in]       w: JSON writer
+ * \param[in]       data: Data to output
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Number of bytes accepted by output
+ */
+typedef size_t  (*esp_json_out_fn)(struct esp_json_writer* w, const void* data, size_t len);
+
+/**
+ * \brief           JSON writer structure
+ */
+typedef struct esp_json_writer {
+    esp_json_out_fn out;                        /*!< Output function */
+    void* arg;                                  /*!< Output function argument */
+    size_t size;                                /*!< Output capacity for buffer and pbuf outputs */
+    size_t len;                                 /*!< Number of bytes accepted by output so far */
+    uint32_t first;                             /*!< Bit per nesting level, set when no element was written yet */
+    uint8_t depth;                              /*!< Current nesting depth */
+    uint8_t err;                                /*!< Set to `1` when output did not accept all data */
+} esp_json_writer_t;
+
+/**
+ * \brief           List of token types reported by parser
+ */
+typedef enum {
+    ESP_JSON_TYPE_OBJ_BEGIN,                    /*!< Object begin, `{` */
+    ESP_JSON_TYPE_OBJ_END,                      /*!< Object end, `}` */
+    ESP_JSON_TYPE_ARR_BEGIN,                    /*!< Array begin, `[` */
+    ESP_JSON_TYPE_ARR_END,                      /*!< Array end, `]` */
+    ESP_JSON_TYPE_KEY,                          /*!< Object member key, next token is its value */
+    ESP_JSON_TYPE_STRING,                       /*!< String value, escape sequences are decoded to UTF-8 */
+    ESP_JSON_TYPE_NUMBER,                       /*!< Number value in its original text form */
+    ESP_JSON_TYPE_TRUE,                         /*!< Literal `true` */
+    ESP_JSON_TYPE_FALSE,                        /*!< Literal `false` */
+    ESP_JSON_TYPE_NULL,                         /*!< Literal `null` */
+} esp_json_type_t;
+
+/**
+ * \brief           Parser token callback function
+ * \param[in]       p: JSON parser
+ * \param[in]       type: Token type
+ * \param[in]       data: `0` terminated token text for key, string and number types, `NULL` otherwise
+ * \param[in]       len: Length of token text
+ * \return          \ref espOK to continue parsing, any other value stops parser and is returned from feed function
+ */
+typedef espr_t  (*esp_json_parser_fn)(struct esp_json_parser* p, esp_json_type_t type, const char* data, size_t len);
+
+/**
+ * \brief           JSON parser structure
+ */
+typedef struct esp_json_parser {
+    esp_json_parser_fn fn;                      /*!< Token callback function */
+    void* arg;                                  /*!< User argument */
+    espr_t res;                                 /*!< Result of parsing, kept once parser stops */
+    size_t pos;                                 /*!< Number of bytes processed so far */
+    uint32_t nest;                              /*!< Bit per nesting level, set for array and cleared for object */
+    uint8_t depth;                              /*!< Current nesting depth */
+    uint8_t state;                              /*!< Internal state */
+    uint8_t is_key;                             /*!< Set when current string is object key */
+    uint8_t lit_pos;                            /*!< Position in literal or unicode escape sequence */
+    const char* lit;                            /*!< Literal being matched */
+    uint32_t ucode;                             /*!< Code point of unicode escape sequence */
+    uint32_t surrogate;                         /*!< Pending high surrogate, `0` when none */
+    size_t token_len;                           /*!< Length of collected token */
+    char token[ESP_CFG_JSON_TOKEN_LEN + 1];     /*!< Collected token */
+} esp_json_parser_t;
+
+void        esp_json_writer_init(esp_json_writer_t* w, esp_json_out_fn out, void* arg);
+void        esp_json_writer_init_buff(esp_json_writer_t* w, char* buff, size_t size);
+void        esp_json_writer_init_pbuf(esp_json_writer_t* w, esp_pbuf_p pbuf);
+void        esp_json_writer_init_conn(esp_json_writer_t* w, esp_conn_p conn);
+void        esp_json_writer_init_http(esp_json_writer_t* w, http_state_t* hs);
+
+espr_t      esp_json_obj_begin(esp_json_writer_t* w, const char* key);
+espr_t      esp_json_obj_end(esp_json_writer_t* w);
+espr_t      esp_json_arr_begin(esp_json_writer_t* w, const char* key);
+espr_t      esp_json_arr_end(esp_json_writer_t* w);
+espr_t      esp_json_str(esp_json_writer_t* w, const char* key, const char* str);
+espr_t      esp_json_strn(esp_json_writer_t* w, const char* key, const char* str, size_t len);
+espr_t      esp_json_int(esp_json_writer_t* w, const char* key, int32_t num);
+espr_t      esp_json_uint(esp_json_writer_t* w, const char* key, uint32_t num);
+espr_t      esp_json_bool(esp_json_writer_t* w, const char* key, uint8_t val);
+espr_t      esp_json_null(esp_json_writer_t* w, const char* key);
+espr_t      esp_json_raw(esp_json_writer_t* w, const char* key, const char* raw);
+
+/**
+ * \brief           Get number of bytes accepted by writer output
+ * \param[in]       w: JSON writer
+ * \return          Length of written document
+ * \hideinitializer
+ */
+#define     esp_json_writer_get_len(w)          ((w)->len)
+
+void        esp_json_parser_init(esp_json_parser_t* p, esp_json_parser_fn fn, void* arg);
+espr_t      esp_json_parser_feed(esp_json_parser_t* p, const void* data, size_t len);
+espr_t      esp_json_parser_feed_pbuf(esp_json_parser_t* p, const esp_pbuf_p pbuf);
+espr_t      esp_json_parser_finish(esp_json_parser_t* p);
+
+/**
+ * \brief           Get current nesting depth of parser
+ * \param[in]       p: JSON parser
+ * \return          Nesting depth, `0` for top level value
+ * \hideinitializer
+ */
+#define     esp_json_parser_get_depth(p)        ((p)->depth)
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_HDR_APP_JSON_H */
@@ -0,0 +1,167 @@
+/**
+ * \file            esp_lz.h
+ * \brief           Streaming LZ compression
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_APP_LZ_H
+#define ESP_HDR_APP_LZ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp/esp.h"
+#include "esp/esp_netconn.h"
+#include "esp/apps/esp_mqtt_client.h"
+
+/**
+ * \ingroup         ESP_APPS
+ * \defgroup        ESP_APP_LZ LZ compression
+ * \brief           Streaming LZSS compression with bounded window memory
+ * \{
+ *
+ * Stream consists of groups with one flag byte followed by up to `8` tokens.
+ * Flag bit `0` marks literal byte, flag bit `1` marks 2-byte match token
+ * with distance in upper \ref ESP_CFG_LZ_WINDOW_BITS bits and length in the rest.
+ * Match with distance `0` and length code `0` ends group early, which allows flushing encoder at any time.
+ * Match with distance `0` and length code `1` starts stored block and ends group,
+ * it is followed by block length minus one and by up to \ref ESP_LZ_STORED_MAX uncompressed bytes.
+ * Encoder stores runs of literal-only groups, so incompressible data grow only by block header.
+ *
+ * Encoder and decoder keep state between calls, data may be split at any point.
+ */
+
+#define ESP_LZ_WINDOW_SIZE              (1 << ESP_CFG_LZ_WINDOW_BITS)   /*!< Window size in units of bytes */
+#define ESP_LZ_MIN_MATCH                3                               /*!< Minimal match length */
+#define ESP_LZ_STORED_MAX               256                             /*!< Maximal length of stored block */
+#define ESP_LZ_MAX_MATCH                ((1 << (16 - ESP_CFG_LZ_WINDOW_BITS)) - 1 + ESP_LZ_MIN_MATCH)   /*!< Maximal match length */
+
+/**
+ * \brief           Maximal compressed size for input of `len` bytes, including final flush
+ * \param[in]       len: Input length
+ * \hideinitializer
+ */
+#define ESP_LZ_MAX_COMPRESSED_LEN(len)  ((len) + ((len) + 7) / 8 + 3)
+
+struct esp_lz_enc;
+struct esp_lz_dec;
+
+/**
+ * \brief           Encoder output function
+ * \param[in]       e: LZ encoder
+ * \param[in]       data: Compressed data
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Number of bytes accepted by output
+ */
+typedef size_t  (*esp_lz_out_fn)(struct esp_lz_enc* e, const void* data, size_t len);
+
+/**
+ * \brief           Decoder output function
+ * \param[in]       d: LZ decoder
+ * \param[in]       data: Decompressed data
+ * \param[in]       len: Length of data in units of bytes
+ * \return          \ref espOK to continue, any other value stops decoder and is returned from feed function
+ */
+typedef espr_t  (*esp_lz_dec_fn)(struct esp_lz_dec* d, const void* data, size_t len);
+
+/**
+ * \brief           LZ encoder structure
+ */
+typedef struct esp_lz_enc {
+    esp_lz_out_fn out;                          /*!< Output function */
+    void* arg;                                  /*!< Output function argument */
+    size_t size;                                /*!< Output capacity for buffer output */
+    size_t len;                                 /*!< Number of bytes accepted by output so far */
+    size_t in_len;                              /*!< Number of input bytes so far */
+    uint8_t err;                                /*!< Set to `1` when output did not accept all data */
+
+    uint16_t pos;                               /*!< Position of next byte to encode in buffer */
+    uint16_t end;                               /*!< End of input data in buffer */
+    uint8_t grp[17];                            /*!< Group being built, flag byte and up to `8` tokens */
+    uint8_t grp_len;                            /*!< Length of group in bytes */
+    uint8_t grp_cnt;                            /*!< Number of tokens in group */
+    uint16_t raw_len;                           /*!< Number of literal bytes waiting for stored block */
+    uint8_t raw[ESP_LZ_STORED_MAX];             /*!< Literals of literal-only groups, waiting for stored block */
+    uint16_t head[1 << ESP_CFG_LZ_HASH_BITS];   /*!< Last buffer position per hash value */
+    uint16_t prev[ESP_LZ_WINDOW_SIZE];          /*!< Previous position with same hash per window slot */
+    uint8_t buf[2 * ESP_LZ_WINDOW_SIZE];        /*!< History window followed by data to encode */
+} esp_lz_enc_t;
+
+/**
+ * \brief           LZ decoder structure
+ */
+typedef struct esp_lz_dec {
+    esp_lz_dec_fn fn;                           /*!< Output function */
+    void* arg;                                  /*!< User argument */
+    espr_t res;                                 /*!< Result of decoding, kept once decoder stops */
+    size_t len;                                 /*!< Number of decompressed bytes so far */
+    uint8_t state;                              /*!< Internal state */
+    uint8_t flags;                              /*!< Flags of current group */
+    uint8_t cnt;                                /*!< Remaining tokens in current group */
+    uint8_t b0;                                 /*!< First byte of match token */
+    uint16_t raw;                               /*!< Remaining bytes of stored block */
+    uint16_t wpos;                              /*!< Write position in window */
+    uint16_t flushed;                           /*!< Window position up to which data were reported */
+    uint8_t win[ESP_LZ_WINDOW_SIZE];            /*!< History window */
+} esp_lz_dec_t;
+
+void        esp_lz_enc_init(esp_lz_enc_t* e, esp_lz_out_fn out, void* arg);
+void        esp_lz_enc_init_buff(esp_lz_enc_t* e, void* buff, size_t size);
+void        esp_lz_enc_init_conn(esp_lz_enc_t* e, esp_conn_p conn);
+#if ESP_CFG_NETCONN || __DOXYGEN__
+void        esp_lz_enc_init_netconn(esp_lz_enc_t* e, esp_netconn_p nc);
+#endif /* ESP_CFG_NETCONN || __DOXYGEN__ */
+espr_t      esp_lz_enc_write(esp_lz_enc_t* e, const void* data, size_t len);
+espr_t      esp_lz_enc_flush(esp_lz_enc_t* e);
+
+espr_t      esp_lz_mqtt_publish(esp_mqtt_client_p client, const char* topic, esp_lz_enc_t* e, esp_mqtt_qos_t qos, uint8_t retain, void* arg);
+
+/**
+ * \brief           Get number of compressed bytes accepted by encoder output
+ * \param[in]       e: LZ encoder
+ * \return          Compressed length
+ * \hideinitializer
+ */
+#define     esp_lz_enc_get_len(e)               ((e)->len)
+
+void        esp_lz_dec_init(esp_lz_dec_t* d, esp_lz_dec_fn fn, void* arg);
+espr_t      esp_lz_dec_feed(esp_lz_dec_t* d, const void* data, size_t len);
+espr_t      esp_lz_dec_feed_pbuf(esp_lz_dec_t* d, const esp_pbuf_p pbuf);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_HDR_APP_LZ_H */
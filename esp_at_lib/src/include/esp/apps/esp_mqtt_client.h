@@ -166,6 +166,76 @@ typedef struct {
     } evt;                                      /*!< Event data parameters */
 } esp_mqtt_evt_t;
 
+#if ESP_CFG_MQTT_METRICS || __DOXYGEN__
+
+/**
+ * \brief           Number of buckets in MQTT latency histogram
+ */
+#define ESP_MQTT_METRICS_HIST_LEN           8
+
+/**
+ * \brief           Number of MQTT packet types, used as index for packet counters
+ */
+#define ESP_MQTT_METRICS_PKT_TYPES          16
+
+/**
+ * \brief           Reason of MQTT connection loss
+ */
+typedef enum {
+    ESP_MQTT_DISCONNECT_REASON_USER = 0x00,     /*!< Disconnected by \ref esp_mqtt_client_disconnect */
+    ESP_MQTT_DISCONNECT_REASON_REMOTE,          /*!< Connection closed by server or network */
+    ESP_MQTT_DISCONNECT_REASON_SEND_FAILED,     /*!< Connection closed by client after failed send */
+    ESP_MQTT_DISCONNECT_REASON_REFUSED,         /*!< Server refused connection in CONNACK packet */
+    ESP_MQTT_DISCONNECT_REASON_TCP_FAILED,      /*!< TCP connection to server was not successful */
+    ESP_MQTT_DISCONNECT_REASON_END,             /*!< Last entry, used as number of reasons */
+} esp_mqtt_disconnect_reason_t;
+
+/**
+ * \brief           MQTT latency histogram
+ */
+typedef struct {
+    uint32_t buckets[ESP_MQTT_METRICS_HIST_LEN];/*!< Bucket `i` counts latencies below `ESP_CFG_MQTT_METRICS_HIST_BASE << i` milliseconds,
+                                                    last bucket counts all others */
+    uint32_t count;                             /*!< Number of samples */
+    uint32_t sum;                               /*!< Sum of all samples in units of milliseconds */
+    uint32_t max;                               /*!< Maximal sample in units of milliseconds */
+} esp_mqtt_hist_t;
+
+/**
+ * \brief           Packet and byte counter
+ */
+typedef struct {
+    uint32_t packets;                           /*!< Number of packets */
+    uint32_t bytes;                             /*!< Number of bytes including fixed header */
+} esp_mqtt_pkt_count_t;
+
+/**
+ * \brief           MQTT client runtime metrics
+ */
+typedef struct {
+    esp_mqtt_pkt_count_t tx[ESP_MQTT_METRICS_PKT_TYPES];/*!< Packets written to output buffer, indexed by packet type */
+    esp_mqtt_pkt_count_t rx[ESP_MQTT_METRICS_PKT_TYPES];/*!< Packets received and processed, indexed by packet type */
+    uint32_t rx_dropped;                        /*!< Number of received packets too big for RX buffer */
+
+    esp_mqtt_hist_t pub_ack[3];                 /*!< Publish to acknowledge latency, indexed by quality of service.
+                                                    For \ref ESP_MQTT_QOS_AT_MOST_ONCE, time until packet was sent */
+    esp_mqtt_hist_t keep_alive_rtt;             /*!< Keep-alive PINGREQ to PINGRESP round-trip time */
+
+    uint32_t requests_in_use;                   /*!< Number of currently used request slots */
+    uint32_t requests_max;                      /*!< Maximal number of used request slots at the same time */
+    uint32_t requests_full;                     /*!< Number of times all request slots were in use */
+
+    uint32_t tx_buff_size;                      /*!< Size of output buffer */
+    uint32_t tx_buff_max;                       /*!< Maximal number of bytes in output buffer at the same time */
+    uint32_t tx_buff_full;                      /*!< Number of times packet did not fit to output buffer */
+
+    uint32_t connects;                          /*!< Number of connections accepted by server */
+    uint32_t reconnects;                        /*!< Number of accepted connections after the first one */
+    uint32_t disconnects[ESP_MQTT_DISCONNECT_REASON_END];   /*!< Number of connection losses, indexed by \ref esp_mqtt_disconnect_reason_t */
+} esp_mqtt_client_metrics_t;
+
+#endif /* ESP_CFG_MQTT_METRICS || __DOXYGEN__ */
+
 /**
  * \brief           MQTT event callback function
  * \param[in]       client: MQTT client
@@ -188,6 +258,11 @@ espr_t              esp_mqtt_client_publish(esp_mqtt_client_p client, const char
 void*               esp_mqtt_client_get_arg(esp_mqtt_client_p client);
 void                esp_mqtt_client_set_arg(esp_mqtt_client_p client, void* arg);
 
+#if ESP_CFG_MQTT_METRICS || __DOXYGEN__
+espr_t              esp_mqtt_client_get_metrics(esp_mqtt_client_p client, esp_mqtt_client_metrics_t* metrics);
+espr_t              esp_mqtt_client_reset_metrics(esp_mqtt_client_p client);
+#endif /* ESP_CFG_MQTT_METRICS || __DOXYGEN__ */
+
 /**
  * \}
  */
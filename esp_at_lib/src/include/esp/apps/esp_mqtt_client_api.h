@@ -85,6 +85,10 @@ uint8_t                 esp_mqtt_client_api_is_connected(esp_mqtt_client_api_p c
 espr_t                  esp_mqtt_client_api_receive(esp_mqtt_client_api_p client, esp_mqtt_client_api_buf_p* p, uint32_t timeout);
 void                    esp_mqtt_client_api_buf_free(esp_mqtt_client_api_buf_p p);
 
+#if ESP_CFG_MQTT_METRICS || __DOXYGEN__
+espr_t                  esp_mqtt_client_api_get_metrics(esp_mqtt_client_api_p client, esp_mqtt_client_metrics_t* metrics);
+#endif /* ESP_CFG_MQTT_METRICS || __DOXYGEN__ */
+
 /**
  * \}
  */
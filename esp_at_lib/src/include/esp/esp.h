@@ -48,6 +48,12 @@ extern "C" {
  */
 
 espr_t      esp_init(esp_evt_fn cb_func, const uint32_t blocking);
+
+espr_t      esp_runtime_cfg_set(const esp_runtime_cfg_t* cfg);
+espr_t      esp_runtime_cfg_tune(const esp_runtime_cfg_t* cfg);
+espr_t      esp_runtime_cfg_get(esp_runtime_cfg_t* cfg);
+size_t      esp_get_conn_max_data_len(void);
+
 espr_t      esp_reset(const esp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking);
 espr_t      esp_reset_with_delay(uint32_t delay, const esp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking);
 
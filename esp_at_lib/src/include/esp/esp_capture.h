@@ -0,0 +1,71 @@
+/**
+ * \file            esp_capture.h
+ * \brief           AT link capture tap
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_CAPTURE_H
+#define ESP_HDR_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp/esp.h"
+
+/**
+ * \ingroup         ESP
+ * \defgroup        ESP_CAPTURE AT link capture
+ * \brief           Capture of AT link traffic in pcapng format
+ * \{
+ *
+ * Every byte sent to device and received from device is recorded
+ * as Enhanced Packet Block with microsecond timestamp and direction flag.
+ *
+ * Capture uses `LINKTYPE_USER0` (`147`) link type. Consecutive writes to low-level send function
+ * are combined to single packet until flush is requested,
+ * so one packet usually holds one full AT command.
+ */
+
+espr_t          esp_capture_start(esp_capture_out_fn out_fn, void* arg);
+espr_t          esp_capture_start_ring(size_t size);
+espr_t          esp_capture_stop(void);
+size_t          esp_capture_read(void* data, size_t len);
+espr_t          esp_capture_get_stats(esp_capture_stats_t* stats);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_HDR_CAPTURE_H */
@@ -102,6 +102,36 @@
 #define ESP_CFG_MEM_ALIGNMENT               4
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` memory region affinity for allocations
+ *
+ * Every memory region assigned with \ref esp_mem_assignmemory has memory class.
+ * Hot objects, such as API messages and small packet buffers, are allocated from
+ * \ref ESP_MEM_CLASS_FAST regions, large buffers from \ref ESP_MEM_CLASS_BULK regions.
+ * When regions of requested class are exhausted, allocation falls back to other classes.
+ *
+ * \note            Not used when \ref ESP_CFG_MEM_CUSTOM is enabled
+ */
+#ifndef ESP_CFG_MEM_AFFINITY
+#define ESP_CFG_MEM_AFFINITY                0
+#endif
+
+/**
+ * \brief           Maximal number of memory regions when \ref ESP_CFG_MEM_AFFINITY is enabled
+ */
+#ifndef ESP_CFG_MEM_MAX_REGIONS
+#define ESP_CFG_MEM_MAX_REGIONS             4
+#endif
+
+/**
+ * \brief           Maximal packet buffer payload length allocated from \ref ESP_MEM_CLASS_FAST memory
+ *
+ * Longer packet buffers are allocated from \ref ESP_MEM_CLASS_BULK memory
+ */
+#ifndef ESP_CFG_MEM_FAST_PBUF_LEN
+#define ESP_CFG_MEM_FAST_PBUF_LEN           128
+#endif
+
 /**
  * \brief           Enables `1` or disables `0` callback function and custom parameter for API functions
  *
@@ -129,6 +159,8 @@
  * \note            This is limitation of ESP AT commands and on systems where RAM
  *                  is not an issue, it should be set to maximal value (`2048`)
  *                  to optimize data transfer speed performance
+ *
+ * \note            Value is default and upper bound for \ref esp_runtime_cfg_t.conn_max_data_len
  */
 #ifndef ESP_CFG_CONN_MAX_DATA_LEN
 #define ESP_CFG_CONN_MAX_DATA_LEN           2048
@@ -144,15 +176,118 @@
 #define ESP_CFG_MAX_SEND_RETRIES            3
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` adaptive chunk size for `AT+CIPSEND` command
+ *
+ * Each connection starts with chunks of \ref esp_runtime_cfg_t.conn_max_data_len bytes.
+ * Size is halved on `SEND FAIL` and reduced when time to send chunk rises well above its average,
+ * it is increased again after several chunks are sent successfully.
+ * Retry after failure is sent with already reduced size.
+ *
+ * \sa              esp_conn_get_chunk_stats
+ */
+#ifndef ESP_CFG_CONN_ADAPTIVE_CHUNK
+#define ESP_CFG_CONN_ADAPTIVE_CHUNK         0
+#endif
+
+/**
+ * \brief           Minimal chunk size for single `AT+CIPSEND` command in units of bytes
+ *
+ * \note            Used only when \ref ESP_CFG_CONN_ADAPTIVE_CHUNK is enabled
+ */
+#ifndef ESP_CFG_CONN_ADAPTIVE_CHUNK_MIN
+#define ESP_CFG_CONN_ADAPTIVE_CHUNK_MIN     128
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` buffered send with `AT+CIPSENDBUF` command on \e TCP connections
+ *
+ * With `AT+CIPSEND`, every chunk of data waits for `SEND OK` before next one may start.
+ * Buffered send queues chunks to TCP send buffer of ESP8266 module and continues immediately,
+ * while module reports `<link>,<segment>,SEND OK` asynchronously.
+ *
+ * \note            When enabled, \ref ESP_EVT_CONN_SEND reports data accepted by module.
+ *                  Use \ref esp_conn_get_sendbuf_pending to check segments not yet acknowledged.
+ *                  Segment later reported with `SEND FAIL` is notified with \ref ESP_EVT_CONN_SEND_FAIL
+ * \note            When firmware rejects the command with plain `ERROR` before it was ever accepted,
+ *                  library falls back to `AT+CIPSEND` until next device reset.
+ *                  `busy` and `link is not valid` replies never trigger the fallback
+ */
+#ifndef ESP_CFG_CONN_SENDBUF
+#define ESP_CFG_CONN_SENDBUF                0
+#endif
+
+/**
+ * \brief           Maximal number of segments queued in module per connection before waiting for `SEND OK`
+ *
+ * \note            Used only when \ref ESP_CFG_CONN_SENDBUF is enabled
+ */
+#ifndef ESP_CFG_CONN_SENDBUF_SEGMENTS
+#define ESP_CFG_CONN_SENDBUF_SEGMENTS       4
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` token bucket rate limiting on connections
+ *
+ * Limits are set in bytes per second and burst size, separately for transmit and receive direction,
+ * per connection with \ref esp_conn_set_rate_limit and for all connections together
+ * with \ref esp_conn_set_global_rate_limit.
+ *
+ * Transmit data are charged before command is put to producer queue.
+ * Blocking send waits until bucket is out of debt. Non-blocking send returns immediately,
+ * its message is held by library and put to producer queue when bucket is out of debt.
+ * Send also waits until its charge keeps bucket debt within burst size.
+ * Debt is limited to burst size, hence sends longer than twice the burst are not fully charged.
+ * Receive data are charged when delivered to application. With \ref ESP_CFG_CONN_MANUAL_TCP_RECEIVE
+ * enabled data stay in ESP device until bucket allows next read, otherwise they are only accounted.
+ *
+ * \note            \ref ESP_EVT_CONN_THROTTLED is sent when bucket of connection runs out of tokens
+ */
+#ifndef ESP_CFG_CONN_RATE_LIMIT
+#define ESP_CFG_CONN_RATE_LIMIT             0
+#endif
+
 /**
  * \brief           Maximum single buffer size for network receive data on active connection
  *
  * \note            When ESP sends buffer bigger than maximal, multiple buffers are created
+ * \note            Value is default and upper bound for \ref esp_runtime_cfg_t.conn_max_recv_buff_size
  */
 #ifndef ESP_CFG_CONN_MAX_RECV_BUFF_SIZE
 #define ESP_CFG_CONN_MAX_RECV_BUFF_SIZE     1460
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` adaptive receive buffer sizing
+ *
+ * Packet buffer size for `+IPD` data is chosen according to amount of data
+ * typically received on connection at once. Consecutive \e TCP packets on the same connection
+ * are stored to shared packet buffer, to reduce number of memory allocations.
+ *
+ * \note            Coalesced data are sent to application latest when currently received
+ *                  block of data from AT port is processed or when any other message is received
+ */
+#ifndef ESP_CFG_IPD_ADAPTIVE
+#define ESP_CFG_IPD_ADAPTIVE                0
+#endif
+
+/**
+ * \brief           Default policy for remote IP and port information in `+IPD` statement
+ *
+ * Value is member of \ref esp_ipd_info_t enumeration:
+ *
+ *  - `0`: \ref ESP_IPD_INFO_ALWAYS, every `+IPD` includes remote IP and port
+ *  - `1`: \ref ESP_IPD_INFO_AUTO, information is enabled only when \e UDP connection is used
+ *  - `2`: \ref ESP_IPD_INFO_NEVER, information is never enabled
+ *
+ * When information is disabled, cached remote address of connection is reported for received data.
+ *
+ * \sa              esp_conn_set_ipd_info_policy
+ */
+#ifndef ESP_CFG_IPD_INFO_POLICY
+#define ESP_CFG_IPD_INFO_POLICY             0
+#endif
+
 /**
  * \brief           Default baudrate used for AT port
  *
@@ -190,6 +325,7 @@
  *                  will have more time to process all the incoming bytes
  *
  * \note            This parameter has no meaning when \ref ESP_CFG_INPUT_USE_PROCESS is enabled
+ * \note            Value is default and upper bound for \ref esp_runtime_cfg_t.rcv_buff_size
  */
 #ifndef ESP_CFG_RCV_BUFF_SIZE
 #define ESP_CFG_RCV_BUFF_SIZE               0x400
@@ -412,6 +548,8 @@
  * \brief           Set number of message queue entries for procuder thread
  *
  * Message queue is used for storing memory address to command data
+ *
+ * \note            Value is default and upper bound for \ref esp_runtime_cfg_t.producer_mbox_size
  */
 #ifndef ESP_CFG_THREAD_PRODUCER_MBOX_SIZE
 #define ESP_CFG_THREAD_PRODUCER_MBOX_SIZE   16
@@ -421,6 +559,8 @@
  * \brief           Set number of message queue entries for processing thread
  *
  * Message queue is used to notify processing thread about new received data on AT port
+ *
+ * \note            Value is default and upper bound for \ref esp_runtime_cfg_t.process_mbox_size
  */
 #ifndef ESP_CFG_THREAD_PROCESS_MBOX_SIZE
 #define ESP_CFG_THREAD_PROCESS_MBOX_SIZE    16
@@ -465,6 +605,41 @@
 #define ESP_THREAD_PROCESS_HOOK()
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` stack high-water tracking for threads
+ *
+ * Threads created with \ref esp_sys_thread_create are recorded by system port
+ * and their maximal stack usage is reported by \ref esp_sys_thread_get_stack_stats.
+ *
+ * \note            System port must support it, Linux port paints thread stack on start,
+ *                  up to \ref ESP_CFG_THREAD_STACK_STATS_PAINT_MAX bytes
+ */
+#ifndef ESP_CFG_THREAD_STACK_STATS
+#define ESP_CFG_THREAD_STACK_STATS          0
+#endif
+
+/**
+ * \brief           Maximal number of threads tracked at a time for stack high-water report
+ *
+ * \note            This has effect only when \ref ESP_CFG_THREAD_STACK_STATS is enabled
+ */
+#ifndef ESP_CFG_THREAD_STACK_STATS_MAX
+#define ESP_CFG_THREAD_STACK_STATS_MAX      8
+#endif
+
+/**
+ * \brief           Maximal number of stack bytes painted per thread
+ *
+ * Painting touches every painted byte. Thread with bigger stack, for example
+ * created with default stack size of the system, is painted and scanned only in top window of this size
+ * and its usage is reported up to this value.
+ *
+ * \note            This has effect only when \ref ESP_CFG_THREAD_STACK_STATS is enabled
+ */
+#ifndef ESP_CFG_THREAD_STACK_STATS_PAINT_MAX
+#define ESP_CFG_THREAD_STACK_STATS_PAINT_MAX    0x10000
+#endif
+
 /**
  * \}
  */
@@ -518,6 +693,8 @@
  * \brief           Receive queue length for pbuf entries
  *
  * Defines maximal number of pbuf data packet references for receive
+ *
+ * \note            Value is default and upper bound for \ref esp_runtime_cfg_t.netconn_receive_queue_len
  */
 #ifndef ESP_CFG_NETCONN_RECEIVE_QUEUE_LEN
 #define ESP_CFG_NETCONN_RECEIVE_QUEUE_LEN   8
@@ -536,11 +713,36 @@
 /**
  * \brief           Maximal number of open MQTT requests at a time
  *
+ * \note            Value is default and upper bound for \ref esp_runtime_cfg_t.mqtt_max_requests
  */
 #ifndef ESP_CFG_MQTT_MAX_REQUESTS
 #define ESP_CFG_MQTT_MAX_REQUESTS           8
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` MQTT client runtime metrics
+ *
+ * When enabled, every client counts packets and bytes per packet type,
+ * publish acknowledge latency, request and output buffer usage,
+ * keep-alive round-trip time and disconnect reasons.
+ *
+ * \sa              esp_mqtt_client_get_metrics
+ */
+#ifndef ESP_CFG_MQTT_METRICS
+#define ESP_CFG_MQTT_METRICS                0
+#endif
+
+/**
+ * \brief           Upper bound of first MQTT latency histogram bucket in units of milliseconds
+ *
+ * Every next bucket has doubled upper bound, last bucket counts all slower samples
+ *
+ * \note            This has effect only when \ref ESP_CFG_MQTT_METRICS is enabled
+ */
+#ifndef ESP_CFG_MQTT_METRICS_HIST_BASE
+#define ESP_CFG_MQTT_METRICS_HIST_BASE      16
+#endif
+
 /**
  * \brief           Set debug level for MQTT client module
  *
@@ -578,6 +780,95 @@
 #define ESP_CFG_DBG_CAYENNE                 ESP_DBG_OFF
 #endif
 
+/**
+ * \}
+ */
+
+/**
+ * \defgroup        ESP_CONFIG_MODULES_JSON JSON module
+ * \brief           Configuration of streaming JSON writer and parser
+ * \{
+ */
+
+/**
+ * \brief           Maximal nesting depth of objects and arrays for JSON writer and parser
+ *
+ * \note            Value must not be greater than `32`
+ */
+#ifndef ESP_CFG_JSON_MAX_DEPTH
+#define ESP_CFG_JSON_MAX_DEPTH              8
+#endif
+
+/**
+ * \brief           Maximal length of single key, string or number token in JSON parser
+ *
+ * Token is collected in parser structure to allow values split across pbufs.
+ * Longer tokens stop parsing with \ref espERRMEM error
+ */
+#ifndef ESP_CFG_JSON_TOKEN_LEN
+#define ESP_CFG_JSON_TOKEN_LEN              64
+#endif
+
+/**
+ * \}
+ */
+
+/**
+ * \defgroup        ESP_CONFIG_MODULES_CBOR CBOR module
+ * \brief           Configuration of streaming CBOR encoder and decoder
+ * \{
+ */
+
+/**
+ * \brief           Maximal nesting depth of arrays and maps for CBOR decoder
+ *
+ * \note            Value must not be greater than `32`
+ */
+#ifndef ESP_CFG_CBOR_MAX_DEPTH
+#define ESP_CFG_CBOR_MAX_DEPTH              8
+#endif
+
+/**
+ * \}
+ */
+
+/**
+ * \defgroup        ESP_CONFIG_MODULES_LZ LZ compression module
+ * \brief           Configuration of streaming LZ compression
+ * \{
+ */
+
+/**
+ * \brief           Number of bits for LZ window size
+ *
+ * Window of `2 ^ bits` bytes is kept by decoder, encoder needs about `4` times as much memory.
+ * Remaining bits of 16-bit match token define maximal match length.
+ * Encoder and decoder must use the same value.
+ *
+ * \note            Value must be between `9` and `12`
+ */
+#ifndef ESP_CFG_LZ_WINDOW_BITS
+#define ESP_CFG_LZ_WINDOW_BITS              10
+#endif
+
+/**
+ * \brief           Number of bits for LZ encoder hash table
+ *
+ * Hash table uses `2 * 2 ^ bits` bytes of memory
+ */
+#ifndef ESP_CFG_LZ_HASH_BITS
+#define ESP_CFG_LZ_HASH_BITS                8
+#endif
+
+/**
+ * \brief           Maximal number of candidates LZ encoder checks for each match
+ *
+ * Larger value gives better compression at cost of processing time
+ */
+#ifndef ESP_CFG_LZ_MAX_CHAIN
+#define ESP_CFG_LZ_MAX_CHAIN                16
+#endif
+
 /**
  * \}
  */
@@ -638,6 +929,276 @@
 #define ESP_CFG_SMART                       0
 #endif
 
+/**
+ * \defgroup        ESP_CONFIG_MODULES_PM Power manager
+ * \brief           Configuration of traffic aware power manager
+ * \{
+ */
+
+/**
+ * \brief           Enables `1` or disables `0` power manager
+ *
+ * When enabled, device is put to sleep mode after configurable idle time
+ * and woken up automatically before next command is sent to it.
+ *
+ * \note            Manager must be started by application with \ref esp_pm_enable
+ */
+#ifndef ESP_CFG_PM
+#define ESP_CFG_PM                          0
+#endif
+
+/**
+ * \brief           Default sleep mode used by power manager
+ *
+ * Value must be a member of \ref esp_sleep_mode_t enumeration
+ */
+#ifndef ESP_CFG_PM_SLEEP_MODE
+#define ESP_CFG_PM_SLEEP_MODE               ESP_SLEEP_MODEM
+#endif
+
+/**
+ * \brief           Default idle time in units of milliseconds before device is put to sleep
+ */
+#ifndef ESP_CFG_PM_IDLE_TIME
+#define ESP_CFG_PM_IDLE_TIME                1000
+#endif
+
+/**
+ * \brief           Default wakeup latency in units of milliseconds
+ *
+ * Time between wakeup pin activation and first AT command sent to device
+ */
+#ifndef ESP_CFG_PM_WAKEUP_LATENCY
+#define ESP_CFG_PM_WAKEUP_LATENCY           0
+#endif
+
+/**
+ * \brief           Set debug level for power manager
+ *
+ * Possible values are \ref ESP_DBG_ON or \ref ESP_DBG_OFF
+ */
+#ifndef ESP_CFG_DBG_PM
+#define ESP_CFG_DBG_PM                      ESP_DBG_OFF
+#endif
+
+/**
+ * \}
+ */
+
+/**
+ * \defgroup        ESP_CONFIG_MODULES_LINKQ Link quality monitor
+ * \brief           Configuration of link quality monitor
+ * \{
+ */
+
+/**
+ * \brief           Enables `1` or disables `0` link quality monitor
+ *
+ * Monitor periodically reads RSSI of connected access point
+ * and tracks reconnections and send failures.
+ *
+ * \note            Station mode must be enabled
+ * \sa              ESP_CFG_MODE_STATION
+ */
+#ifndef ESP_CFG_LINKQ
+#define ESP_CFG_LINKQ                       0
+#endif
+
+/**
+ * \brief           Default RSSI sampling interval in units of milliseconds
+ *
+ * Used when \ref esp_linkq_start is called with `0` as interval
+ */
+#ifndef ESP_CFG_LINKQ_INTERVAL
+#define ESP_CFG_LINKQ_INTERVAL              5000
+#endif
+
+/**
+ * \brief           RSSI smoothing factor as power of `2`
+ *
+ * Each new sample contributes `1 / (2 ^ value)` to smoothed RSSI value
+ */
+#ifndef ESP_CFG_LINKQ_SMOOTH_SHIFT
+#define ESP_CFG_LINKQ_SMOOTH_SHIFT          2
+#endif
+
+/**
+ * \brief           Minimal smoothed RSSI in units of dBm for link to be considered good
+ */
+#ifndef ESP_CFG_LINKQ_RSSI_GOOD
+#define ESP_CFG_LINKQ_RSSI_GOOD             -67
+#endif
+
+/**
+ * \brief           Smoothed RSSI in units of dBm below which link is considered poor
+ */
+#ifndef ESP_CFG_LINKQ_RSSI_POOR
+#define ESP_CFG_LINKQ_RSSI_POOR             -80
+#endif
+
+/**
+ * \brief           Hysteresis in units of dB to apply when link level improves
+ *
+ * Prevents level from toggling when RSSI oscillates around threshold
+ */
+#ifndef ESP_CFG_LINKQ_HYSTERESIS
+#define ESP_CFG_LINKQ_HYSTERESIS            3
+#endif
+
+/**
+ * \brief           Smoothed send failure ratio in units of percent
+ *                  at which link level is degraded by one step
+ */
+#ifndef ESP_CFG_LINKQ_FAIL_RATIO
+#define ESP_CFG_LINKQ_FAIL_RATIO            20
+#endif
+
+/**
+ * \brief           Set debug level for link quality monitor
+ *
+ * Possible values are \ref ESP_DBG_ON or \ref ESP_DBG_OFF
+ */
+#ifndef ESP_CFG_DBG_LINKQ
+#define ESP_CFG_DBG_LINKQ                   ESP_DBG_OFF
+#endif
+
+/**
+ * \}
+ */
+
+/**
+ * \defgroup        ESP_CONFIG_MODULES_CAPTURE AT link capture
+ * \brief           Configuration of AT link capture tap
+ * \{
+ */
+
+/**
+ * \brief           Enables `1` or disables `0` AT link capture tap
+ *
+ * When enabled, every byte sent with low-level send function
+ * and every byte received with \ref esp_input or \ref esp_input_process
+ * can be recorded in pcapng format.
+ *
+ * \note            Capture must be started by application with \ref esp_capture_start
+ *                  or \ref esp_capture_start_ring
+ */
+#ifndef ESP_CFG_CAPTURE
+#define ESP_CFG_CAPTURE                     0
+#endif
+
+/**
+ * \brief           Size of transmit aggregation buffer in units of bytes
+ *
+ * Small writes to low-level send function are combined to single record
+ * until flush is requested or buffer is full
+ */
+#ifndef ESP_CFG_CAPTURE_TX_BUFF_SIZE
+#define ESP_CFG_CAPTURE_TX_BUFF_SIZE        256
+#endif
+
+/**
+ * \brief           Get current time for capture records in units of microseconds
+ *
+ * Default implementation uses \ref esp_sys_now and has millisecond resolution,
+ * while file header declares microsecond resolution.
+ * Ports should provide microsecond timer read, free running hardware timer or monotonic system clock,
+ * to show gaps and stalls shorter than millisecond.
+ *
+ * \note            Value must be of `uint64_t` type
+ */
+#ifndef ESP_CFG_CAPTURE_TIME_US
+#define ESP_CFG_CAPTURE_TIME_US()           ((uint64_t)esp_sys_now() * 1000U)
+#endif
+
+/**
+ * \}
+ */
+
+/**
+ * \defgroup        ESP_CONFIG_MODULES_EVT_TIMESTAMP Event timestamps
+ * \brief           Configuration of event timestamps and sequence numbers
+ * \{
+ */
+
+/**
+ * \brief           Enables `1` or disables `0` event timestamps
+ *
+ * When enabled, every event carries global sequence number,
+ * arrival time of input data which triggered it and time of dispatch to callback.
+ * Received packet buffers carry arrival time of their last byte
+ * and time when they were passed to application.
+ *
+ * Difference between times gives queueing delay inside the stack.
+ *
+ * \sa              esp_evt_get_seq, esp_evt_get_time_input, esp_evt_get_time_dispatch, esp_pbuf_get_time_input
+ */
+#ifndef ESP_CFG_EVT_TIMESTAMP
+#define ESP_CFG_EVT_TIMESTAMP               0
+#endif
+
+/**
+ * \brief           Get current time for event timestamps
+ *
+ * Default implementation uses \ref esp_sys_now and has millisecond resolution,
+ * queueing delays inside the stack are mostly shorter.
+ * Ports should provide microsecond timer read, same as for \ref ESP_CFG_CAPTURE_TIME_US,
+ * truncated to `32-bit`.
+ *
+ * \note            Value must be of `uint32_t` type, monotonic and may overflow
+ */
+#ifndef ESP_CFG_EVT_TIMESTAMP_NOW
+#define ESP_CFG_EVT_TIMESTAMP_NOW()         esp_sys_now()
+#endif
+
+/**
+ * \brief           Number of input arrival times kept between \ref esp_input and processing thread
+ *
+ * Each call to \ref esp_input records its time. When more calls are pending than this value,
+ * their data are assigned time of the next recorded call.
+ *
+ * \note            Not used when \ref ESP_CFG_INPUT_USE_PROCESS is enabled
+ */
+#ifndef ESP_CFG_EVT_TIMESTAMP_INPUT_MARKS
+#define ESP_CFG_EVT_TIMESTAMP_INPUT_MARKS   8
+#endif
+
+/**
+ * \}
+ */
+
+/**
+ * \defgroup        ESP_CONFIG_MODULES_EVT_POLL Pollable event queue
+ * \brief           Configuration of event delivery through pollable descriptor
+ * \{
+ */
+
+/**
+ * \brief           Enables `1` or disables `0` pollable event queue
+ *
+ * When enabled, events can be delivered to application thread
+ * through descriptor usable with `select`, `poll` or `epoll`.
+ *
+ * \note            Available on POSIX systems only
+ * \sa              ESP_EVT_POLL
+ */
+#ifndef ESP_CFG_EVT_POLL
+#define ESP_CFG_EVT_POLL                    0
+#endif
+
+/**
+ * \brief           Maximal number of events waiting in queue
+ *
+ * When queue is full, connection lifecycle events are held in overflow list
+ * and other events are dropped
+ */
+#ifndef ESP_CFG_EVT_POLL_QUEUE_LEN
+#define ESP_CFG_EVT_POLL_QUEUE_LEN          32
+#endif
+
+/**
+ * \}
+ */
+
 /**
  * \}
  */
@@ -754,6 +1315,14 @@ void *  my_memset(void* dst, int b, size_t len);
 #error "At least one of ESP_CFG_ESP8266 or ESP_CFG_ESP32 must be set to 1!"
 #endif /* !ESP_CFG_ESP8266 && !ESP_CFG_ESP32 */
 
+/* Link quality monitor config */
+#if ESP_CFG_LINKQ && !ESP_CFG_MODE_STATION
+#error "Link quality monitor may only be used when station mode is enabled!"
+#endif /* ESP_CFG_LINKQ && !ESP_CFG_MODE_STATION */
+#if ESP_CFG_LINKQ && !ESP_CFG_USE_API_FUNC_EVT
+#error "Link quality monitor requires ESP_CFG_USE_API_FUNC_EVT to be enabled!"
+#endif /* ESP_CFG_LINKQ && !ESP_CFG_USE_API_FUNC_EVT */
+
 /* WPS config */
 #if ESP_CFG_WPS && !ESP_CFG_MODE_STATION
 #error "WPS function may only be used when station mode is enabled!"
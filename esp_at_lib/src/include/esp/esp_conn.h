@@ -61,11 +61,22 @@ uint8_t     esp_conn_is_active(esp_conn_p conn);
 uint8_t     esp_conn_is_closed(esp_conn_p conn);
 int8_t      esp_conn_getnum(esp_conn_p conn);
 espr_t      esp_conn_set_ssl_buffersize(size_t size, const uint32_t blocking);
+espr_t      esp_conn_set_ipd_info_policy(esp_ipd_info_t policy, const esp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking);
 espr_t      esp_get_conns_status(const uint32_t blocking);
 esp_conn_p  esp_conn_get_from_evt(esp_evt_t* evt);
 espr_t      esp_conn_write(esp_conn_p conn, const void* data, size_t btw, uint8_t flush, size_t* const mem_available);
 espr_t      esp_conn_recved(esp_conn_p conn, esp_pbuf_p pbuf);
 size_t      esp_conn_get_total_recved_count(esp_conn_p conn);
+size_t      esp_conn_get_sendbuf_pending(esp_conn_p conn);
+size_t      esp_conn_get_active_count(void);
+espr_t      esp_conn_get_ipd_stats(esp_conn_ipd_stats_t* stats);
+#if ESP_CFG_CONN_ADAPTIVE_CHUNK || __DOXYGEN__
+espr_t      esp_conn_get_chunk_stats(esp_conn_p conn, esp_conn_chunk_stats_t* stats);
+#endif /* ESP_CFG_CONN_ADAPTIVE_CHUNK || __DOXYGEN__ */
+#if ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__
+espr_t      esp_conn_set_rate_limit(esp_conn_p conn, const esp_conn_rate_limit_t* tx, const esp_conn_rate_limit_t* rx);
+espr_t      esp_conn_set_global_rate_limit(const esp_conn_rate_limit_t* tx, const esp_conn_rate_limit_t* rx);
+#endif /* ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__ */
 
 uint8_t     esp_conn_get_remote_ip(esp_conn_p conn, esp_ip_t* ip);
 esp_port_t  esp_conn_get_remote_port(esp_conn_p conn);
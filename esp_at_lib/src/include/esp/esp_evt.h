@@ -51,6 +51,12 @@ espr_t          esp_evt_register(esp_evt_fn fn);
 espr_t          esp_evt_unregister(esp_evt_fn fn);
 esp_evt_type_t  esp_evt_get_type(esp_evt_t* cc);
 
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+uint32_t        esp_evt_get_seq(esp_evt_t* cc);
+uint32_t        esp_evt_get_time_input(esp_evt_t* cc);
+uint32_t        esp_evt_get_time_dispatch(esp_evt_t* cc);
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
+
 /**
  * \anchor          ESP_EVT_RESET_DETECTED
  * \name            Reset detected
@@ -146,11 +152,31 @@ esp_conn_p  esp_evt_conn_recv_get_conn(esp_evt_t* cc);
 esp_conn_p  esp_evt_conn_send_get_conn(esp_evt_t* cc);
 size_t      esp_evt_conn_send_get_length(esp_evt_t* cc);
 espr_t      esp_evt_conn_send_get_result(esp_evt_t* cc);
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+uint32_t    esp_evt_conn_send_get_time_queued(esp_evt_t* cc);
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
 
 /**
  * \}
  */
 
+#if ESP_CFG_CONN_SENDBUF || __DOXYGEN__
+
+/**
+ * \anchor          ESP_EVT_CONN_SEND_FAIL
+ * \name            Connection buffered segment failed
+ * \brief           Event helper functions for \ref ESP_EVT_CONN_SEND_FAIL event
+ */
+
+esp_conn_p  esp_evt_conn_send_fail_get_conn(esp_evt_t* cc);
+uint32_t    esp_evt_conn_send_fail_get_segment(esp_evt_t* cc);
+
+/**
+ * \}
+ */
+
+#endif /* ESP_CFG_CONN_SENDBUF || __DOXYGEN__ */
+
 /**
  * \anchor          ESP_EVT_CONN_ACTIVE
  * \name            Connection active
@@ -191,6 +217,25 @@ esp_conn_p  esp_evt_conn_poll_get_conn(esp_evt_t* cc);
  * \}
  */
 
+#if ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__
+
+/**
+ * \anchor          ESP_EVT_CONN_THROTTLED
+ * \name            Connection throttled
+ * \brief           Event helper functions for \ref ESP_EVT_CONN_THROTTLED event
+ */
+
+esp_conn_p  esp_evt_conn_throttled_get_conn(esp_evt_t* cc);
+uint8_t     esp_evt_conn_throttled_is_rx(esp_evt_t* cc);
+uint8_t     esp_evt_conn_throttled_is_global(esp_evt_t* cc);
+uint32_t    esp_evt_conn_throttled_get_wait(esp_evt_t* cc);
+
+/**
+ * \}
+ */
+
+#endif /* ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__ */
+
 /**
  * \anchor          ESP_EVT_CONN_ERROR
  * \name            Connection error
@@ -274,6 +319,34 @@ const char* esp_evt_ping_get_host(esp_evt_t* cc);
 uint32_t    esp_evt_ping_get_time(esp_evt_t* cc);
 
 
+/**
+ * \}
+ */
+
+/**
+ * \anchor          ESP_EVT_LINKQ_CHANGED
+ * \name            Link quality
+ * \brief           Event helper functions for \ref ESP_EVT_LINKQ_CHANGED event
+ */
+
+esp_linkq_level_t   esp_evt_linkq_get_level(esp_evt_t* cc);
+esp_linkq_level_t   esp_evt_linkq_get_level_prev(esp_evt_t* cc);
+int16_t             esp_evt_linkq_get_rssi(esp_evt_t* cc);
+
+/**
+ * \}
+ */
+
+/**
+ * \anchor          ESP_EVT_PM_CHANGED
+ * \name            Power manager
+ * \brief           Event helper functions for \ref ESP_EVT_PM_CHANGED event
+ */
+
+espr_t              esp_evt_pm_get_result(esp_evt_t* cc);
+esp_sleep_mode_t    esp_evt_pm_get_mode(esp_evt_t* cc);
+uint32_t            esp_evt_pm_get_wakeup_time(esp_evt_t* cc);
+
 /**
  * \}
  */
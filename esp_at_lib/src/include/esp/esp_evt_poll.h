@@ -0,0 +1,92 @@
+/**
+ * \file            esp_evt_poll.h
+ * \brief           Pollable event queue
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_EVT_POLL_H
+#define ESP_HDR_EVT_POLL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "esp/esp.h"
+
+/**
+ * \ingroup         ESP_EVT
+ * \defgroup        ESP_EVT_POLL Pollable event queue
+ * \brief           Events delivered to application thread through pollable descriptor
+ * \{
+ *
+ * Instead of processing events in callbacks on library threads,
+ * application sets \ref esp_evt_poll_evt_fn as global callback and as callback of connections.
+ * Events are copied to queue and descriptor returned by \ref esp_evt_poll_get_fd
+ * becomes readable while queue is not empty. Descriptor can be added to `select`, `poll` or `epoll` loop,
+ * where events are drained with \ref esp_evt_poll.
+ *
+ * Implementation uses `eventfd` on Linux and `pipe` on other POSIX systems.
+ *
+ * \note            Events are processed after callback returned. Data pointers in event,
+ *                  except packet buffer and connection handle, are only valid when they point
+ *                  to memory provided by application in API call.
+ *                  Connection handle may already be closed when event is processed,
+ *                  and may even have been reused by new connection already.
+ *                  Track handles with \ref ESP_EVT_CONN_ACTIVE and \ref ESP_EVT_CONN_CLOSE events
+ *                  in queue order instead of checking connection state directly.
+ *
+ * \note            For \ref ESP_EVT_CONN_RECV event, application owns one reference to packet buffer
+ *                  and must free it with \ref esp_pbuf_free.
+ *                  When \ref ESP_CFG_CONN_MANUAL_TCP_RECEIVE is enabled, application must also call \ref esp_conn_recved.
+ *
+ * Queue length is set with \ref ESP_CFG_EVT_POLL_QUEUE_LEN. When queue is full,
+ * connection lifecycle events \ref ESP_EVT_CONN_ACTIVE, \ref ESP_EVT_CONN_RECV, \ref ESP_EVT_CONN_CLOSE
+ * and \ref ESP_EVT_CONN_ERROR are not dropped. Received data is chained to packet buffer
+ * of previous receive event of the same connection, when possible, other events are held
+ * in overflow list allocated from library heap. Only other events are dropped,
+ * or lifecycle events when heap is exhausted.
+ */
+
+espr_t      esp_evt_poll_init(void);
+espr_t      esp_evt_poll_deinit(void);
+int         esp_evt_poll_get_fd(void);
+espr_t      esp_evt_poll_evt_fn(esp_evt_t* evt);
+espr_t      esp_evt_poll(esp_evt_t* evt);
+espr_t      esp_evt_poll_get_stats(esp_evt_poll_stats_t* stats);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ESP_HDR_EVT_POLL_H */
@@ -76,6 +76,18 @@ extern "C" {
 #if ESP_CFG_SMART || __DOXYGEN__
 #include "esp/esp_smart.h"
 #endif /* ESP_CFG_SMART || __DOXYGEN__ */
+#if ESP_CFG_PM || __DOXYGEN__
+#include "esp/esp_pm.h"
+#endif /* ESP_CFG_PM || __DOXYGEN__ */
+#if ESP_CFG_LINKQ || __DOXYGEN__
+#include "esp/esp_linkq.h"
+#endif /* ESP_CFG_LINKQ || __DOXYGEN__ */
+#if ESP_CFG_CAPTURE || __DOXYGEN__
+#include "esp/esp_capture.h"
+#endif /* ESP_CFG_CAPTURE || __DOXYGEN__ */
+#if ESP_CFG_EVT_POLL || __DOXYGEN__
+#include "esp/esp_evt_poll.h"
+#endif /* ESP_CFG_EVT_POLL || __DOXYGEN__ */
 #include "esp/esp_dhcp.h"
 
 #ifdef __cplusplus
@@ -0,0 +1,71 @@
+/**
+ * \file            esp_linkq.h
+ * \brief           Link quality monitor
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_LINKQ_H
+#define ESP_HDR_LINKQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp/esp.h"
+
+/**
+ * \ingroup         ESP
+ * \defgroup        ESP_LINKQ Link quality monitor
+ * \brief           Background WiFi link quality monitor
+ * \{
+ *
+ * Monitor periodically reads RSSI of connected access point,
+ * smooths it and combines it with send failure ratio to a single link level.
+ *
+ * When level changes, \ref ESP_EVT_LINKQ_CHANGED event is sent to application.
+ */
+
+espr_t          esp_linkq_start(uint32_t interval);
+espr_t          esp_linkq_stop(void);
+espr_t          esp_linkq_get_stats(esp_linkq_stats_t* stats);
+espr_t          esp_linkq_reset_stats(void);
+esp_linkq_level_t   esp_linkq_get_level(void);
+size_t          esp_linkq_get_recommended_payload(void);
+size_t          esp_linkq_get_recommended_batch(void);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_HDR_LINKQ_H */
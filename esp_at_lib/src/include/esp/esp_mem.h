@@ -47,6 +47,16 @@ extern "C" {
  * \{
  */
 
+/**
+ * \brief           Memory class of region and allocation
+ */
+typedef enum {
+    ESP_MEM_CLASS_DEFAULT = 0x00,               /*!< General purpose memory */
+    ESP_MEM_CLASS_FAST,                         /*!< Fast memory for hot, frequently accessed objects, such as tightly-coupled SRAM */
+    ESP_MEM_CLASS_BULK,                         /*!< Slow memory for large, rarely accessed buffers, such as external RAM */
+    ESP_MEM_CLASS_END,                          /*!< Number of memory classes, used to check for valid value */
+} esp_mem_class_t;
+
 #if !ESP_CFG_MEM_CUSTOM || __DOXYGEN__
 
 /**
@@ -55,9 +65,38 @@ extern "C" {
 typedef struct {
     void* start_addr;                           /*!< Start address of region */
     size_t size;                                /*!< Size in units of bytes of region */
+    esp_mem_class_t mem_class;                  /*!< Memory class of region, used when \ref ESP_CFG_MEM_AFFINITY is enabled */
 } esp_mem_region_t;
 
+/**
+ * \brief           Memory allocator statistics
+ */
+typedef struct {
+    size_t total;                               /*!< Total heap size in units of bytes, available after regions are assigned */
+    size_t available;                           /*!< Currently available bytes, including block metadata */
+    size_t min_available;                       /*!< Lowest number of available bytes since start */
+    size_t largest_free;                        /*!< Largest size in units of bytes single allocation can currently get */
+    size_t free_blocks;                         /*!< Number of free blocks. Growing value indicates fragmentation */
+    uint32_t alloc_cnt;                         /*!< Number of successful allocations */
+    uint32_t free_cnt;                          /*!< Number of freed blocks */
+    uint32_t failed_cnt;                        /*!< Number of failed allocations */
+} esp_mem_stats_t;
+
+/**
+ * \brief           Memory region statistics
+ */
+typedef struct {
+    esp_mem_class_t mem_class;                  /*!< Memory class of region */
+    size_t total;                               /*!< Region size available for allocations in units of bytes */
+    size_t available;                           /*!< Currently available bytes, including block metadata */
+    size_t min_available;                       /*!< Lowest number of available bytes since start */
+    uint32_t alloc_cnt;                         /*!< Number of successful allocations from region */
+    uint32_t fallback_cnt;                      /*!< Number of allocations of other class, placed to region when their regions were exhausted */
+} esp_mem_region_stats_t;
+
 uint8_t esp_mem_assignmemory(const esp_mem_region_t* regions, size_t size);
+uint8_t esp_mem_get_stats(esp_mem_stats_t* stats);
+uint8_t esp_mem_get_region_stats(size_t index, esp_mem_region_stats_t* stats);
 
 #endif /* !ESP_CFG_MEM_CUSTOM || __DOXYGEN__ */
 
@@ -67,6 +106,9 @@ void*   esp_mem_calloc(size_t num, size_t size);
 void    esp_mem_free(void* ptr);
 uint8_t esp_mem_free_s(void** ptr);
 
+void*   esp_mem_malloc_class(esp_mem_class_t mem_class, size_t size);
+void*   esp_mem_calloc_class(esp_mem_class_t mem_class, size_t num, size_t size);
+
 /**
  * \}
  */
@@ -73,7 +73,13 @@ void *          esp_pbuf_get_linear_addr(const esp_pbuf_p pbuf, size_t offset, s
 
 void            esp_pbuf_set_ip(esp_pbuf_p pbuf, const esp_ip_t* ip, esp_port_t port);
 
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+uint32_t        esp_pbuf_get_time_input(const esp_pbuf_p pbuf);
+uint32_t        esp_pbuf_get_time_dispatch(const esp_pbuf_p pbuf);
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
+
 void            esp_pbuf_dump(esp_pbuf_p p, uint8_t seq);
+size_t          esp_pbuf_get_count(void);
 
 /**
  * \}
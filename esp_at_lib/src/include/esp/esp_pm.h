@@ -0,0 +1,72 @@
+/**
+ * \file            esp_pm.h
+ * \brief           Power manager
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_PM_H
+#define ESP_HDR_PM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp/esp.h"
+
+/**
+ * \ingroup         ESP
+ * \defgroup        ESP_PM Power manager
+ * \brief           Traffic aware sleep mode management
+ * \{
+ *
+ * Power manager puts device to sleep mode when there was no traffic on AT port
+ * and no command pending for configured idle time.
+ *
+ * When new command is sent to producer queue while device is sleeping,
+ * wakeup command is queued in front of it and wakeup pin (if available) is activated immediately,
+ * so that wakeup latency overlaps with time command waits in the queue.
+ */
+
+espr_t      esp_pm_enable(uint8_t en);
+espr_t      esp_pm_set_config(const esp_pm_config_t* config);
+espr_t      esp_pm_get_config(esp_pm_config_t* config);
+espr_t      esp_pm_get_stats(esp_pm_stats_t* stats);
+uint8_t     esp_pm_is_sleeping(void);
+espr_t      esp_pm_set_sleep_mode(esp_sleep_mode_t mode, const esp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_HDR_PM_H */
@@ -41,6 +41,7 @@ extern "C" {
 #include "esp/esp.h"
 #include "esp/esp_typedefs.h"
 #include "esp/esp_debug.h"
+#include "esp/esp_mem.h"
 
 /**
  * \addtogroup      ESP_TYPEDEFS
@@ -154,6 +155,19 @@ typedef enum {
 #endif /* ESP_CFG_ESP32 || __DOXYGEN__ */
 } esp_cmd_t;
 
+#if ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__
+
+/**
+ * \brief           Token bucket state
+ */
+typedef struct {
+    esp_conn_rate_limit_t limit;                /*!< Configured limit */
+    int32_t         tokens;                     /*!< Available tokens in units of bytes, negative when in debt */
+    uint32_t        time;                       /*!< Time of last refill in units of milliseconds */
+} esp_rate_bucket_t;
+
+#endif /* ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__ */
+
 /**
  * \brief           Connection structure
  */
@@ -180,6 +194,24 @@ typedef struct esp_conn {
     size_t          tcp_not_ack_bytes;          /*!< Number of bytes not acknowledge by application done with processing
                                                         This variable is increased everytime new packet is read to be sent to application and decreased when application acknowledges it */
 #endif /* ESP_CFG_CONN_MANUAL_TCP_RECEIVE || __DOXYGEN__ */
+#if ESP_CFG_IPD_ADAPTIVE || __DOXYGEN__
+    size_t          ipd_burst_avg;              /*!< Smoothed number of bytes received at once, used for buffer sizing */
+#endif /* ESP_CFG_IPD_ADAPTIVE || __DOXYGEN__ */
+#if ESP_CFG_CONN_SENDBUF || __DOXYGEN__
+    struct {
+        uint8_t     pending;                    /*!< Number of queued segments without `SEND OK` or `SEND FAIL` */
+    } sendbuf;                                  /*!< Buffered send status with `AT+CIPSENDBUF` */
+#endif /* ESP_CFG_CONN_SENDBUF || __DOXYGEN__ */
+#if ESP_CFG_CONN_ADAPTIVE_CHUNK || __DOXYGEN__
+    struct {
+        esp_conn_chunk_stats_t stats;           /*!< Current chunk size and statistics */
+        uint8_t     ok_cnt;                     /*!< Number of successful chunks since last size change */
+    } chunk;                                    /*!< Adaptive `AT+CIPSEND` chunk size */
+#endif /* ESP_CFG_CONN_ADAPTIVE_CHUNK || __DOXYGEN__ */
+#if ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__
+    esp_rate_bucket_t rate_tx;                  /*!< Transmit rate limit */
+    esp_rate_bucket_t rate_rx;                  /*!< Receive rate limit */
+#endif /* ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__ */
 
     union {
         struct {
@@ -192,6 +224,9 @@ typedef struct esp_conn {
             uint8_t receive_blocked:1;          /*!< Status whether we should block manual receive for some time */
             uint8_t receive_is_command_queued:1;/*!< Status whether manual read command is in the queue already */
 #endif /* ESP_CFG_CONN_MANUAL_TCP_RECEIVE || __DOXYGEN__ */
+#if (ESP_CFG_CONN_MANUAL_TCP_RECEIVE && ESP_CFG_CONN_RATE_LIMIT) || __DOXYGEN__
+            uint8_t receive_rate_wait:1;        /*!< Status whether manual read waits for receive rate limit timeout */
+#endif /* (ESP_CFG_CONN_MANUAL_TCP_RECEIVE && ESP_CFG_CONN_RATE_LIMIT) || __DOXYGEN__ */
         } f;                                    /*!< Connection flags */
     } status;                                   /*!< Connection status union with flag bits */
 } esp_conn_t;
@@ -208,6 +243,10 @@ typedef struct esp_pbuf {
     uint8_t* payload;                           /*!< Pointer to payload memory */
     esp_ip_t ip;                                /*!< Remote address for received IPD data */
     esp_port_t port;                            /*!< Remote port for received IPD data */
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+    uint32_t time_input;                        /*!< Arrival time of last received byte in packet buffer */
+    uint32_t time_dispatch;                     /*!< Time when packet buffer was passed to application */
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
 } esp_pbuf_t;
 
 /**
@@ -224,6 +263,13 @@ typedef struct {
     size_t              buff_ptr;               /*!< Buffer pointer to save data to.
                                                      When set to `NULL` while `read = 1`, reading should ignore incoming data */
     esp_pbuf_p          buff;                   /*!< Pointer to data buffer used for receiving data */
+#if ESP_CFG_IPD_ADAPTIVE || __DOXYGEN__
+    esp_pbuf_p          coal_buff;              /*!< Received packet buffer with free space, waiting for more data */
+    esp_conn_p          coal_conn;              /*!< Connection of pending packet buffer */
+    size_t              coal_used;              /*!< Number of bytes used in pending packet buffer */
+    esp_conn_p          run_conn;               /*!< Connection receiving current burst of data */
+    size_t              run_len;                /*!< Number of bytes received in current burst */
+#endif /* ESP_CFG_IPD_ADAPTIVE || __DOXYGEN__ */
 } esp_ipd_t;
 
 /**
@@ -251,6 +297,9 @@ typedef struct esp_msg {
         struct {
             uint32_t baudrate;                  /*!< Baudrate for AT port */
         } uart;                                 /*!< UART configuration */
+        struct {
+            esp_sleep_mode_t mode;              /*!< Sleep mode to set */
+        } sleep;                                /*!< Sleep mode configuration */
         struct {
             esp_mode_t mode;                    /*!< Mode of operation */
             esp_mode_t* mode_get;               /*!< Get mode */
@@ -356,11 +405,26 @@ typedef struct esp_msg {
             size_t sent_all;                    /*!< Number of bytes sent all together */
             uint8_t tries;                      /*!< Number of tries used for last packet */
             uint8_t wait_send_ok_err;           /*!< Set to 1 when we wait for SEND OK or SEND ERROR */
+#if ESP_CFG_CONN_SENDBUF || __DOXYGEN__
+            uint8_t buffered;                   /*!< Set to 1 when last packet uses `AT+CIPSENDBUF` */
+            uint8_t wait_segment;               /*!< Set to 1 when module buffer is full and we wait for `SEND OK` */
+            uint8_t busy;                       /*!< Set to 1 when module replied `busy` to `AT+CIPSENDBUF` */
+            uint8_t link_invalid;               /*!< Set to 1 when module replied `link is not valid` to `AT+CIPSENDBUF` */
+#endif /* ESP_CFG_CONN_SENDBUF || __DOXYGEN__ */
+#if ESP_CFG_CONN_ADAPTIVE_CHUNK || __DOXYGEN__
+            uint32_t time_sent;                 /*!< Time when last packet was written to device */
+#endif /* ESP_CFG_CONN_ADAPTIVE_CHUNK || __DOXYGEN__ */
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+            uint32_t time_queued;               /*!< Time when send request was created */
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
             const esp_ip_t* remote_ip;          /*!< Remote IP address for UDP connection */
             esp_port_t remote_port;             /*!< Remote port address for UDP connection */
             uint8_t fau;                        /*!< Free after use flag to free memory after data are sent (or not) */
             size_t* bw;                         /*!< Number of bytes written so far */
             uint8_t val_id;                     /*!< Connection current validation ID when command was sent to queue */
+#if ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__
+            struct esp_msg* held_next;          /*!< Next message waiting for transmit tokens */
+#endif /* ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__ */
         } conn_send;                            /*!< Structure to send data on connection */
 #if ESP_CFG_CONN_MANUAL_TCP_RECEIVE
         struct {
@@ -439,6 +503,9 @@ typedef struct esp_msg {
             uint8_t pki_number;                 /*!< The index of cert and private key, if only one cert and private key, the value should be 0. */
             uint8_t ca_number;                  /*!< The index of CA, if only one CA, the value should be 0. */
         } tcpip_ssl_cfg;                        /*!< SSl configuration for connection */
+        struct {
+            esp_ipd_info_t policy;              /*!< New policy for `+IPD` remote information */
+        } tcpip_dinfo;                          /*!< Set `+IPD` remote information policy */
     } msg;                                      /*!< Group of different message contents */
 } esp_msg_t;
 
@@ -490,6 +557,12 @@ typedef struct {
 
     esp_link_conn_t     link_conn;              /*!< Link connection handle */
     esp_ipd_t           ipd;                    /*!< Connection incoming data structure */
+    uint8_t             ipd_info;               /*!< Set to `1` when `+IPD` includes remote IP and port */
+    uint8_t             ipd_info_set;           /*!< Value sent with last `AT+CIPDINFO` command */
+#if ESP_CFG_CONN_SENDBUF || __DOXYGEN__
+    uint8_t             sendbuf_ok;             /*!< Set to `1` once module accepted `AT+CIPSENDBUF` command */
+    uint8_t             sendbuf_unsupported;    /*!< Set to `1` when firmware does not support `AT+CIPSENDBUF` command */
+#endif /* ESP_CFG_CONN_SENDBUF || __DOXYGEN__ */
     esp_conn_t          conns[ESP_CFG_MAX_CONNS];   /*!< Array of all connection structures */
 
 #if ESP_CFG_MODE_STATION || __DOXYGEN__
@@ -500,6 +573,34 @@ typedef struct {
 #endif /* ESP_CFG_MODE_ACCESS_POINT || __DOXYGEN__ */
 } esp_modules_t;
 
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+
+/**
+ * \brief           Input arrival time mark
+ */
+typedef struct {
+    uint32_t end;                               /*!< Total number of bytes written to input buffer after this input */
+    uint32_t time;                              /*!< Arrival time of input */
+} esp_input_mark_t;
+
+/**
+ * \brief           Event timestamp state
+ */
+typedef struct {
+    uint32_t seq;                               /*!< Sequence number of last dispatched event */
+    uint32_t input_time;                        /*!< Arrival time of input data currently being processed */
+    uint8_t input_time_valid;                   /*!< Set to `1` while input data are processed */
+#if !ESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__
+    esp_input_mark_t marks[ESP_CFG_EVT_TIMESTAMP_INPUT_MARKS];  /*!< Arrival times of pending input data */
+    volatile size_t marks_w;                    /*!< Marks write index, modified by \ref esp_input only */
+    volatile size_t marks_r;                    /*!< Marks read index, modified by processing thread only */
+    uint32_t written;                           /*!< Total number of bytes written to input buffer */
+    uint32_t processed;                         /*!< Total number of bytes processed from input buffer */
+#endif /* !ESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__ */
+} esp_evt_ts_t;
+
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
+
 /**
  * \brief           ESP global structure
  */
@@ -515,12 +616,23 @@ typedef struct {
     esp_buff_t          buff;                   /*!< Input processing buffer */
 #endif /* !ESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__ */
     esp_ll_t            ll;                     /*!< Low level functions */
+    esp_runtime_cfg_t   cfg;                    /*!< Runtime buffer and queue sizes */
+    esp_conn_ipd_stats_t ipd_stats;             /*!< Received network data statistics */
+    esp_ipd_info_t      ipd_info_policy;        /*!< Policy for remote information in `+IPD` */
+#if ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__
+    esp_rate_bucket_t   rate_tx;                /*!< Global transmit rate limit for all connections */
+    esp_rate_bucket_t   rate_rx;                /*!< Global receive rate limit for all connections */
+    esp_msg_t*          rate_tx_held;           /*!< Non-blocking send messages waiting for transmit tokens, in order of send calls */
+#endif /* ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__ */
 
     esp_msg_t*          msg;                    /*!< Pointer to current user message being executed */
 
     esp_evt_t           evt;                    /*!< Callback processing structure */
     esp_evt_func_t*     evt_func;               /*!< Callback function linked list */
     esp_evt_fn          evt_server;             /*!< Default callback function for server connections */
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+    esp_evt_ts_t        evt_ts;                 /*!< Event timestamp state */
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
 
     esp_modules_t       m;                      /*!< All modules. When resetting, reset structure */
 
@@ -563,7 +675,7 @@ extern esp_t esp;
 
 #define ESP_MSG_VAR_DEFINE(name)                esp_msg_t* name
 #define ESP_MSG_VAR_ALLOC(name, blocking)       do {\
-    (name) = esp_mem_malloc(sizeof(*(name)));       \
+    (name) = esp_mem_malloc_class(ESP_MEM_CLASS_FAST, sizeof(*(name)));   \
     ESP_DEBUGW(ESP_CFG_DBG_VAR | ESP_DBG_TYPE_TRACE, (name) != NULL, "[MSG VAR] Allocated %d bytes at %p\r\n", sizeof(*(name)), (name)); \
     ESP_DEBUGW(ESP_CFG_DBG_VAR | ESP_DBG_TYPE_TRACE, (name) == NULL, "[MSG VAR] Error allocating %d bytes\r\n", sizeof(*(name))); \
     if ((name) == NULL) {                           \
@@ -617,12 +729,49 @@ void        espi_conn_init(void);
 void        espi_conn_start_timeout(esp_conn_p conn);
 espr_t      espi_conn_check_available_rx_data(void);
 espr_t      espi_conn_manual_tcp_try_read_data(esp_conn_p conn);
+#if ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__
+uint32_t    espi_conn_rate_wait(esp_conn_p conn, uint8_t is_rx, size_t len);
+void        espi_conn_rate_charge(esp_conn_p conn, uint8_t is_rx, size_t len);
+#endif /* ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__ */
+void*       espi_mem_calloc_class_cnt(esp_mem_class_t mem_class, size_t num, size_t size, size_t* cnt);
 espr_t      espi_send_msg_to_producer_mbox(esp_msg_t* msg, espr_t (*process_fn)(esp_msg_t *), uint32_t max_block_time);
 uint32_t    espi_get_from_mbox_with_timeout_checks(esp_sys_mbox_t* b, void** m, uint32_t timeout);
 
 void        espi_reset_everything(uint8_t forced);
 void        espi_process_events_for_timeout_or_error(esp_msg_t* msg, espr_t err);
 
+#if ESP_CFG_PM
+void        espi_pm_msg_enqueue(esp_msg_t* msg);
+void        espi_pm_msg_done(esp_msg_t* msg);
+void        espi_pm_activity(void);
+void        espi_pm_wakeup_wait(void);
+void        espi_pm_sleep_result(esp_msg_t* msg, espr_t res);
+void        espi_pm_reset(void);
+#endif /* ESP_CFG_PM */
+
+#if ESP_CFG_LINKQ
+void        espi_linkq_wifi_status(uint8_t connected);
+void        espi_linkq_send_result(espr_t res);
+void        espi_linkq_send_retry(void);
+#endif /* ESP_CFG_LINKQ */
+
+#if ESP_CFG_IPD_ADAPTIVE
+void        espi_ipd_flush(void);
+#endif /* ESP_CFG_IPD_ADAPTIVE */
+
+#if ESP_CFG_EVT_TIMESTAMP
+void        espi_evt_stamp(esp_evt_t* evt);
+uint32_t    espi_evt_input_time(void);
+#define ESP_EVT_STAMP(evt)                  espi_evt_stamp(evt)
+#else /* ESP_CFG_EVT_TIMESTAMP */
+#define ESP_EVT_STAMP(evt)
+#endif /* !ESP_CFG_EVT_TIMESTAMP */
+
+#if ESP_CFG_CAPTURE
+size_t      espi_capture_send(const void* data, size_t len);
+void        espi_capture_recv(const void* data, size_t len);
+#endif /* ESP_CFG_CAPTURE */
+
 /**
  * \}
  */
@@ -198,6 +198,102 @@ typedef struct {
     esp_mac_t mac;                              /*!< MAC address of connected station */
 } esp_sta_t;
 
+/**
+ * \ingroup         ESP_PM
+ * \brief           List of possible sleep modes
+ */
+typedef enum {
+    ESP_SLEEP_NONE = 0x00,                      /*!< Sleep disabled, device is fully awake */
+    ESP_SLEEP_LIGHT,                            /*!< Light sleep. Device must be woken up by wakeup pin, configured with `AT+WAKEUPGPIO` */
+    ESP_SLEEP_MODEM,                            /*!< Modem sleep. RF is turned off between DTIM beacons, AT port stays active */
+} esp_sleep_mode_t;
+
+/**
+ * \ingroup         ESP_PM
+ * \brief           Power manager configuration
+ */
+typedef struct {
+    esp_sleep_mode_t mode;                      /*!< Sleep mode to use when device is idle */
+    uint32_t idle_time;                         /*!< Time without traffic in units of milliseconds before going to sleep */
+    uint32_t wakeup_latency;                    /*!< Time in units of milliseconds device needs after wakeup pin is activated,
+                                                    before it is able to accept AT commands */
+} esp_pm_config_t;
+
+/**
+ * \ingroup         ESP_PM
+ * \brief           Power manager statistics
+ */
+typedef struct {
+    uint32_t sleep_cnt;                         /*!< Number of times device entered sleep mode */
+    uint32_t wakeup_cnt;                        /*!< Number of successful wakeups */
+    uint32_t wakeup_err;                        /*!< Number of failed sleep or wakeup commands */
+    uint32_t wakeup_time_last;                  /*!< Time from wakeup request to device ready for last wakeup, in units of milliseconds */
+    uint32_t wakeup_time_max;                   /*!< Maximal wakeup time in units of milliseconds */
+    uint32_t sleep_time;                        /*!< Total time spent in sleep mode in units of milliseconds */
+} esp_pm_stats_t;
+
+/**
+ * \ingroup         ESP_LINKQ
+ * \brief           List of possible link quality levels
+ */
+typedef enum {
+    ESP_LINKQ_LEVEL_LOST = 0x00,                /*!< Station is not connected to access point */
+    ESP_LINKQ_LEVEL_POOR,                       /*!< Marginal link, expect retransmissions */
+    ESP_LINKQ_LEVEL_FAIR,                       /*!< Usable link with occasional failures */
+    ESP_LINKQ_LEVEL_GOOD,                       /*!< Strong link */
+} esp_linkq_level_t;
+
+/**
+ * \ingroup         ESP_LINKQ
+ * \brief           Link quality statistics
+ */
+typedef struct {
+    esp_linkq_level_t level;                    /*!< Current link level */
+    int16_t rssi_last;                          /*!< Last RSSI sample in units of dBm */
+    int16_t rssi_avg;                           /*!< Smoothed RSSI value in units of dBm */
+    uint32_t samples;                           /*!< Number of successful RSSI samples */
+    uint32_t reconnects;                        /*!< Number of connections to access point after disconnect */
+    uint32_t disconnects;                       /*!< Number of disconnections from access point */
+    uint32_t send_ok;                           /*!< Number of successful send operations */
+    uint32_t send_failed;                       /*!< Number of failed send operations */
+    uint32_t send_retries;                      /*!< Number of `SEND FAIL` retransmissions */
+    uint8_t fail_ratio;                         /*!< Smoothed send failure ratio in units of percent */
+} esp_linkq_stats_t;
+
+/**
+ * \ingroup         ESP_CAPTURE
+ * \brief           Capture output function prototype
+ * \param[in]       data: Data to write to capture output
+ * \param[in]       len: Length of data in units of bytes
+ * \param[in]       arg: Custom user argument
+ */
+typedef void (*esp_capture_out_fn)(const void* data, size_t len, void* arg);
+
+/**
+ * \ingroup         ESP_CAPTURE
+ * \brief           AT link capture statistics
+ */
+typedef struct {
+    uint32_t tx_bytes;                          /*!< Number of bytes sent to device since capture start */
+    uint32_t rx_bytes;                          /*!< Number of bytes received from device since capture start */
+    uint32_t records;                           /*!< Number of written packet records */
+    uint32_t dropped;                           /*!< Number of records dropped due to full ring buffer */
+    uint32_t start_time;                        /*!< Capture start time in units of milliseconds */
+} esp_capture_stats_t;
+
+/**
+ * \ingroup         ESP_EVT_POLL
+ * \brief           Pollable event queue statistics
+ */
+typedef struct {
+    uint32_t queued;                            /*!< Number of events written to queue */
+    uint32_t dropped;                           /*!< Number of events dropped due to full queue */
+    uint32_t held;                              /*!< Number of connection events held in overflow list due to full queue */
+    uint32_t merged;                            /*!< Number of receive events chained to queued receive event due to full queue */
+    uint32_t pending;                           /*!< Number of events currently in queue and overflow list */
+    uint32_t pending_max;                       /*!< Maximal number of events in queue at the same time */
+} esp_evt_poll_stats_t;
+
 /**
  * \ingroup         ESP_TYPEDEFS
  * \brief           Date and time structure
@@ -254,6 +350,21 @@ typedef enum {
     ESP_CONN_TYPE_SSL,                          /*!< Connection type is SSL */
 } esp_conn_type_t;
 
+/**
+ * \ingroup         ESP_CONN
+ * \brief           Policy for remote IP and port information in `+IPD` statement
+ *
+ * Information is configured with `AT+CIPDINFO` command,
+ * which applies to all connections on device at the same time.
+ */
+typedef enum {
+    ESP_IPD_INFO_ALWAYS = 0x00,                 /*!< Remote IP and port are included in every `+IPD` */
+    ESP_IPD_INFO_AUTO,                          /*!< Remote IP and port are included only while \e UDP connection is active or started.
+                                                    \e TCP and \e SSL connections use remote address known from connection start */
+    ESP_IPD_INFO_NEVER,                         /*!< Remote IP and port are never included.
+                                                    Received data always report remote address known from connection start */
+} esp_ipd_info_t;
+
 /* Forward declarations */
 struct esp_evt;
 struct esp_conn;
@@ -304,6 +415,8 @@ typedef enum esp_evt_type_t {
     ESP_EVT_CONN_ERROR,                         /*!< Client connection start was not successful */
     ESP_EVT_CONN_CLOSE,                         /*!< Connection close event. Check status if successful */
     ESP_EVT_CONN_POLL,                          /*!< Poll for connection if there are any changes */
+    ESP_EVT_CONN_THROTTLED,                     /*!< Connection ran out of rate limit tokens.
+                                                    Defined regardless of \ref ESP_CFG_CONN_RATE_LIMIT to keep event values stable */
 
     ESP_EVT_SERVER,                             /*!< Server status changed */
 
@@ -332,6 +445,16 @@ typedef enum esp_evt_type_t {
 #if ESP_CFG_PING || __DOXYGEN__
     ESP_EVT_PING,                               /*!< PING service finished */
 #endif /* ESP_CFG_PING || __DOXYGEN__ */
+#if ESP_CFG_LINKQ || __DOXYGEN__
+    ESP_EVT_LINKQ_CHANGED,                      /*!< Link quality level changed */
+#endif /* ESP_CFG_LINKQ || __DOXYGEN__ */
+#if ESP_CFG_PM || __DOXYGEN__
+    ESP_EVT_PM_CHANGED,                         /*!< Device entered or exited sleep mode */
+#endif /* ESP_CFG_PM || __DOXYGEN__ */
+#if ESP_CFG_CONN_SENDBUF || __DOXYGEN__
+    ESP_EVT_CONN_SEND_FAIL,                     /*!< Module reported `SEND FAIL` for segment queued with `AT+CIPSENDBUF`,
+                                                    after \ref ESP_EVT_CONN_SEND already reported data as accepted */
+#endif /* ESP_CFG_CONN_SENDBUF || __DOXYGEN__ */
 } esp_evt_type_t;
 
 /**
@@ -340,6 +463,12 @@ typedef enum esp_evt_type_t {
  */
 typedef struct esp_evt {
     esp_evt_type_t type;                        /*!< Callback type */
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+    uint32_t seq;                               /*!< Global sequence number, increased for every dispatched event */
+    uint32_t time_input;                        /*!< Arrival time of input data which triggered event.
+                                                    Equal to dispatch time when event was not triggered by input data */
+    uint32_t time_dispatch;                     /*!< Time when event was dispatched to callback */
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
     union {
         struct {
             uint8_t forced;                     /*!< Set to `1` if reset forced by user */
@@ -360,7 +489,16 @@ typedef struct esp_evt {
             esp_conn_p conn;                    /*!< Connection where data were sent */
             size_t sent;                        /*!< Number of bytes sent on connection */
             espr_t res;                         /*!< Send data result */
+#if ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__
+            uint32_t time_queued;               /*!< Time when send request was queued by application */
+#endif /* ESP_CFG_EVT_TIMESTAMP || __DOXYGEN__ */
         } conn_data_send;                       /*!< Data send. Use with \ref ESP_EVT_CONN_SEND event */
+#if ESP_CFG_CONN_SENDBUF || __DOXYGEN__
+        struct {
+            esp_conn_p conn;                    /*!< Connection where segment failed */
+            uint32_t seg_id;                    /*!< Segment ID reported by module */
+        } conn_send_fail;                       /*!< Buffered segment failed. Use with \ref ESP_EVT_CONN_SEND_FAIL event */
+#endif /* ESP_CFG_CONN_SENDBUF || __DOXYGEN__ */
         struct {
             const char* host;                   /*!< Host to use for connection */
             esp_port_t port;                    /*!< Remote port used for connection */
@@ -377,6 +515,14 @@ typedef struct esp_evt {
         struct {
             esp_conn_p conn;                    /*!< Set connection pointer */
         } conn_poll;                            /*!< Polling active connection to check for timeouts. Use with \ref ESP_EVT_CONN_POLL event */
+#if ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__
+        struct {
+            esp_conn_p conn;                    /*!< Throttled connection */
+            uint8_t is_rx;                      /*!< Set to `1` for receive direction, `0` for transmit */
+            uint8_t is_global;                  /*!< Set to `1` when global limit throttles connection */
+            uint32_t wait;                      /*!< Time until bucket is out of debt in units of milliseconds */
+        } conn_throttled;                       /*!< Connection throttled. Use with \ref ESP_EVT_CONN_THROTTLED event */
+#endif /* ESP_CFG_CONN_RATE_LIMIT || __DOXYGEN__ */
 
         struct {
             espr_t res;                         /*!< Status of command */
@@ -420,6 +566,20 @@ typedef struct esp_evt {
             uint32_t time;                      /*!< Time required for ping. Valid only if operation succedded */
         } ping;                                 /*!< Ping finished. Use with \ref ESP_EVT_PING event */
 #endif /* ESP_CFG_PING || __DOXYGEN__ */
+#if ESP_CFG_LINKQ || __DOXYGEN__
+        struct {
+            esp_linkq_level_t level;            /*!< New link level */
+            esp_linkq_level_t level_prev;       /*!< Previous link level */
+            int16_t rssi;                       /*!< Smoothed RSSI in units of dBm */
+        } linkq;                                /*!< Link quality changed. Use with \ref ESP_EVT_LINKQ_CHANGED event */
+#endif /* ESP_CFG_LINKQ || __DOXYGEN__ */
+#if ESP_CFG_PM || __DOXYGEN__
+        struct {
+            espr_t res;                         /*!< Result of sleep or wakeup command */
+            esp_sleep_mode_t mode;              /*!< Active sleep mode, \ref ESP_SLEEP_NONE when awake */
+            uint32_t wakeup_time;               /*!< Wakeup time in units of milliseconds. Valid only after wakeup */
+        } pm;                                   /*!< Power state changed. Use with \ref ESP_EVT_PM_CHANGED event */
+#endif /* ESP_CFG_PM || __DOXYGEN__ */
     } evt;                                      /*!< Callback event union */
 } esp_evt_t;
 
@@ -445,6 +605,14 @@ typedef size_t (*esp_ll_send_fn)(const void* data, size_t len);
  */
 typedef uint8_t (*esp_ll_reset_fn)(uint8_t state);
 
+/**
+ * \ingroup         ESP_LL
+ * \brief           Function prototype for wakeup pin control of ESP device
+ * \param[in]       state: Set to `1` to activate wakeup pin, `0` to release it
+ * \return          `1` on successful action, `0` otherwise
+ */
+typedef uint8_t (*esp_ll_wakeup_fn)(uint8_t state);
+
 /**
  * \ingroup         ESP_LL
  * \brief           Low level user specific functions
@@ -452,11 +620,32 @@ typedef uint8_t (*esp_ll_reset_fn)(uint8_t state);
 typedef struct {
     esp_ll_send_fn send_fn;                     /*!< Callback function to transmit data */
     esp_ll_reset_fn reset_fn;                   /*!< Reset callback function */
+    esp_ll_wakeup_fn wakeup_fn;                 /*!< Optional wakeup pin callback function, used to exit light sleep mode */
     struct {
         uint32_t baudrate;                      /*!< UART baudrate value */
     } uart;                                     /*!< UART communication parameters */
 } esp_ll_t;
 
+/**
+ * \ingroup         ESP
+ * \brief           Runtime configuration of buffer and queue sizes
+ *
+ * Compile-time configuration value is used as default and as upper bound for each field.
+ * Field set to `0` in \ref esp_runtime_cfg_set selects default value,
+ * while in \ref esp_runtime_cfg_tune it leaves current value unchanged.
+ */
+typedef struct {
+    size_t rcv_buff_size;                       /*!< Input buffer size, bounded by \ref ESP_CFG_RCV_BUFF_SIZE. Init time only */
+    size_t producer_mbox_size;                  /*!< Producer queue length, bounded by \ref ESP_CFG_THREAD_PRODUCER_MBOX_SIZE. Init time only */
+    size_t process_mbox_size;                   /*!< Process queue length, bounded by \ref ESP_CFG_THREAD_PROCESS_MBOX_SIZE. Init time only */
+    size_t conn_max_data_len;                   /*!< Maximal length of single send, bounded by \ref ESP_CFG_CONN_MAX_DATA_LEN */
+    size_t conn_max_recv_buff_size;             /*!< Maximal length of received packet buffer, bounded by \ref ESP_CFG_CONN_MAX_RECV_BUFF_SIZE */
+    size_t netconn_receive_queue_len;           /*!< Netconn receive queue length, bounded by \ref ESP_CFG_NETCONN_RECEIVE_QUEUE_LEN.
+                                                    Change applies to netconns created afterwards */
+    size_t mqtt_max_requests;                   /*!< Number of MQTT requests per client, bounded by \ref ESP_CFG_MQTT_MAX_REQUESTS.
+                                                    Change applies to MQTT clients created afterwards */
+} esp_runtime_cfg_t;
+
 /**
  * \ingroup         ESP_TIMEOUT
  * \brief           Timeout callback function prototype
@@ -505,6 +694,39 @@ typedef struct {
  */
 typedef void (*esp_api_cmd_evt_fn) (espr_t res, void* arg);
 
+/**
+ * \ingroup         ESP_CONN
+ * \brief           Statistics of received network data
+ */
+typedef struct {
+    uint32_t packets;                           /*!< Number of `+IPD` packets received with data */
+    uint32_t allocs;                            /*!< Number of packet buffers allocated for received data */
+    uint32_t coalesced;                         /*!< Number of packets stored to already allocated packet buffer */
+    uint32_t failed;                            /*!< Number of failed packet buffer allocations */
+} esp_conn_ipd_stats_t;
+
+/**
+ * \ingroup         ESP_CONN
+ * \brief           Token bucket rate limit for single direction
+ */
+typedef struct {
+    uint32_t rate;                              /*!< Average rate in units of bytes per second. Set to `0` to disable limit */
+    uint32_t burst;                             /*!< Bucket size in units of bytes, maximal amount sent at once after idle period
+                                                    and maximal debt after single large transfer. Set to `0` to use `rate` */
+} esp_conn_rate_limit_t;
+
+/**
+ * \ingroup         ESP_CONN
+ * \brief           Adaptive send chunk statistics of connection
+ */
+typedef struct {
+    size_t size;                                /*!< Current chunk size for `AT+CIPSEND` in units of bytes */
+    uint32_t time_per_kb;                       /*!< Smoothed time to send `1024` bytes in units of milliseconds */
+    uint32_t grows;                             /*!< Number of chunk size increases */
+    uint32_t shrinks;                           /*!< Number of chunk size decreases */
+    uint32_t fails;                             /*!< Number of chunks reported with `SEND FAIL` */
+} esp_conn_chunk_stats_t;
+
 /**
  * \ingroup         ESP_CONN
  * \brief           Connection start structure, used to start the connection in extended mode
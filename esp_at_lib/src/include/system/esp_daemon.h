@@ -0,0 +1,216 @@
+/**
+ * \file            esp_daemon.h
+ * \brief           Multi-process stack daemon
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_DAEMON_H
+#define ESP_HDR_DAEMON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "esp/esp.h"
+
+/**
+ * \ingroup         ESP
+ * \defgroup        ESP_DAEMON Multi-process daemon
+ * \brief           Share one module between processes on Linux host
+ * \{
+ *
+ * Daemon process initializes library and owns the module.
+ * Client processes connect to daemon over `AF_UNIX` control socket
+ * and use module connections through \ref ESP_DAEMON_CLIENT library.
+ *
+ * On connect, daemon creates shared memory for client with `memfd_create`
+ * and passes it to client together with two `eventfd` doorbells:
+ * one rung by client when it produced data or released receive slots,
+ * one rung by daemon when it produced data, closed connection or released transmit slots.
+ *
+ * Every connection channel has transmit and receive ring of fixed size slots.
+ * Rings are single-producer, single-consumer with free running indexes,
+ * no locks are shared between processes.
+ *
+ *  - Client writes transmit data directly to slot and daemon passes slot memory
+ *      to \ref esp_conn_send in non-blocking mode. Slot is released on \ref ESP_EVT_CONN_SEND event
+ *  - Daemon copies received packet buffers to receive slots,
+ *      client reads data directly from slot and releases it when processed
+ *
+ * Control requests are served on separate control thread and map to blocking \ref esp_conn_start and \ref esp_conn_close.
+ * Data thread keeps moving ring data of all clients while control request waits for module.
+ */
+
+/**
+ * \brief           Number of connection channels per client
+ */
+#ifndef ESP_DAEMON_CHANNELS
+#define ESP_DAEMON_CHANNELS                 4
+#endif
+
+/**
+ * \brief           Number of slots in every transmit and receive ring
+ */
+#ifndef ESP_DAEMON_RING_SLOTS
+#define ESP_DAEMON_RING_SLOTS               16
+#endif
+
+/**
+ * \brief           Size of data in single ring slot in units of bytes
+ */
+#ifndef ESP_DAEMON_SLOT_SIZE
+#define ESP_DAEMON_SLOT_SIZE                ESP_CFG_CONN_MAX_DATA_LEN
+#endif
+
+/**
+ * \brief           Maximal number of transmit slots of one channel passed to library at the same time
+ *
+ * Keeps space in producer message queue for other commands, such as reads in manual receive mode
+ */
+#ifndef ESP_DAEMON_TX_INFLIGHT
+#define ESP_DAEMON_TX_INFLIGHT              2
+#endif
+
+/**
+ * \brief           Maximal number of clients connected to daemon at the same time
+ */
+#ifndef ESP_DAEMON_MAX_CLIENTS
+#define ESP_DAEMON_MAX_CLIENTS              8
+#endif
+
+/**
+ * \brief           Maximal length of remote host name in control request, including `NULL` termination
+ */
+#ifndef ESP_DAEMON_HOST_LEN
+#define ESP_DAEMON_HOST_LEN                 64
+#endif
+
+#define ESP_DAEMON_MAGIC                    0x45535044  /*!< Shared memory magic number, `ESPD` */
+
+/**
+ * \brief           Type of record in receive ring slot
+ */
+typedef enum {
+    ESP_DAEMON_REC_DATA = 0x00,                 /*!< Slot holds received data */
+    ESP_DAEMON_REC_CLOSED,                      /*!< Connection closed, no more data will follow */
+} esp_daemon_rec_t;
+
+/**
+ * \brief           Single ring slot
+ */
+typedef struct {
+    uint32_t type;                              /*!< Record type, member of \ref esp_daemon_rec_t. Receive ring only */
+    uint32_t len;                               /*!< Number of valid bytes in `data` */
+    uint8_t data[ESP_DAEMON_SLOT_SIZE];         /*!< Slot data */
+} esp_daemon_slot_t;
+
+/**
+ * \brief           Single-producer, single-consumer ring in shared memory
+ *
+ * Indexes are free running, slot index is `index % ESP_DAEMON_RING_SLOTS`
+ */
+typedef struct {
+    uint32_t head;                              /*!< Next slot to write, written by producer only */
+    uint32_t tail;                              /*!< Next slot to read, written by consumer only */
+    esp_daemon_slot_t slots[ESP_DAEMON_RING_SLOTS]; /*!< Ring slots */
+} esp_daemon_ring_t;
+
+/**
+ * \brief           Connection channel in shared memory
+ */
+typedef struct {
+    uint32_t closed;                            /*!< Set to `1` by daemon when connection is closed */
+    esp_daemon_ring_t tx;                       /*!< Data from client to module, produced by client */
+    esp_daemon_ring_t rx;                       /*!< Data from module to client, produced by daemon */
+} esp_daemon_chan_t;
+
+/**
+ * \brief           Shared memory of one client
+ */
+typedef struct {
+    uint32_t magic;                             /*!< Set to \ref ESP_DAEMON_MAGIC */
+    uint32_t channels;                          /*!< Number of channels, client checks it matches own build */
+    uint32_t ring_slots;                        /*!< Number of slots in ring */
+    uint32_t slot_size;                         /*!< Size of slot data */
+    esp_daemon_chan_t chans[ESP_DAEMON_CHANNELS];   /*!< Connection channels */
+} esp_daemon_shm_t;
+
+/**
+ * \brief           Control request operation
+ */
+typedef enum {
+    ESP_DAEMON_OP_CONN_START = 0x01,            /*!< Start connection, see \ref esp_conn_start */
+    ESP_DAEMON_OP_CONN_CLOSE,                   /*!< Close connection and release channel, see \ref esp_conn_close */
+} esp_daemon_op_t;
+
+/**
+ * \brief           Control request from client
+ */
+typedef struct {
+    uint32_t op;                                /*!< Operation, member of \ref esp_daemon_op_t */
+    uint32_t chan;                              /*!< Channel number for \ref ESP_DAEMON_OP_CONN_CLOSE */
+    uint32_t type;                              /*!< Connection type, member of \ref esp_conn_type_t */
+    uint32_t port;                              /*!< Remote port */
+    char host[ESP_DAEMON_HOST_LEN];             /*!< Remote host, `NULL` terminated */
+} esp_daemon_req_t;
+
+/**
+ * \brief           Control response from daemon
+ *
+ * First response is sent right after client connects,
+ * with shared memory and doorbell descriptors attached
+ */
+typedef struct {
+    int32_t res;                                /*!< Result, member of \ref espr_t enumeration */
+    uint32_t chan;                              /*!< Channel number of started connection */
+} esp_daemon_rsp_t;
+
+/**
+ * \brief           Daemon statistics
+ */
+typedef struct {
+    uint32_t clients;                           /*!< Number of currently connected clients */
+    uint32_t conns;                             /*!< Number of connections started for clients */
+    uint32_t bytes_tx;                          /*!< Number of bytes passed from clients to module */
+    uint32_t bytes_rx;                          /*!< Number of bytes passed from module to clients */
+} esp_daemon_stats_t;
+
+espr_t      esp_daemon_start(const char* path);
+void        esp_daemon_get_stats(esp_daemon_stats_t* stats);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ESP_HDR_DAEMON_H */
@@ -0,0 +1,104 @@
+/**
+ * \file            esp_daemon_client.h
+ * \brief           Client library for multi-process stack daemon
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_DAEMON_CLIENT_H
+#define ESP_HDR_DAEMON_CLIENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system/esp_daemon.h"
+
+/**
+ * \ingroup         ESP_DAEMON
+ * \defgroup        ESP_DAEMON_CLIENT Client library
+ * \brief           Use module connections of daemon from other process
+ * \{
+ *
+ * Client library does not initialize ESP-AT library and does not link it,
+ * only types are shared.
+ *
+ * Functions follow \ref ESP_NETCONN semantics: connection is started and closed with blocking call,
+ * data are received with timeout and \ref espCLOSED is returned once remote side closed connection.
+ * Data are exchanged in place in shared memory:
+ *
+ *  - \ref esp_daemon_conn_send_alloc returns pointer to free transmit slot,
+ *      application writes data there and submits it with \ref esp_daemon_conn_send_commit
+ *  - \ref esp_daemon_conn_receive returns pointer to received data in shared memory,
+ *      valid until \ref esp_daemon_conn_recved is called
+ *
+ * Descriptor returned by \ref esp_daemon_client_get_fd becomes readable when daemon rings doorbell
+ * and can be added to `poll` or `epoll` set. When it is readable, application clears it
+ * with \ref esp_daemon_client_clear_fd and then processes all connections with `0` timeout.
+ *
+ * \note            Client handle and its connections must be used from single thread
+ */
+
+#define ESP_DAEMON_WAIT_FOREVER             0xFFFFFFFF  /*!< Timeout value to wait without limit */
+
+struct esp_daemon_client;
+struct esp_daemon_conn;
+
+/**
+ * \brief           Client handle
+ */
+typedef struct esp_daemon_client* esp_daemon_client_p;
+
+/**
+ * \brief           Client connection handle
+ */
+typedef struct esp_daemon_conn* esp_daemon_conn_p;
+
+esp_daemon_client_p esp_daemon_client_new(const char* path);
+void        esp_daemon_client_delete(esp_daemon_client_p client);
+int         esp_daemon_client_get_fd(esp_daemon_client_p client);
+void        esp_daemon_client_clear_fd(esp_daemon_client_p client);
+
+espr_t      esp_daemon_conn_start(esp_daemon_client_p client, esp_daemon_conn_p* conn, esp_conn_type_t type, const char* host, esp_port_t port);
+espr_t      esp_daemon_conn_close(esp_daemon_conn_p conn);
+void *      esp_daemon_conn_send_alloc(esp_daemon_conn_p conn, size_t* len, uint32_t timeout);
+espr_t      esp_daemon_conn_send_commit(esp_daemon_conn_p conn, size_t len);
+espr_t      esp_daemon_conn_send(esp_daemon_conn_p conn, const void* data, size_t btw, uint32_t timeout);
+espr_t      esp_daemon_conn_receive(esp_daemon_conn_p conn, const void** data, size_t* len, uint32_t timeout);
+espr_t      esp_daemon_conn_recved(esp_daemon_conn_p conn);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ESP_HDR_DAEMON_CLIENT_H */
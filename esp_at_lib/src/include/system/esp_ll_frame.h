@@ -0,0 +1,176 @@
+/**
+ * \file            esp_ll_frame.h
+ * \brief           Low-level driver for ESP-AT SPI AT protocol
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_LL_FRAME_H
+#define ESP_HDR_LL_FRAME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system/esp_ll.h"
+
+/**
+ * \ingroup         ESP_LL
+ * \defgroup        ESP_LL_FRAME SPI AT transport
+ * \brief           AT stream carried with ESP-AT SPI AT protocol over host driven bus
+ * \{
+ *
+ * Driver implements \ref esp_ll_init and talks to stock ESP-AT firmware built with SPI AT interface.
+ * AT parser sees the same byte stream as with UART.
+ * Bus is accessed through \ref esp_ll_frame_link_t, set with \ref esp_ll_frame_set_link before \ref esp_init.
+ *
+ * Module is half-duplex SPI slave. Every transaction starts with command byte, address byte and dummy byte,
+ * followed by data in direction given by command, see \ref ESP_LL_FRAME_CMD_SIZE.
+ * Module drives handshake line when it has data for host or is ready to receive data from host,
+ * host then reads slave status with \ref ESP_LL_FRAME_CMD_RDBUF at \ref ESP_LL_FRAME_ADDR_STATUS.
+ * Module releases the line once status is read.
+ *
+ *  - Host to module: host writes send request with \ref ESP_LL_FRAME_CMD_WRBUF at \ref ESP_LL_FRAME_ADDR_REQUEST,
+ *      module answers with writable status, host writes data with \ref ESP_LL_FRAME_CMD_WRDMA
+ *      and finishes with \ref ESP_LL_FRAME_CMD_WR_DONE
+ *  - Module to host: module reports readable status, host reads data with \ref ESP_LL_FRAME_CMD_RDDMA
+ *      and finishes with \ref ESP_LL_FRAME_CMD_RD_DONE
+ *
+ * Send request and status share the same `4` bytes layout, see \ref esp_ll_frame_info_encode.
+ * Both sides count transfers in their direction with sequence number.
+ *
+ * Data from library are collected in transmit buffer and sent when library flushes AT port,
+ * or when buffer holds data for full transfer. Transmit function waits for free space in buffer.
+ *
+ * Library calls transmit function with core lock held, driver thread must never wait for the same lock.
+ * Received data are therefore written to library input buffer with \ref esp_input,
+ * \ref ESP_CFG_INPUT_USE_PROCESS must be disabled and \ref ESP_CFG_RCV_BUFF_SIZE
+ * should hold at least two transfers of \ref ESP_LL_FRAME_MAX_DATA bytes.
+ */
+
+/**
+ * \brief           Maximal length of data in single transfer in units of bytes
+ *
+ * Must not exceed length module firmware accepts and sends in single transfer
+ */
+#ifndef ESP_LL_FRAME_MAX_DATA
+#define ESP_LL_FRAME_MAX_DATA               2048
+#endif
+
+/**
+ * \brief           Size of transmit buffer in units of bytes
+ *
+ * Library waits for response before next command and writes connection data
+ * after module requests them, buffer holding \ref ESP_CFG_CONN_MAX_DATA_LEN bytes
+ * and common command lets library write without waiting for the bus
+ */
+#ifndef ESP_LL_FRAME_TX_BUFF_SIZE
+#define ESP_LL_FRAME_TX_BUFF_SIZE           (ESP_CFG_CONN_MAX_DATA_LEN + 256)
+#endif
+
+/**
+ * \brief           Time in units of milliseconds to wait for handshake line
+ *                  after send request, before request is sent again
+ *
+ * Recovers missed handshake interrupt or request lost by module
+ */
+#ifndef ESP_LL_FRAME_POLL_TIME
+#define ESP_LL_FRAME_POLL_TIME              100
+#endif
+
+#define ESP_LL_FRAME_CMD_WRDMA              0x01    /*!< Write data to module */
+#define ESP_LL_FRAME_CMD_RDDMA              0x02    /*!< Read data from module */
+#define ESP_LL_FRAME_CMD_WRBUF              0x03    /*!< Write module shared buffer, used for send request */
+#define ESP_LL_FRAME_CMD_RDBUF              0x04    /*!< Read module shared buffer, used for slave status */
+#define ESP_LL_FRAME_CMD_WR_DONE            0x07    /*!< End of data write */
+#define ESP_LL_FRAME_CMD_RD_DONE            0x08    /*!< End of data read */
+
+#define ESP_LL_FRAME_ADDR_REQUEST           0x00    /*!< Shared buffer address of send request */
+#define ESP_LL_FRAME_ADDR_STATUS            0x04    /*!< Shared buffer address of slave status */
+#define ESP_LL_FRAME_CMD_SIZE               3       /*!< Command, address and dummy byte before data of every transaction */
+#define ESP_LL_FRAME_INFO_SIZE              4       /*!< Size of send request and slave status in units of bytes */
+
+#define ESP_LL_FRAME_INFO_READABLE          0x01    /*!< Slave status: module has data for host */
+#define ESP_LL_FRAME_INFO_WRITABLE          0x02    /*!< Slave status: module is ready to receive data from host */
+#define ESP_LL_FRAME_INFO_REQUEST           0xFE    /*!< Send request from host, magic number */
+
+/**
+ * \brief           Send request or slave status
+ */
+typedef struct {
+    uint8_t type;                               /*!< \ref ESP_LL_FRAME_INFO_READABLE, \ref ESP_LL_FRAME_INFO_WRITABLE
+                                                    or \ref ESP_LL_FRAME_INFO_REQUEST */
+    uint8_t seq;                                /*!< Sequence number of transfer in announced direction */
+    uint16_t len;                               /*!< Length of data to transfer */
+} esp_ll_frame_info_t;
+
+/**
+ * \brief           Bus access functions
+ *
+ * Functions are called from driver thread, except `init_fn`
+ */
+typedef struct {
+    uint8_t (*init_fn)(void);                   /*!< Initialize bus and handshake line. Return `1` on success.
+                                                    Set to `NULL` if not used */
+    uint8_t (*transfer_fn)(const void* tx, void* rx, size_t len);   /*!< Full duplex transfer of one transaction,
+                                                    chip select is active for whole transfer. Return `1` on success */
+    uint8_t (*ready_fn)(void);                  /*!< Read handshake line, return `1` when active */
+    esp_ll_reset_fn reset_fn;                   /*!< Module reset, set to `NULL` if not available */
+} esp_ll_frame_link_t;
+
+/**
+ * \brief           SPI AT transport statistics
+ */
+typedef struct {
+    uint32_t transactions;                      /*!< Number of slave status reads */
+    uint32_t frames_tx;                         /*!< Number of transfers to module */
+    uint32_t frames_rx;                         /*!< Number of transfers from module */
+    uint32_t bytes_tx;                          /*!< Number of data bytes delivered to module */
+    uint32_t bytes_rx;                          /*!< Number of data bytes received from module */
+    uint32_t status_errors;                     /*!< Number of invalid or unexpected slave status reads */
+    uint32_t seq_errors;                        /*!< Number of transfers from module with unexpected sequence number */
+    uint32_t request_retries;                   /*!< Number of send requests sent again without answer */
+} esp_ll_frame_stats_t;
+
+void        esp_ll_frame_set_link(const esp_ll_frame_link_t* link);
+void        esp_ll_frame_notify(void);
+void        esp_ll_frame_get_stats(esp_ll_frame_stats_t* stats);
+
+void        esp_ll_frame_info_encode(const esp_ll_frame_info_t* info, uint8_t* buf);
+uint8_t     esp_ll_frame_info_decode(const uint8_t* buf, esp_ll_frame_info_t* info);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ESP_HDR_LL_FRAME_H */
@@ -0,0 +1,96 @@
+/**
+ * \file            esp_ll_frame_loop.h
+ * \brief           Loopback link with module side of ESP-AT SPI AT protocol
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_LL_FRAME_LOOP_H
+#define ESP_HDR_LL_FRAME_LOOP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system/esp_ll_frame.h"
+
+/**
+ * \ingroup         ESP_LL_FRAME
+ * \defgroup        ESP_LL_FRAME_LOOP Loopback link
+ * \brief           Module side of ESP-AT SPI AT protocol in the same process
+ * \{
+ *
+ * Link behaves like SPI slave of ESP-AT firmware. It answers send requests from host
+ * with writable status when it has free receive buffer, and reports pending output with readable status.
+ * Requests from host are served before output, one transfer at a time.
+ * Handshake line is a flag, set when status is armed and cleared when host reads it.
+ * Activation is reported with \ref esp_ll_frame_notify.
+ *
+ * Module behind link is AT byte stream, for example emulator or scripted responder.
+ * It receives host data with `input_fn` in link thread, one transfer at a time,
+ * and sends data to host with \ref esp_ll_frame_loop_output.
+ * Receive buffer is released when `input_fn` returns.
+ */
+
+/**
+ * \brief           Number of module receive buffers
+ */
+#ifndef ESP_LL_FRAME_LOOP_BUFFERS
+#define ESP_LL_FRAME_LOOP_BUFFERS           4
+#endif
+
+/**
+ * \brief           Size of module output buffer in units of bytes
+ */
+#ifndef ESP_LL_FRAME_LOOP_TX_BUFF_SIZE
+#define ESP_LL_FRAME_LOOP_TX_BUFF_SIZE      0x2000
+#endif
+
+/**
+ * \brief           Module behind loopback link
+ */
+typedef struct {
+    uint8_t (*init_fn)(void);                   /*!< Start module, called once from link initialization.
+                                                    Return `1` on success. Set to `NULL` if not used */
+    size_t (*input_fn)(const void* data, size_t len);   /*!< Process data from host */
+} esp_ll_frame_loop_module_t;
+
+void        esp_ll_frame_loop_set_module(const esp_ll_frame_loop_module_t* module);
+const esp_ll_frame_link_t*  esp_ll_frame_loop_get_link(void);
+size_t      esp_ll_frame_loop_output(const void* data, size_t len);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ESP_HDR_LL_FRAME_LOOP_H */
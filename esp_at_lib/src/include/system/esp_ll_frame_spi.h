@@ -0,0 +1,103 @@
+/**
+ * \file            esp_ll_frame_spi.h
+ * \brief           SPI link for ESP-AT SPI AT protocol on Linux hosts
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_LL_FRAME_SPI_H
+#define ESP_HDR_LL_FRAME_SPI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system/esp_ll_frame.h"
+
+/**
+ * \ingroup         ESP_LL_FRAME
+ * \defgroup        ESP_LL_FRAME_SPI SPI link
+ * \brief           ESP-AT SPI AT protocol over `spidev` with handshake line on GPIO character device
+ * \{
+ *
+ * Host is SPI master, module running ESP-AT firmware with SPI AT interface is half-duplex SPI slave.
+ * Every transaction, command, address and dummy byte followed by data, is single `spidev` message,
+ * chip select is released in between transactions.
+ *
+ * Handshake line is watched for edges in link thread, which notifies driver.
+ * Module reset line is optional.
+ */
+
+/**
+ * \brief           Default SPI device
+ */
+#ifndef ESP_LL_FRAME_SPI_DEV
+#define ESP_LL_FRAME_SPI_DEV                "/dev/spidev0.0"
+#endif
+
+/**
+ * \brief           Default SPI clock in units of Hz
+ */
+#ifndef ESP_LL_FRAME_SPI_SPEED
+#define ESP_LL_FRAME_SPI_SPEED              10000000
+#endif
+
+/**
+ * \brief           Default GPIO chip with handshake and reset lines
+ */
+#ifndef ESP_LL_FRAME_SPI_GPIO_CHIP
+#define ESP_LL_FRAME_SPI_GPIO_CHIP          "/dev/gpiochip0"
+#endif
+
+/**
+ * \brief           SPI link configuration
+ */
+typedef struct {
+    const char* dev;                            /*!< SPI device. Set to `NULL` to use \ref ESP_LL_FRAME_SPI_DEV */
+    uint32_t speed;                             /*!< SPI clock in units of Hz. Set to `0` to use \ref ESP_LL_FRAME_SPI_SPEED */
+    uint8_t mode;                               /*!< SPI mode, from `0` to `3` */
+    const char* gpio_chip;                      /*!< GPIO chip. Set to `NULL` to use \ref ESP_LL_FRAME_SPI_GPIO_CHIP */
+    uint32_t hs_line;                           /*!< Handshake line offset on GPIO chip */
+    uint8_t hs_active_low;                      /*!< Set to `1` when handshake line is active low */
+    uint8_t reset;                              /*!< Set to `1` to drive module reset with `reset_line`, active low */
+    uint32_t reset_line;                        /*!< Reset line offset on GPIO chip */
+} esp_ll_frame_spi_config_t;
+
+void        esp_ll_frame_spi_set_config(const esp_ll_frame_spi_config_t* config);
+const esp_ll_frame_link_t*  esp_ll_frame_spi_get_link(void);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ESP_HDR_LL_FRAME_SPI_H */
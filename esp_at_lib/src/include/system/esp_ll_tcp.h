@@ -0,0 +1,116 @@
+/**
+ * \file            esp_ll_tcp.h
+ * \brief           Low-level communication over TCP serial bridge
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_LL_TCP_H
+#define ESP_HDR_LL_TCP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system/esp_ll.h"
+
+/**
+ * \ingroup         ESP_LL
+ * \defgroup        ESP_LL_TCP TCP serial bridge
+ * \brief           AT port carried over TCP connection to serial device server
+ * \{
+ *
+ * Driver for POSIX hosts, where module is attached to serial device server
+ * or serial-over-IP bridge, such as `ser2net` or `socat`.
+ *
+ * In raw mode, TCP stream is AT stream. In RFC 2217 mode, driver negotiates
+ * telnet COM port control option and sets baudrate, data format and flow control
+ * of remote serial port, every time library changes AT baudrate.
+ *
+ * Data from library are collected in transmit buffer until library flushes AT port,
+ * which happens at the end of every command. Complete command is then sent
+ * in single TCP segment with Nagle algorithm disabled.
+ *
+ * When connection is lost, driver reconnects in background.
+ */
+
+/**
+ * \brief           Default bridge host name or address
+ */
+#ifndef ESP_LL_TCP_HOST
+#define ESP_LL_TCP_HOST                     "127.0.0.1"
+#endif
+
+/**
+ * \brief           Default bridge TCP port
+ */
+#ifndef ESP_LL_TCP_PORT
+#define ESP_LL_TCP_PORT                     4000
+#endif
+
+/**
+ * \brief           Size of transmit buffer in units of bytes
+ *
+ * Data are sent when library flushes AT port or when buffer is full
+ */
+#ifndef ESP_LL_TCP_TX_BUFF_SIZE
+#define ESP_LL_TCP_TX_BUFF_SIZE             1460
+#endif
+
+/**
+ * \brief           Delay between reconnect attempts in units of milliseconds
+ */
+#ifndef ESP_LL_TCP_RECONNECT_DELAY
+#define ESP_LL_TCP_RECONNECT_DELAY          1000
+#endif
+
+/**
+ * \brief           TCP bridge configuration
+ */
+typedef struct {
+    const char* host;                           /*!< Bridge host name or address. Set to `NULL` to use \ref ESP_LL_TCP_HOST */
+    uint16_t port;                              /*!< Bridge TCP port. Set to `0` to use \ref ESP_LL_TCP_PORT */
+    uint8_t rfc2217;                            /*!< Set to `1` to use RFC 2217 telnet COM port control, `0` for raw TCP */
+    uint8_t flow_control;                       /*!< Set to `1` to enable RTS/CTS flow control on remote port. RFC 2217 only */
+    uint8_t reset_rts;                          /*!< Set to `1` to drive module reset with RTS line of remote port. RFC 2217 only,
+                                                    cannot be used together with flow control */
+} esp_ll_tcp_config_t;
+
+void        esp_ll_tcp_set_config(const esp_ll_tcp_config_t* config);
+uint8_t     esp_ll_tcp_is_connected(void);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ESP_HDR_LL_TCP_H */
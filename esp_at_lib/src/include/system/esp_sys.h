@@ -129,6 +129,21 @@ uint8_t     esp_sys_thread_create(esp_sys_thread_t* t, const char* name, esp_sys
 uint8_t     esp_sys_thread_terminate(esp_sys_thread_t* t);
 uint8_t     esp_sys_thread_yield(void);
 
+#if ESP_CFG_THREAD_STACK_STATS || __DOXYGEN__
+
+/**
+ * \brief           Stack usage of single thread
+ */
+typedef struct {
+    const char* name;                           /*!< Thread name as passed to \ref esp_sys_thread_create */
+    size_t size;                                /*!< Stack size in units of bytes, `0` when unknown */
+    size_t used_max;                            /*!< High-water mark, maximal number of stack bytes used so far */
+} esp_sys_thread_stack_t;
+
+size_t      esp_sys_thread_get_stack_stats(esp_sys_thread_stack_t* stats, size_t len);
+
+#endif /* ESP_CFG_THREAD_STACK_STATS || __DOXYGEN__ */
+
 /**
  * \}
  */
@@ -0,0 +1,80 @@
+/**
+ * \file            esp_sys_posix_stack.h
+ * \brief           Stack painting shared by POSIX system ports
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_SYS_POSIX_STACK_H
+#define ESP_HDR_SYS_POSIX_STACK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "esp_config.h"
+
+#if (ESP_CFG_OS && ESP_CFG_THREAD_STACK_STATS) || __DOXYGEN__
+
+/**
+ * \ingroup         ESP_SYS
+ * \defgroup        ESP_SYS_POSIX_STACK POSIX stack painting
+ * \brief           Stack high-water tracking for `posix` and `posix_vt` ports
+ * \{
+ *
+ * Thread paints its own unused stack on start,
+ * statistics later count untouched bytes from stack bottom.
+ */
+
+/**
+ * \brief           Value used to paint unused stack
+ */
+#define ESP_SYS_POSIX_STACK_PAINT           0xA5
+
+/**
+ * \brief           Stack area below painting frame left unpainted
+ */
+#define ESP_SYS_POSIX_STACK_PAINT_MARGIN    1024
+
+uint8_t     esp_sys_posix_stack_paint(const uint8_t** lo, size_t* size);
+size_t      esp_sys_posix_stack_used(const uint8_t* lo, size_t size);
+
+/**
+ * \}
+ */
+
+#endif /* (ESP_CFG_OS && ESP_CFG_THREAD_STACK_STATS) || __DOXYGEN__ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ESP_HDR_SYS_POSIX_STACK_H */
@@ -0,0 +1,73 @@
+/**
+ * \file            esp_sys_port.h
+ * \brief           POSIX based system file implementation with virtual time
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef ESP_HDR_SYSTEM_PORT_H
+#define ESP_HDR_SYSTEM_PORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "esp_config.h"
+
+#if ESP_CFG_OS && !__DOXYGEN__
+
+typedef struct vt_mutex*            esp_sys_mutex_t;
+typedef struct vt_sem*              esp_sys_sem_t;
+typedef struct vt_mbox*             esp_sys_mbox_t;
+typedef struct vt_thread*           esp_sys_thread_t;
+typedef int                         esp_sys_thread_prio_t;
+
+#define ESP_SYS_MBOX_NULL           ((esp_sys_mbox_t)0)
+#define ESP_SYS_SEM_NULL            ((esp_sys_sem_t)0)
+#define ESP_SYS_MUTEX_NULL          ((esp_sys_mutex_t)0)
+#define ESP_SYS_TIMEOUT             ((uint32_t)0xFFFFFFFFUL)
+#define ESP_SYS_THREAD_PRIO         (0)
+#define ESP_SYS_THREAD_SS           (0x8000)
+#define ESP_SYS_VIRTUAL_TIME        1           /*!< System port runs on virtual time */
+
+uint8_t     esp_sys_vt_thread_register(void);
+uint8_t     esp_sys_vt_thread_unregister(void);
+uint32_t    esp_sys_vt_get_real_time(void);
+uint64_t    esp_sys_posix_now_us(void);
+
+#endif /* ESP_CFG_OS && !__DOXYGEN__ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ESP_HDR_SYSTEM_PORT_H */
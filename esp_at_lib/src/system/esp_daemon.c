@@ -0,0 +1,640 @@
+/**
+ * \file            esp_daemon.c
+ * \brief           Multi-process stack daemon for Linux hosts
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#define _GNU_SOURCE                             /* For memfd_create and accept4 */
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "system/esp_daemon.h"
+#include "esp/esp.h"
+
+#if !__DOXYGEN__
+
+/* Ring indexes are shared with client process, producer publishes slot with release store */
+#define RING_LOAD(x)                __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define RING_STORE(x, v)            __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define RING_SLOT(r, i)             (&(r)->slots[(i) % ESP_DAEMON_RING_SLOTS])
+
+/*
+ * Epoll event data, descriptor type in low byte and client index above.
+ * Listening and control sockets are served on control thread, doorbells on data thread
+ */
+#define EP_LISTEN                   0
+#define EP_CTRL                     1
+#define EP_DOORBELL                 2
+#define EP_DATA(type, idx)          (((uint64_t)(idx) << 8) | (type))
+
+/* Period to retry transmit slots refused by library, in units of milliseconds */
+#define DAEMON_RETRY_PERIOD         100
+
+struct daemon_client;
+
+/**
+ * \brief           Daemon side of connection channel
+ */
+typedef struct {
+    struct daemon_client* client;               /*!< Client owning channel */
+    esp_daemon_chan_t* shm;                     /*!< Channel rings in shared memory */
+    esp_conn_p conn;                            /*!< Library connection, `NULL` when closed */
+    esp_pbuf_p rx_pbuf;                         /*!< Received data not yet copied to receive ring */
+    size_t rx_off;                              /*!< Number of bytes of `rx_pbuf` already copied */
+    uint32_t tx_next;                           /*!< Next transmit slot to pass to library */
+    uint8_t used;                               /*!< Set to `1` when channel is allocated by client */
+    uint8_t closed;                             /*!< Set to `1` when close record must be written after data */
+} daemon_chan_t;
+
+/**
+ * \brief           Connected client
+ */
+typedef struct daemon_client {
+    int ctrl;                                   /*!< Control socket, `-1` when slot is free */
+    int db_daemon;                              /*!< Doorbell rung by client */
+    int db_client;                              /*!< Doorbell rung by daemon */
+    int shm_fd;                                 /*!< Shared memory descriptor */
+    esp_daemon_shm_t* shm;                      /*!< Shared memory mapping */
+    daemon_chan_t chans[ESP_DAEMON_CHANNELS];   /*!< Connection channels */
+} daemon_client_t;
+
+/**
+ * \brief           Daemon state
+ */
+static struct {
+    int listen;                                 /*!< Listening control socket */
+    int ep;                                     /*!< Epoll descriptor of data thread */
+    int ep_ctrl;                                /*!< Epoll descriptor of control thread */
+    daemon_client_t clients[ESP_DAEMON_MAX_CLIENTS];/*!< Client slots. Shared memory and doorbells
+                                                    are protected by core lock, control socket is used by control thread only */
+    esp_daemon_stats_t stats;                   /*!< Daemon statistics, protected by core lock */
+} srv = {
+    .listen = -1,
+    .ep = -1,
+    .ep_ctrl = -1,
+};
+
+/**
+ * \brief           Ring doorbell
+ * \param[in]       fd: Doorbell `eventfd`
+ */
+static void
+doorbell_ring(int fd) {
+    uint64_t val = 1;
+
+    if (write(fd, &val, sizeof(val)) < 0) {
+        /* Counter overflow only, doorbell is already rung */
+    }
+}
+
+/**
+ * \brief           Clear doorbell
+ * \param[in]       fd: Doorbell `eventfd`
+ */
+static void
+doorbell_clear(int fd) {
+    uint64_t val;
+
+    if (read(fd, &val, sizeof(val)) < 0) {
+        /* Not rung */
+    }
+}
+
+/**
+ * \brief           Copy pending received data and close record to receive ring
+ * \note            Core lock must be held by caller
+ * \param[in]       ch: Channel
+ * \return          `1` if any slot was written, `0` otherwise
+ */
+static uint8_t
+chan_flush_rx(daemon_chan_t* ch) {
+    esp_daemon_ring_t* r = &ch->shm->rx;
+    esp_daemon_slot_t* s;
+    uint32_t head = r->head;
+    uint8_t written = 0;
+
+    while (head - RING_LOAD(r->tail) < ESP_DAEMON_RING_SLOTS) {
+        s = RING_SLOT(r, head);
+        if (ch->rx_pbuf != NULL) {
+            s->type = ESP_DAEMON_REC_DATA;
+            s->len = (uint32_t)esp_pbuf_copy(ch->rx_pbuf, s->data, sizeof(s->data), ch->rx_off);
+            ch->rx_off += s->len;
+            srv.stats.bytes_rx += s->len;
+            if (ch->rx_off >= esp_pbuf_length(ch->rx_pbuf, 1)) {
+                if (ch->conn != NULL) {
+                    esp_conn_recved(ch->conn, ch->rx_pbuf);
+                }
+                esp_pbuf_free(ch->rx_pbuf);
+                ch->rx_pbuf = NULL;
+                ch->rx_off = 0;
+            }
+        } else if (ch->closed) {
+            s->type = ESP_DAEMON_REC_CLOSED;
+            s->len = 0;
+            ch->closed = 0;
+        } else {
+            break;
+        }
+        RING_STORE(r->head, ++head);
+        written = 1;
+    }
+    return written;
+}
+
+/**
+ * \brief           Pass new transmit slots to library
+ *
+ * Slot memory is sent in place, it stays reserved until \ref ESP_EVT_CONN_SEND event
+ *
+ * \note            Core lock must be held by caller
+ * \param[in]       ch: Channel
+ */
+static void
+chan_submit_tx(daemon_chan_t* ch) {
+    esp_daemon_ring_t* r = &ch->shm->tx;
+    esp_daemon_slot_t* s;
+    uint32_t head = RING_LOAD(r->head);
+    size_t len;
+
+    while (ch->conn != NULL && ch->tx_next != head
+        && ch->tx_next - r->tail < ESP_DAEMON_TX_INFLIGHT) {
+        s = RING_SLOT(r, ch->tx_next);
+        len = ESP_MIN((size_t)s->len, sizeof(s->data));
+        if (len == 0 || esp_conn_send(ch->conn, s->data, len, NULL, 0) != espOK) {
+            break;                              /* Retried on next doorbell or retry period */
+        }
+        ++ch->tx_next;
+    }
+}
+
+/**
+ * \brief           Connection event callback for all client connections
+ * \param[in]       evt: Event information
+ * \return          \ref espOK on success, member of \ref espr_t otherwise
+ */
+static espr_t
+daemon_conn_evt_fn(esp_evt_t* evt) {
+    esp_conn_p conn = esp_conn_get_from_evt(evt);
+    daemon_chan_t* ch;
+    esp_pbuf_p pbuf;
+    uint8_t ring = 0;
+
+    if (conn == NULL || (ch = esp_conn_get_arg(conn)) == NULL) {
+        return espOK;
+    }
+    if (esp_evt_get_type(evt) == ESP_EVT_CONN_ACTIVE) {
+        ch->conn = conn;
+        return espOK;
+    } else if (ch->conn != conn) {
+        return espOK;                           /* Late event of released channel */
+    }
+    switch (esp_evt_get_type(evt)) {
+        case ESP_EVT_CONN_RECV: {
+            pbuf = esp_evt_conn_recv_get_buff(evt);
+            esp_pbuf_ref(pbuf);                 /* Keep buffer until copied to ring */
+            if (ch->rx_pbuf == NULL) {
+                ch->rx_pbuf = pbuf;
+            } else {
+                esp_pbuf_cat(ch->rx_pbuf, pbuf);
+            }
+            ring = chan_flush_rx(ch);
+            break;
+        }
+        case ESP_EVT_CONN_SEND: {
+            /* Sends complete in order, oldest slot is released */
+            RING_STORE(ch->shm->tx.tail, ch->shm->tx.tail + 1);
+            if (esp_evt_conn_send_get_result(evt) == espOK) {
+                srv.stats.bytes_tx += (uint32_t)esp_evt_conn_send_get_length(evt);
+            }
+
+            /* Producer queue has free entry now, pass slots refused before */
+            for (size_t i = 0; i < ESP_DAEMON_CHANNELS; ++i) {
+                if (ch->client->chans[i].used) {
+                    chan_submit_tx(&ch->client->chans[i]);
+                }
+            }
+            ring = 1;
+            break;
+        }
+        case ESP_EVT_CONN_CLOSE: {
+            RING_STORE(ch->shm->closed, 1);
+            ch->conn = NULL;
+            ch->closed = 1;
+            ring = chan_flush_rx(ch);
+            break;
+        }
+        default:
+            break;
+    }
+    if (ring) {
+        doorbell_ring(ch->client->db_client);
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Close connection and free channel
+ * \param[in]       ch: Channel
+ */
+static void
+chan_release(daemon_chan_t* ch) {
+    esp_conn_p conn;
+
+    esp_core_lock();
+    conn = ch->conn;
+    esp_core_unlock();
+    if (conn != NULL) {
+        esp_conn_close(conn, 1);
+    }
+
+    esp_core_lock();
+    if (ch->conn != NULL) {
+        esp_conn_set_arg(ch->conn, NULL);       /* Close failed, ignore further events */
+    }
+    if (ch->rx_pbuf != NULL) {
+        esp_pbuf_free(ch->rx_pbuf);
+    }
+    ch->conn = NULL;
+    ch->rx_pbuf = NULL;
+    ch->rx_off = 0;
+    ch->tx_next = 0;
+    ch->closed = 0;
+    ch->used = 0;
+    ch->shm->closed = 0;
+    ch->shm->tx.head = ch->shm->tx.tail = 0;
+    ch->shm->rx.head = ch->shm->rx.tail = 0;
+    esp_core_unlock();
+}
+
+/**
+ * \brief           Start connection on free channel of client
+ * \param[in]       c: Client
+ * \param[in]       req: Start request
+ * \param[out]      num: Channel number
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+chan_start(daemon_client_t* c, esp_daemon_req_t* req, uint32_t* num) {
+    daemon_chan_t* ch = NULL;
+    espr_t res;
+
+    esp_core_lock();
+    for (size_t i = 0; i < ESP_DAEMON_CHANNELS; ++i) {
+        if (!c->chans[i].used) {
+            ch = &c->chans[i];
+            ch->used = 1;
+            *num = (uint32_t)i;
+            break;
+        }
+    }
+    esp_core_unlock();
+    if (ch == NULL) {
+        return espERRNOFREECONN;
+    }
+
+    req->host[sizeof(req->host) - 1] = '\0';
+    if (req->type > ESP_CONN_TYPE_SSL || req->port == 0 || req->port > 0xFFFF || req->host[0] == '\0') {
+        res = espPARERR;
+    } else {
+        res = esp_conn_start(NULL, (esp_conn_type_t)req->type, req->host, (esp_port_t)req->port, ch, daemon_conn_evt_fn, 1);
+    }
+    if (res == espOK) {
+        esp_core_lock();
+        ++srv.stats.conns;
+        esp_core_unlock();
+    } else {
+        chan_release(ch);
+    }
+    return res;
+}
+
+/**
+ * \brief           Close descriptor if open
+ * \param[in,out]   fd: Descriptor, set to `-1`
+ */
+static void
+fd_close(int* fd) {
+    if (*fd >= 0) {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+/**
+ * \brief           Release all resources of client
+ * \param[in]       c: Client
+ */
+static void
+client_free(daemon_client_t* c) {
+    esp_daemon_shm_t* shm;
+
+    for (size_t i = 0; i < ESP_DAEMON_CHANNELS; ++i) {
+        if (c->chans[i].used) {
+            chan_release(&c->chans[i]);
+        }
+    }
+
+    /* Hide client from data thread and connection events before resources are released */
+    esp_core_lock();
+    shm = c->shm;
+    c->shm = NULL;
+    if (c->ctrl >= 0) {
+        --srv.stats.clients;
+    }
+    /* Closing removes descriptors from epoll set */
+    fd_close(&c->db_daemon);
+    fd_close(&c->db_client);
+    esp_core_unlock();
+    if (shm != NULL) {
+        munmap(shm, sizeof(*shm));
+    }
+    fd_close(&c->ctrl);
+    fd_close(&c->shm_fd);
+}
+
+/**
+ * \brief           Accept new client, create shared memory and doorbells
+ */
+static void
+client_accept(void) {
+    struct epoll_event ev = { .events = EPOLLIN };
+    esp_daemon_rsp_t rsp = { .res = espOK };
+    struct iovec iov = { .iov_base = &rsp, .iov_len = sizeof(rsp) };
+    union {
+        struct cmsghdr hdr;
+        uint8_t buff[CMSG_SPACE(3 * sizeof(int))];
+    } cmsg;
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = cmsg.buff, .msg_controllen = sizeof(cmsg.buff) };
+    daemon_client_t* c = NULL;
+    esp_daemon_shm_t* shm = MAP_FAILED;
+    size_t idx = 0;
+    int fd, db_daemon = -1, db_client = -1;
+
+    if ((fd = accept4(srv.listen, NULL, NULL, SOCK_CLOEXEC)) < 0) {
+        return;
+    }
+    for (idx = 0; idx < ESP_DAEMON_MAX_CLIENTS; ++idx) {
+        if (srv.clients[idx].ctrl < 0 && srv.clients[idx].shm_fd < 0) {
+            c = &srv.clients[idx];
+            break;
+        }
+    }
+    if (c == NULL) {
+        close(fd);
+        return;
+    }
+
+    /* Shared memory is zero filled, rings start empty */
+    if ((c->shm_fd = memfd_create("esp_daemon", MFD_CLOEXEC)) < 0
+        || ftruncate(c->shm_fd, sizeof(*shm)) != 0
+        || (shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE, MAP_SHARED, c->shm_fd, 0)) == MAP_FAILED
+        || (db_daemon = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0
+        || (db_client = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        if (shm != MAP_FAILED) {
+            munmap(shm, sizeof(*shm));
+        }
+        fd_close(&db_daemon);
+        fd_close(&c->shm_fd);
+        close(fd);
+        return;
+    }
+    shm->magic = ESP_DAEMON_MAGIC;
+    shm->channels = ESP_DAEMON_CHANNELS;
+    shm->ring_slots = ESP_DAEMON_RING_SLOTS;
+    shm->slot_size = ESP_DAEMON_SLOT_SIZE;
+
+    /* Publish client to data thread */
+    esp_core_lock();
+    c->shm = shm;
+    c->db_daemon = db_daemon;
+    c->db_client = db_client;
+    for (size_t i = 0; i < ESP_DAEMON_CHANNELS; ++i) {
+        c->chans[i].client = c;
+        c->chans[i].shm = &shm->chans[i];
+    }
+    ++srv.stats.clients;
+    esp_core_unlock();
+
+    /* Pass shared memory and doorbells with first response */
+    cmsg.hdr.cmsg_level = SOL_SOCKET;
+    cmsg.hdr.cmsg_type = SCM_RIGHTS;
+    cmsg.hdr.cmsg_len = CMSG_LEN(3 * sizeof(int));
+    ((int *)CMSG_DATA(&cmsg.hdr))[0] = c->shm_fd;
+    ((int *)CMSG_DATA(&cmsg.hdr))[1] = c->db_daemon;
+    ((int *)CMSG_DATA(&cmsg.hdr))[2] = c->db_client;
+    c->ctrl = fd;
+    if (sendmsg(fd, &msg, MSG_NOSIGNAL) != sizeof(rsp)) {
+        client_free(c);
+        return;
+    }
+    ev.data.u64 = EP_DATA(EP_CTRL, idx);
+    epoll_ctl(srv.ep_ctrl, EPOLL_CTL_ADD, c->ctrl, &ev);
+    ev.data.u64 = EP_DATA(EP_DOORBELL, idx);
+    epoll_ctl(srv.ep, EPOLL_CTL_ADD, db_daemon, &ev);
+}
+
+/**
+ * \brief           Process control request of client
+ * \param[in]       c: Client
+ */
+static void
+client_ctrl(daemon_client_t* c) {
+    esp_daemon_req_t req;
+    esp_daemon_rsp_t rsp = { .res = espPARERR };
+    ssize_t len;
+
+    if ((len = recv(c->ctrl, &req, sizeof(req), 0)) <= 0) {
+        client_free(c);                         /* Client closed socket or exited */
+        return;
+    }
+    if (len == sizeof(req)) {
+        switch (req.op) {
+            case ESP_DAEMON_OP_CONN_START: {
+                rsp.res = chan_start(c, &req, &rsp.chan);
+                break;
+            }
+            case ESP_DAEMON_OP_CONN_CLOSE: {
+                if (req.chan < ESP_DAEMON_CHANNELS && c->chans[req.chan].used) {
+                    chan_release(&c->chans[req.chan]);
+                    rsp.res = espOK;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    if (send(c->ctrl, &rsp, sizeof(rsp), MSG_NOSIGNAL) != sizeof(rsp)) {
+        client_free(c);
+    }
+}
+
+/**
+ * \brief           Move data between client rings and library
+ * \param[in]       c: Client
+ */
+static void
+client_service(daemon_client_t* c) {
+    uint8_t ring = 0;
+
+    esp_core_lock();
+    if (c->shm != NULL) {
+        for (size_t i = 0; i < ESP_DAEMON_CHANNELS; ++i) {
+            if (c->chans[i].used) {
+                chan_submit_tx(&c->chans[i]);
+                ring |= chan_flush_rx(&c->chans[i]);
+            }
+        }
+        if (ring) {
+            doorbell_ring(c->db_client);
+        }
+    }
+    esp_core_unlock();
+}
+
+/**
+ * \brief           Control thread, accepts clients and serves control requests
+ *
+ * Requests block until module answers, data thread is not affected
+ *
+ * \param[in]       arg: Thread argument, not used
+ */
+static void
+daemon_ctrl_thread(void* arg) {
+    struct epoll_event evs[ESP_DAEMON_MAX_CLIENTS + 1];
+    daemon_client_t* c;
+    int n;
+
+    ESP_UNUSED(arg);
+    while (1) {
+        n = epoll_wait(srv.ep_ctrl, evs, ESP_ARRAYSIZE(evs), -1);
+        for (int i = 0; i < n; ++i) {
+            c = &srv.clients[evs[i].data.u64 >> 8];
+            switch (evs[i].data.u64 & 0xFF) {
+                case EP_LISTEN: client_accept(); break;
+                case EP_CTRL: if (c->ctrl >= 0) { client_ctrl(c); } break;
+                default: break;
+            }
+        }
+    }
+}
+
+/**
+ * \brief           Data thread, serves client doorbells and retries refused transmit slots
+ * \param[in]       arg: Thread argument, not used
+ */
+static void
+daemon_thread(void* arg) {
+    struct epoll_event evs[ESP_DAEMON_MAX_CLIENTS];
+    daemon_client_t* c;
+    int n;
+
+    ESP_UNUSED(arg);
+    while (1) {
+        n = epoll_wait(srv.ep, evs, ESP_ARRAYSIZE(evs), DAEMON_RETRY_PERIOD);
+        for (int i = 0; i < n; ++i) {
+            c = &srv.clients[evs[i].data.u64 >> 8];
+            if ((evs[i].data.u64 & 0xFF) == EP_DOORBELL) {
+                esp_core_lock();
+                if (c->shm != NULL) {           /* Descriptor may be closed by control thread */
+                    doorbell_clear(c->db_daemon);
+                }
+                esp_core_unlock();
+            }
+        }
+
+        /* Serve all clients, also retries transmit slots refused by library */
+        for (size_t i = 0; i < ESP_DAEMON_MAX_CLIENTS; ++i) {
+            client_service(&srv.clients[i]);
+        }
+    }
+}
+
+#endif /* !__DOXYGEN__ */
+
+/**
+ * \brief           Start daemon on control socket path
+ *
+ * Library must be initialized with \ref esp_init before daemon is started.
+ * Existing socket file on the same path is removed.
+ *
+ * \param[in]       path: Path of `AF_UNIX` control socket
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_daemon_start(const char* path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    struct epoll_event ev = { .events = EPOLLIN, .data.u64 = EP_DATA(EP_LISTEN, 0) };
+
+    ESP_ASSERT("path != NULL", path != NULL);
+    ESP_ASSERT("path fits socket address", strlen(path) < sizeof(addr.sun_path));
+
+    if (srv.listen >= 0) {
+        return espERR;
+    }
+    for (size_t i = 0; i < ESP_DAEMON_MAX_CLIENTS; ++i) {
+        srv.clients[i].ctrl = srv.clients[i].db_daemon = -1;
+        srv.clients[i].db_client = srv.clients[i].shm_fd = -1;
+    }
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if ((srv.listen = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) < 0
+        || bind(srv.listen, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(srv.listen, ESP_DAEMON_MAX_CLIENTS) != 0
+        || (srv.ep = epoll_create1(EPOLL_CLOEXEC)) < 0
+        || (srv.ep_ctrl = epoll_create1(EPOLL_CLOEXEC)) < 0
+        || epoll_ctl(srv.ep_ctrl, EPOLL_CTL_ADD, srv.listen, &ev) != 0
+        || !esp_sys_thread_create(NULL, "esp_daemon", daemon_thread, NULL, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO)) {
+        fd_close(&srv.ep_ctrl);
+        fd_close(&srv.ep);
+        fd_close(&srv.listen);
+        return espERR;
+    }
+
+    /* Data thread cannot be stopped, daemon stays started without clients on failure */
+    if (!esp_sys_thread_create(NULL, "esp_daemon_ctrl", daemon_ctrl_thread, NULL, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO)) {
+        return espERR;
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Get daemon statistics
+ * \param[out]      stats: Statistics to fill
+ */
+void
+esp_daemon_get_stats(esp_daemon_stats_t* stats) {
+    esp_core_lock();
+    ESP_MEMCPY(stats, &srv.stats, sizeof(*stats));
+    esp_core_unlock();
+}
@@ -0,0 +1,443 @@
+/**
+ * \file            esp_daemon_client.c
+ * \brief           Client library for multi-process stack daemon
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "system/esp_daemon_client.h"
+
+#if !__DOXYGEN__
+
+/* Ring indexes are shared with daemon process, producer publishes slot with release store */
+#define RING_LOAD(x)                __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define RING_STORE(x, v)            __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define RING_SLOT(r, i)             (&(r)->slots[(i) % ESP_DAEMON_RING_SLOTS])
+
+/**
+ * \brief           Client connection
+ */
+struct esp_daemon_conn {
+    esp_daemon_client_p client;                 /*!< Client owning connection */
+    esp_daemon_chan_t* shm;                     /*!< Channel rings in shared memory */
+    uint32_t num;                               /*!< Channel number */
+    uint8_t used;                               /*!< Set to `1` when connection is started */
+};
+
+/**
+ * \brief           Client
+ */
+struct esp_daemon_client {
+    int ctrl;                                   /*!< Control socket */
+    int db_daemon;                              /*!< Doorbell rung by client */
+    int db_client;                              /*!< Doorbell rung by daemon */
+    esp_daemon_shm_t* shm;                      /*!< Shared memory mapping */
+    struct esp_daemon_conn conns[ESP_DAEMON_CHANNELS];  /*!< Connections */
+};
+
+/**
+ * \brief           Get monotonic time
+ * \return          Time in units of milliseconds
+ */
+static uint32_t
+client_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/**
+ * \brief           Ring daemon doorbell
+ * \param[in]       client: Client handle
+ */
+static void
+client_doorbell_ring(esp_daemon_client_p client) {
+    uint64_t val = 1;
+
+    if (write(client->db_daemon, &val, sizeof(val)) < 0) {
+        /* Counter overflow only, doorbell is already rung */
+    }
+}
+
+/**
+ * \brief           Wait for daemon doorbell
+ *
+ * Doorbell is cleared and state checked once more before thread sleeps,
+ * so doorbell rung in between is not lost
+ *
+ * \param[in]       client: Client handle
+ * \param[in]       start: Time when operation started
+ * \param[in]       timeout: Operation timeout in units of milliseconds
+ * \param[in,out]   cleared: Set to `1` when doorbell was cleared after last check, initially `0`
+ * \return          `1` when state must be checked again, `0` on timeout
+ */
+static uint8_t
+client_wait(esp_daemon_client_p client, uint32_t start, uint32_t timeout, uint8_t* cleared) {
+    struct pollfd pfd = { .fd = client->db_client, .events = POLLIN };
+    uint32_t elapsed = client_now() - start;
+
+    if (timeout == 0 || (timeout != ESP_DAEMON_WAIT_FOREVER && elapsed >= timeout)) {
+        return 0;
+    } else if (!*cleared) {
+        esp_daemon_client_clear_fd(client);
+        *cleared = 1;
+        return 1;
+    }
+    *cleared = 0;
+    if (poll(&pfd, 1, timeout == ESP_DAEMON_WAIT_FOREVER ? -1 : (int)(timeout - elapsed)) < 0 && errno != EINTR) {
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * \brief           Send control request and wait for response
+ * \param[in]       client: Client handle
+ * \param[in]       req: Request to send
+ * \param[out]      rsp: Response from daemon
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+static espr_t
+client_request(esp_daemon_client_p client, const esp_daemon_req_t* req, esp_daemon_rsp_t* rsp) {
+    if (send(client->ctrl, req, sizeof(*req), MSG_NOSIGNAL) != sizeof(*req)
+        || recv(client->ctrl, rsp, sizeof(*rsp), 0) != sizeof(*rsp)) {
+        return espERR;
+    }
+    return (espr_t)rsp->res;
+}
+
+#endif /* !__DOXYGEN__ */
+
+/**
+ * \brief           Connect to daemon
+ * \param[in]       path: Path of daemon control socket
+ * \return          Client handle on success, `NULL` otherwise
+ */
+esp_daemon_client_p
+esp_daemon_client_new(const char* path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    esp_daemon_rsp_t rsp;
+    struct iovec iov = { .iov_base = &rsp, .iov_len = sizeof(rsp) };
+    union {
+        struct cmsghdr hdr;
+        uint8_t buff[CMSG_SPACE(3 * sizeof(int))];
+    } cmsg;
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = cmsg.buff, .msg_controllen = sizeof(cmsg.buff) };
+    esp_daemon_client_p client;
+    void* shm;
+    int fds[3];
+
+    if (path == NULL || strlen(path) >= sizeof(addr.sun_path)
+        || (client = calloc(1, sizeof(*client))) == NULL) {
+        return NULL;
+    }
+    client->db_daemon = client->db_client = -1;
+    strcpy(addr.sun_path, path);
+
+    /* First message carries shared memory and doorbells */
+    if ((client->ctrl = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) < 0
+        || connect(client->ctrl, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || recvmsg(client->ctrl, &msg, MSG_CMSG_CLOEXEC) != sizeof(rsp)
+        || rsp.res != espOK
+        || msg.msg_controllen < CMSG_LEN(sizeof(fds))
+        || cmsg.hdr.cmsg_level != SOL_SOCKET || cmsg.hdr.cmsg_type != SCM_RIGHTS
+        || cmsg.hdr.cmsg_len != CMSG_LEN(sizeof(fds))) {
+        esp_daemon_client_delete(client);
+        return NULL;
+    }
+    memcpy(fds, CMSG_DATA(&cmsg.hdr), sizeof(fds));
+    client->db_daemon = fds[1];
+    client->db_client = fds[2];
+    shm = mmap(NULL, sizeof(*client->shm), PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    close(fds[0]);                              /* Mapping keeps memory */
+    if (shm == MAP_FAILED) {
+        esp_daemon_client_delete(client);
+        return NULL;
+    }
+    client->shm = shm;
+
+    /* Both processes must agree on layout */
+    if (client->shm->magic != ESP_DAEMON_MAGIC
+        || client->shm->channels != ESP_DAEMON_CHANNELS
+        || client->shm->ring_slots != ESP_DAEMON_RING_SLOTS
+        || client->shm->slot_size != ESP_DAEMON_SLOT_SIZE) {
+        esp_daemon_client_delete(client);
+        return NULL;
+    }
+    for (size_t i = 0; i < ESP_DAEMON_CHANNELS; ++i) {
+        client->conns[i].client = client;
+        client->conns[i].shm = &client->shm->chans[i];
+        client->conns[i].num = (uint32_t)i;
+    }
+    return client;
+}
+
+/**
+ * \brief           Disconnect from daemon
+ *
+ * Daemon closes all connections of client
+ *
+ * \param[in]       client: Client handle
+ */
+void
+esp_daemon_client_delete(esp_daemon_client_p client) {
+    if (client == NULL) {
+        return;
+    }
+    if (client->ctrl >= 0) {
+        close(client->ctrl);
+    }
+    if (client->shm != NULL) {
+        munmap(client->shm, sizeof(*client->shm));
+    }
+    if (client->db_daemon >= 0) {
+        close(client->db_daemon);
+    }
+    if (client->db_client >= 0) {
+        close(client->db_client);
+    }
+    free(client);
+}
+
+/**
+ * \brief           Get descriptor for `poll` or `epoll` set
+ *
+ * Descriptor is readable when daemon received data, closed connection or released transmit slots.
+ * Clear it with \ref esp_daemon_client_clear_fd before connections are processed
+ *
+ * \param[in]       client: Client handle
+ * \return          Descriptor
+ */
+int
+esp_daemon_client_get_fd(esp_daemon_client_p client) {
+    return client->db_client;
+}
+
+/**
+ * \brief           Clear descriptor returned by \ref esp_daemon_client_get_fd
+ * \param[in]       client: Client handle
+ */
+void
+esp_daemon_client_clear_fd(esp_daemon_client_p client) {
+    uint64_t val;
+
+    if (read(client->db_client, &val, sizeof(val)) < 0) {
+        /* Not rung */
+    }
+}
+
+/**
+ * \brief           Start connection through daemon
+ *
+ * Function blocks until daemon started connection, see \ref esp_conn_start
+ *
+ * \param[in]       client: Client handle
+ * \param[out]      conn: Pointer to save connection handle to
+ * \param[in]       type: Connection type
+ * \param[in]       host: Remote host
+ * \param[in]       port: Remote port
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_daemon_conn_start(esp_daemon_client_p client, esp_daemon_conn_p* conn, esp_conn_type_t type, const char* host, esp_port_t port) {
+    esp_daemon_req_t req = { .op = ESP_DAEMON_OP_CONN_START, .type = (uint32_t)type, .port = port };
+    esp_daemon_rsp_t rsp;
+    espr_t res;
+
+    ESP_ASSERT("client != NULL", client != NULL);
+    ESP_ASSERT("conn != NULL", conn != NULL);
+    ESP_ASSERT("host != NULL", host != NULL);
+    ESP_ASSERT("host fits request", strlen(host) < sizeof(req.host));
+
+    strcpy(req.host, host);
+    if ((res = client_request(client, &req, &rsp)) == espOK) {
+        if (rsp.chan >= ESP_DAEMON_CHANNELS) {
+            return espERR;
+        }
+        *conn = &client->conns[rsp.chan];
+        (*conn)->used = 1;
+    }
+    return res;
+}
+
+/**
+ * \brief           Close connection and release its channel
+ *
+ * Must be called also when connection was closed by remote side,
+ * all pointers to connection data become invalid
+ *
+ * \param[in]       conn: Connection handle
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_daemon_conn_close(esp_daemon_conn_p conn) {
+    esp_daemon_req_t req = { .op = ESP_DAEMON_OP_CONN_CLOSE };
+    esp_daemon_rsp_t rsp;
+
+    ESP_ASSERT("conn != NULL && conn->used", conn != NULL && conn->used);
+
+    req.chan = conn->num;
+    conn->used = 0;
+    return client_request(conn->client, &req, &rsp);
+}
+
+/**
+ * \brief           Get free transmit slot to write data to
+ * \param[in]       conn: Connection handle
+ * \param[out]      len: Size of slot in units of bytes
+ * \param[in]       timeout: Time to wait for free slot in units of milliseconds.
+ *                      Use `0` to return immediately or \ref ESP_DAEMON_WAIT_FOREVER
+ * \return          Pointer to slot data on success, `NULL` on timeout or when connection is closed
+ */
+void *
+esp_daemon_conn_send_alloc(esp_daemon_conn_p conn, size_t* len, uint32_t timeout) {
+    esp_daemon_ring_t* r = &conn->shm->tx;
+    uint32_t start = client_now();
+    uint8_t cleared = 0;
+
+    while (1) {
+        if (RING_LOAD(conn->shm->closed)) {
+            return NULL;
+        } else if (r->head - RING_LOAD(r->tail) < ESP_DAEMON_RING_SLOTS) {
+            break;
+        } else if (!client_wait(conn->client, start, timeout, &cleared)) {
+            return NULL;
+        }
+    }
+    *len = sizeof(RING_SLOT(r, r->head)->data);
+    return RING_SLOT(r, r->head)->data;
+}
+
+/**
+ * \brief           Submit transmit slot returned by \ref esp_daemon_conn_send_alloc
+ * \param[in]       conn: Connection handle
+ * \param[in]       len: Number of bytes written to slot
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_daemon_conn_send_commit(esp_daemon_conn_p conn, size_t len) {
+    esp_daemon_ring_t* r = &conn->shm->tx;
+
+    ESP_ASSERT("len > 0 && len <= ESP_DAEMON_SLOT_SIZE", len > 0 && len <= ESP_DAEMON_SLOT_SIZE);
+
+    RING_SLOT(r, r->head)->len = (uint32_t)len;
+    RING_STORE(r->head, r->head + 1);
+    client_doorbell_ring(conn->client);
+    return espOK;
+}
+
+/**
+ * \brief           Copy data to transmit slots and submit them
+ * \param[in]       conn: Connection handle
+ * \param[in]       data: Data to send
+ * \param[in]       btw: Number of bytes to send
+ * \param[in]       timeout: Time to wait for every free slot in units of milliseconds
+ * \return          \ref espOK on success, \ref espCLOSED when connection is closed,
+ *                      \ref espTIMEOUT when no slot was released in time
+ */
+espr_t
+esp_daemon_conn_send(esp_daemon_conn_p conn, const void* data, size_t btw, uint32_t timeout) {
+    const uint8_t* d = data;
+    uint8_t* slot;
+    size_t len;
+
+    while (btw > 0) {
+        if ((slot = esp_daemon_conn_send_alloc(conn, &len, timeout)) == NULL) {
+            return RING_LOAD(conn->shm->closed) ? espCLOSED : espTIMEOUT;
+        }
+        len = btw < len ? btw : len;
+        memcpy(slot, d, len);
+        esp_daemon_conn_send_commit(conn, len);
+        d += len;
+        btw -= len;
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Receive data in place from shared memory
+ *
+ * Data remain valid until \ref esp_daemon_conn_recved is called
+ *
+ * \param[in]       conn: Connection handle
+ * \param[out]      data: Pointer to save data pointer to
+ * \param[out]      len: Number of received bytes
+ * \param[in]       timeout: Time to wait for data in units of milliseconds.
+ *                      Use `0` to return immediately or \ref ESP_DAEMON_WAIT_FOREVER
+ * \return          \ref espOK on success, \ref espCLOSED when all data were received and connection is closed,
+ *                      \ref espTIMEOUT when no data were received in time
+ */
+espr_t
+esp_daemon_conn_receive(esp_daemon_conn_p conn, const void** data, size_t* len, uint32_t timeout) {
+    esp_daemon_ring_t* r = &conn->shm->rx;
+    esp_daemon_slot_t* s;
+    uint32_t start = client_now();
+    uint8_t cleared = 0;
+
+    while (1) {
+        if (RING_LOAD(r->head) != r->tail) {
+            break;
+        } else if (!client_wait(conn->client, start, timeout, &cleared)) {
+            return espTIMEOUT;
+        }
+    }
+    s = RING_SLOT(r, r->tail);
+    if (s->type == ESP_DAEMON_REC_CLOSED) {
+        return espCLOSED;
+    }
+    *data = s->data;
+    *len = s->len;
+    return espOK;
+}
+
+/**
+ * \brief           Release data returned by \ref esp_daemon_conn_receive
+ * \param[in]       conn: Connection handle
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_daemon_conn_recved(esp_daemon_conn_p conn) {
+    esp_daemon_ring_t* r = &conn->shm->rx;
+
+    if (RING_LOAD(r->head) == r->tail
+        || RING_SLOT(r, r->tail)->type == ESP_DAEMON_REC_CLOSED) {
+        return espERR;
+    }
+    RING_STORE(r->tail, r->tail + 1);
+    client_doorbell_ring(conn->client);
+    return espOK;
+}
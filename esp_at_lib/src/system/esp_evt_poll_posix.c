@@ -0,0 +1,372 @@
+/**
+ * \file            esp_evt_poll_posix.c
+ * \brief           Pollable event queue for POSIX systems
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include "esp/esp.h"
+#include "esp/esp_evt_poll.h"
+#include "esp/esp_mem.h"
+
+#if ESP_CFG_EVT_POLL || __DOXYGEN__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif /* defined(__linux__) */
+
+/*
+ * Queue is written by library threads and read by application thread.
+ * Descriptor is signalled when queue becomes non-empty and cleared
+ * when last event is read, both with queue mutex locked,
+ * hence descriptor is readable exactly while events are pending.
+ *
+ * Connection lifecycle events are never dropped. When queue is full,
+ * received data is chained to last queued receive event of the same connection,
+ * if no other event of that connection follows it. Other lifecycle events
+ * are held in overflow list, which is moved to queue as application reads events.
+ */
+
+/**
+ * \brief           Event held in overflow list
+ */
+typedef struct esp_evt_poll_node {
+    struct esp_evt_poll_node* next;             /*!< Next held event */
+    esp_evt_t evt;                              /*!< Held event */
+} esp_evt_poll_node_t;
+
+/**
+ * \brief           Pollable event queue
+ */
+typedef struct {
+    esp_evt_t queue[ESP_CFG_EVT_POLL_QUEUE_LEN];/*!< Queued events */
+    size_t r;                                   /*!< Read index */
+    size_t w;                                   /*!< Write index */
+    size_t cnt;                                 /*!< Number of queued events */
+    esp_evt_poll_node_t* ovf_first;             /*!< First event in overflow list */
+    esp_evt_poll_node_t* ovf_last;              /*!< Last event in overflow list */
+    esp_sys_mutex_t mutex;                      /*!< Queue protection mutex */
+    int fd_r;                                   /*!< Descriptor for application to poll */
+    int fd_w;                                   /*!< Descriptor to signal, same as `fd_r` for `eventfd` */
+    uint8_t initialized;                        /*!< Set to `1` when queue is ready */
+    esp_evt_poll_stats_t stats;                 /*!< Queue statistics */
+} esp_evt_poll_t;
+
+static esp_evt_poll_t evt_poll = { .fd_r = -1, .fd_w = -1 };
+
+/**
+ * \brief           Make descriptor readable
+ */
+static void
+poll_signal(void) {
+    uint64_t val = 1;
+    ssize_t res;
+
+    /* `eventfd` requires 8-bytes write, single byte is enough for pipe */
+    do {
+        res = write(evt_poll.fd_w, &val, evt_poll.fd_r == evt_poll.fd_w ? sizeof(val) : 1);
+    } while (res < 0 && errno == EINTR);
+}
+
+/**
+ * \brief           Read all pending signals from descriptor
+ */
+static void
+poll_clear(void) {
+    uint64_t val[8];
+    ssize_t res;
+
+    do {
+        res = read(evt_poll.fd_r, val, sizeof(val));
+    } while (res > 0 || (res < 0 && errno == EINTR));
+}
+
+/**
+ * \brief           Create queue and pollable descriptor
+ * \note            Must be called before library is initialized with \ref esp_init,
+ *                  when \ref esp_evt_poll_evt_fn is used as global callback
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_evt_poll_init(void) {
+    if (evt_poll.initialized) {
+        return espOK;
+    }
+#if defined(__linux__)
+    evt_poll.fd_r = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    evt_poll.fd_w = evt_poll.fd_r;
+    if (evt_poll.fd_r < 0) {
+        return espERR;
+    }
+#else /* defined(__linux__) */
+    {
+        int fds[2];
+
+        if (pipe(fds) != 0) {
+            return espERR;
+        }
+        for (size_t i = 0; i < 2; ++i) {
+            fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+            fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+        }
+        evt_poll.fd_r = fds[0];
+        evt_poll.fd_w = fds[1];
+    }
+#endif /* !defined(__linux__) */
+    if (!esp_sys_mutex_create(&evt_poll.mutex)) {
+        esp_evt_poll_deinit();
+        return espERRMEM;
+    }
+    evt_poll.r = evt_poll.w = evt_poll.cnt = 0;
+    ESP_MEMSET(&evt_poll.stats, 0x00, sizeof(evt_poll.stats));
+    evt_poll.initialized = 1;
+    return espOK;
+}
+
+/**
+ * \brief           Release pending events and close descriptor
+ * \note            Library must not call \ref esp_evt_poll_evt_fn anymore
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_evt_poll_deinit(void) {
+    esp_evt_t evt;
+
+    if (evt_poll.initialized) {
+        while (esp_evt_poll(&evt) == espOK) {   /* Overflow list is moved to queue on read */
+            if (evt.type == ESP_EVT_CONN_RECV) {
+                esp_pbuf_free(evt.evt.conn_data_recv.buff);
+            }
+        }
+        evt_poll.initialized = 0;
+        esp_sys_mutex_delete(&evt_poll.mutex);
+    }
+    if (evt_poll.fd_w >= 0 && evt_poll.fd_w != evt_poll.fd_r) {
+        close(evt_poll.fd_w);
+    }
+    if (evt_poll.fd_r >= 0) {
+        close(evt_poll.fd_r);
+    }
+    evt_poll.fd_r = evt_poll.fd_w = -1;
+    return espOK;
+}
+
+/**
+ * \brief           Get descriptor to add to `select`, `poll` or `epoll` set
+ *
+ * Descriptor is readable while events are waiting in queue.
+ * Application must not read from it, it is cleared by \ref esp_evt_poll
+ *
+ * \return          Descriptor or `-1` when queue is not initialized
+ */
+int
+esp_evt_poll_get_fd(void) {
+    return evt_poll.fd_r;
+}
+
+/**
+ * \brief           Check if event must never be dropped
+ * \param[in]       evt: Event to check
+ * \return          `1` for connection lifecycle event, `0` otherwise
+ */
+static uint8_t
+poll_evt_is_reliable(esp_evt_t* evt) {
+    return evt->type == ESP_EVT_CONN_ACTIVE || evt->type == ESP_EVT_CONN_RECV
+        || evt->type == ESP_EVT_CONN_CLOSE || evt->type == ESP_EVT_CONN_ERROR;
+}
+
+/**
+ * \brief           Find last pending event of connection
+ * \note            Queue mutex must be locked
+ * \param[in]       conn: Connection handle
+ * \return          Pointer to last queued or held event of connection, `NULL` if none
+ */
+static esp_evt_t*
+poll_find_last(esp_conn_p conn) {
+    esp_evt_t* last = NULL;
+
+    for (esp_evt_poll_node_t* n = evt_poll.ovf_first; n != NULL; n = n->next) {
+        if (esp_conn_get_from_evt(&n->evt) == conn) {
+            last = &n->evt;
+        }
+    }
+    for (size_t i = 0; last == NULL && i < evt_poll.cnt; ++i) {
+        size_t idx = (evt_poll.w + ESP_CFG_EVT_POLL_QUEUE_LEN - 1 - i) % ESP_CFG_EVT_POLL_QUEUE_LEN;
+
+        if (esp_conn_get_from_evt(&evt_poll.queue[idx]) == conn) {
+            last = &evt_poll.queue[idx];
+        }
+    }
+    return last;
+}
+
+/**
+ * \brief           Keep lifecycle event which does not fit to queue
+ * \note            Queue mutex must be locked
+ * \param[in]       evt: Event to keep
+ * \return          `1` when event was kept, `0` otherwise
+ */
+static uint8_t
+poll_overflow(esp_evt_t* evt) {
+    esp_evt_poll_node_t* node;
+    esp_evt_t* last;
+
+    /* Merge data with last receive event, when nothing else follows it */
+    if (evt->type == ESP_EVT_CONN_RECV
+        && (last = poll_find_last(esp_evt_conn_recv_get_conn(evt))) != NULL
+        && last->type == ESP_EVT_CONN_RECV
+        && esp_pbuf_chain(esp_evt_conn_recv_get_buff(last), esp_evt_conn_recv_get_buff(evt)) == espOK) {
+        ++evt_poll.stats.merged;
+        return 1;
+    }
+
+    if ((node = esp_mem_malloc(sizeof(*node))) == NULL) {
+        return 0;
+    }
+    ESP_MEMCPY(&node->evt, evt, sizeof(*evt));
+    if (evt->type == ESP_EVT_CONN_RECV) {
+        esp_pbuf_ref(evt->evt.conn_data_recv.buff); /* Keep buffer for application */
+    }
+    node->next = NULL;
+    if (evt_poll.ovf_last != NULL) {
+        evt_poll.ovf_last->next = node;
+    } else {
+        evt_poll.ovf_first = node;
+    }
+    evt_poll.ovf_last = node;
+    ++evt_poll.stats.held;
+    return 1;
+}
+
+/**
+ * \brief           Event callback function which writes event to queue
+ *
+ * Set it as global callback in \ref esp_init or with \ref esp_evt_register
+ * and as connection callback in \ref esp_conn_start or \ref esp_conn_startex
+ *
+ * \param[in]       evt: Event to queue
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_evt_poll_evt_fn(esp_evt_t* evt) {
+    if (!evt_poll.initialized) {
+        return espOK;
+    }
+
+    esp_sys_mutex_lock(&evt_poll.mutex);
+    if (evt_poll.cnt == ESP_CFG_EVT_POLL_QUEUE_LEN || evt_poll.ovf_first != NULL) {
+        /* Queue order is kept, new events go after held ones */
+        if (!poll_evt_is_reliable(evt) || !poll_overflow(evt)) {
+            ++evt_poll.stats.dropped;           /* Library frees packet buffer */
+        }
+    } else {
+        ESP_MEMCPY(&evt_poll.queue[evt_poll.w], evt, sizeof(*evt));
+        if (evt->type == ESP_EVT_CONN_RECV) {
+            esp_pbuf_ref(evt->evt.conn_data_recv.buff); /* Keep buffer for application */
+        }
+        evt_poll.w = (evt_poll.w + 1) % ESP_CFG_EVT_POLL_QUEUE_LEN;
+        if (++evt_poll.cnt == 1) {
+            poll_signal();
+        }
+        ++evt_poll.stats.queued;
+        if (evt_poll.cnt > evt_poll.stats.pending_max) {
+            evt_poll.stats.pending_max = (uint32_t)evt_poll.cnt;
+        }
+    }
+    esp_sys_mutex_unlock(&evt_poll.mutex);
+    return espOK;
+}
+
+/**
+ * \brief           Read next event from queue, without blocking
+ *
+ * Call it when descriptor is readable until it returns error
+ *
+ * \param[out]      evt: Event structure to fill
+ * \return          \ref espOK when event was read, \ref espERR when queue is empty,
+ *                      member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_evt_poll(esp_evt_t* evt) {
+    espr_t res = espERR;
+
+    ESP_ASSERT("evt != NULL", evt != NULL);
+
+    if (!evt_poll.initialized) {
+        return espERR;
+    }
+    esp_sys_mutex_lock(&evt_poll.mutex);
+    if (evt_poll.cnt > 0) {
+        ESP_MEMCPY(evt, &evt_poll.queue[evt_poll.r], sizeof(*evt));
+        evt_poll.r = (evt_poll.r + 1) % ESP_CFG_EVT_POLL_QUEUE_LEN;
+        if (evt_poll.ovf_first != NULL) {       /* Move held event to free slot */
+            esp_evt_poll_node_t* node = evt_poll.ovf_first;
+
+            ESP_MEMCPY(&evt_poll.queue[evt_poll.w], &node->evt, sizeof(node->evt));
+            evt_poll.w = (evt_poll.w + 1) % ESP_CFG_EVT_POLL_QUEUE_LEN;
+            if ((evt_poll.ovf_first = node->next) == NULL) {
+                evt_poll.ovf_last = NULL;
+            }
+            esp_mem_free(node);
+            ++evt_poll.stats.queued;
+        } else if (--evt_poll.cnt == 0) {
+            poll_clear();
+        }
+        res = espOK;
+    }
+    esp_sys_mutex_unlock(&evt_poll.mutex);
+    return res;
+}
+
+/**
+ * \brief           Get queue statistics
+ * \param[out]      stats: Statistics to fill
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_evt_poll_get_stats(esp_evt_poll_stats_t* stats) {
+    ESP_ASSERT("stats != NULL", stats != NULL);
+
+    if (!evt_poll.initialized) {
+        return espERR;
+    }
+    esp_sys_mutex_lock(&evt_poll.mutex);
+    ESP_MEMCPY(stats, &evt_poll.stats, sizeof(*stats));
+    stats->pending = (uint32_t)evt_poll.cnt;
+    for (esp_evt_poll_node_t* n = evt_poll.ovf_first; n != NULL; n = n->next) {
+        ++stats->pending;
+    }
+    esp_sys_mutex_unlock(&evt_poll.mutex);
+    return espOK;
+}
+
+#endif /* ESP_CFG_EVT_POLL || __DOXYGEN__ */
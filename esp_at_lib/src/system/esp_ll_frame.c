@@ -0,0 +1,424 @@
+/**
+ * \file            esp_ll_frame.c
+ * \brief           Low-level driver for ESP-AT SPI AT protocol
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <string.h>
+#include "system/esp_ll_frame.h"
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+#include "esp/esp_input.h"
+
+#if ESP_CFG_INPUT_USE_PROCESS
+#error "ESP_CFG_INPUT_USE_PROCESS must be disabled, driver thread may not wait for core lock"
+#endif /* ESP_CFG_INPUT_USE_PROCESS */
+
+#if !__DOXYGEN__
+
+/**
+ * \brief           Driver state
+ */
+static struct {
+    const esp_ll_frame_link_t* link;            /*!< Bus access functions */
+    uint8_t initialized;                        /*!< Set to `1` when driver is initialized */
+    volatile uint8_t running;                   /*!< Set to `0` to stop driver thread */
+    esp_sys_sem_t sem;                          /*!< Released when driver thread exits */
+    esp_sys_sem_t wake;                         /*!< Wakes driver thread on flush or handshake */
+    esp_sys_sem_t space;                        /*!< Released when transmit buffer has free space */
+    esp_sys_mutex_t mutex;                      /*!< Protects transmit buffer and statistics */
+
+    uint8_t tx[ESP_LL_FRAME_TX_BUFF_SIZE];      /*!< Transmit ring buffer */
+    size_t tx_r;                                /*!< Read index of transmit buffer */
+    size_t tx_len;                              /*!< Number of bytes in transmit buffer */
+    size_t tx_commit;                           /*!< Number of bytes ready to be sent, up to last flush */
+
+    uint8_t tx_seq;                             /*!< Sequence number of next transfer to module */
+    size_t req_len;                             /*!< Length announced with pending send request, `0` when none */
+    uint32_t req_time;                          /*!< Time when send request was written */
+    uint8_t rx_seq;                             /*!< Expected sequence number of next transfer from module */
+    uint8_t rx_valid;                           /*!< Set to `1` when `rx_seq` is valid */
+
+    uint8_t xfer_tx[ESP_LL_FRAME_CMD_SIZE + ESP_LL_FRAME_MAX_DATA]; /*!< Transaction to module */
+    uint8_t xfer_rx[ESP_LL_FRAME_CMD_SIZE + ESP_LL_FRAME_MAX_DATA]; /*!< Transaction from module */
+
+    esp_ll_frame_stats_t stats;                 /*!< Driver statistics */
+} frm;
+
+/**
+ * \brief           Execute single transaction
+ * \note            Data to module must be prepared in `xfer_tx` after command bytes
+ * \param[in]       cmd: Transaction command
+ * \param[in]       addr: Transaction address
+ * \param[in]       len: Length of data after command bytes
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+frame_xfer(uint8_t cmd, uint8_t addr, size_t len) {
+    frm.xfer_tx[0] = cmd;
+    frm.xfer_tx[1] = addr;
+    frm.xfer_tx[2] = 0x00;                      /* Dummy byte */
+    return frm.link->transfer_fn(frm.xfer_tx, frm.xfer_rx, ESP_LL_FRAME_CMD_SIZE + len);
+}
+
+/**
+ * \brief           Write send request to module
+ * \param[in]       len: Number of bytes host wants to send
+ */
+static void
+frame_request(size_t len) {
+    esp_ll_frame_info_t info = {
+        .type = ESP_LL_FRAME_INFO_REQUEST,
+        .seq = frm.tx_seq,
+        .len = (uint16_t)len,
+    };
+
+    esp_ll_frame_info_encode(&info, &frm.xfer_tx[ESP_LL_FRAME_CMD_SIZE]);
+    if (frame_xfer(ESP_LL_FRAME_CMD_WRBUF, ESP_LL_FRAME_ADDR_REQUEST, ESP_LL_FRAME_INFO_SIZE)) {
+        frm.req_len = len;
+        frm.req_time = esp_sys_now();
+    }
+}
+
+/**
+ * \brief           Read slave status and execute transfer module is ready for
+ */
+static void
+frame_service(void) {
+    esp_ll_frame_info_t st;
+    size_t n, len;
+    uint8_t ok;
+
+    memset(&frm.xfer_tx[ESP_LL_FRAME_CMD_SIZE], 0x00, ESP_LL_FRAME_INFO_SIZE);
+    if (!frame_xfer(ESP_LL_FRAME_CMD_RDBUF, ESP_LL_FRAME_ADDR_STATUS, ESP_LL_FRAME_INFO_SIZE)
+        || !esp_ll_frame_info_decode(&frm.xfer_rx[ESP_LL_FRAME_CMD_SIZE], &st)
+        || st.type == ESP_LL_FRAME_INFO_REQUEST) {
+        esp_sys_mutex_lock(&frm.mutex);
+        ++frm.stats.status_errors;
+        esp_sys_mutex_unlock(&frm.mutex);
+        esp_delay(1);                           /* Module may not be ready yet */
+        return;
+    }
+    if (st.type == ESP_LL_FRAME_INFO_WRITABLE && frm.req_len == 0) {
+        /* Answer to request already served or given up, release module without data */
+        frame_xfer(ESP_LL_FRAME_CMD_WR_DONE, 0x00, 0);
+        esp_sys_mutex_lock(&frm.mutex);
+        ++frm.stats.status_errors;
+        esp_sys_mutex_unlock(&frm.mutex);
+        return;
+    }
+
+    if (st.type == ESP_LL_FRAME_INFO_READABLE) {
+        memset(&frm.xfer_tx[ESP_LL_FRAME_CMD_SIZE], 0x00, st.len);
+        ok = frame_xfer(ESP_LL_FRAME_CMD_RDDMA, 0x00, st.len);
+        ok = frame_xfer(ESP_LL_FRAME_CMD_RD_DONE, 0x00, 0) && ok;
+
+        esp_sys_mutex_lock(&frm.mutex);
+        ++frm.stats.transactions;
+        if (ok) {
+            if (frm.rx_valid && st.seq != frm.rx_seq) {
+                ++frm.stats.seq_errors;         /* Sequence is followed, data are delivered anyway */
+            }
+            frm.rx_seq = (uint8_t)(st.seq + 1);
+            frm.rx_valid = 1;
+            ++frm.stats.frames_rx;
+            frm.stats.bytes_rx += st.len;
+        }
+        esp_sys_mutex_unlock(&frm.mutex);
+
+        /* Input buffer does not need core lock, library may wait for transmit buffer meanwhile */
+        if (ok) {
+            esp_input(&frm.xfer_rx[ESP_LL_FRAME_CMD_SIZE], st.len);
+        }
+    } else {
+        /* Data stay in buffer until delivered */
+        len = ESP_MIN(frm.req_len, (size_t)st.len);
+        esp_sys_mutex_lock(&frm.mutex);
+        n = ESP_MIN(len, sizeof(frm.tx) - frm.tx_r);
+        memcpy(&frm.xfer_tx[ESP_LL_FRAME_CMD_SIZE], &frm.tx[frm.tx_r], n);
+        memcpy(&frm.xfer_tx[ESP_LL_FRAME_CMD_SIZE + n], frm.tx, len - n);
+        esp_sys_mutex_unlock(&frm.mutex);
+
+        ok = frame_xfer(ESP_LL_FRAME_CMD_WRDMA, 0x00, len);
+        ok = frame_xfer(ESP_LL_FRAME_CMD_WR_DONE, 0x00, 0) && ok;
+        frm.req_len = 0;
+
+        esp_sys_mutex_lock(&frm.mutex);
+        ++frm.stats.transactions;
+        if (ok) {
+            frm.tx_r = (frm.tx_r + len) % sizeof(frm.tx);
+            frm.tx_len -= len;
+            frm.tx_commit -= len;
+            ++frm.tx_seq;
+            ++frm.stats.frames_tx;
+            frm.stats.bytes_tx += (uint32_t)len;
+        }
+        esp_sys_mutex_unlock(&frm.mutex);
+        if (ok) {
+            esp_sys_sem_release(&frm.space);
+        }
+    }
+}
+
+/**
+ * \brief           Driver thread, requests sends and serves module when handshake line is active
+ * \param[in]       arg: Thread argument, not used
+ */
+static void
+frame_thread(void* arg) {
+    size_t len;
+
+    ESP_UNUSED(arg);
+    while (frm.running) {
+        esp_sys_mutex_lock(&frm.mutex);
+        len = ESP_MIN(frm.tx_commit, (size_t)ESP_LL_FRAME_MAX_DATA);
+        esp_sys_mutex_unlock(&frm.mutex);
+
+        if (len > 0 && frm.req_len == 0) {
+            frame_request(len);
+        }
+        if (frm.link->ready_fn()) {
+            frame_service();
+        } else if (esp_sys_sem_wait(&frm.wake, ESP_LL_FRAME_POLL_TIME) == ESP_SYS_TIMEOUT
+            && frm.req_len > 0 && esp_sys_now() - frm.req_time >= ESP_LL_FRAME_POLL_TIME) {
+            /* Handshake may be missed or request lost, request again */
+            esp_sys_mutex_lock(&frm.mutex);
+            ++frm.stats.request_retries;
+            esp_sys_mutex_unlock(&frm.mutex);
+            frm.req_len = 0;
+        }
+    }
+    esp_sys_sem_release(&frm.sem);              /* Notify deinit function */
+    esp_sys_thread_terminate(NULL);
+}
+
+/**
+ * \brief           Send data to ESP device, function called from ESP stack when we have data to send
+ *
+ * Function waits for free space in transmit buffer.
+ * Driver thread frees it without core lock, which is held by caller
+ *
+ * \param[in]       data: Pointer to data to send, `NULL` to flush transmit buffer
+ * \param[in]       len: Number of bytes to send
+ * \return          Number of bytes written to transmit buffer
+ */
+static size_t
+send_data(const void* data, size_t len) {
+    const uint8_t* d = data;
+    size_t w, n, rem = len;
+
+    if (d == NULL) {
+        esp_sys_mutex_lock(&frm.mutex);
+        frm.tx_commit = frm.tx_len;
+        esp_sys_mutex_unlock(&frm.mutex);
+        esp_sys_sem_release(&frm.wake);
+        return 0;
+    }
+    while (rem > 0 && frm.running) {
+        esp_sys_mutex_lock(&frm.mutex);
+        w = (frm.tx_r + frm.tx_len) % sizeof(frm.tx);
+        n = ESP_MIN(rem, sizeof(frm.tx) - frm.tx_len);
+        n = ESP_MIN(n, sizeof(frm.tx) - w);
+        memcpy(&frm.tx[w], d, n);
+        frm.tx_len += n;
+        if (frm.tx_len - frm.tx_commit >= ESP_LL_FRAME_MAX_DATA || frm.tx_len == sizeof(frm.tx)) {
+            frm.tx_commit = frm.tx_len;         /* Full transfer is ready, do not wait for flush */
+            esp_sys_sem_release(&frm.wake);
+        }
+        esp_sys_mutex_unlock(&frm.mutex);
+        d += n;
+        rem -= n;
+        if (n == 0) {
+            esp_sys_sem_wait(&frm.space, ESP_LL_FRAME_POLL_TIME);
+        }
+    }
+    return len - rem;
+}
+
+#endif /* !__DOXYGEN__ */
+
+/**
+ * \brief           Set bus access functions
+ * \note            Must be called before \ref esp_init
+ * \param[in]       link: Bus access functions. Structure must stay valid while driver is used
+ */
+void
+esp_ll_frame_set_link(const esp_ll_frame_link_t* link) {
+    frm.link = link;
+}
+
+/**
+ * \brief           Notify driver that handshake line became active
+ *
+ * Call from handshake line interrupt or from thread watching the line
+ */
+void
+esp_ll_frame_notify(void) {
+    if (frm.initialized) {
+        esp_sys_sem_release(&frm.wake);
+    }
+}
+
+/**
+ * \brief           Get driver statistics
+ * \param[out]      stats: Output statistics
+ */
+void
+esp_ll_frame_get_stats(esp_ll_frame_stats_t* stats) {
+    if (!frm.initialized) {
+        memset(stats, 0x00, sizeof(*stats));
+        return;
+    }
+    esp_sys_mutex_lock(&frm.mutex);
+    *stats = frm.stats;
+    esp_sys_mutex_unlock(&frm.mutex);
+}
+
+/**
+ * \brief           Encode send request or slave status
+ *
+ * Layout is `type`, `seq` and `len` as little-endian `16-bit` value
+ *
+ * \param[in]       info: Request or status to encode
+ * \param[out]      buf: Output buffer of \ref ESP_LL_FRAME_INFO_SIZE bytes
+ */
+void
+esp_ll_frame_info_encode(const esp_ll_frame_info_t* info, uint8_t* buf) {
+    buf[0] = info->type;
+    buf[1] = info->seq;
+    buf[2] = ESP_U8(info->len);
+    buf[3] = ESP_U8(info->len >> 8);
+}
+
+/**
+ * \brief           Decode and check send request or slave status
+ * \param[in]       buf: Input buffer of \ref ESP_LL_FRAME_INFO_SIZE bytes
+ * \param[out]      info: Decoded request or status
+ * \return          `1` when type is known and length is valid, `0` otherwise
+ */
+uint8_t
+esp_ll_frame_info_decode(const uint8_t* buf, esp_ll_frame_info_t* info) {
+    info->type = buf[0];
+    info->seq = buf[1];
+    info->len = (uint16_t)(buf[2] | (buf[3] << 8));
+    return (info->type == ESP_LL_FRAME_INFO_READABLE || info->type == ESP_LL_FRAME_INFO_WRITABLE
+        || info->type == ESP_LL_FRAME_INFO_REQUEST)
+        && info->len > 0 && info->len <= ESP_LL_FRAME_MAX_DATA;
+}
+
+/**
+ * \brief           Callback function called from initialization process
+ * \note            This function may be called multiple times if AT baudrate is changed from application.
+ *                  Bus clock is set by link, baudrate is not used
+ * \param[in,out]   ll: Pointer to \ref esp_ll_t structure to fill data for communication functions
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_ll_init(esp_ll_t* ll) {
+#if !ESP_CFG_MEM_CUSTOM
+    /* Step 1: Configure memory for dynamic allocations */
+    static uint8_t memory[0x10000];             /* Create memory for dynamic allocations with specific size */
+
+    esp_mem_region_t mem_regions[] = {
+        { memory, sizeof(memory), ESP_MEM_CLASS_DEFAULT }
+    };
+    if (!frm.initialized) {
+        esp_mem_assignmemory(mem_regions, ESP_ARRAYSIZE(mem_regions));  /* Assign memory for allocations to ESP library */
+    }
+#endif /* !ESP_CFG_MEM_CUSTOM */
+
+    /* Step 2: Initialize bus and start driver thread */
+    if (!frm.initialized) {
+        if (frm.link == NULL || frm.link->transfer_fn == NULL || frm.link->ready_fn == NULL) {
+            return espPARERR;
+        }
+        if (!esp_sys_mutex_create(&frm.mutex)) {
+            return espERR;
+        }
+        if (!esp_sys_sem_create(&frm.sem, 0) || !esp_sys_sem_create(&frm.wake, 0)
+            || !esp_sys_sem_create(&frm.space, 0)) {
+            goto cleanup;
+        }
+        frm.initialized = 1;                    /* Link may notify from its init function */
+        if (frm.link->init_fn != NULL && !frm.link->init_fn()) {
+            goto cleanup;
+        }
+        frm.running = 1;
+        if (!esp_sys_thread_create(NULL, "esp_ll_frame", frame_thread, NULL, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO)) {
+            frm.running = 0;
+            goto cleanup;
+        }
+
+        ll->send_fn = send_data;                /* Set callback function to send data */
+        ll->reset_fn = frm.link->reset_fn;
+    }
+    return espOK;
+
+cleanup:
+    frm.initialized = 0;
+    if (esp_sys_sem_isvalid(&frm.space)) {
+        esp_sys_sem_delete(&frm.space);
+        esp_sys_sem_invalid(&frm.space);
+    }
+    if (esp_sys_sem_isvalid(&frm.wake)) {
+        esp_sys_sem_delete(&frm.wake);
+        esp_sys_sem_invalid(&frm.wake);
+    }
+    if (esp_sys_sem_isvalid(&frm.sem)) {
+        esp_sys_sem_delete(&frm.sem);
+        esp_sys_sem_invalid(&frm.sem);
+    }
+    esp_sys_mutex_delete(&frm.mutex);
+    return espERR;
+}
+
+/**
+ * \brief           Callback function to de-init low-level communication part
+ * \param[in,out]   ll: Pointer to \ref esp_ll_t structure to fill data for communication functions
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_ll_deinit(esp_ll_t* ll) {
+    ESP_UNUSED(ll);
+    if (frm.initialized) {
+        frm.running = 0;
+        esp_sys_sem_release(&frm.wake);         /* Wake up driver thread */
+        esp_sys_sem_wait(&frm.sem, 0);          /* Wait driver thread to exit */
+        frm.initialized = 0;
+        esp_sys_sem_delete(&frm.space);
+        esp_sys_sem_invalid(&frm.space);
+        esp_sys_sem_delete(&frm.wake);
+        esp_sys_sem_invalid(&frm.wake);
+        esp_sys_sem_delete(&frm.sem);
+        esp_sys_sem_invalid(&frm.sem);
+        esp_sys_mutex_delete(&frm.mutex);
+    }
+    return espOK;
+}
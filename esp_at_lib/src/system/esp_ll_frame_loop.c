@@ -0,0 +1,357 @@
+/**
+ * \file            esp_ll_frame_loop.c
+ * \brief           Loopback link with module side of ESP-AT SPI AT protocol
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <string.h>
+#include "system/esp_ll_frame_loop.h"
+#include "esp/esp.h"
+
+#if !__DOXYGEN__
+
+/**
+ * \brief           Module receive buffer
+ */
+typedef struct {
+    uint8_t data[ESP_LL_FRAME_MAX_DATA];        /*!< Transfer data */
+    size_t len;                                 /*!< Length of transfer data */
+} loop_buff_t;
+
+/**
+ * \brief           Link state, module side of transport
+ */
+static struct {
+    esp_ll_frame_loop_module_t module;          /*!< Module behind link */
+    uint8_t initialized;                        /*!< Set to `1` when link is initialized */
+    esp_sys_mutex_t mutex;                      /*!< Protects link state */
+    esp_sys_sem_t rx_sem;                       /*!< Wakes link thread when data are received */
+    esp_sys_sem_t tx_sem;                       /*!< Released when output buffer has free space */
+    volatile uint8_t hs;                        /*!< Handshake line */
+
+    esp_ll_frame_info_t status;                 /*!< Armed slave status, `type` is `0` when none */
+    esp_ll_frame_info_t cur;                    /*!< Status read by host, transfer in progress. `type` is `0` when none */
+    esp_ll_frame_info_t req;                    /*!< Send request from host, `type` is `0` when none */
+
+    uint8_t tx[ESP_LL_FRAME_LOOP_TX_BUFF_SIZE]; /*!< Output ring buffer */
+    size_t tx_r;                                /*!< Read index of output buffer */
+    size_t tx_len;                              /*!< Number of bytes in output buffer */
+    uint8_t frame[ESP_LL_FRAME_MAX_DATA];       /*!< Data for next read transfer of host */
+    size_t frame_len;                           /*!< Length of data for host, `0` when none */
+    uint8_t tx_seq;                             /*!< Sequence number of next transfer to host */
+
+    loop_buff_t bufs[ESP_LL_FRAME_LOOP_BUFFERS];/*!< Receive buffers */
+    size_t buf_r;                               /*!< Index of oldest used receive buffer */
+    size_t buf_cnt;                             /*!< Number of used receive buffers */
+    size_t wr_len;                              /*!< Number of bytes written by host in current write transfer */
+    uint8_t rx_seq;                             /*!< Sequence number of next expected transfer from host */
+    uint8_t rx_valid;                           /*!< Set to `1` when `rx_seq` is valid */
+} loop;
+
+/**
+ * \brief           Arm slave status for next transfer and set handshake line
+ * \note            Mutex must be locked by caller
+ */
+static void
+loop_arm(void) {
+    size_t n;
+
+    if (loop.cur.type == 0 && loop.status.type == 0) {
+        if (loop.req.type != 0 && loop.buf_cnt < ESP_LL_FRAME_LOOP_BUFFERS) {
+            /* Host requests are served first, commands are never delayed by received data */
+            loop.status.type = ESP_LL_FRAME_INFO_WRITABLE;
+            loop.status.seq = loop.req.seq;
+            loop.status.len = loop.req.len;
+            loop.req.type = 0;
+        } else {
+            /* New transfer is taken from output buffer only after previous one is read */
+            if (loop.frame_len == 0 && loop.tx_len > 0) {
+                loop.frame_len = ESP_MIN(loop.tx_len, (size_t)ESP_LL_FRAME_MAX_DATA);
+                n = ESP_MIN(loop.frame_len, sizeof(loop.tx) - loop.tx_r);
+                memcpy(loop.frame, &loop.tx[loop.tx_r], n);
+                memcpy(&loop.frame[n], loop.tx, loop.frame_len - n);
+                loop.tx_r = (loop.tx_r + loop.frame_len) % sizeof(loop.tx);
+                loop.tx_len -= loop.frame_len;
+                esp_sys_sem_release(&loop.tx_sem);
+            }
+            if (loop.frame_len > 0) {
+                loop.status.type = ESP_LL_FRAME_INFO_READABLE;
+                loop.status.seq = loop.tx_seq;
+                loop.status.len = (uint16_t)loop.frame_len;
+            }
+        }
+    }
+    loop.hs = loop.status.type != 0;
+}
+
+/**
+ * \brief           Process send request from host
+ * \note            Mutex must be locked by caller
+ * \param[in]       data: Request data
+ * \param[in]       len: Length of request data
+ */
+static void
+loop_request(const uint8_t* data, size_t len) {
+    esp_ll_frame_info_t info;
+
+    if (len < ESP_LL_FRAME_INFO_SIZE || !esp_ll_frame_info_decode(data, &info)
+        || info.type != ESP_LL_FRAME_INFO_REQUEST) {
+        return;
+    }
+    if (loop.rx_valid && info.seq == (uint8_t)(loop.rx_seq - 1)) {
+        return;                                 /* Request repeated by host after its data were received */
+    }
+    if (loop.status.type == ESP_LL_FRAME_INFO_WRITABLE) {
+        loop.status.type = 0;                   /* Repeated request replaces not yet reported one */
+    }
+    loop.req = info;
+    loop_arm();
+}
+
+/**
+ * \brief           Execute one transaction, called by host
+ * \param[in]       tx: Data from host
+ * \param[out]      rx: Data to host
+ * \param[in]       len: Length of transaction
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+loop_transfer(const void* tx, void* rx, size_t len) {
+    const uint8_t* t = tx;
+    uint8_t* r = rx;
+    loop_buff_t* b;
+    size_t n;
+    uint8_t hs;
+
+    if (len < ESP_LL_FRAME_CMD_SIZE) {
+        return 0;
+    }
+    memset(r, 0xFF, len);
+    t += ESP_LL_FRAME_CMD_SIZE;
+    r += ESP_LL_FRAME_CMD_SIZE;
+    len -= ESP_LL_FRAME_CMD_SIZE;
+
+    esp_sys_mutex_lock(&loop.mutex);
+    switch (((const uint8_t *)tx)[0]) {
+        case ESP_LL_FRAME_CMD_WRBUF: {
+            if (((const uint8_t *)tx)[1] == ESP_LL_FRAME_ADDR_REQUEST) {
+                loop_request(t, len);
+            }
+            break;
+        }
+        case ESP_LL_FRAME_CMD_RDBUF: {
+            if (((const uint8_t *)tx)[1] == ESP_LL_FRAME_ADDR_STATUS && len >= ESP_LL_FRAME_INFO_SIZE) {
+                esp_ll_frame_info_encode(&loop.status, r);  /* Type `0` is invalid status for host */
+                if (loop.status.type != 0) {
+                    loop.cur = loop.status;     /* Line is released when status is read */
+                    loop.status.type = 0;
+                    loop.wr_len = 0;
+                }
+                loop_arm();
+            }
+            break;
+        }
+        case ESP_LL_FRAME_CMD_WRDMA: {
+            if (loop.cur.type == ESP_LL_FRAME_INFO_WRITABLE) {
+                b = &loop.bufs[(loop.buf_r + loop.buf_cnt) % ESP_LL_FRAME_LOOP_BUFFERS];
+                loop.wr_len = ESP_MIN(len, (size_t)loop.cur.len);
+                memcpy(b->data, t, loop.wr_len);
+                b->len = loop.wr_len;
+            }
+            break;
+        }
+        case ESP_LL_FRAME_CMD_WR_DONE: {
+            if (loop.cur.type == ESP_LL_FRAME_INFO_WRITABLE) {
+                if (loop.wr_len > 0) {
+                    ++loop.buf_cnt;             /* Buffer was reserved when status was armed */
+                    loop.rx_seq = (uint8_t)(loop.cur.seq + 1);
+                    loop.rx_valid = 1;
+                    esp_sys_sem_release(&loop.rx_sem);
+                }
+                loop.cur.type = 0;
+                loop_arm();
+            }
+            break;
+        }
+        case ESP_LL_FRAME_CMD_RDDMA: {
+            if (loop.cur.type == ESP_LL_FRAME_INFO_READABLE) {
+                n = ESP_MIN(len, loop.frame_len);
+                memcpy(r, loop.frame, n);
+                memset(&r[n], 0x00, len - n);
+            }
+            break;
+        }
+        case ESP_LL_FRAME_CMD_RD_DONE: {
+            if (loop.cur.type == ESP_LL_FRAME_INFO_READABLE) {
+                loop.frame_len = 0;
+                ++loop.tx_seq;
+                loop.cur.type = 0;
+                loop_arm();
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    hs = loop.hs;
+    esp_sys_mutex_unlock(&loop.mutex);
+    if (hs) {
+        esp_ll_frame_notify();
+    }
+    return 1;
+}
+
+/**
+ * \brief           Read handshake line
+ * \return          `1` when active, `0` otherwise
+ */
+static uint8_t
+loop_ready(void) {
+    return loop.hs;
+}
+
+/**
+ * \brief           Link thread, passes received data to module
+ * \param[in]       arg: Thread argument, not used
+ */
+static void
+loop_thread(void* arg) {
+    loop_buff_t* b;
+    uint8_t hs;
+
+    ESP_UNUSED(arg);
+    while (1) {
+        esp_sys_sem_wait(&loop.rx_sem, 0);
+        while (1) {
+            esp_sys_mutex_lock(&loop.mutex);
+            b = loop.buf_cnt > 0 ? &loop.bufs[loop.buf_r] : NULL;
+            esp_sys_mutex_unlock(&loop.mutex);
+            if (b == NULL) {
+                break;
+            }
+            loop.module.input_fn(b->data, b->len);  /* Buffer is not reused until released */
+
+            esp_sys_mutex_lock(&loop.mutex);
+            loop.buf_r = (loop.buf_r + 1) % ESP_LL_FRAME_LOOP_BUFFERS;
+            --loop.buf_cnt;
+            loop_arm();                         /* Pending request may be served now */
+            hs = loop.hs;
+            esp_sys_mutex_unlock(&loop.mutex);
+            if (hs) {
+                esp_ll_frame_notify();
+            }
+        }
+    }
+}
+
+/**
+ * \brief           Initialize link and start module
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+loop_init(void) {
+    if (loop.initialized) {
+        return 1;
+    }
+    if (loop.module.input_fn == NULL
+        || !esp_sys_mutex_create(&loop.mutex)
+        || !esp_sys_sem_create(&loop.rx_sem, 0)
+        || !esp_sys_sem_create(&loop.tx_sem, 0)
+        || !esp_sys_thread_create(NULL, "esp_ll_frame_loop", loop_thread, NULL, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO)) {
+        return 0;
+    }
+    loop.initialized = 1;
+    return loop.module.init_fn == NULL || loop.module.init_fn();
+}
+
+static const esp_ll_frame_link_t loop_link = {
+    .init_fn = loop_init,
+    .transfer_fn = loop_transfer,
+    .ready_fn = loop_ready,
+};
+
+#endif /* !__DOXYGEN__ */
+
+/**
+ * \brief           Set module behind link
+ * \note            Must be called before \ref esp_init
+ * \param[in]       module: Module functions
+ */
+void
+esp_ll_frame_loop_set_module(const esp_ll_frame_loop_module_t* module) {
+    loop.module = *module;
+}
+
+/**
+ * \brief           Get loopback link functions for \ref esp_ll_frame_set_link
+ * \return          Link functions
+ */
+const esp_ll_frame_link_t*
+esp_ll_frame_loop_get_link(void) {
+    return &loop_link;
+}
+
+/**
+ * \brief           Send data from module to host
+ * \note            Function blocks until all data are in output buffer
+ * \param[in]       data: Data to send
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Number of bytes sent
+ */
+size_t
+esp_ll_frame_loop_output(const void* data, size_t len) {
+    const uint8_t* d = data;
+    size_t w, n, rem = len;
+    uint8_t hs;
+
+    if (!loop.initialized) {
+        return 0;
+    }
+    while (rem > 0) {
+        esp_sys_mutex_lock(&loop.mutex);
+        w = (loop.tx_r + loop.tx_len) % sizeof(loop.tx);
+        n = ESP_MIN(rem, sizeof(loop.tx) - loop.tx_len);
+        n = ESP_MIN(n, sizeof(loop.tx) - w);
+        memcpy(&loop.tx[w], d, n);
+        loop.tx_len += n;
+        loop_arm();
+        hs = loop.hs;
+        esp_sys_mutex_unlock(&loop.mutex);
+        if (hs) {
+            esp_ll_frame_notify();
+        }
+        d += n;
+        rem -= n;
+        if (n == 0) {
+            esp_sys_sem_wait(&loop.tx_sem, 10);
+        }
+    }
+    return len;
+}
@@ -0,0 +1,230 @@
+/**
+ * \file            esp_ll_frame_spi.c
+ * \brief           SPI link for ESP-AT SPI AT protocol on Linux hosts
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#include <linux/spi/spidev.h>
+#include "system/esp_ll_frame_spi.h"
+#include "esp/esp.h"
+
+#if !__DOXYGEN__
+
+/**
+ * \brief           Link state
+ */
+static struct {
+    esp_ll_frame_spi_config_t cfg;              /*!< Active configuration */
+    uint8_t initialized;                        /*!< Set to `1` when link is initialized */
+    int spi_fd;                                 /*!< SPI device */
+    int hs_fd;                                  /*!< Handshake line event descriptor */
+    int reset_fd;                               /*!< Reset line handle descriptor, `-1` when not used */
+} spi = {
+    .spi_fd = -1,
+    .hs_fd = -1,
+    .reset_fd = -1,
+};
+
+/**
+ * \brief           Close descriptor and mark it closed
+ * \param[in,out]   fd: Descriptor to close
+ */
+static void
+spi_close(int* fd) {
+    if (*fd >= 0) {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+/**
+ * \brief           Execute one transaction, command, address and dummy byte followed by data
+ * \param[in]       tx: Data to module
+ * \param[out]      rx: Data from module
+ * \param[in]       len: Length of transaction
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+spi_transfer(const void* tx, void* rx, size_t len) {
+    struct spi_ioc_transfer t = {
+        .tx_buf = (uintptr_t)tx,
+        .rx_buf = (uintptr_t)rx,
+        .len = (uint32_t)len,
+        .speed_hz = spi.cfg.speed,
+        .bits_per_word = 8,
+    };
+
+    return ioctl(spi.spi_fd, SPI_IOC_MESSAGE(1), &t) >= 0;
+}
+
+/**
+ * \brief           Read handshake line
+ * \return          `1` when active, `0` otherwise
+ */
+static uint8_t
+spi_ready(void) {
+    struct gpiohandle_data data = { 0 };
+
+    if (ioctl(spi.hs_fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) < 0) {
+        return 0;
+    }
+    return data.values[0] != 0;
+}
+
+/**
+ * \brief           Drive module reset line
+ * \param[in]       state: `1` to activate reset, `0` to release it
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+spi_reset(uint8_t state) {
+    struct gpiohandle_data data = { 0 };
+
+    data.values[0] = state;
+    return spi.reset_fd >= 0 && ioctl(spi.reset_fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data) >= 0;
+}
+
+/**
+ * \brief           Link thread, notifies driver on handshake line edges
+ * \param[in]       arg: Thread argument, not used
+ */
+static void
+spi_thread(void* arg) {
+    struct pollfd pfd = { .fd = spi.hs_fd, .events = POLLIN };
+    struct gpioevent_data evt;
+
+    ESP_UNUSED(arg);
+    while (1) {
+        if (poll(&pfd, 1, -1) > 0 && read(spi.hs_fd, &evt, sizeof(evt)) == sizeof(evt)) {
+            esp_ll_frame_notify();
+        }
+    }
+}
+
+/**
+ * \brief           Open SPI device and GPIO lines
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+spi_init(void) {
+    struct gpioevent_request hs = { 0 };
+    struct gpiohandle_request rst = { 0 };
+    uint8_t mode, bits = 8;
+    int chip;
+
+    if (spi.initialized) {
+        return 1;
+    }
+    if (spi.cfg.dev == NULL) {
+        spi.cfg.dev = ESP_LL_FRAME_SPI_DEV;
+    }
+    if (spi.cfg.speed == 0) {
+        spi.cfg.speed = ESP_LL_FRAME_SPI_SPEED;
+    }
+    if (spi.cfg.gpio_chip == NULL) {
+        spi.cfg.gpio_chip = ESP_LL_FRAME_SPI_GPIO_CHIP;
+    }
+    mode = spi.cfg.mode & 0x03;
+
+    /* SPI device */
+    if ((spi.spi_fd = open(spi.cfg.dev, O_RDWR)) < 0
+        || ioctl(spi.spi_fd, SPI_IOC_WR_MODE, &mode) < 0
+        || ioctl(spi.spi_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0
+        || ioctl(spi.spi_fd, SPI_IOC_WR_MAX_SPEED_HZ, &spi.cfg.speed) < 0) {
+        spi_close(&spi.spi_fd);
+        return 0;
+    }
+
+    /* Handshake input with edge events, optional reset output */
+    if ((chip = open(spi.cfg.gpio_chip, O_RDWR)) < 0) {
+        spi_close(&spi.spi_fd);
+        return 0;
+    }
+    hs.lineoffset = spi.cfg.hs_line;
+    hs.handleflags = GPIOHANDLE_REQUEST_INPUT | (spi.cfg.hs_active_low ? GPIOHANDLE_REQUEST_ACTIVE_LOW : 0);
+    hs.eventflags = GPIOEVENT_REQUEST_BOTH_EDGES;
+    strncpy(hs.consumer_label, "esp_ll_frame", sizeof(hs.consumer_label) - 1);
+    if (ioctl(chip, GPIO_GET_LINEEVENT_IOCTL, &hs) == 0) {
+        spi.hs_fd = hs.fd;
+    }
+    if (spi.cfg.reset) {
+        rst.lineoffsets[0] = spi.cfg.reset_line;
+        rst.lines = 1;
+        rst.flags = GPIOHANDLE_REQUEST_OUTPUT | GPIOHANDLE_REQUEST_ACTIVE_LOW;
+        strncpy(rst.consumer_label, "esp_ll_frame", sizeof(rst.consumer_label) - 1);
+        if (ioctl(chip, GPIO_GET_LINEHANDLE_IOCTL, &rst) == 0) {
+            spi.reset_fd = rst.fd;
+        }
+    }
+    close(chip);                                /* Line descriptors stay valid */
+    if (spi.hs_fd < 0 || (spi.cfg.reset && spi.reset_fd < 0)
+        || !esp_sys_thread_create(NULL, "esp_ll_frame_spi", spi_thread, NULL, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO)) {
+        spi_close(&spi.reset_fd);
+        spi_close(&spi.hs_fd);
+        spi_close(&spi.spi_fd);
+        return 0;
+    }
+    spi.initialized = 1;
+    return 1;
+}
+
+static esp_ll_frame_link_t spi_link = {
+    .init_fn = spi_init,
+    .transfer_fn = spi_transfer,
+    .ready_fn = spi_ready,
+};
+
+#endif /* !__DOXYGEN__ */
+
+/**
+ * \brief           Set SPI link configuration
+ * \note            Must be called before \ref esp_init to take effect
+ * \param[in]       config: New configuration
+ */
+void
+esp_ll_frame_spi_set_config(const esp_ll_frame_spi_config_t* config) {
+    spi.cfg = *config;
+    spi_link.reset_fn = spi.cfg.reset ? spi_reset : NULL;
+}
+
+/**
+ * \brief           Get SPI link functions for \ref esp_ll_frame_set_link
+ * \return          Link functions
+ */
+const esp_ll_frame_link_t*
+esp_ll_frame_spi_get_link(void) {
+    return &spi_link;
+}
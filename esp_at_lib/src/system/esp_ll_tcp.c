@@ -0,0 +1,572 @@
+/**
+ * \file            esp_ll_tcp.c
+ * \brief           Low-level communication with ESP device over TCP serial bridge
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "system/esp_ll_tcp.h"
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+#include "esp/esp_input.h"
+
+#if !__DOXYGEN__
+
+/* Telnet commands */
+#define TELNET_SE                   240
+#define TELNET_SB                   250
+#define TELNET_WILL                 251
+#define TELNET_WONT                 252
+#define TELNET_DO                   253
+#define TELNET_DONT                 254
+#define TELNET_IAC                  255
+
+/* Telnet options */
+#define TELNET_OPT_BINARY           0
+#define TELNET_OPT_SGA              3
+#define TELNET_OPT_COM_PORT         44
+
+/* RFC 2217 client to server commands, server responses are increased by 100 */
+#define COM_PORT_SET_BAUDRATE       1
+#define COM_PORT_SET_DATASIZE       2
+#define COM_PORT_SET_PARITY         3
+#define COM_PORT_SET_STOPSIZE       4
+#define COM_PORT_SET_CONTROL        5
+
+/* RFC 2217 values */
+#define COM_PORT_PARITY_NONE        1
+#define COM_PORT_STOPSIZE_1         1
+#define COM_PORT_CONTROL_FLOW_NONE  1
+#define COM_PORT_CONTROL_FLOW_HW    3
+#define COM_PORT_CONTROL_RTS_ON     11
+#define COM_PORT_CONTROL_RTS_OFF    12
+
+/**
+ * \brief           Telnet receive parser states
+ */
+typedef enum {
+    TELNET_STATE_DATA = 0x00,                   /*!< Plain data */
+    TELNET_STATE_IAC,                           /*!< Received IAC, waiting command */
+    TELNET_STATE_OPT,                           /*!< Received negotiation command, waiting option */
+    TELNET_STATE_SB,                            /*!< Inside subnegotiation */
+    TELNET_STATE_SB_IAC,                        /*!< Received IAC inside subnegotiation */
+} telnet_state_t;
+
+/**
+ * \brief           Driver state
+ */
+static struct {
+    esp_ll_tcp_config_t cfg;                    /*!< Active configuration */
+    uint8_t initialized;                        /*!< Set to `1` when driver is initialized */
+    volatile uint8_t running;                   /*!< Set to `0` to stop receive thread */
+    esp_sys_sem_t sem;                          /*!< Released when receive thread exits */
+    esp_sys_mutex_t mutex;                      /*!< Protects socket writes and transmit buffer */
+    volatile int sock;                          /*!< Connected socket, `-1` when not connected */
+    uint32_t baudrate;                          /*!< Requested AT port baudrate */
+    uint8_t com_port;                           /*!< Set to `1` when server accepted COM port control option */
+
+    uint8_t tx[ESP_LL_TCP_TX_BUFF_SIZE];        /*!< Transmit buffer */
+    size_t tx_len;                              /*!< Number of bytes in transmit buffer */
+
+    telnet_state_t state;                       /*!< Receive parser state */
+    uint8_t cmd;                                /*!< Negotiation command waiting for option */
+    uint8_t sb[16];                             /*!< Subnegotiation data */
+    size_t sb_len;                              /*!< Length of subnegotiation data */
+    uint8_t rx[0x1000];                         /*!< Received raw data */
+    uint8_t data[0x1000];                       /*!< Received AT data, after telnet processing */
+} tcp = {
+    .sock = -1,
+};
+
+/**
+ * \brief           Send transmit buffer to socket
+ * \note            Mutex must be locked by caller
+ */
+static void
+tx_flush(void) {
+    size_t off = 0;
+    ssize_t res;
+
+    while (off < tcp.tx_len && tcp.sock >= 0) {
+        res = send(tcp.sock, &tcp.tx[off], tcp.tx_len - off, MSG_NOSIGNAL);
+        if (res <= 0) {
+            shutdown(tcp.sock, SHUT_RDWR);      /* Receive thread closes socket and reconnects */
+            break;
+        }
+        off += (size_t)res;
+    }
+    tcp.tx_len = 0;
+}
+
+/**
+ * \brief           Put byte to transmit buffer
+ * \note            Mutex must be locked by caller
+ * \param[in]       b: Byte to put
+ */
+static void
+tx_put(uint8_t b) {
+    if (tcp.tx_len == sizeof(tcp.tx)) {
+        tx_flush();
+    }
+    tcp.tx[tcp.tx_len++] = b;
+}
+
+/**
+ * \brief           Put data byte to transmit buffer, escape IAC in RFC 2217 mode
+ * \note            Mutex must be locked by caller
+ * \param[in]       b: Byte to put
+ */
+static void
+tx_put_data(uint8_t b) {
+    tx_put(b);
+    if (tcp.cfg.rfc2217 && b == TELNET_IAC) {
+        tx_put(b);
+    }
+}
+
+/**
+ * \brief           Send telnet option negotiation
+ * \note            Mutex must be locked by caller
+ * \param[in]       cmd: Negotiation command
+ * \param[in]       opt: Option
+ */
+static void
+telnet_send_opt(uint8_t cmd, uint8_t opt) {
+    tx_put(TELNET_IAC);
+    tx_put(cmd);
+    tx_put(opt);
+}
+
+/**
+ * \brief           Send RFC 2217 COM port command
+ * \note            Mutex must be locked by caller
+ * \param[in]       cmd: COM port command
+ * \param[in]       val: Command value
+ * \param[in]       len: Length of value in units of bytes, `1` or `4`, sent in network byte order
+ */
+static void
+com_port_send(uint8_t cmd, uint32_t val, size_t len) {
+    tx_put(TELNET_IAC);
+    tx_put(TELNET_SB);
+    tx_put(TELNET_OPT_COM_PORT);
+    tx_put(cmd);
+    while (len-- > 0) {
+        tx_put_data((uint8_t)(val >> (8 * len)));
+    }
+    tx_put(TELNET_IAC);
+    tx_put(TELNET_SE);
+}
+
+/**
+ * \brief           Configure remote serial port
+ * \note            Mutex must be locked by caller
+ */
+static void
+com_port_configure(void) {
+    com_port_send(COM_PORT_SET_BAUDRATE, tcp.baudrate, 4);
+    com_port_send(COM_PORT_SET_DATASIZE, 8, 1);
+    com_port_send(COM_PORT_SET_PARITY, COM_PORT_PARITY_NONE, 1);
+    com_port_send(COM_PORT_SET_STOPSIZE, COM_PORT_STOPSIZE_1, 1);
+    com_port_send(COM_PORT_SET_CONTROL, tcp.cfg.flow_control ? COM_PORT_CONTROL_FLOW_HW : COM_PORT_CONTROL_FLOW_NONE, 1);
+}
+
+/**
+ * \brief           Process option negotiation received from server
+ *
+ * Options requested by driver on connect are accepted without reply,
+ * all other options are refused
+ *
+ * \note            Mutex must be locked by caller
+ * \param[in]       cmd: Negotiation command
+ * \param[in]       opt: Option
+ */
+static void
+telnet_process_opt(uint8_t cmd, uint8_t opt) {
+    switch (cmd) {
+        case TELNET_DO:
+            if (opt == TELNET_OPT_COM_PORT) {
+                if (!tcp.com_port) {
+                    tcp.com_port = 1;
+                    com_port_configure();
+                }
+            } else if (opt != TELNET_OPT_BINARY && opt != TELNET_OPT_SGA) {
+                telnet_send_opt(TELNET_WONT, opt);
+            }
+            break;
+        case TELNET_WILL:
+            if (opt != TELNET_OPT_BINARY && opt != TELNET_OPT_SGA) {
+                telnet_send_opt(TELNET_DONT, opt);
+            }
+            break;
+        case TELNET_DONT:
+            if (opt == TELNET_OPT_COM_PORT) {
+                tcp.com_port = 0;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * \brief           Process received data, remove telnet commands in RFC 2217 mode
+ * \param[in]       d: Received data
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Number of AT data bytes written to data buffer
+ */
+static size_t
+process_rx(const uint8_t* d, size_t len) {
+    size_t out = 0;
+
+    if (!tcp.cfg.rfc2217) {
+        ESP_MEMCPY(tcp.data, d, len);
+        return len;
+    }
+
+    esp_sys_mutex_lock(&tcp.mutex);
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t b = d[i];
+
+        switch (tcp.state) {
+            case TELNET_STATE_DATA:
+                if (b == TELNET_IAC) {
+                    tcp.state = TELNET_STATE_IAC;
+                } else {
+                    tcp.data[out++] = b;
+                }
+                break;
+            case TELNET_STATE_IAC:
+                if (b == TELNET_IAC) {          /* Escaped data byte */
+                    tcp.data[out++] = b;
+                    tcp.state = TELNET_STATE_DATA;
+                } else if (b >= TELNET_WILL) {
+                    tcp.cmd = b;
+                    tcp.state = TELNET_STATE_OPT;
+                } else if (b == TELNET_SB) {
+                    tcp.sb_len = 0;
+                    tcp.state = TELNET_STATE_SB;
+                } else {                        /* Other commands are ignored */
+                    tcp.state = TELNET_STATE_DATA;
+                }
+                break;
+            case TELNET_STATE_OPT:
+                telnet_process_opt(tcp.cmd, b);
+                tcp.state = TELNET_STATE_DATA;
+                break;
+            case TELNET_STATE_SB:
+                if (b == TELNET_IAC) {
+                    tcp.state = TELNET_STATE_SB_IAC;
+                } else if (tcp.sb_len < sizeof(tcp.sb)) {
+                    tcp.sb[tcp.sb_len++] = b;
+                }
+                break;
+            case TELNET_STATE_SB_IAC:
+                if (b == TELNET_IAC) {
+                    if (tcp.sb_len < sizeof(tcp.sb)) {
+                        tcp.sb[tcp.sb_len++] = b;
+                    }
+                    tcp.state = TELNET_STATE_SB;
+                } else {                        /* SE, server responses and notifications are not used */
+                    tcp.state = TELNET_STATE_DATA;
+                }
+                break;
+            default:
+                tcp.state = TELNET_STATE_DATA;
+                break;
+        }
+    }
+    tx_flush();                                 /* Send negotiation replies, if any */
+    esp_sys_mutex_unlock(&tcp.mutex);
+    return out;
+}
+
+/**
+ * \brief           Connect to bridge and start negotiation
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+tcp_connect(void) {
+    struct addrinfo hints = { 0 }, *res, *ai;
+    char port[8];
+    int fd = -1, on = 1;
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    sprintf(port, "%u", (unsigned)tcp.cfg.port);
+    if (getaddrinfo(tcp.cfg.host, port, &hints, &res) != 0) {
+        return 0;
+    }
+    for (ai = res; ai != NULL; ai = ai->ai_next) {
+        if ((fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0) {
+            continue;
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) {
+        return 0;
+    }
+
+    /* Commands are batched until flush, send them without waiting for ACK */
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+
+    esp_sys_mutex_lock(&tcp.mutex);
+    tcp.sock = fd;
+    tcp.tx_len = 0;
+    tcp.state = TELNET_STATE_DATA;
+    tcp.com_port = 0;
+    if (tcp.cfg.rfc2217) {
+        telnet_send_opt(TELNET_WILL, TELNET_OPT_BINARY);
+        telnet_send_opt(TELNET_DO, TELNET_OPT_BINARY);
+        telnet_send_opt(TELNET_WILL, TELNET_OPT_SGA);
+        telnet_send_opt(TELNET_DO, TELNET_OPT_SGA);
+        telnet_send_opt(TELNET_WILL, TELNET_OPT_COM_PORT);
+        tx_flush();
+    }
+    esp_sys_mutex_unlock(&tcp.mutex);
+    return 1;
+}
+
+/**
+ * \brief           Close connection to bridge
+ */
+static void
+tcp_disconnect(void) {
+    esp_sys_mutex_lock(&tcp.mutex);
+    if (tcp.sock >= 0) {
+        close(tcp.sock);
+        tcp.sock = -1;
+    }
+    tcp.tx_len = 0;
+    esp_sys_mutex_unlock(&tcp.mutex);
+}
+
+/**
+ * \brief           Receive thread, reads data from bridge and reconnects when connection is lost
+ * \param[in]       arg: Thread argument, not used
+ */
+static void
+tcp_thread(void* arg) {
+    ssize_t len;
+    size_t out;
+
+    ESP_UNUSED(arg);
+    while (tcp.running) {
+        if (tcp.sock < 0 && !tcp_connect()) {
+            esp_delay(ESP_LL_TCP_RECONNECT_DELAY);
+            continue;
+        }
+        len = recv(tcp.sock, tcp.rx, sizeof(tcp.rx), 0);
+        if (len <= 0) {
+            tcp_disconnect();
+            continue;
+        }
+#ifdef TCP_QUICKACK
+        {
+            int on = 1;                         /* Acknowledge responses immediately, bridge may use Nagle */
+            setsockopt(tcp.sock, IPPROTO_TCP, TCP_QUICKACK, &on, sizeof(on));
+        }
+#endif /* TCP_QUICKACK */
+        if ((out = process_rx(tcp.rx, (size_t)len)) > 0) {
+#if ESP_CFG_INPUT_USE_PROCESS
+            esp_input_process(tcp.data, out);
+#else /* ESP_CFG_INPUT_USE_PROCESS */
+            esp_input(tcp.data, out);
+#endif /* !ESP_CFG_INPUT_USE_PROCESS */
+        }
+    }
+    tcp_disconnect();
+    esp_sys_sem_release(&tcp.sem);              /* Notify deinit function */
+    esp_sys_thread_terminate(NULL);
+}
+
+/**
+ * \brief           Send data to ESP device, function called from ESP stack when we have data to send
+ * \param[in]       data: Pointer to data to send, `NULL` to flush transmit buffer
+ * \param[in]       len: Number of bytes to send
+ * \return          Number of bytes sent
+ */
+static size_t
+send_data(const void* data, size_t len) {
+    const uint8_t* d = data;
+
+    esp_sys_mutex_lock(&tcp.mutex);
+    if (tcp.sock < 0) {
+        esp_sys_mutex_unlock(&tcp.mutex);
+        return 0;
+    }
+    if (d == NULL) {
+        tx_flush();
+    } else {
+        for (size_t i = 0; i < len; ++i) {
+            tx_put_data(d[i]);
+        }
+    }
+    esp_sys_mutex_unlock(&tcp.mutex);
+    return len;
+}
+
+/**
+ * \brief           Reset device with RTS line of remote serial port
+ * \param[in]       state: `1` to activate reset, `0` to release it
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+reset_device(uint8_t state) {
+    uint8_t res = 0;
+
+    esp_sys_mutex_lock(&tcp.mutex);
+    if (tcp.sock >= 0 && tcp.com_port) {
+        com_port_send(COM_PORT_SET_CONTROL, state ? COM_PORT_CONTROL_RTS_ON : COM_PORT_CONTROL_RTS_OFF, 1);
+        tx_flush();
+        res = 1;
+    }
+    esp_sys_mutex_unlock(&tcp.mutex);
+    return res;
+}
+
+#endif /* !__DOXYGEN__ */
+
+/**
+ * \brief           Set bridge configuration
+ * \note            Must be called before \ref esp_init to take effect
+ * \param[in]       config: New configuration
+ */
+void
+esp_ll_tcp_set_config(const esp_ll_tcp_config_t* config) {
+    tcp.cfg = *config;
+}
+
+/**
+ * \brief           Check if driver is connected to bridge
+ * \return          `1` if connected, `0` otherwise
+ */
+uint8_t
+esp_ll_tcp_is_connected(void) {
+    return tcp.sock >= 0;
+}
+
+/**
+ * \brief           Callback function called from initialization process
+ * \note            This function may be called multiple times if AT baudrate is changed from application
+ * \param[in,out]   ll: Pointer to \ref esp_ll_t structure to fill data for communication functions
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_ll_init(esp_ll_t* ll) {
+#if !ESP_CFG_MEM_CUSTOM
+    /* Step 1: Configure memory for dynamic allocations */
+    static uint8_t memory[0x10000];             /* Create memory for dynamic allocations with specific size */
+
+    esp_mem_region_t mem_regions[] = {
+        { memory, sizeof(memory), ESP_MEM_CLASS_DEFAULT }
+    };
+    if (!tcp.initialized) {
+        esp_mem_assignmemory(mem_regions, ESP_ARRAYSIZE(mem_regions));  /* Assign memory for allocations to ESP library */
+    }
+#endif /* !ESP_CFG_MEM_CUSTOM */
+
+    /* Step 2: Connect to bridge and start receive thread */
+    if (!tcp.initialized) {
+        if (tcp.cfg.host == NULL) {
+            tcp.cfg.host = ESP_LL_TCP_HOST;
+        }
+        if (tcp.cfg.port == 0) {
+            tcp.cfg.port = ESP_LL_TCP_PORT;
+        }
+        if (tcp.cfg.flow_control) {             /* RTS is used for flow control */
+            tcp.cfg.reset_rts = 0;
+        }
+        tcp.baudrate = ll->uart.baudrate;
+        if (!esp_sys_mutex_create(&tcp.mutex)) {
+            return espERR;
+        }
+        if (!esp_sys_sem_create(&tcp.sem, 0)) {
+            esp_sys_mutex_delete(&tcp.mutex);
+            return espERR;
+        }
+        tcp_connect();                          /* First attempt, thread retries on failure */
+        tcp.running = 1;
+        if (!esp_sys_thread_create(NULL, "esp_ll_tcp", tcp_thread, NULL, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO)) {
+            tcp_disconnect();
+            esp_sys_sem_delete(&tcp.sem);
+            esp_sys_mutex_delete(&tcp.mutex);
+            return espERR;
+        }
+        tcp.initialized = 1;
+
+        ll->send_fn = send_data;                /* Set callback function to send data */
+        ll->reset_fn = tcp.cfg.rfc2217 && tcp.cfg.reset_rts ? reset_device : NULL;
+    }
+
+    /* Step 3: Apply new baudrate to remote serial port */
+    esp_sys_mutex_lock(&tcp.mutex);
+    tcp.baudrate = ll->uart.baudrate;
+    if (tcp.sock >= 0 && tcp.com_port) {
+        com_port_send(COM_PORT_SET_BAUDRATE, tcp.baudrate, 4);
+        tx_flush();
+    }
+    esp_sys_mutex_unlock(&tcp.mutex);
+    return espOK;
+}
+
+/**
+ * \brief           Callback function to de-init low-level communication part
+ * \param[in,out]   ll: Pointer to \ref esp_ll_t structure to fill data for communication functions
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_ll_deinit(esp_ll_t* ll) {
+    ESP_UNUSED(ll);
+    if (tcp.initialized) {
+        tcp.running = 0;
+        esp_sys_mutex_lock(&tcp.mutex);
+        if (tcp.sock >= 0) {
+            shutdown(tcp.sock, SHUT_RDWR);      /* Wake up receive thread */
+        }
+        esp_sys_mutex_unlock(&tcp.mutex);
+        esp_sys_sem_wait(&tcp.sem, 0);          /* Wait receive thread to exit */
+        esp_sys_sem_delete(&tcp.sem);
+        esp_sys_mutex_delete(&tcp.mutex);
+        tcp.initialized = 0;
+    }
+    return espOK;
+}
@@ -38,6 +38,14 @@
 
 static osMutexId_t sys_mutex;
 
+#if ESP_CFG_THREAD_STACK_STATS
+/* Threads created by library, for stack high-water report */
+static struct {
+    osThreadId_t id;
+    const char* name;
+} threads[ESP_CFG_THREAD_STACK_STATS_MAX];
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+
 uint8_t
 esp_sys_init(void) {
     esp_sys_mutex_create(&sys_mutex);
@@ -184,6 +192,20 @@ esp_sys_thread_create(esp_sys_thread_t* t, const char* name, esp_sys_thread_fn t
     };
 
     id = osThreadNew(thread_func, arg, &thread_attr);
+#if ESP_CFG_THREAD_STACK_STATS
+    if (id != NULL) {
+        int32_t lock = osKernelLock();
+
+        for (size_t i = 0; i < ESP_CFG_THREAD_STACK_STATS_MAX; ++i) {
+            if (threads[i].id == NULL) {
+                threads[i].id = id;
+                threads[i].name = name;
+                break;
+            }
+        }
+        osKernelRestoreLock(lock);
+    }
+#endif /* ESP_CFG_THREAD_STACK_STATS */
     if (t != NULL) {
         *t = id;
     }
@@ -192,6 +214,18 @@ esp_sys_thread_create(esp_sys_thread_t* t, const char* name, esp_sys_thread_fn t
 
 uint8_t
 esp_sys_thread_terminate(esp_sys_thread_t* t) {
+#if ESP_CFG_THREAD_STACK_STATS
+    osThreadId_t id = t != NULL ? *t : osThreadGetId();
+    int32_t lock = osKernelLock();
+
+    for (size_t i = 0; i < ESP_CFG_THREAD_STACK_STATS_MAX; ++i) {
+        if (threads[i].id == id) {
+            threads[i].id = NULL;
+            break;
+        }
+    }
+    osKernelRestoreLock(lock);
+#endif /* ESP_CFG_THREAD_STACK_STATS */
     if (t != NULL) {
         osThreadTerminate(*t);
     } else {
@@ -206,4 +240,28 @@ esp_sys_thread_yield(void) {
     return 1;
 }
 
+#if ESP_CFG_THREAD_STACK_STATS
+
+size_t
+esp_sys_thread_get_stack_stats(esp_sys_thread_stack_t* stats, size_t len) {
+    size_t cnt = 0, size, unused;
+    int32_t lock = osKernelLock();
+
+    for (size_t i = 0; i < ESP_CFG_THREAD_STACK_STATS_MAX && cnt < len; ++i) {
+        if (threads[i].id == NULL) {
+            continue;
+        }
+        size = osThreadGetStackSize(threads[i].id);
+        unused = osThreadGetStackSpace(threads[i].id);  /* Minimal free stack space so far */
+        stats[cnt].name = threads[i].name;
+        stats[cnt].size = size;
+        stats[cnt].used_max = size > unused ? size - unused : 0;
+        ++cnt;
+    }
+    osKernelRestoreLock(lock);
+    return cnt;
+}
+
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+
 #endif /* !__DOXYGEN__ */
@@ -44,6 +44,16 @@ typedef struct freertos_mbox {
     void *d;
 } freertos_mbox;
 
+#if ESP_CFG_THREAD_STACK_STATS
+/* Threads created by library, for stack high-water report */
+typedef struct freertos_thread {
+    TaskHandle_t handle;
+    const char* name;
+    size_t size;
+} freertos_thread;
+static freertos_thread threads[ESP_CFG_THREAD_STACK_STATS_MAX];
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+
 uint8_t
 esp_sys_init(void) {
     sys_mutex = xSemaphoreCreateMutex();
@@ -208,12 +218,44 @@ esp_sys_mbox_invalid(esp_sys_mbox_t* b) {
 
 uint8_t
 esp_sys_thread_create(esp_sys_thread_t* t, const char* name, esp_sys_thread_fn thread_func, void* const arg, size_t stack_size, esp_sys_thread_prio_t prio) {
-    return xTaskCreate(thread_func, name, stack_size, arg, prio, t) == pdPASS ? 1 : 0;
+    TaskHandle_t handle;
+
+    if (xTaskCreate(thread_func, name, stack_size, arg, prio, &handle) != pdPASS) {
+        return 0;
+    }
+#if ESP_CFG_THREAD_STACK_STATS
+    vTaskSuspendAll();
+    for (size_t i = 0; i < ESP_CFG_THREAD_STACK_STATS_MAX; ++i) {
+        if (threads[i].handle == NULL) {
+            threads[i].handle = handle;
+            threads[i].name = name;
+            threads[i].size = stack_size * sizeof(StackType_t); /* Stack depth is in units of words */
+            break;
+        }
+    }
+    xTaskResumeAll();
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+    if (t != NULL) {
+        *t = handle;
+    }
+    return 1;
 }
 
 uint8_t
 esp_sys_thread_terminate(esp_sys_thread_t* t) {
-    vTaskDelete(*t);
+#if ESP_CFG_THREAD_STACK_STATS
+    TaskHandle_t handle = t != NULL ? *t : xTaskGetCurrentTaskHandle();
+
+    vTaskSuspendAll();
+    for (size_t i = 0; i < ESP_CFG_THREAD_STACK_STATS_MAX; ++i) {
+        if (threads[i].handle == handle) {
+            threads[i].handle = NULL;
+            break;
+        }
+    }
+    xTaskResumeAll();
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+    vTaskDelete(t != NULL ? *t : NULL);         /* NULL deletes calling task */
     return 1;
 }
 
@@ -223,4 +265,31 @@ esp_sys_thread_yield(void) {
     return 1;
 }
 
+#if ESP_CFG_THREAD_STACK_STATS
+
+/*
+ * Requires INCLUDE_uxTaskGetStackHighWaterMark and INCLUDE_xTaskGetCurrentTaskHandle
+ * to be enabled in FreeRTOSConfig.h
+ */
+size_t
+esp_sys_thread_get_stack_stats(esp_sys_thread_stack_t* stats, size_t len) {
+    size_t cnt = 0, unused;
+
+    vTaskSuspendAll();
+    for (size_t i = 0; i < ESP_CFG_THREAD_STACK_STATS_MAX && cnt < len; ++i) {
+        if (threads[i].handle == NULL) {
+            continue;
+        }
+        unused = (size_t)uxTaskGetStackHighWaterMark(threads[i].handle) * sizeof(StackType_t);
+        stats[cnt].name = threads[i].name;
+        stats[cnt].size = threads[i].size;
+        stats[cnt].used_max = threads[i].size > unused ? threads[i].size - unused : 0;
+        ++cnt;
+    }
+    xTaskResumeAll();
+    return cnt;
+}
+
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+
 #endif /* !__DOXYGEN__ */
@@ -0,0 +1,587 @@
+/**
+ * \file            esp_sys_posix.c
+ * \brief           System dependant functions for POSIX systems
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include "system/esp_sys.h"
+#include "system/esp_sys_posix_stack.h"
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#if !__DOXYGEN__
+
+/**
+ * \brief           Binary semaphore implementation with mutex and condition variable
+ */
+struct posix_sem {
+    pthread_mutex_t mutex;                      /*!< Mutex to lock access */
+    pthread_cond_t cond;                        /*!< Condition signalled on release */
+    uint8_t cnt;                                /*!< Semaphore count, `0` or `1` */
+};
+
+/**
+ * \brief           Message queue implementation with mutex and condition variables
+ */
+struct posix_mbox {
+    pthread_mutex_t mutex;                      /*!< Mutex to lock access */
+    pthread_cond_t not_empty;                   /*!< Condition signalled when entry is written */
+    pthread_cond_t not_full;                    /*!< Condition signalled when entry is read */
+    size_t in, out, size;
+    void* entries[1];
+};
+
+/**
+ * \brief           Thread start parameters
+ */
+typedef struct {
+    esp_sys_thread_fn fn;                       /*!< Thread function */
+    void* arg;                                  /*!< Thread argument */
+    const char* name;                           /*!< Thread name */
+    size_t stack_size;                          /*!< Stack size requested by library, `0` for default */
+} posix_thread_start_t;
+
+#if ESP_CFG_THREAD_STACK_STATS
+
+/**
+ * \brief           Painted stack of running thread
+ */
+typedef struct {
+    pthread_t id;                               /*!< Thread ID */
+    const char* name;                           /*!< Thread name */
+    const uint8_t* lo;                          /*!< Lowest tracked stack address */
+    size_t size;                                /*!< Tracked stack size in units of bytes */
+    size_t stack_size;                          /*!< Stack size requested by library, `0` for default */
+    uint8_t used;                               /*!< Set to `1` when entry is in use */
+} posix_thread_stack_t;
+
+static posix_thread_stack_t thread_stacks[ESP_CFG_THREAD_STACK_STATS_MAX];
+static pthread_mutex_t thread_stacks_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+
+static struct timespec sys_start_time;
+static esp_sys_mutex_t sys_mutex;               /* Mutex ID for main protection */
+
+/**
+ * \brief           Get current kernel time in units of milliseconds
+ */
+static uint32_t
+osKernelSysTick(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec - sys_start_time.tv_sec) * 1000
+        + (now.tv_nsec - sys_start_time.tv_nsec) / 1000000);
+}
+
+/**
+ * \brief           Initialize condition variable to use monotonic clock
+ * \param[in]       cond: Condition variable to initialize
+ */
+static void
+cond_init(pthread_cond_t* cond) {
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/**
+ * \brief           Wait for condition with optional timeout
+ * \note            Mutex must be locked by caller
+ * \param[in]       cond: Condition variable to wait for
+ * \param[in]       mutex: Mutex protecting condition
+ * \param[in]       abstime: Absolute timeout time or `NULL` to wait forever
+ * \return          `1` when condition was signalled, `0` on timeout
+ */
+static uint8_t
+cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* abstime) {
+    if (abstime == NULL) {
+        pthread_cond_wait(cond, mutex);
+        return 1;
+    }
+    return pthread_cond_timedwait(cond, mutex, abstime) != ETIMEDOUT;
+}
+
+/**
+ * \brief           Calculate absolute timeout time
+ * \param[out]      ts: Output time structure
+ * \param[in]       timeout: Timeout in units of milliseconds. `0` means wait forever
+ * \return          Pointer to `ts` or `NULL` when waiting forever
+ */
+static const struct timespec*
+abs_timeout(struct timespec* ts, uint32_t timeout) {
+    if (timeout == 0) {
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeout / 1000;
+    ts->tv_nsec += (long)(timeout % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_nsec -= 1000000000L;
+        ++ts->tv_sec;
+    }
+    return ts;
+}
+
+#if ESP_CFG_THREAD_STACK_STATS
+
+/**
+ * \brief           Remove thread from stack statistics, called on thread exit or cancellation
+ * \param[in]       arg: Pointer to \ref posix_thread_stack_t entry
+ */
+static void
+thread_stack_unregister(void* arg) {
+    posix_thread_stack_t* e = arg;
+
+    pthread_mutex_lock(&thread_stacks_mutex);
+    e->used = 0;
+    pthread_mutex_unlock(&thread_stacks_mutex);
+}
+
+/**
+ * \brief           Paint unused stack of calling thread and add it to stack statistics
+ * \param[in]       name: Thread name
+ * \param[in]       stack_size: Stack size requested by library, `0` for default
+ * \return          Statistics entry or `NULL` when stack bounds are unknown or table is full
+ */
+static posix_thread_stack_t*
+thread_stack_register(const char* name, size_t stack_size) {
+    posix_thread_stack_t* e = NULL;
+    const uint8_t* lo;
+    size_t size;
+
+    if (!esp_sys_posix_stack_paint(&lo, &size)) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&thread_stacks_mutex);
+    for (size_t i = 0; i < ESP_CFG_THREAD_STACK_STATS_MAX; ++i) {
+        if (!thread_stacks[i].used) {
+            e = &thread_stacks[i];
+            e->id = pthread_self();
+            e->name = name;
+            e->lo = lo;
+            e->size = size;
+            e->stack_size = stack_size;
+            e->used = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&thread_stacks_mutex);
+    return e;
+}
+
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+
+/**
+ * \brief           Thread entry wrapper to match pthread function prototype
+ * \param[in]       arg: Pointer to \ref posix_thread_start_t structure
+ */
+static void *
+thread_start(void* arg) {
+    posix_thread_start_t start = *(posix_thread_start_t *)arg;
+
+    free(arg);
+#if ESP_CFG_THREAD_STACK_STATS
+    {
+        posix_thread_stack_t* e = thread_stack_register(start.name, start.stack_size);
+
+        if (e != NULL) {
+            pthread_cleanup_push(thread_stack_unregister, e);
+            start.fn(start.arg);
+            pthread_cleanup_pop(1);
+            return NULL;
+        }
+    }
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+    start.fn(start.arg);
+    return NULL;
+}
+
+uint8_t
+esp_sys_init(void) {
+    clock_gettime(CLOCK_MONOTONIC, &sys_start_time);
+
+    esp_sys_mutex_create(&sys_mutex);
+    return 1;
+}
+
+uint32_t
+esp_sys_now(void) {
+    return osKernelSysTick();
+}
+
+/**
+ * \brief           Get current time with microsecond resolution
+ * \note            Same time base as \ref esp_sys_now, use it for timestamps
+ * \return          Time since initialization in units of microseconds
+ */
+uint64_t
+esp_sys_posix_now_us(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - sys_start_time.tv_sec) * 1000000
+        + (now.tv_nsec - sys_start_time.tv_nsec) / 1000;
+}
+
+#if ESP_CFG_OS
+uint8_t
+esp_sys_protect(void) {
+    esp_sys_mutex_lock(&sys_mutex);
+    return 1;
+}
+
+uint8_t
+esp_sys_unprotect(void) {
+    esp_sys_mutex_unlock(&sys_mutex);
+    return 1;
+}
+
+uint8_t
+esp_sys_mutex_create(esp_sys_mutex_t* p) {
+    pthread_mutexattr_t attr;
+
+    *p = malloc(sizeof(**p));
+    if (*p != NULL) {
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(*p, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+    return *p != NULL;
+}
+
+uint8_t
+esp_sys_mutex_delete(esp_sys_mutex_t* p) {
+    pthread_mutex_destroy(*p);
+    free(*p);
+    return 1;
+}
+
+uint8_t
+esp_sys_mutex_lock(esp_sys_mutex_t* p) {
+    return pthread_mutex_lock(*p) == 0;
+}
+
+uint8_t
+esp_sys_mutex_unlock(esp_sys_mutex_t* p) {
+    return pthread_mutex_unlock(*p) == 0;
+}
+
+uint8_t
+esp_sys_mutex_isvalid(esp_sys_mutex_t* p) {
+    return p != NULL && *p != NULL;
+}
+
+uint8_t
+esp_sys_mutex_invalid(esp_sys_mutex_t* p) {
+    *p = ESP_SYS_MUTEX_NULL;
+    return 1;
+}
+
+uint8_t
+esp_sys_sem_create(esp_sys_sem_t* p, uint8_t cnt) {
+    *p = malloc(sizeof(**p));
+    if (*p != NULL) {
+        pthread_mutex_init(&(*p)->mutex, NULL);
+        cond_init(&(*p)->cond);
+        (*p)->cnt = !!cnt;
+    }
+    return *p != NULL;
+}
+
+uint8_t
+esp_sys_sem_delete(esp_sys_sem_t* p) {
+    pthread_cond_destroy(&(*p)->cond);
+    pthread_mutex_destroy(&(*p)->mutex);
+    free(*p);
+    return 1;
+}
+
+uint32_t
+esp_sys_sem_wait(esp_sys_sem_t* p, uint32_t timeout) {
+    struct timespec ts;
+    const struct timespec* abstime;
+    uint32_t tick = osKernelSysTick();
+    uint8_t ok = 1;
+
+    abstime = abs_timeout(&ts, timeout);
+    pthread_mutex_lock(&(*p)->mutex);
+    while ((*p)->cnt == 0 && ok) {
+        ok = cond_wait(&(*p)->cond, &(*p)->mutex, abstime);
+    }
+    if ((*p)->cnt > 0) {
+        (*p)->cnt = 0;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&(*p)->mutex);
+    return ok ? (osKernelSysTick() - tick) : ESP_SYS_TIMEOUT;
+}
+
+uint8_t
+esp_sys_sem_release(esp_sys_sem_t* p) {
+    pthread_mutex_lock(&(*p)->mutex);
+    (*p)->cnt = 1;
+    pthread_cond_signal(&(*p)->cond);
+    pthread_mutex_unlock(&(*p)->mutex);
+    return 1;
+}
+
+uint8_t
+esp_sys_sem_isvalid(esp_sys_sem_t* p) {
+    return p != NULL && *p != NULL;
+}
+
+uint8_t
+esp_sys_sem_invalid(esp_sys_sem_t* p) {
+    *p = ESP_SYS_SEM_NULL;
+    return 1;
+}
+
+uint8_t
+esp_sys_mbox_create(esp_sys_mbox_t* b, size_t size) {
+    struct posix_mbox* mbox;
+
+    *b = NULL;
+
+    mbox = malloc(sizeof(*mbox) + size * sizeof(void *));
+    if (mbox != NULL) {
+        memset(mbox, 0x00, sizeof(*mbox));
+        mbox->size = size + 1;                  /* Set it to 1 more as cyclic buffer has only one less than size */
+        pthread_mutex_init(&mbox->mutex, NULL);
+        cond_init(&mbox->not_empty);
+        cond_init(&mbox->not_full);
+        *b = mbox;
+    }
+    return *b != NULL;
+}
+
+uint8_t
+esp_sys_mbox_delete(esp_sys_mbox_t* b) {
+    struct posix_mbox* mbox = *b;
+
+    pthread_cond_destroy(&mbox->not_empty);
+    pthread_cond_destroy(&mbox->not_full);
+    pthread_mutex_destroy(&mbox->mutex);
+    free(mbox);
+    return 1;
+}
+
+/**
+ * \brief           Check if message box is full
+ * \param[in]       m: Message box handle
+ * \return          1 if full, 0 otherwise
+ */
+static uint8_t
+mbox_is_full(struct posix_mbox* m) {
+    return ((m->in + 1) % m->size) == m->out;
+}
+
+/**
+ * \brief           Check if message box is empty
+ * \param[in]       m: Message box handle
+ * \return          1 if empty, 0 otherwise
+ */
+static uint8_t
+mbox_is_empty(struct posix_mbox* m) {
+    return m->in == m->out;
+}
+
+uint32_t
+esp_sys_mbox_put(esp_sys_mbox_t* b, void* m) {
+    struct posix_mbox* mbox = *b;
+    uint32_t time = osKernelSysTick();          /* Get start time */
+
+    pthread_mutex_lock(&mbox->mutex);
+    while (mbox_is_full(mbox)) {
+        cond_wait(&mbox->not_full, &mbox->mutex, NULL);
+    }
+    mbox->entries[mbox->in] = m;
+    mbox->in = (mbox->in + 1) % mbox->size;
+    pthread_cond_signal(&mbox->not_empty);      /* Signal non-empty state */
+    pthread_mutex_unlock(&mbox->mutex);
+    return osKernelSysTick() - time;
+}
+
+uint32_t
+esp_sys_mbox_get(esp_sys_mbox_t* b, void** m, uint32_t timeout) {
+    struct posix_mbox* mbox = *b;
+    struct timespec ts;
+    const struct timespec* abstime;
+    uint32_t time = osKernelSysTick();
+
+    abstime = abs_timeout(&ts, timeout);
+    pthread_mutex_lock(&mbox->mutex);
+    while (mbox_is_empty(mbox)) {
+        if (!cond_wait(&mbox->not_empty, &mbox->mutex, abstime) && mbox_is_empty(mbox)) {
+            pthread_mutex_unlock(&mbox->mutex);
+            return ESP_SYS_TIMEOUT;
+        }
+    }
+    *m = mbox->entries[mbox->out];
+    mbox->out = (mbox->out + 1) % mbox->size;
+    pthread_cond_signal(&mbox->not_full);
+    pthread_mutex_unlock(&mbox->mutex);
+
+    return osKernelSysTick() - time;
+}
+
+uint8_t
+esp_sys_mbox_putnow(esp_sys_mbox_t* b, void* m) {
+    struct posix_mbox* mbox = *b;
+
+    pthread_mutex_lock(&mbox->mutex);
+    if (mbox_is_full(mbox)) {
+        pthread_mutex_unlock(&mbox->mutex);
+        return 0;
+    }
+    mbox->entries[mbox->in] = m;
+    mbox->in = (mbox->in + 1) % mbox->size;
+    pthread_cond_signal(&mbox->not_empty);
+    pthread_mutex_unlock(&mbox->mutex);
+    return 1;
+}
+
+uint8_t
+esp_sys_mbox_getnow(esp_sys_mbox_t* b, void** m) {
+    struct posix_mbox* mbox = *b;
+
+    pthread_mutex_lock(&mbox->mutex);
+    if (mbox_is_empty(mbox)) {
+        pthread_mutex_unlock(&mbox->mutex);
+        return 0;
+    }
+    *m = mbox->entries[mbox->out];
+    mbox->out = (mbox->out + 1) % mbox->size;
+    pthread_cond_signal(&mbox->not_full);       /* Queue not full anymore */
+    pthread_mutex_unlock(&mbox->mutex);
+    return 1;
+}
+
+uint8_t
+esp_sys_mbox_isvalid(esp_sys_mbox_t* b) {
+    return b != NULL && *b != NULL;
+}
+
+uint8_t
+esp_sys_mbox_invalid(esp_sys_mbox_t* b) {
+    *b = ESP_SYS_MBOX_NULL;
+    return 1;
+}
+
+uint8_t
+esp_sys_thread_create(esp_sys_thread_t* t, const char* name, esp_sys_thread_fn thread_func, void* const arg, size_t stack_size, esp_sys_thread_prio_t prio) {
+    posix_thread_start_t* start;
+    pthread_attr_t attr;
+    pthread_t id;
+    int res;
+
+    (void)prio;
+
+    if ((start = malloc(sizeof(*start))) == NULL) {
+        return 0;
+    }
+    start->fn = thread_func;
+    start->arg = arg;
+    start->name = name;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (stack_size > 0 && stack_size < (size_t)PTHREAD_STACK_MIN) {
+        stack_size = (size_t)PTHREAD_STACK_MIN;
+    }
+    if (stack_size > 0) {
+        pthread_attr_setstacksize(&attr, stack_size);
+    }
+    start->stack_size = stack_size;
+    res = pthread_create(&id, &attr, thread_start, start);
+    pthread_attr_destroy(&attr);
+    if (res != 0) {
+        free(start);
+        return 0;
+    }
+    if (t != NULL) {
+        *t = id;
+    }
+    return 1;
+}
+
+uint8_t
+esp_sys_thread_terminate(esp_sys_thread_t* t) {
+    if (t == NULL) {                            /* Shall we terminate ourself? */
+        pthread_exit(NULL);
+    }
+    pthread_cancel(*t);
+    return 1;
+}
+
+uint8_t
+esp_sys_thread_yield(void) {
+    sched_yield();
+    return 1;
+}
+
+#if ESP_CFG_THREAD_STACK_STATS
+
+size_t
+esp_sys_thread_get_stack_stats(esp_sys_thread_stack_t* stats, size_t len) {
+    size_t cnt = 0, used;
+
+    pthread_mutex_lock(&thread_stacks_mutex);
+    for (size_t i = 0; i < ESP_CFG_THREAD_STACK_STATS_MAX && cnt < len; ++i) {
+        const posix_thread_stack_t* e = &thread_stacks[i];
+
+        if (!e->used) {
+            continue;
+        }
+        stats[cnt].name = e->name;
+        stats[cnt].size = e->stack_size > 0 ? e->stack_size : e->size;  /* Default stack is reported up to tracked window */
+        used = esp_sys_posix_stack_used(e->lo, e->size);
+        stats[cnt].used_max = used < stats[cnt].size ? used : stats[cnt].size;
+        ++cnt;
+    }
+    pthread_mutex_unlock(&thread_stacks_mutex);
+    return cnt;
+}
+
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+
+#endif /* ESP_CFG_OS */
+#endif /* !__DOXYGEN__ */
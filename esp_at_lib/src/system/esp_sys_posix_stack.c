@@ -0,0 +1,104 @@
+/**
+ * \file            esp_sys_posix_stack.c
+ * \brief           Stack painting shared by POSIX system ports
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#define _GNU_SOURCE                             /* For pthread_getattr_np */
+#include <string.h>
+#include <pthread.h>
+#include "system/esp_sys_posix_stack.h"
+
+#if ESP_CFG_OS && ESP_CFG_THREAD_STACK_STATS
+
+/**
+ * \brief           Paint unused stack of calling thread
+ *
+ * Stack is painted from bottom up to the frame of this function,
+ * except \ref ESP_SYS_POSIX_STACK_PAINT_MARGIN bytes used by painting itself.
+ * Only \ref ESP_CFG_THREAD_STACK_STATS_PAINT_MAX bytes below the frame are painted,
+ * bigger stacks are tracked in this window only
+ *
+ * \param[out]      lo: Lowest tracked stack address
+ * \param[out]      size: Tracked stack size from `lo` to stack top in units of bytes
+ * \return          `1` on success, `0` when stack bounds are unknown
+ */
+uint8_t
+esp_sys_posix_stack_paint(const uint8_t** lo, size_t* size) {
+    pthread_attr_t attr;
+    void* addr;
+    size_t len, guard, paint;
+    uint8_t* bottom;
+
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+        return 0;
+    }
+    if (pthread_attr_getstack(&attr, &addr, &len) != 0
+        || pthread_attr_getguardsize(&attr, &guard) != 0) {
+        pthread_attr_destroy(&attr);
+        return 0;
+    }
+    pthread_attr_destroy(&attr);
+
+    /* Skip guard page, even if it is already excluded by library */
+    bottom = (uint8_t *)addr + guard;
+    len = len > guard ? len - guard : 0;
+
+    /* Paint from stack bottom up to current frame */
+    paint = (size_t)((uint8_t *)__builtin_frame_address(0) - bottom);
+    if (len == 0 || paint > len || paint <= ESP_SYS_POSIX_STACK_PAINT_MARGIN) {
+        return 0;
+    }
+    if (paint > ESP_CFG_THREAD_STACK_STATS_PAINT_MAX) {
+        bottom += paint - ESP_CFG_THREAD_STACK_STATS_PAINT_MAX;
+        len -= paint - ESP_CFG_THREAD_STACK_STATS_PAINT_MAX;
+        paint = ESP_CFG_THREAD_STACK_STATS_PAINT_MAX;
+    }
+    memset(bottom, ESP_SYS_POSIX_STACK_PAINT, paint - ESP_SYS_POSIX_STACK_PAINT_MARGIN);
+    *lo = bottom;
+    *size = len;
+    return 1;
+}
+
+/**
+ * \brief           Get maximal stack usage of painted stack
+ * \param[in]       lo: Lowest tracked stack address from \ref esp_sys_posix_stack_paint
+ * \param[in]       size: Tracked stack size from \ref esp_sys_posix_stack_paint
+ * \return          Number of bytes used at least once
+ */
+size_t
+esp_sys_posix_stack_used(const uint8_t* lo, size_t size) {
+    size_t unused;
+
+    for (unused = 0; unused < size && lo[unused] == ESP_SYS_POSIX_STACK_PAINT; ++unused) {}
+    return size - unused;
+}
+
+#endif /* ESP_CFG_OS && ESP_CFG_THREAD_STACK_STATS */
@@ -0,0 +1,891 @@
+/**
+ * \file            esp_sys_posix_vt.c
+ * \brief           System dependant functions for POSIX systems with virtual time
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT library.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include "system/esp_sys.h"
+#include "system/esp_sys_posix_stack.h"
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+
+/*
+ * Virtual time port
+ *
+ * Only one registered thread runs at a time. Running thread keeps the turn
+ * until it blocks on one of system primitives or yields, when turn is passed
+ * to next runnable thread in FIFO order.
+ *
+ * When no thread is runnable, virtual time jumps directly to the first
+ * timeout of blocked threads, hence timers and timeouts expire immediately
+ * instead of waiting for wall clock. As scheduling only depends on order of
+ * blocking calls, runs with the same input are reproducible.
+ *
+ * Threads created with \ref esp_sys_thread_create and thread calling \ref esp_sys_init
+ * are registered automatically. Other threads run freely (foreign threads)
+ * and may only use non-blocking calls or wait for events without taking part in scheduling.
+ */
+
+#if !__DOXYGEN__
+
+/**
+ * \brief           Registered thread control block
+ */
+typedef struct vt_thread {
+    struct vt_thread* next;                     /*!< Next thread in list of registered threads */
+    struct vt_thread* run_next;                 /*!< Next thread in run queue */
+    pthread_cond_t cond;                        /*!< Condition signalled when thread gets the turn */
+    esp_sys_thread_fn fn;                       /*!< Thread function */
+    void* arg;                                  /*!< Thread function argument */
+    const void* wait_obj;                       /*!< Object thread is blocked on, `NULL` when runnable */
+    uint32_t wait_seq;                          /*!< Blocking order, used for FIFO wake-up */
+    uint32_t deadline;                          /*!< Virtual time when wait times out */
+    uint8_t has_deadline;                       /*!< Set to `1` when wait has timeout */
+    uint8_t timed_out;                          /*!< Set to `1` when thread was woken up by timeout */
+    uint8_t killed;                             /*!< Set to `1` when thread was terminated by other thread */
+#if ESP_CFG_THREAD_STACK_STATS
+    const char* name;                           /*!< Thread name */
+    const uint8_t* stack_lo;                    /*!< Lowest tracked stack address */
+    size_t stack_size;                          /*!< Tracked stack size, `0` when stack is not tracked */
+    size_t stack_req;                           /*!< Stack size requested by library, `0` for default */
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+} vt_thread_t;
+
+/**
+ * \brief           Recursive mutex
+ */
+struct vt_mutex {
+    pthread_t owner;                            /*!< Owner thread */
+    uint32_t cnt;                               /*!< Recursive lock count, `0` when not locked */
+};
+
+/**
+ * \brief           Binary semaphore
+ */
+struct vt_sem {
+    uint8_t cnt;                                /*!< Semaphore count, `0` or `1` */
+};
+
+/**
+ * \brief           Message queue
+ */
+struct vt_mbox {
+    size_t in, out, size;
+    void* entries[1];
+};
+
+/**
+ * \brief           Scheduler state
+ */
+static struct {
+    pthread_mutex_t lock;                       /*!< Protects scheduler and all objects */
+    pthread_cond_t foreign_cond;                /*!< Broadcast on every state change, for foreign threads */
+    vt_thread_t* threads;                       /*!< List of registered threads */
+    vt_thread_t* run_head;                      /*!< First thread in run queue */
+    vt_thread_t* run_tail;                      /*!< Last thread in run queue */
+    vt_thread_t* current;                       /*!< Thread with the turn or `NULL` when all are blocked */
+    uint32_t now;                               /*!< Virtual time in units of milliseconds */
+    uint32_t seq;                               /*!< Blocking sequence counter */
+    struct timespec real_start;                 /*!< Wall clock time at initialization */
+} vt = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .foreign_cond = PTHREAD_COND_INITIALIZER,
+};
+
+static __thread vt_thread_t* vt_self;           /* Control block of calling thread, `NULL` for foreign threads */
+static esp_sys_mutex_t sys_mutex;               /* Mutex ID for main protection */
+
+/**
+ * \brief           Check if time `a` is at or after time `b`
+ */
+#define VT_TIME_REACHED(a, b)       ((int32_t)((a) - (b)) >= 0)
+
+/**
+ * \brief           Add thread to the end of run queue
+ * \param[in]       t: Thread to add
+ */
+static void
+run_push(vt_thread_t* t) {
+    t->run_next = NULL;
+    if (vt.run_tail != NULL) {
+        vt.run_tail->run_next = t;
+    } else {
+        vt.run_head = t;
+    }
+    vt.run_tail = t;
+}
+
+/**
+ * \brief           Remove first thread from run queue
+ * \return          Thread or `NULL` when queue is empty
+ */
+static vt_thread_t*
+run_pop(void) {
+    vt_thread_t* t = vt.run_head;
+
+    if (t != NULL) {
+        vt.run_head = t->run_next;
+        if (vt.run_head == NULL) {
+            vt.run_tail = NULL;
+        }
+    }
+    return t;
+}
+
+/**
+ * \brief           Find blocked thread with lowest blocking sequence
+ * \param[in]       obj: Object thread waits on or `NULL` to find any thread with expired timeout
+ * \return          Thread or `NULL` if not found
+ */
+static vt_thread_t*
+find_blocked(const void* obj) {
+    vt_thread_t* t, *found = NULL;
+
+    for (t = vt.threads; t != NULL; t = t->next) {
+        if (t->wait_obj == NULL) {
+            continue;
+        }
+        if (obj != NULL ? t->wait_obj == obj : (t->has_deadline && VT_TIME_REACHED(vt.now, t->deadline))) {
+            if (found == NULL || (int32_t)(t->wait_seq - found->wait_seq) < 0) {
+                found = t;
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * \brief           Advance virtual time to first timeout and wake expired threads
+ */
+static void
+vt_advance(void) {
+    vt_thread_t* t;
+    uint32_t next = 0;
+    uint8_t found = 0;
+
+    for (t = vt.threads; t != NULL; t = t->next) {
+        if (t->wait_obj != NULL && t->has_deadline
+            && (!found || (int32_t)(t->deadline - next) < 0)) {
+            next = t->deadline;
+            found = 1;
+        }
+    }
+    if (!found) {
+        return;                                 /* Everything waits forever, only foreign thread can help */
+    }
+    if (!VT_TIME_REACHED(vt.now, next)) {
+        vt.now = next;
+    }
+    while ((t = find_blocked(NULL)) != NULL) {
+        t->wait_obj = NULL;
+        t->timed_out = 1;
+        run_push(t);
+    }
+    pthread_cond_broadcast(&vt.foreign_cond);
+}
+
+/**
+ * \brief           Pass the turn to next runnable thread
+ */
+static void
+vt_dispatch(void) {
+    vt_thread_t* t;
+
+    if ((t = run_pop()) == NULL) {
+        vt_advance();
+        t = run_pop();
+    }
+    vt.current = t;
+    if (t != NULL) {
+        pthread_cond_signal(&t->cond);
+    }
+}
+
+/**
+ * \brief           Remove thread from scheduler
+ * \param[in]       t: Thread to remove
+ */
+static void
+vt_remove(vt_thread_t* t) {
+    vt_thread_t** p;
+
+    for (p = &vt.threads; *p != NULL; p = &(*p)->next) {
+        if (*p == t) {
+            *p = t->next;
+            break;
+        }
+    }
+    for (p = &vt.run_head, vt.run_tail = NULL; *p != NULL; ) {
+        if (*p == t) {
+            *p = t->run_next;
+        } else {
+            vt.run_tail = *p;
+            p = &(*p)->run_next;
+        }
+    }
+    if (vt.current == t) {
+        vt_dispatch();
+    }
+}
+
+/**
+ * \brief           Remove calling thread from scheduler and exit
+ * \note            Scheduler lock must be held by caller
+ */
+static void
+vt_exit(void) {
+    vt_thread_t* self = vt_self;
+
+    vt_remove(self);
+    pthread_mutex_unlock(&vt.lock);
+    pthread_cond_destroy(&self->cond);
+    free(self);
+    vt_self = NULL;
+    pthread_exit(NULL);
+}
+
+/**
+ * \brief           Wait until calling thread gets the turn
+ * \note            Scheduler lock must be held by caller
+ * \param[in]       self: Calling thread
+ */
+static void
+vt_wait_turn(vt_thread_t* self) {
+    while (vt.current != self) {
+        pthread_cond_wait(&self->cond, &vt.lock);
+    }
+    if (self->killed) {
+        vt_exit();
+    }
+}
+
+/**
+ * \brief           Block calling thread until woken up by event or timeout
+ * \note            Scheduler lock must be held by caller.
+ *                  Caller must check its condition again after return
+ * \param[in]       obj: Object to wait on
+ * \param[in]       has_deadline: Set to `1` when `deadline` is valid
+ * \param[in]       deadline: Virtual time when wait times out
+ * \return          `1` when woken up by event, `0` on timeout
+ */
+static uint8_t
+vt_block(const void* obj, uint8_t has_deadline, uint32_t deadline) {
+    vt_thread_t* self = vt_self;
+
+    if (has_deadline && VT_TIME_REACHED(vt.now, deadline)) {
+        return 0;
+    }
+    if (self == NULL) {                         /* Foreign thread waits for any state change */
+        pthread_cond_wait(&vt.foreign_cond, &vt.lock);
+        return !(has_deadline && VT_TIME_REACHED(vt.now, deadline));
+    }
+    self->wait_obj = obj;
+    self->wait_seq = ++vt.seq;
+    self->has_deadline = has_deadline;
+    self->deadline = deadline;
+    self->timed_out = 0;
+    vt_dispatch();
+    vt_wait_turn(self);
+    return !self->timed_out;
+}
+
+/**
+ * \brief           Wake up threads blocked on object
+ * \note            Scheduler lock must be held by caller
+ * \param[in]       obj: Object threads wait on
+ * \param[in]       all: Set to `1` to wake all threads, `0` to wake only the first one
+ */
+static void
+vt_wake(const void* obj, uint8_t all) {
+    vt_thread_t* t;
+
+    while ((t = find_blocked(obj)) != NULL) {
+        t->wait_obj = NULL;
+        t->timed_out = 0;
+        run_push(t);
+        if (!all) {
+            break;
+        }
+    }
+    pthread_cond_broadcast(&vt.foreign_cond);
+    if (vt.current == NULL) {                   /* Called from foreign thread while all were blocked */
+        vt_dispatch();
+    }
+}
+
+/**
+ * \brief           Create new thread control block
+ * \return          Control block or `NULL` on failure
+ */
+static vt_thread_t*
+vt_thread_new(void) {
+    vt_thread_t* t;
+
+    if ((t = calloc(1, sizeof(*t))) != NULL) {
+        pthread_cond_init(&t->cond, NULL);
+    }
+    return t;
+}
+
+/**
+ * \brief           Add thread to the end of list of registered threads
+ * \note            Scheduler lock must be held by caller
+ * \param[in]       t: Thread to add
+ */
+static void
+vt_thread_add(vt_thread_t* t) {
+    vt_thread_t** p;
+
+    for (p = &vt.threads; *p != NULL; p = &(*p)->next) {}
+    *p = t;
+}
+
+#if ESP_CFG_THREAD_STACK_STATS
+
+/**
+ * \brief           Paint unused stack of calling thread for high-water tracking
+ * \param[in]       self: Calling thread
+ */
+static void
+vt_stack_paint(vt_thread_t* self) {
+    const uint8_t* lo;
+    size_t size;
+
+    if (!esp_sys_posix_stack_paint(&lo, &size)) {
+        return;
+    }
+    pthread_mutex_lock(&vt.lock);
+    self->stack_lo = lo;
+    self->stack_size = size;
+    pthread_mutex_unlock(&vt.lock);
+}
+
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+
+/**
+ * \brief           Thread entry wrapper, waits for the turn before running thread function
+ * \param[in]       arg: Thread control block
+ */
+static void *
+thread_start(void* arg) {
+    vt_thread_t* self = arg;
+
+    vt_self = self;
+#if ESP_CFG_THREAD_STACK_STATS
+    vt_stack_paint(self);
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+    pthread_mutex_lock(&vt.lock);
+    vt_wait_turn(self);
+    pthread_mutex_unlock(&vt.lock);
+
+    self->fn(self->arg);
+
+    pthread_mutex_lock(&vt.lock);
+    vt_exit();
+    return NULL;
+}
+
+/**
+ * \brief           Register calling thread to virtual time scheduler
+ *
+ * Registered thread runs only when it has the turn and must block only through system functions.
+ * Thread calling \ref esp_sys_init and threads created with \ref esp_sys_thread_create
+ * are registered automatically
+ *
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+esp_sys_vt_thread_register(void) {
+    vt_thread_t* t;
+
+    if (vt_self != NULL) {
+        return 1;
+    }
+    if ((t = vt_thread_new()) == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&vt.lock);
+    vt_self = t;
+    vt_thread_add(t);
+    if (vt.current == NULL) {
+        vt.current = t;
+    } else {
+        run_push(t);
+        vt_wait_turn(t);
+    }
+    pthread_mutex_unlock(&vt.lock);
+    return 1;
+}
+
+/**
+ * \brief           Unregister calling thread from virtual time scheduler
+ *
+ * Thread continues as foreign thread and may block on external events,
+ * such as reading from file or socket
+ *
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+esp_sys_vt_thread_unregister(void) {
+    vt_thread_t* self = vt_self;
+
+    if (self == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&vt.lock);
+    vt_remove(self);
+    vt_self = NULL;
+    pthread_mutex_unlock(&vt.lock);
+    pthread_cond_destroy(&self->cond);
+    free(self);
+    return 1;
+}
+
+/**
+ * \brief           Get wall clock time since initialization
+ * \return          Real time in units of milliseconds
+ */
+uint32_t
+esp_sys_vt_get_real_time(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec - vt.real_start.tv_sec) * 1000
+        + (now.tv_nsec - vt.real_start.tv_nsec) / 1000000);
+}
+
+uint8_t
+esp_sys_init(void) {
+    clock_gettime(CLOCK_MONOTONIC, &vt.real_start);
+
+    esp_sys_vt_thread_register();               /* Calling thread takes part in scheduling */
+    esp_sys_mutex_create(&sys_mutex);
+    return 1;
+}
+
+uint32_t
+esp_sys_now(void) {
+    uint32_t now;
+
+    pthread_mutex_lock(&vt.lock);
+    now = vt.now;
+    pthread_mutex_unlock(&vt.lock);
+    return now;
+}
+
+/**
+ * \brief           Get current virtual time in units of microseconds
+ * \note            Virtual time advances in milliseconds, value is \ref esp_sys_now multiplied
+ * \return          Virtual time in units of microseconds
+ */
+uint64_t
+esp_sys_posix_now_us(void) {
+    return (uint64_t)esp_sys_now() * 1000;
+}
+
+#if ESP_CFG_OS
+uint8_t
+esp_sys_protect(void) {
+    esp_sys_mutex_lock(&sys_mutex);
+    return 1;
+}
+
+uint8_t
+esp_sys_unprotect(void) {
+    esp_sys_mutex_unlock(&sys_mutex);
+    return 1;
+}
+
+uint8_t
+esp_sys_mutex_create(esp_sys_mutex_t* p) {
+    *p = calloc(1, sizeof(**p));
+    return *p != NULL;
+}
+
+uint8_t
+esp_sys_mutex_delete(esp_sys_mutex_t* p) {
+    free(*p);
+    return 1;
+}
+
+uint8_t
+esp_sys_mutex_lock(esp_sys_mutex_t* p) {
+    struct vt_mutex* m = *p;
+
+    pthread_mutex_lock(&vt.lock);
+    while (m->cnt > 0 && !pthread_equal(m->owner, pthread_self())) {
+        vt_block(m, 0, 0);
+    }
+    m->owner = pthread_self();
+    ++m->cnt;
+    pthread_mutex_unlock(&vt.lock);
+    return 1;
+}
+
+uint8_t
+esp_sys_mutex_unlock(esp_sys_mutex_t* p) {
+    struct vt_mutex* m = *p;
+    uint8_t res = 0;
+
+    pthread_mutex_lock(&vt.lock);
+    if (m->cnt > 0 && pthread_equal(m->owner, pthread_self())) {
+        if (--m->cnt == 0) {
+            vt_wake(m, 0);
+        }
+        res = 1;
+    }
+    pthread_mutex_unlock(&vt.lock);
+    return res;
+}
+
+uint8_t
+esp_sys_mutex_isvalid(esp_sys_mutex_t* p) {
+    return p != NULL && *p != NULL;
+}
+
+uint8_t
+esp_sys_mutex_invalid(esp_sys_mutex_t* p) {
+    *p = ESP_SYS_MUTEX_NULL;
+    return 1;
+}
+
+uint8_t
+esp_sys_sem_create(esp_sys_sem_t* p, uint8_t cnt) {
+    if ((*p = calloc(1, sizeof(**p))) != NULL) {
+        (*p)->cnt = !!cnt;
+    }
+    return *p != NULL;
+}
+
+uint8_t
+esp_sys_sem_delete(esp_sys_sem_t* p) {
+    free(*p);
+    return 1;
+}
+
+uint32_t
+esp_sys_sem_wait(esp_sys_sem_t* p, uint32_t timeout) {
+    struct vt_sem* s = *p;
+    uint32_t start;
+
+    pthread_mutex_lock(&vt.lock);
+    start = vt.now;
+    while (s->cnt == 0) {
+        if (!vt_block(s, timeout > 0, start + timeout) && s->cnt == 0) {
+            pthread_mutex_unlock(&vt.lock);
+            return ESP_SYS_TIMEOUT;
+        }
+    }
+    s->cnt = 0;
+    start = vt.now - start;
+    pthread_mutex_unlock(&vt.lock);
+    return start;
+}
+
+uint8_t
+esp_sys_sem_release(esp_sys_sem_t* p) {
+    pthread_mutex_lock(&vt.lock);
+    (*p)->cnt = 1;
+    vt_wake(*p, 0);
+    pthread_mutex_unlock(&vt.lock);
+    return 1;
+}
+
+uint8_t
+esp_sys_sem_isvalid(esp_sys_sem_t* p) {
+    return p != NULL && *p != NULL;
+}
+
+uint8_t
+esp_sys_sem_invalid(esp_sys_sem_t* p) {
+    *p = ESP_SYS_SEM_NULL;
+    return 1;
+}
+
+uint8_t
+esp_sys_mbox_create(esp_sys_mbox_t* b, size_t size) {
+    struct vt_mbox* mbox;
+
+    *b = NULL;
+
+    mbox = malloc(sizeof(*mbox) + size * sizeof(void *));
+    if (mbox != NULL) {
+        memset(mbox, 0x00, sizeof(*mbox));
+        mbox->size = size + 1;                  /* Set it to 1 more as cyclic buffer has only one less than size */
+        *b = mbox;
+    }
+    return *b != NULL;
+}
+
+uint8_t
+esp_sys_mbox_delete(esp_sys_mbox_t* b) {
+    free(*b);
+    return 1;
+}
+
+/**
+ * \brief           Check if message box is full
+ * \param[in]       m: Message box handle
+ * \return          1 if full, 0 otherwise
+ */
+static uint8_t
+mbox_is_full(struct vt_mbox* m) {
+    return ((m->in + 1) % m->size) == m->out;
+}
+
+/**
+ * \brief           Check if message box is empty
+ * \param[in]       m: Message box handle
+ * \return          1 if empty, 0 otherwise
+ */
+static uint8_t
+mbox_is_empty(struct vt_mbox* m) {
+    return m->in == m->out;
+}
+
+/**
+ * \brief           Write entry to message box and wake up reader
+ * \note            Scheduler lock must be held and message box must not be full
+ * \param[in]       m: Message box handle
+ * \param[in]       e: Entry to write
+ */
+static void
+mbox_write(struct vt_mbox* m, void* e) {
+    m->entries[m->in] = e;
+    m->in = (m->in + 1) % m->size;
+    vt_wake(&m->in, 0);                         /* Wake reader waiting for data */
+}
+
+/**
+ * \brief           Read entry from message box and wake up writer
+ * \note            Scheduler lock must be held and message box must not be empty
+ * \param[in]       m: Message box handle
+ * \return          Read entry
+ */
+static void*
+mbox_read(struct vt_mbox* m) {
+    void* e = m->entries[m->out];
+
+    m->out = (m->out + 1) % m->size;
+    vt_wake(&m->out, 0);                        /* Wake writer waiting for free space */
+    return e;
+}
+
+uint32_t
+esp_sys_mbox_put(esp_sys_mbox_t* b, void* m) {
+    struct vt_mbox* mbox = *b;
+    uint32_t start;
+
+    pthread_mutex_lock(&vt.lock);
+    start = vt.now;
+    while (mbox_is_full(mbox)) {
+        vt_block(&mbox->out, 0, 0);
+    }
+    mbox_write(mbox, m);
+    start = vt.now - start;
+    pthread_mutex_unlock(&vt.lock);
+    return start;
+}
+
+uint32_t
+esp_sys_mbox_get(esp_sys_mbox_t* b, void** m, uint32_t timeout) {
+    struct vt_mbox* mbox = *b;
+    uint32_t start;
+
+    pthread_mutex_lock(&vt.lock);
+    start = vt.now;
+    while (mbox_is_empty(mbox)) {
+        if (!vt_block(&mbox->in, timeout > 0, start + timeout) && mbox_is_empty(mbox)) {
+            pthread_mutex_unlock(&vt.lock);
+            return ESP_SYS_TIMEOUT;
+        }
+    }
+    *m = mbox_read(mbox);
+    start = vt.now - start;
+    pthread_mutex_unlock(&vt.lock);
+    return start;
+}
+
+uint8_t
+esp_sys_mbox_putnow(esp_sys_mbox_t* b, void* m) {
+    struct vt_mbox* mbox = *b;
+    uint8_t res = 0;
+
+    pthread_mutex_lock(&vt.lock);
+    if (!mbox_is_full(mbox)) {
+        mbox_write(mbox, m);
+        res = 1;
+    }
+    pthread_mutex_unlock(&vt.lock);
+    return res;
+}
+
+uint8_t
+esp_sys_mbox_getnow(esp_sys_mbox_t* b, void** m) {
+    struct vt_mbox* mbox = *b;
+    uint8_t res = 0;
+
+    pthread_mutex_lock(&vt.lock);
+    if (!mbox_is_empty(mbox)) {
+        *m = mbox_read(mbox);
+        res = 1;
+    }
+    pthread_mutex_unlock(&vt.lock);
+    return res;
+}
+
+uint8_t
+esp_sys_mbox_isvalid(esp_sys_mbox_t* b) {
+    return b != NULL && *b != NULL;
+}
+
+uint8_t
+esp_sys_mbox_invalid(esp_sys_mbox_t* b) {
+    *b = ESP_SYS_MBOX_NULL;
+    return 1;
+}
+
+uint8_t
+esp_sys_thread_create(esp_sys_thread_t* t, const char* name, esp_sys_thread_fn thread_func, void* const arg, size_t stack_size, esp_sys_thread_prio_t prio) {
+    vt_thread_t* th;
+    pthread_attr_t attr;
+    pthread_t id;
+    int res;
+
+    (void)name;
+    (void)prio;
+
+    if ((th = vt_thread_new()) == NULL) {
+        return 0;
+    }
+    th->fn = thread_func;
+    th->arg = arg;
+#if ESP_CFG_THREAD_STACK_STATS
+    th->name = name;
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+
+    pthread_mutex_lock(&vt.lock);
+    vt_thread_add(th);
+    if (vt.current == NULL) {                   /* Created from foreign thread while all are blocked */
+        vt.current = th;
+    } else {
+        run_push(th);
+    }
+    pthread_mutex_unlock(&vt.lock);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (stack_size > 0) {
+        stack_size = stack_size < (size_t)PTHREAD_STACK_MIN ? (size_t)PTHREAD_STACK_MIN : stack_size;
+        pthread_attr_setstacksize(&attr, stack_size);
+    }
+#if ESP_CFG_THREAD_STACK_STATS
+    th->stack_req = stack_size;
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+    res = pthread_create(&id, &attr, thread_start, th);
+    pthread_attr_destroy(&attr);
+    if (res != 0) {
+        pthread_mutex_lock(&vt.lock);
+        vt_remove(th);
+        pthread_mutex_unlock(&vt.lock);
+        pthread_cond_destroy(&th->cond);
+        free(th);
+        return 0;
+    }
+    if (t != NULL) {
+        *t = th;
+    }
+    return 1;
+}
+
+uint8_t
+esp_sys_thread_terminate(esp_sys_thread_t* t) {
+    pthread_mutex_lock(&vt.lock);
+    if (t == NULL || *t == vt_self) {           /* Shall we terminate ourself? */
+        if (vt_self != NULL) {
+            vt_exit();
+        }
+        pthread_mutex_unlock(&vt.lock);
+        pthread_exit(NULL);
+    }
+
+    /* Thread exits next time it gets the turn */
+    (*t)->killed = 1;
+    if ((*t)->wait_obj != NULL) {
+        (*t)->wait_obj = NULL;
+        run_push(*t);
+    }
+    pthread_mutex_unlock(&vt.lock);
+    return 1;
+}
+
+uint8_t
+esp_sys_thread_yield(void) {
+    vt_thread_t* self = vt_self;
+
+    if (self == NULL) {
+        return 1;
+    }
+    pthread_mutex_lock(&vt.lock);
+    run_push(self);
+    vt_dispatch();
+    vt_wait_turn(self);
+    pthread_mutex_unlock(&vt.lock);
+    return 1;
+}
+
+#if ESP_CFG_THREAD_STACK_STATS
+
+size_t
+esp_sys_thread_get_stack_stats(esp_sys_thread_stack_t* stats, size_t len) {
+    vt_thread_t* t;
+    size_t cnt = 0, used;
+
+    pthread_mutex_lock(&vt.lock);
+    for (t = vt.threads; t != NULL && cnt < len; t = t->next) {
+        if (t->stack_size == 0) {               /* Registered thread not created by library */
+            continue;
+        }
+        stats[cnt].name = t->name;
+        stats[cnt].size = t->stack_req > 0 ? t->stack_req : t->stack_size;  /* Default stack is reported up to tracked window */
+        used = esp_sys_posix_stack_used(t->stack_lo, t->stack_size);
+        stats[cnt].used_max = used < stats[cnt].size ? used : stats[cnt].size;
+        ++cnt;
+    }
+    pthread_mutex_unlock(&vt.lock);
+    return cnt;
+}
+
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+
+#endif /* ESP_CFG_OS */
+#endif /* !__DOXYGEN__ */
@@ -386,3 +386,27 @@ esp_sys_thread_yield(void) {
     osThreadYield();
     return 1;
 }
+
+#if ESP_CFG_THREAD_STACK_STATS || __DOXYGEN__
+
+/**
+ * \brief           Get stack high-water marks of threads created with \ref esp_sys_thread_create
+ *
+ * Port shall record threads in \ref esp_sys_thread_create and forget them in \ref esp_sys_thread_terminate.
+ * Maximal stack usage is usually provided by operating system,
+ * otherwise stack may be painted with known value on thread start
+ * and scanned for first overwritten byte from the stack bottom.
+ *
+ * \note            This function is required only when \ref ESP_CFG_THREAD_STACK_STATS is enabled
+ * \param[out]      stats: Array to fill with statistics, one entry per thread
+ * \param[in]       len: Number of entries in `stats` array
+ * \return          Number of entries written to `stats` array, `0` if not supported by port
+ */
+size_t
+esp_sys_thread_get_stack_stats(esp_sys_thread_stack_t* stats, size_t len) {
+    (void)stats;
+    (void)len;
+    return 0;                                   /* CMSIS-OS v1 has no stack usage query */
+}
+
+#endif /* ESP_CFG_THREAD_STACK_STATS || __DOXYGEN__ */
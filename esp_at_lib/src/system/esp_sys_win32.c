@@ -365,5 +365,17 @@ esp_sys_thread_yield(void) {
     return 1;
 }
 
+#if ESP_CFG_THREAD_STACK_STATS
+
+size_t
+esp_sys_thread_get_stack_stats(esp_sys_thread_stack_t* stats, size_t len) {
+    /* Not implemented, threads use default reserved stack */
+    (void)stats;
+    (void)len;
+    return 0;
+}
+
+#endif /* ESP_CFG_THREAD_STACK_STATS */
+
 #endif /* ESP_CFG_OS */
 #endif /* !__DOXYGEN__ */